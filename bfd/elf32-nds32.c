@@ -237,6 +237,10 @@ struct elf_nds32_obj_tdata
 
   unsigned int hdr_size;
   int* offset_to_gp;
+
+  /* What refers to each section, indexed by section header index, for
+     deleting blanks.  */
+  struct nds32_elf_sec_refs *sec_refs;
 };
 
 #define elf_nds32_tdata(bfd) \
@@ -9035,9 +9039,10 @@ find_relocs_at_address (Elf_Internal_Rela *reloc,
    `reloc' is just a refence point to find a relocation at specified offset.
    If not found, return irelend.
 
-   Assuming relocations are sorted by r_offset,
-   we find the relocation from `reloc' backward untill relocs,
-   or find it from `reloc' forward untill irelend.  */
+   Relocations are sorted by r_offset, see nds32_elf_relax_section, and
+   the companion relocations of a sequence are close to `reloc', so we
+   gallop from `reloc' toward `offset_p' and finish with a binary search
+   instead of walking every relocation in between.  */
 
 static Elf_Internal_Rela *
 find_relocs_at_address_addr (Elf_Internal_Rela *reloc,
@@ -9047,29 +9052,69 @@ find_relocs_at_address_addr (Elf_Internal_Rela *reloc,
 			     bfd_vma offset_p)
 {
   Elf_Internal_Rela *rel_t = NULL;
+  size_t count = irelend - relocs;
+  size_t lo, hi, step;
 
   /* First, we try to find a relocation of offset `offset_p',
      and then we use find_relocs_at_address to find specific type.  */
 
   if (reloc->r_offset > offset_p)
     {
-      /* Find backward.  */
-      for (rel_t = reloc;
-	   rel_t >= relocs && rel_t->r_offset > offset_p; rel_t--)
-	/* Do nothing.  */;
+      /* Find backward the last relocation at or before `offset_p'.
+	 Everything from HI on is beyond it.  */
+      hi = reloc - relocs;
+      step = 1;
+      while (hi > 0)
+	{
+	  lo = hi > step ? hi - step : 0;
+	  if (relocs[lo].r_offset <= offset_p)
+	    break;
+	  hi = lo;
+	  step *= 2;
+	}
+      if (hi == 0)
+	return irelend;
+      while (hi - lo > 1)
+	{
+	  size_t mid = lo + (hi - lo) / 2;
+
+	  if (relocs[mid].r_offset <= offset_p)
+	    lo = mid;
+	  else
+	    hi = mid;
+	}
+      rel_t = relocs + lo;
     }
   else if (reloc->r_offset < offset_p)
     {
-      /* Find forward.  */
-      for (rel_t = reloc;
-	   rel_t < irelend && rel_t->r_offset < offset_p; rel_t++)
-	/* Do nothing.  */;
+      /* Find forward the first relocation at or after `offset_p'.
+	 Everything up to LO is before it.  */
+      lo = reloc - relocs;
+      step = 1;
+      for (;;)
+	{
+	  hi = lo + step < count ? lo + step : count;
+	  if (hi == count || relocs[hi].r_offset >= offset_p)
+	    break;
+	  lo = hi;
+	  step *= 2;
+	}
+      while (hi - lo > 1)
+	{
+	  size_t mid = lo + (hi - lo) / 2;
+
+	  if (relocs[mid].r_offset >= offset_p)
+	    hi = mid;
+	  else
+	    lo = mid;
+	}
+      rel_t = relocs + hi;
     }
   else
     rel_t = reloc;
 
   /* Not found?  */
-  if (rel_t < relocs || rel_t == irelend || rel_t->r_offset != offset_p)
+  if (rel_t == irelend || rel_t->r_offset != offset_p)
     return irelend;
 
   return find_relocs_at_address (rel_t, relocs, irelend, reloc_type);
@@ -9143,6 +9188,11 @@ clean_nds32_elf_blank (void)
     }
 }
 
+/* Find the last blank starting at or before ADDR, walking from the
+   cursor BLANK_P.  The accumulative sizes are only kept up to date up
+   to the cursor, see insert_nds32_elf_blank_recalc_total, so refresh
+   them while walking forward.  */
+
 static nds32_elf_blank_t *
 search_nds32_elf_blank (nds32_elf_blank_t *blank_p, bfd_vma addr)
 {
@@ -9155,7 +9205,10 @@ search_nds32_elf_blank (nds32_elf_blank_t *blank_p, bfd_vma addr)
   while (blank_t && addr < blank_t->offset)
     blank_t = blank_t->prev;
   while (blank_t && blank_t->next && addr >= blank_t->next->offset)
-    blank_t = blank_t->next;
+    {
+      blank_t->next->total_size = blank_t->total_size + blank_t->size;
+      blank_t = blank_t->next;
+    }
 
   return blank_t;
 }
@@ -9210,6 +9263,7 @@ insert_nds32_elf_blank (nds32_elf_blank_t **blank_p, bfd_vma addr, bfd_vma len)
       /* Extend the origin blank.  */
       if (addr + len > blank_t->offset + blank_t->size)
 	blank_t->size = addr + len - blank_t->offset;
+      *blank_p = blank_t;
     }
   else
     {
@@ -9229,6 +9283,11 @@ insert_nds32_elf_blank (nds32_elf_blank_t **blank_p, bfd_vma addr, bfd_vma len)
   return TRUE;
 }
 
+/* Insert a blank and keep the accumulative sizes usable.  Only the
+   new cursor is recomputed; the blanks after it are refreshed lazily by
+   search_nds32_elf_blank, so inserting in address order stays linear
+   instead of rewriting the whole tail for every blank.  */
+
 static bfd_boolean
 insert_nds32_elf_blank_recalc_total (nds32_elf_blank_t **blank_p, bfd_vma addr,
 				     bfd_vma len)
@@ -9239,18 +9298,10 @@ insert_nds32_elf_blank_recalc_total (nds32_elf_blank_t **blank_p, bfd_vma addr,
     return FALSE;
 
   blank_t = *blank_p;
-
   if (!blank_t->prev)
-    {
-      blank_t->total_size = 0;
-      blank_t = blank_t->next;
-    }
-
-  while (blank_t)
-    {
-      blank_t->total_size = blank_t->prev->total_size + blank_t->prev->size;
-      blank_t = blank_t->next;
-    }
+    blank_t->total_size = 0;
+  else
+    blank_t->total_size = blank_t->prev->total_size + blank_t->prev->size;
 
   return TRUE;
 }
@@ -9275,25 +9326,585 @@ calc_nds32_blank_total (nds32_elf_blank_t *blank_p)
     }
 }
 
+/* A sorted array view of a finished blank list.  Deleting the blanks
+   adjusts every reloc and symbol of the bfd, in no particular address
+   order, so look them up by binary search on the accumulative sizes
+   instead of walking the list.  */
+
+struct nds32_elf_blank_index
+{
+  nds32_elf_blank_t **nodes;
+  size_t count;
+};
+
+static bfd_boolean
+build_nds32_elf_blank_index (struct nds32_elf_blank_index *index,
+			     nds32_elf_blank_t *blank_head)
+{
+  nds32_elf_blank_t *blank_t;
+  size_t n = 0;
+
+  for (blank_t = blank_head; blank_t; blank_t = blank_t->next)
+    n++;
+
+  index->nodes = bfd_malloc (n * sizeof (nds32_elf_blank_t *));
+  if (index->nodes == NULL)
+    return FALSE;
+
+  index->count = n;
+  n = 0;
+  for (blank_t = blank_head; blank_t; blank_t = blank_t->next)
+    index->nodes[n++] = blank_t;
+  return TRUE;
+}
+
+/* Return the position of the last blank starting at or before ADDR.
+   HINT is the result of the previous search; relocs and symbols are
+   mostly sorted, so try it and its successor first.  */
+
+static size_t
+search_nds32_elf_blank_index (const struct nds32_elf_blank_index *index,
+			      size_t hint, bfd_vma addr)
+{
+  nds32_elf_blank_t **nodes = index->nodes;
+  size_t lo, hi;
+
+  if (hint < index->count && nodes[hint]->offset <= addr)
+    {
+      if (hint + 1 == index->count || addr < nodes[hint + 1]->offset)
+	return hint;
+      if (hint + 2 == index->count || addr < nodes[hint + 2]->offset)
+	return hint + 1;
+    }
+
+  /* Find the first blank beyond ADDR.  */
+  lo = 0;
+  hi = index->count;
+  while (lo < hi)
+    {
+      size_t mid = lo + (hi - lo) / 2;
+
+      if (nodes[mid]->offset <= addr)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+  return lo > 0 ? lo - 1 : 0;
+}
+
+/* Like get_nds32_elf_blank_total, on an index.  */
+
+static bfd_vma
+get_nds32_elf_blank_index_total (const struct nds32_elf_blank_index *index,
+				 size_t *hint, bfd_vma addr, int overwrite)
+{
+  nds32_elf_blank_t *blank_t;
+  size_t i;
+
+  if (index->count == 0)
+    return 0;
+
+  i = search_nds32_elf_blank_index (index, *hint, addr);
+  blank_t = index->nodes[i];
+  if (addr < blank_t->offset)
+    return 0;
+
+  if (overwrite)
+    *hint = i;
+
+  if (addr < blank_t->offset + blank_t->size)
+    return blank_t->total_size + (addr - blank_t->offset);
+  else
+    return blank_t->total_size + blank_t->size;
+}
+
+/* What refers to a section of a bfd: the relocs of other sections
+   against its local symbols, sorted by the index of their section and
+   then by position, and the symbols defined in it.  Deleting blanks in
+   a section only needs to adjust these, not every reloc and symbol of
+   the bfd.  */
+
+struct nds32_elf_reloc_ref
+{
+  asection *sec;
+  unsigned int index;
+};
+
+struct nds32_elf_sec_refs
+{
+  struct nds32_elf_reloc_ref *relocs;
+  unsigned int reloc_count;
+  unsigned int reloc_alloc;
+
+  /* Indexes into the local symbols and into elf_sym_hashes.  */
+  unsigned int *local_syms;
+  unsigned int local_count;
+  unsigned int *global_syms;
+  unsigned int global_count;
+};
+
+/* Add reloc INDEX of SEC to REFS, unless it is there already.  */
+
+static bfd_boolean
+nds32_elf_add_reloc_ref (bfd *abfd, struct nds32_elf_sec_refs *refs,
+			 asection *sec, unsigned int index)
+{
+  struct nds32_elf_reloc_ref *ref;
+  unsigned int lo, hi;
+
+  lo = 0;
+  hi = refs->reloc_count;
+
+  /* The index is built in order, so try the end first.  */
+  if (hi > 0
+      && (refs->relocs[hi - 1].sec->index < sec->index
+	  || (refs->relocs[hi - 1].sec == sec
+	      && refs->relocs[hi - 1].index < index)))
+    lo = hi;
+
+  while (lo < hi)
+    {
+      unsigned int mid = lo + (hi - lo) / 2;
+
+      ref = &refs->relocs[mid];
+      if (ref->sec->index < sec->index
+	  || (ref->sec == sec && ref->index < index))
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+
+  if (lo < refs->reloc_count
+      && refs->relocs[lo].sec == sec
+      && refs->relocs[lo].index == index)
+    return TRUE;
+
+  if (refs->reloc_count == refs->reloc_alloc)
+    {
+      /* The old array stays on the bfd's objalloc until it is closed,
+	 but growing is rare once the index has been built.  */
+      refs->reloc_alloc = refs->reloc_alloc * 2 + 4;
+      ref = bfd_alloc (abfd, refs->reloc_alloc * sizeof (*ref));
+      if (ref == NULL)
+	return FALSE;
+      if (refs->reloc_count != 0)
+	memcpy (ref, refs->relocs, refs->reloc_count * sizeof (*ref));
+      refs->relocs = ref;
+    }
+
+  ref = &refs->relocs[lo];
+  memmove (ref + 1, ref, (refs->reloc_count - lo) * sizeof (*ref));
+  ref->sec = sec;
+  ref->index = index;
+  refs->reloc_count++;
+  return TRUE;
+}
+
+/* Add the relocs of SEC against local symbols of other sections to
+   REFS, or only count them if COUNT.  */
+
+static bfd_boolean
+nds32_elf_index_reloc_refs (bfd *abfd, asection *sec, Elf_Internal_Sym *isym,
+			    struct nds32_elf_sec_refs *refs, bfd_boolean count)
+{
+  Elf_Internal_Shdr *symtab_hdr = &elf_tdata (abfd)->symtab_hdr;
+  Elf_Internal_Rela *internal_relocs;
+  unsigned int shnum = elf_numsections (abfd);
+  unsigned int sec_shndx;
+  unsigned int i;
+
+  if (!(sec->flags & SEC_RELOC))
+    return TRUE;
+
+  /* Relocations MUST be kept in memory, because relaxation adjust them.  */
+  internal_relocs = _bfd_elf_link_read_relocs (abfd, sec, NULL, NULL,
+					       TRUE /* keep_memory */);
+  if (internal_relocs == NULL)
+    return FALSE;
+
+  sec_shndx = _bfd_elf_section_from_bfd_section (abfd, sec);
+  for (i = 0; i < sec->reloc_count; i++)
+    {
+      unsigned long r_symndx = ELF32_R_SYM (internal_relocs[i].r_info);
+      unsigned int shndx;
+
+      if (r_symndx >= symtab_hdr->sh_info)
+	continue;
+
+      shndx = isym[r_symndx].st_shndx;
+      if (shndx == SHN_UNDEF || shndx >= shnum || shndx == sec_shndx)
+	continue;
+
+      if (count)
+	refs[shndx].reloc_alloc++;
+      else if (!nds32_elf_add_reloc_ref (abfd, &refs[shndx], sec, i))
+	return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Set *REFS_P to the section reference index of ABFD, whose local
+   symbols are ISYM, building it the first time.  Building it costs
+   about as much as deleting blanks without it, so leave *REFS_P NULL
+   when ABFD has only one section to relax.  */
+
+static bfd_boolean
+nds32_elf_get_sec_refs (bfd *abfd, Elf_Internal_Sym *isym,
+			struct nds32_elf_sec_refs **refs_p)
+{
+  Elf_Internal_Shdr *symtab_hdr = &elf_tdata (abfd)->symtab_hdr;
+  struct elf_link_hash_entry **sym_hashes = elf_sym_hashes (abfd);
+  unsigned int shnum = elf_numsections (abfd);
+  struct nds32_elf_sec_refs *refs;
+  unsigned int symcount;
+  unsigned int i;
+  asection *sect;
+  int pass;
+
+  *refs_p = elf_nds32_tdata (abfd)->sec_refs;
+  if (*refs_p != NULL)
+    return TRUE;
+
+  i = 0;
+  for (sect = abfd->sections; sect != NULL && i < 2; sect = sect->next)
+    if ((sect->flags & (SEC_CODE | SEC_RELOC | SEC_EXCLUDE))
+	== (SEC_CODE | SEC_RELOC))
+      i++;
+  if (i < 2)
+    return TRUE;
+
+  refs = bfd_zalloc (abfd, shnum * sizeof (*refs));
+  if (refs == NULL)
+    return FALSE;
+
+  symcount = (symtab_hdr->sh_size / sizeof (Elf32_External_Sym)
+	      - symtab_hdr->sh_info);
+
+  /* Count everything first, so that each array is allocated once.  */
+  for (pass = 0; pass < 2; pass++)
+    {
+      for (sect = abfd->sections; sect != NULL; sect = sect->next)
+	if (!nds32_elf_index_reloc_refs (abfd, sect, isym, refs, pass == 0))
+	  return FALSE;
+
+      for (i = 0; i < symtab_hdr->sh_info; i++)
+	{
+	  unsigned int shndx = isym[i].st_shndx;
+
+	  if (shndx == SHN_UNDEF || shndx >= shnum)
+	    continue;
+	  if (pass == 0)
+	    refs[shndx].local_count++;
+	  else
+	    refs[shndx].local_syms[refs[shndx].local_count++] = i;
+	}
+
+      for (i = 0; i < symcount; i++)
+	{
+	  struct elf_link_hash_entry *h = sym_hashes[i];
+	  unsigned int shndx;
+
+	  if (h == NULL
+	      || (h->root.type != bfd_link_hash_defined
+		  && h->root.type != bfd_link_hash_defweak)
+	      || h->root.u.def.section->owner != abfd)
+	    continue;
+
+	  shndx = _bfd_elf_section_from_bfd_section (abfd,
+						     h->root.u.def.section);
+	  if (shndx == SHN_UNDEF || shndx >= shnum)
+	    continue;
+	  if (pass == 0)
+	    refs[shndx].global_count++;
+	  else
+	    refs[shndx].global_syms[refs[shndx].global_count++] = i;
+	}
+
+      if (pass == 1)
+	break;
+
+      for (i = 0; i < shnum; i++)
+	{
+	  if (refs[i].reloc_alloc != 0)
+	    {
+	      refs[i].relocs = bfd_alloc (abfd, (refs[i].reloc_alloc
+						 * sizeof (*refs[i].relocs)));
+	      if (refs[i].relocs == NULL)
+		return FALSE;
+	    }
+	  if (refs[i].local_count != 0)
+	    {
+	      refs[i].local_syms = bfd_alloc (abfd, (refs[i].local_count
+						     * sizeof (unsigned int)));
+	      if (refs[i].local_syms == NULL)
+		return FALSE;
+	      refs[i].local_count = 0;
+	    }
+	  if (refs[i].global_count != 0)
+	    {
+	      refs[i].global_syms = bfd_alloc (abfd, (refs[i].global_count
+						      * sizeof (unsigned int)));
+	      if (refs[i].global_syms == NULL)
+		return FALSE;
+	      refs[i].global_count = 0;
+	    }
+	}
+    }
+
+  elf_nds32_tdata (abfd)->sec_refs = *refs_p = refs;
+  return TRUE;
+}
+
+/* Add the relocs of SEC of ABFD to its section reference index again,
+   if it has been built.  Sorting the relocs moves them, and the
+   relaxers move some onto the symbol of the sequence they relax, which
+   may be in another section.  Entries left behind are harmless, as the
+   relocs are checked again when used.  */
+
+static bfd_boolean
+nds32_elf_update_sec_refs (bfd *abfd, asection *sec)
+{
+  Elf_Internal_Shdr *symtab_hdr = &elf_tdata (abfd)->symtab_hdr;
+
+  if (elf_nds32_tdata (abfd)->sec_refs == NULL)
+    return TRUE;
+
+  /* Building the index read the local symbols into SYMTAB_HDR.  */
+  return nds32_elf_index_reloc_refs (abfd, sec,
+				     (Elf_Internal_Sym *) symtab_hdr->contents,
+				     elf_nds32_tdata (abfd)->sec_refs, FALSE);
+}
+
+/* Adjust IREL of SECT for deleting the blanks of INDEX from SEC, whose
+   section header index is SEC_SHNDX.  *CONTENTS_P caches the contents
+   of SECT, and *HINT and *HINT2 the searches in INDEX; reset them for
+   each section.  */
+
+static bfd_boolean
+nds32_elf_relax_adjust_reloc (bfd *abfd, asection *sec,
+			      unsigned int sec_shndx, asection *sect,
+			      Elf_Internal_Rela *irel, Elf_Internal_Sym *isym,
+			      bfd_byte **contents_p,
+			      const struct nds32_elf_blank_index *index,
+			      size_t *hint, size_t *hint2)
+{
+  Elf_Internal_Shdr *symtab_hdr = &elf_tdata (abfd)->symtab_hdr;
+  nds32_elf_blank_t *blank_t;
+  bfd_byte *contents;
+  bfd_vma raddr;
+
+  if (ELF32_R_SYM (irel->r_info) < symtab_hdr->sh_info
+      && ELF32_R_TYPE (irel->r_info) >= R_NDS32_DIFF8
+      && ELF32_R_TYPE (irel->r_info) <= R_NDS32_DIFF32
+      && isym[ELF32_R_SYM (irel->r_info)].st_shndx == sec_shndx)
+    {
+      unsigned long val = 0;
+      unsigned long mask;
+      long before, between;
+      long offset = 0;
+
+      /* Only DIFF relocs against SEC touch the contents, so do not read
+	 and cache them until one is seen.  */
+      if (*contents_p == NULL
+	  && !nds32_get_section_contents (abfd, sect, contents_p, TRUE))
+	return FALSE;
+      contents = *contents_p;
+
+      switch (ELF32_R_TYPE (irel->r_info))
+	{
+	case R_NDS32_DIFF8:
+	  offset = bfd_get_8 (abfd, contents + irel->r_offset);
+	  break;
+	case R_NDS32_DIFF16:
+	  offset = bfd_get_16 (abfd, contents + irel->r_offset);
+	  break;
+	case R_NDS32_DIFF32:
+	  val = bfd_get_32 (abfd, contents + irel->r_offset);
+	  /* Get the signed bit and mask for the high part.  The
+	     gcc will alarm when right shift 32-bit since the
+	     type size of long may be 32-bit.  */
+	  mask = 0 - (val >> 31);
+	  if (mask)
+	    offset = (val | (mask - 0xffffffff));
+	  else
+	    offset = val;
+	  break;
+	default:
+	  BFD_ASSERT (0);
+	}
+
+      /*		  DIFF value
+	0	     |encoded in location|
+	|------------|-------------------|---------
+		    sym+off(addend)
+	-- before ---| *****************
+	--------------------- between ---|
+
+	We only care how much data are relax between DIFF,
+	marked as ***.  */
+
+      before = get_nds32_elf_blank_index_total (index, hint,
+						irel->r_addend, 0);
+      between = get_nds32_elf_blank_index_total
+	(index, hint, irel->r_addend + offset, 0);
+      if (between == before)
+	goto done_adjust_diff;
+
+      switch (ELF32_R_TYPE (irel->r_info))
+	{
+	case R_NDS32_DIFF8:
+	  bfd_put_8 (abfd, offset - (between - before),
+		     contents + irel->r_offset);
+	  break;
+	case R_NDS32_DIFF16:
+	  bfd_put_16 (abfd, offset - (between - before),
+		      contents + irel->r_offset);
+	  break;
+	case R_NDS32_DIFF32:
+	  bfd_put_32 (abfd, offset - (between - before),
+		      contents + irel->r_offset);
+	  break;
+	}
+    }
+  else if (ELF32_R_SYM (irel->r_info) < symtab_hdr->sh_info
+	   && ELF32_R_TYPE (irel->r_info) == R_NDS32_DIFF_ULEB128
+	   && isym[ELF32_R_SYM (irel->r_info)].st_shndx == sec_shndx)
+    {
+      bfd_vma val = 0;
+      unsigned int len = 0;
+      unsigned long before, between;
+      bfd_byte *endp, *p;
+
+      if (*contents_p == NULL
+	  && !nds32_get_section_contents (abfd, sect, contents_p, TRUE))
+	return FALSE;
+      contents = *contents_p;
+
+      val = _bfd_read_unsigned_leb128 (abfd, contents + irel->r_offset,
+				       &len);
+
+      before = get_nds32_elf_blank_index_total (index, hint,
+						irel->r_addend, 0);
+      between = get_nds32_elf_blank_index_total
+	(index, hint, irel->r_addend + val, 0);
+      if (between == before)
+	goto done_adjust_diff;
+
+      p = contents + irel->r_offset;
+      endp = p + len -1;
+      memset (p, 0x80, len);
+      *(endp) = 0;
+      p = write_uleb128 (p, val - (between - before)) - 1;
+      if (p < endp)
+	*p |= 0x80;
+    }
+done_adjust_diff:
+
+  if (sec == sect)
+    {
+      raddr = irel->r_offset;
+      irel->r_offset -= get_nds32_elf_blank_index_total (index, hint2,
+							 irel->r_offset, 1);
+      blank_t = index->nodes[*hint2];
+
+      if (ELF32_R_TYPE (irel->r_info) == R_NDS32_NONE)
+	return TRUE;
+      if (blank_t->next
+	  && (blank_t->offset > raddr
+	      || blank_t->next->offset <= raddr))
+	_bfd_error_handler
+	  (_("%pB: error: search_nds32_elf_blank reports wrong node"),
+	   abfd);
+
+      /* Mark reloc in deleted portion as NONE.
+	 For some relocs like R_NDS32_LABEL that doesn't modify the
+	 content in the section.  R_NDS32_LABEL doesn't belong to the
+	 instruction in the section, so we should preserve it.  */
+      if (raddr >= blank_t->offset
+	  && raddr < blank_t->offset + blank_t->size
+	  && ELF32_R_TYPE (irel->r_info) != R_NDS32_LABEL
+	  && ELF32_R_TYPE (irel->r_info) != R_NDS32_RELAX_REGION_BEGIN
+	  && ELF32_R_TYPE (irel->r_info) != R_NDS32_RELAX_REGION_END
+	  && ELF32_R_TYPE (irel->r_info) != R_NDS32_RELAX_ENTRY
+	  && ELF32_R_TYPE (irel->r_info) != R_NDS32_SUBTRAHEND
+	  && ELF32_R_TYPE (irel->r_info) != R_NDS32_MINUEND)
+	{
+	  irel->r_info = ELF32_R_INFO (ELF32_R_SYM (irel->r_info),
+				       R_NDS32_NONE);
+	  return TRUE;
+	}
+    }
+
+  if (ELF32_R_TYPE (irel->r_info) == R_NDS32_NONE
+      || ELF32_R_TYPE (irel->r_info) == R_NDS32_LABEL
+      || ELF32_R_TYPE (irel->r_info) == R_NDS32_RELAX_ENTRY)
+    return TRUE;
+
+  if (ELF32_R_SYM (irel->r_info) < symtab_hdr->sh_info
+      && isym[ELF32_R_SYM (irel->r_info)].st_shndx == sec_shndx
+      && ELF_ST_TYPE (isym[ELF32_R_SYM (irel->r_info)].st_info) == STT_SECTION)
+    {
+      if (irel->r_addend <= sec->size)
+	irel->r_addend -=
+	  get_nds32_elf_blank_index_total (index, hint, irel->r_addend, 1);
+    }
+
+  return TRUE;
+}
+
+/* Adjust all the relocs of SECT for deleting the blanks of INDEX from
+   SEC, whose section header index is SEC_SHNDX.  */
+
+static bfd_boolean
+nds32_elf_relax_adjust_relocs (bfd *abfd, asection *sec,
+			       unsigned int sec_shndx, asection *sect,
+			       Elf_Internal_Sym *isym,
+			       const struct nds32_elf_blank_index *index)
+{
+  Elf_Internal_Rela *internal_relocs;
+  Elf_Internal_Rela *irel;
+  Elf_Internal_Rela *irelend;
+  bfd_byte *contents = NULL;
+  size_t hint = 0;
+  size_t hint2 = 0;
+
+  if (!(sect->flags & SEC_RELOC))
+    return TRUE;
+
+  /* Relocations MUST be kept in memory, because relaxation adjust them.  */
+  internal_relocs = _bfd_elf_link_read_relocs (abfd, sect, NULL, NULL,
+					       TRUE /* keep_memory */);
+  if (internal_relocs == NULL)
+    return FALSE;
+
+  irelend = internal_relocs + sect->reloc_count;
+  for (irel = internal_relocs; irel < irelend; irel++)
+    if (!nds32_elf_relax_adjust_reloc (abfd, sec, sec_shndx, sect, irel, isym,
+				       &contents, index, &hint, &hint2))
+      return FALSE;
+
+  return TRUE;
+}
+
 static bfd_boolean
 nds32_elf_relax_delete_blanks (bfd *abfd, asection *sec,
 			       nds32_elf_blank_t *blank_p)
 {
   Elf_Internal_Shdr *symtab_hdr;	/* Symbol table header of this bfd.  */
   Elf_Internal_Sym *isym = NULL;	/* Symbol table of this bfd.  */
-  Elf_Internal_Sym *isymend;		/* Symbol entry iterator.  */
   unsigned int sec_shndx;		/* The section the be relaxed.  */
   bfd_byte *contents;			/* Contents data of iterating section.  */
   Elf_Internal_Rela *internal_relocs;
-  Elf_Internal_Rela *irel;
-  Elf_Internal_Rela *irelend;
   struct elf_link_hash_entry **sym_hashes;
-  struct elf_link_hash_entry **end_hashes;
-  unsigned int symcount;
+  struct nds32_elf_sec_refs *refs;
+  unsigned int count;
+  unsigned int i;
   asection *sect;
   nds32_elf_blank_t *blank_t;
-  nds32_elf_blank_t *blank_t2;
   nds32_elf_blank_t *blank_head;
+  struct nds32_elf_blank_index index;
+  size_t hint, hint2;
 
   blank_head = blank_t = blank_p;
   while (blank_head->prev != NULL)
@@ -9332,204 +9943,96 @@ nds32_elf_relax_delete_blanks (bfd *abfd, asection *sec,
   if (isym == NULL || symtab_hdr->sh_info == 0)
     return FALSE;
 
-  blank_t = blank_head;
   calc_nds32_blank_total (blank_head);
+  if (!build_nds32_elf_blank_index (&index, blank_head))
+    return FALSE;
 
-  for (sect = abfd->sections; sect != NULL; sect = sect->next)
-    {
-      /* Adjust all the relocs.  */
-
-      /* Relocations MUST be kept in memory, because relaxation adjust them.  */
-      internal_relocs = _bfd_elf_link_read_relocs (abfd, sect, NULL, NULL,
-						   TRUE /* keep_memory */);
-      irelend = internal_relocs + sect->reloc_count;
-
-      blank_t = blank_head;
-      blank_t2 = blank_head;
-
-      if (!(sect->flags & SEC_RELOC))
-	continue;
+  if (!nds32_elf_get_sec_refs (abfd, isym, &refs))
+    goto error_return;
 
-      nds32_get_section_contents (abfd, sect, &contents, TRUE);
+  /* Adjust all the relocs of this section.  */
+  if (!nds32_elf_relax_adjust_relocs (abfd, sec, sec_shndx, sec, isym,
+				      &index))
+    goto error_return;
 
-      for (irel = internal_relocs; irel < irelend; irel++)
+  /* And those of the other sections against its local symbols.  */
+  if (refs == NULL)
+    {
+      for (sect = abfd->sections; sect != NULL; sect = sect->next)
+	if (sect != sec
+	    && !nds32_elf_relax_adjust_relocs (abfd, sec, sec_shndx, sect,
+					       isym, &index))
+	  goto error_return;
+    }
+  else
+    {
+      refs += sec_shndx;
+      sect = NULL;
+      internal_relocs = NULL;
+      hint = 0;
+      hint2 = 0;
+      contents = NULL;
+      for (i = 0; i < refs->reloc_count; i++)
 	{
-	  bfd_vma raddr;
-
-	  if (ELF32_R_TYPE (irel->r_info) >= R_NDS32_DIFF8
-	      && ELF32_R_TYPE (irel->r_info) <= R_NDS32_DIFF32
-	      && isym[ELF32_R_SYM (irel->r_info)].st_shndx == sec_shndx)
-	    {
-	      unsigned long val = 0;
-	      unsigned long mask;
-	      long before, between;
-	      long offset = 0;
-
-	      switch (ELF32_R_TYPE (irel->r_info))
-		{
-		case R_NDS32_DIFF8:
-		  offset = bfd_get_8 (abfd, contents + irel->r_offset);
-		  break;
-		case R_NDS32_DIFF16:
-		  offset = bfd_get_16 (abfd, contents + irel->r_offset);
-		  break;
-		case R_NDS32_DIFF32:
-		  val = bfd_get_32 (abfd, contents + irel->r_offset);
-		  /* Get the signed bit and mask for the high part.  The
-		     gcc will alarm when right shift 32-bit since the
-		     type size of long may be 32-bit.  */
-		  mask = 0 - (val >> 31);
-		  if (mask)
-		    offset = (val | (mask - 0xffffffff));
-		  else
-		    offset = val;
-		  break;
-		default:
-		  BFD_ASSERT (0);
-		}
-
-	      /*		  DIFF value
-		0	     |encoded in location|
-		|------------|-------------------|---------
-			    sym+off(addend)
-		-- before ---| *****************
-		--------------------- between ---|
-
-		We only care how much data are relax between DIFF,
-		marked as ***.  */
-
-	      before = get_nds32_elf_blank_total (&blank_t, irel->r_addend, 0);
-	      between = get_nds32_elf_blank_total (&blank_t,
-						   irel->r_addend + offset, 0);
-	      if (between == before)
-		goto done_adjust_diff;
-
-	      switch (ELF32_R_TYPE (irel->r_info))
-		{
-		case R_NDS32_DIFF8:
-		  bfd_put_8 (abfd, offset - (between - before),
-			     contents + irel->r_offset);
-		  break;
-		case R_NDS32_DIFF16:
-		  bfd_put_16 (abfd, offset - (between - before),
-			      contents + irel->r_offset);
-		  break;
-		case R_NDS32_DIFF32:
-		  bfd_put_32 (abfd, offset - (between - before),
-			      contents + irel->r_offset);
-		  break;
-		}
-	    }
-	  else if (ELF32_R_TYPE (irel->r_info) == R_NDS32_DIFF_ULEB128
-	      && isym[ELF32_R_SYM (irel->r_info)].st_shndx == sec_shndx)
-	    {
-	      bfd_vma val = 0;
-	      unsigned int len = 0;
-	      unsigned long before, between;
-	      bfd_byte *endp, *p;
-
-	      val = _bfd_read_unsigned_leb128 (abfd, contents + irel->r_offset,
-					       &len);
-
-	      before = get_nds32_elf_blank_total (&blank_t, irel->r_addend, 0);
-	      between = get_nds32_elf_blank_total (&blank_t,
-						   irel->r_addend + val, 0);
-	      if (between == before)
-		goto done_adjust_diff;
-
-	      p = contents + irel->r_offset;
-	      endp = p + len -1;
-	      memset (p, 0x80, len);
-	      *(endp) = 0;
-	      p = write_uleb128 (p, val - (between - before)) - 1;
-	      if (p < endp)
-		*p |= 0x80;
-	    }
-done_adjust_diff:
-
-	  if (sec == sect)
-	    {
-	      raddr = irel->r_offset;
-	      irel->r_offset -= get_nds32_elf_blank_total (&blank_t2,
-							   irel->r_offset, 1);
-
-	      if (ELF32_R_TYPE (irel->r_info) == R_NDS32_NONE)
-		continue;
-	      if (blank_t2 && blank_t2->next
-		  && (blank_t2->offset > raddr
-		      || blank_t2->next->offset <= raddr))
-		_bfd_error_handler
-		  (_("%pB: error: search_nds32_elf_blank reports wrong node"),
-		   abfd);
-
-	      /* Mark reloc in deleted portion as NONE.
-		 For some relocs like R_NDS32_LABEL that doesn't modify the
-		 content in the section.  R_NDS32_LABEL doesn't belong to the
-		 instruction in the section, so we should preserve it.  */
-	      if (raddr >= blank_t2->offset
-		  && raddr < blank_t2->offset + blank_t2->size
-		  && ELF32_R_TYPE (irel->r_info) != R_NDS32_LABEL
-		  && ELF32_R_TYPE (irel->r_info) != R_NDS32_RELAX_REGION_BEGIN
-		  && ELF32_R_TYPE (irel->r_info) != R_NDS32_RELAX_REGION_END
-		  && ELF32_R_TYPE (irel->r_info) != R_NDS32_RELAX_ENTRY
-		  && ELF32_R_TYPE (irel->r_info) != R_NDS32_SUBTRAHEND
-		  && ELF32_R_TYPE (irel->r_info) != R_NDS32_MINUEND)
-		{
-		  irel->r_info = ELF32_R_INFO (ELF32_R_SYM (irel->r_info),
-					       R_NDS32_NONE);
-		  continue;
-		}
-	    }
-
-	  if (ELF32_R_TYPE (irel->r_info) == R_NDS32_NONE
-	      || ELF32_R_TYPE (irel->r_info) == R_NDS32_LABEL
-	      || ELF32_R_TYPE (irel->r_info) == R_NDS32_RELAX_ENTRY)
+	  if (refs->relocs[i].sec == sec)
 	    continue;
 
-	  if (ELF32_R_SYM (irel->r_info) < symtab_hdr->sh_info
-	      && isym[ELF32_R_SYM (irel->r_info)].st_shndx == sec_shndx
-	      && ELF_ST_TYPE (isym[ELF32_R_SYM (irel->r_info)].st_info) == STT_SECTION)
+	  if (refs->relocs[i].sec != sect)
 	    {
-	      if (irel->r_addend <= sec->size)
-		irel->r_addend -=
-		  get_nds32_elf_blank_total (&blank_t, irel->r_addend, 1);
+	      sect = refs->relocs[i].sec;
+	      internal_relocs = _bfd_elf_link_read_relocs
+		(abfd, sect, NULL, NULL, TRUE /* keep_memory */);
+	      if (internal_relocs == NULL)
+		goto error_return;
+	      hint = 0;
+	      hint2 = 0;
+	      contents = NULL;
 	    }
+
+	  if (!nds32_elf_relax_adjust_reloc
+	      (abfd, sec, sec_shndx, sect,
+	       internal_relocs + refs->relocs[i].index, isym, &contents,
+	       &index, &hint, &hint2))
+	    goto error_return;
 	}
     }
 
   /* Adjust the local symbols defined in this section.  */
-  blank_t = blank_head;
-  for (isymend = isym + symtab_hdr->sh_info; isym < isymend; isym++)
+  count = refs != NULL ? refs->local_count : symtab_hdr->sh_info;
+  hint = 0;
+  for (i = 0; i < count; i++)
     {
-      if (isym->st_shndx == sec_shndx)
+      Elf_Internal_Sym *lsym = isym + (refs != NULL ? refs->local_syms[i] : i);
+
+      if (lsym->st_shndx == sec_shndx
+	  && lsym->st_value <= sec->size)
 	{
-	  if (isym->st_value <= sec->size)
-	    {
-	      bfd_vma ahead;
-	      bfd_vma orig_addr = isym->st_value;
+	  bfd_vma ahead;
+	  bfd_vma orig_addr = lsym->st_value;
 
-	      ahead = get_nds32_elf_blank_total (&blank_t, isym->st_value, 1);
-	      isym->st_value -= ahead;
+	  ahead = get_nds32_elf_blank_index_total (&index, &hint,
+						   lsym->st_value, 1);
+	  lsym->st_value -= ahead;
 
-	      /* Adjust function size.  */
-	      if (ELF32_ST_TYPE (isym->st_info) == STT_FUNC
-		  && isym->st_size > 0)
-		isym->st_size -=
-		  get_nds32_elf_blank_total
-		  (&blank_t, orig_addr + isym->st_size, 0) - ahead;
-	    }
+	  /* Adjust function size.  */
+	  if (ELF32_ST_TYPE (lsym->st_info) == STT_FUNC
+	      && lsym->st_size > 0)
+	    lsym->st_size -=
+	      get_nds32_elf_blank_index_total
+	      (&index, &hint, orig_addr + lsym->st_size, 0) - ahead;
 	}
     }
 
   /* Now adjust the global symbols defined in this section.  */
-  symcount = (symtab_hdr->sh_size / sizeof (Elf32_External_Sym)
-	      - symtab_hdr->sh_info);
+  count = (refs != NULL ? refs->global_count
+	   : (symtab_hdr->sh_size / sizeof (Elf32_External_Sym)
+	      - symtab_hdr->sh_info));
   sym_hashes = elf_sym_hashes (abfd);
-  end_hashes = sym_hashes + symcount;
-  blank_t = blank_head;
-  for (; sym_hashes < end_hashes; sym_hashes++)
+  hint = 0;
+  for (i = 0; i < count; i++)
     {
-      struct elf_link_hash_entry *sym_hash = *sym_hashes;
+      struct elf_link_hash_entry *sym_hash
+	= sym_hashes[refs != NULL ? refs->global_syms[i] : i];
 
       if ((sym_hash->root.type == bfd_link_hash_defined
 	   || sym_hash->root.type == bfd_link_hash_defweak)
@@ -9540,14 +10043,15 @@ done_adjust_diff:
 	      bfd_vma ahead;
 	      bfd_vma orig_addr = sym_hash->root.u.def.value;
 
-	      ahead = get_nds32_elf_blank_total (&blank_t, sym_hash->root.u.def.value, 1);
+	      ahead = get_nds32_elf_blank_index_total
+		(&index, &hint, sym_hash->root.u.def.value, 1);
 	      sym_hash->root.u.def.value -= ahead;
 
 	      /* Adjust function size.  */
 	      if (sym_hash->type == STT_FUNC)
 		sym_hash->size -=
-		  get_nds32_elf_blank_total
-		  (&blank_t, orig_addr + sym_hash->size, 0) - ahead;
+		  get_nds32_elf_blank_index_total
+		  (&index, &hint, orig_addr + sym_hash->size, 0) - ahead;
 
 	    }
 	}
@@ -9585,6 +10089,7 @@ done_adjust_diff:
        reduce the section size by only part of the blank size.  */
     sec->size -= blank_t->total_size + (sec->size - blank_t->offset);
 
+  free (index.nodes);
   while (blank_head)
     {
       blank_t = blank_head;
@@ -9593,6 +10098,10 @@ done_adjust_diff:
     }
 
   return TRUE;
+
+ error_return:
+  free (index.nodes);
+  return FALSE;
 }
 
 /* Get the contents of a section.  */
@@ -12204,6 +12713,15 @@ nds32_relax_adjust_label (bfd *abfd, asection *sec,
   return TRUE;
 }
 
+/* Relax SEC of ABFD.  The generic relaxation loop calls this for each
+   input section in turn, once per pass.  Sections can not be relaxed
+   concurrently: the blank free list, is_SDA_BASE_set and the records
+   of nds32_elf_relax_guard are static; deleting blanks in a section
+   rewrites the relocs and contents of the other sections of ABFD that
+   refer to it, and updates the index of those references kept for
+   ABFD; and BFD's file cache and memory allocation are not
+   thread-safe.  */
+
 static bfd_boolean
 nds32_elf_relax_section (bfd *abfd, asection *sec,
 			 struct bfd_link_info *link_info, bfd_boolean *again)
@@ -12280,6 +12798,15 @@ nds32_elf_relax_section (bfd *abfd, asection *sec,
   if (internal_relocs == NULL)
     goto error_return;
 
+  /* The relaxers look up companion relocations with
+     find_relocs_at_address_addr, which needs them sorted by r_offset.
+     The assembler already emits them sorted, so this is a linear pass,
+     and deleting blanks keeps the order for the next pass.  */
+  nds32_insertion_sort (internal_relocs, sec->reloc_count,
+			sizeof (Elf_Internal_Rela), compar_reloc);
+  if (!nds32_elf_update_sec_refs (abfd, sec))
+    goto error_return;
+
   irelend = internal_relocs + sec->reloc_count;
   irel = find_relocs_at_address (internal_relocs, internal_relocs,
 				 irelend, R_NDS32_RELAX_ENTRY);
@@ -12527,6 +13054,9 @@ nds32_elf_relax_section (bfd *abfd, asection *sec,
        If object file is assembled with flag '-Os',
        the we don't adjust jump-destination on 4-byte boundary.  */
 
+  if (!nds32_elf_update_sec_refs (abfd, sec))
+    goto error_return;
+
   if (relax_blank_list)
     {
       nds32_elf_relax_delete_blanks (abfd, sec, relax_blank_list);
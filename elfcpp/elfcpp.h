@@ -269,6 +269,7 @@ enum EM
   EM_ALTERA_NIOS2 = 113,
   EM_CRX = 114,
   EM_TI_PRU = 144,
+  EM_NDS32 = 167,
   EM_AARCH64 = 183,
   EM_TILEGX = 191,
   // The Morph MT.
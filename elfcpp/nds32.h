@@ -0,0 +1,232 @@
+// nds32.h -- ELF definitions specific to EM_NDS32  -*- C++ -*-
+
+// Copyright (C) 2019 Free Software Foundation, Inc.
+
+// This file is part of elfcpp.
+
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU Library General Public License
+// as published by the Free Software Foundation; either version 2, or
+// (at your option) any later version.
+
+// In addition to the permissions in the GNU Library General Public
+// License, the Free Software Foundation gives you unlimited
+// permission to link the compiled version of this file into
+// combinations with other programs, and to distribute those
+// combinations without any restriction coming from the use of this
+// file.  (The Library Public License restrictions do apply in other
+// respects; for example, they cover modification of the file, and
+// distribution when not linked into a combined executable.)
+
+// This program is distributed in the hope that it will be useful, but
+// WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+// Library General Public License for more details.
+
+// You should have received a copy of the GNU Library General Public
+// License along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston, MA
+// 02110-1301, USA.
+
+#ifndef ELFCPP_NDS32_H
+#define ELFCPP_NDS32_H
+
+namespace elfcpp
+{
+
+// The relocation numbers, see include/elf/nds32.h.
+
+enum
+{
+  // These used for relocations.
+  R_NDS32_NONE = 0,
+  // REL relocations.
+  R_NDS32_16 = 1,
+  R_NDS32_32 = 2,
+  R_NDS32_20 = 3,
+  R_NDS32_9_PCREL = 4,
+  R_NDS32_15_PCREL = 5,
+  R_NDS32_17_PCREL = 6,
+  R_NDS32_25_PCREL = 7,
+  R_NDS32_HI20 = 8,
+  R_NDS32_LO12S3 = 9,
+  R_NDS32_LO12S2 = 10,
+  R_NDS32_LO12S1 = 11,
+  R_NDS32_LO12S0 = 12,
+  R_NDS32_SDA15S3 = 13,
+  R_NDS32_SDA15S2 = 14,
+  R_NDS32_SDA15S1 = 15,
+  R_NDS32_SDA15S0 = 16,
+  R_NDS32_GNU_VTINHERIT = 17,
+  R_NDS32_GNU_VTENTRY = 18,
+  // RELA relocations.
+  R_NDS32_16_RELA = 19,
+  R_NDS32_32_RELA = 20,
+  R_NDS32_20_RELA = 21,
+  R_NDS32_9_PCREL_RELA = 22,
+  R_NDS32_15_PCREL_RELA = 23,
+  R_NDS32_17_PCREL_RELA = 24,
+  R_NDS32_25_PCREL_RELA = 25,
+  R_NDS32_HI20_RELA = 26,
+  R_NDS32_LO12S3_RELA = 27,
+  R_NDS32_LO12S2_RELA = 28,
+  R_NDS32_LO12S1_RELA = 29,
+  R_NDS32_LO12S0_RELA = 30,
+  R_NDS32_SDA15S3_RELA = 31,
+  R_NDS32_SDA15S2_RELA = 32,
+  R_NDS32_SDA15S1_RELA = 33,
+  R_NDS32_SDA15S0_RELA = 34,
+  R_NDS32_RELA_GNU_VTINHERIT = 35,
+  R_NDS32_RELA_GNU_VTENTRY = 36,
+  // GOT and PLT.
+  R_NDS32_GOT20 = 37,
+  R_NDS32_25_PLTREL = 38,
+  R_NDS32_COPY = 39,
+  R_NDS32_GLOB_DAT = 40,
+  R_NDS32_JMP_SLOT = 41,
+  R_NDS32_RELATIVE = 42,
+  R_NDS32_GOTOFF = 43,
+  R_NDS32_GOTPC20 = 44,
+  R_NDS32_GOT_HI20 = 45,
+  R_NDS32_GOT_LO12 = 46,
+  R_NDS32_GOTPC_HI20 = 47,
+  R_NDS32_GOTPC_LO12 = 48,
+  R_NDS32_GOTOFF_HI20 = 49,
+  R_NDS32_GOTOFF_LO12 = 50,
+  // 32_to_16 relaxations.
+  R_NDS32_INSN16 = 51,
+  // Alignment tag.
+  R_NDS32_LABEL = 52,
+  R_NDS32_LONGCALL1 = 53, // Obsolete.
+  R_NDS32_LONGCALL2 = 54, // Obsolete.
+  R_NDS32_LONGCALL3 = 55, // Obsolete.
+  R_NDS32_LONGJUMP1 = 56, // Obsolete.
+  R_NDS32_LONGJUMP2 = 57, // Obsolete.
+  R_NDS32_LONGJUMP3 = 58, // Obsolete.
+  R_NDS32_LOADSTORE = 59, // Obsolete.
+  R_NDS32_9_FIXED_RELA = 60,
+  R_NDS32_15_FIXED_RELA = 61,
+  R_NDS32_17_FIXED_RELA = 62,
+  R_NDS32_25_FIXED_RELA = 63,
+  R_NDS32_PLTREL_HI20 = 64, // Obsolete.
+  R_NDS32_PLTREL_LO12 = 65, // Obsolete.
+  R_NDS32_PLT_GOTREL_HI20 = 66,
+  R_NDS32_PLT_GOTREL_LO12 = 67,
+  R_NDS32_SDA12S2_DP_RELA = 68,
+  R_NDS32_SDA12S2_SP_RELA = 69,
+  R_NDS32_LO12S2_DP_RELA = 70,
+  R_NDS32_LO12S2_SP_RELA = 71,
+  R_NDS32_LO12S0_ORI_RELA = 72,
+  R_NDS32_SDA16S3_RELA = 73,
+  R_NDS32_SDA17S2_RELA = 74,
+  R_NDS32_SDA18S1_RELA = 75,
+  R_NDS32_SDA19S0_RELA = 76,
+  R_NDS32_DWARF2_OP1_RELA = 77, // Obsolete.
+  R_NDS32_DWARF2_OP2_RELA = 78, // Obsolete.
+  R_NDS32_DWARF2_LEB_RELA = 79, // Obsolete.
+  R_NDS32_UPDATE_TA_RELA = 80, // Obsolete.
+  R_NDS32_9_PLTREL = 81,
+  R_NDS32_PLT_GOTREL_LO20 = 82,
+  R_NDS32_PLT_GOTREL_LO15 = 83,
+  R_NDS32_PLT_GOTREL_LO19 = 84,
+  R_NDS32_GOT_LO15 = 85,
+  R_NDS32_GOT_LO19 = 86,
+  R_NDS32_GOTOFF_LO15 = 87,
+  R_NDS32_GOTOFF_LO19 = 88,
+  R_NDS32_GOT15S2_RELA = 89,
+  R_NDS32_GOT17S2_RELA = 90,
+  R_NDS32_5_RELA = 91,
+  R_NDS32_10_UPCREL_RELA = 92, // Obsolete.
+  R_NDS32_SDA_FP7U2_RELA = 93,
+  R_NDS32_WORD_9_PCREL_RELA = 94,
+  R_NDS32_25_ABS_RELA = 95,
+  R_NDS32_17IFC_PCREL_RELA = 96, // Obsolete.
+  R_NDS32_10IFCU_PCREL_RELA = 97, // Obsolete.
+  // TLS support.
+  R_NDS32_TLS_LE_HI20 = 98,
+  R_NDS32_TLS_LE_LO12 = 99,
+  R_NDS32_TLS_IE_HI20 = 100,
+  R_NDS32_TLS_IE_LO12S2 = 101,
+  R_NDS32_TLS_TPOFF = 102,
+  R_NDS32_TLS_LE_20 = 103,
+  R_NDS32_TLS_LE_15S0 = 104,
+  R_NDS32_TLS_LE_15S1 = 105,
+  R_NDS32_TLS_LE_15S2 = 106,
+  R_NDS32_LONGCALL4 = 107,
+  R_NDS32_LONGCALL5 = 108,
+  R_NDS32_LONGCALL6 = 109,
+  R_NDS32_LONGJUMP4 = 110,
+  R_NDS32_LONGJUMP5 = 111,
+  R_NDS32_LONGJUMP6 = 112,
+  R_NDS32_LONGJUMP7 = 113,
+  // Reserved numbers: 114.
+  // TLS support
+  R_NDS32_TLS_IE_LO12 = 115,
+  R_NDS32_TLS_IEGP_HI20 = 116,
+  R_NDS32_TLS_IEGP_LO12 = 117,
+  R_NDS32_TLS_IEGP_LO12S2 = 118,
+  R_NDS32_TLS_DESC = 119,
+  R_NDS32_TLS_DESC_HI20 = 120,
+  R_NDS32_TLS_DESC_LO12 = 121,
+  R_NDS32_TLS_DESC_20 = 122,
+  R_NDS32_TLS_DESC_SDA17S2 = 123,
+  // Reserved numbers: 124-191.
+
+  // These used only for relaxations
+  R_NDS32_RELAX_ENTRY = 192,
+  R_NDS32_GOT_SUFF = 193,
+  R_NDS32_GOTOFF_SUFF = 194,
+  R_NDS32_PLT_GOT_SUFF = 195,
+  R_NDS32_MULCALL_SUFF = 196, // Obsolete.
+  R_NDS32_PTR = 197,
+  R_NDS32_PTR_COUNT = 198,
+  R_NDS32_PTR_RESOLVED = 199,
+  R_NDS32_PLTBLOCK = 200, // Obsolete.
+  R_NDS32_RELAX_REGION_BEGIN = 201,
+  R_NDS32_RELAX_REGION_END = 202,
+  R_NDS32_MINUEND = 203,
+  R_NDS32_SUBTRAHEND = 204,
+  R_NDS32_DIFF8 = 205,
+  R_NDS32_DIFF16 = 206,
+  R_NDS32_DIFF32 = 207,
+  R_NDS32_DIFF_ULEB128 = 208,
+  R_NDS32_DATA = 209,
+  R_NDS32_TRAN = 210,
+  // TLS support
+  R_NDS32_TLS_LE_ADD = 211,
+  R_NDS32_TLS_LE_LS = 212,
+  R_NDS32_EMPTY = 213,
+  R_NDS32_TLS_DESC_ADD = 214,
+  R_NDS32_TLS_DESC_FUNC = 215,
+  R_NDS32_TLS_DESC_CALL = 216,
+  R_NDS32_TLS_DESC_MEM = 217,
+  R_NDS32_RELAX_REMOVE = 218,
+  R_NDS32_RELAX_GROUP = 219,
+  R_NDS32_TLS_IEGP_LW = 220,
+  R_NDS32_LSI = 221,
+  // Reserved numbers: 222-255.
+};
+
+// e_flags values.
+
+enum
+{
+  // Architecture, bits 31-28.
+  EF_NDS_ARCH = 0xf0000000,
+  // Instruction set extensions, bits 27-8.
+  EF_NDS_INST = 0x0fffff00,
+  // Reduced register file.
+  E_NDS32_HAS_REDUCED_REGS = 0x00010000,
+  // No MAC instruction used.
+  E_NDS32_HAS_NO_MAC_INST = 0x00100000,
+  // FPU register configuration.
+  E_NDS32_FPU_REG_CONF = 0x00c00000,
+  // ABI, bits 7-4.
+  EF_NDS_ABI = 0x000000f0,
+  // Andes ELF version, bits 3-0.
+  EF_NDS32_ELF_VERSION = 0x0000000f
+};
+
+} // End namespace elfcpp.
+
+#endif // !defined(ELFCPP_NDS32_H)
@@ -2311,7 +2311,8 @@ enum options
   OPTION_RELAX_B2BB_ON,
   OPTION_RELAX_ALL_OFF,
   OPTION_OPTIMIZE,
-  OPTION_OPTIMIZE_SPACE
+  OPTION_OPTIMIZE_SPACE,
+  OPTION_RELAX_STATS
 };
 
 const char *md_shortopts = "m:O:";
@@ -2332,6 +2333,7 @@ struct option md_longopts[] =
   {"mno-fp-as-gp-relax", no_argument, NULL, OPTION_RELAX_FP_AS_GP_OFF},
   {"mb2bb", no_argument, NULL, OPTION_RELAX_B2BB_ON},
   {"mno-all-relax", no_argument, NULL, OPTION_RELAX_ALL_OFF},
+  {"mrelax-stats", no_argument, NULL, OPTION_RELAX_STATS},
   {NULL, no_argument, NULL, 0}
 };
 
@@ -2405,6 +2407,7 @@ static int nds32_pic = 0;
 static int nds32_relax_fp_as_gp = 1;
 static int nds32_relax_b2bb = 0;
 static int nds32_relax_all = 1;
+static int nds32_relax_stats = 0;
 struct nds32_set_option_table
 {
   const char *name;		/* Option string.  */
@@ -2478,7 +2481,8 @@ md_show_usage (FILE *stream)
   -mpic			  Generate PIC\n\
   -mno-fp-as-gp-relax	  Suppress fp-as-gp relaxation for this file\n\
   -mb2bb-relax		  Back-to-back branch optimization\n\
-  -mno-all-relax	  Suppress all relaxation for this file\n"));
+  -mno-all-relax	  Suppress all relaxation for this file\n\
+  -mrelax-stats		  Report relaxation passes and times\n"));
 
   for (coarse_tune = parse_opts; coarse_tune->name != NULL; coarse_tune++)
     {
@@ -2503,6 +2507,7 @@ nds32_frag_init (fragS *fragp)
 {
   fragp->tc_frag_data.flag = 0;
   fragp->tc_frag_data.opcode = NULL;
+  fragp->tc_frag_data.relax_info = NULL;
   fragp->tc_frag_data.fixup = NULL;
 }
 
@@ -3695,6 +3700,9 @@ nds32_parse_option (int c, const char *arg)
     case OPTION_RELAX_ALL_OFF:
       nds32_relax_all = 0;
       break;
+    case OPTION_RELAX_STATS:
+      nds32_relax_stats = 1;
+      break;
     default:
       /* Determination of which option table to search for to save time.  */
       if (!arg)
@@ -6629,7 +6637,7 @@ md_undefined_symbol (char *name ATTRIBUTE_UNUSED)
 
 static long
 nds32_calc_branch_offset (segT segment, fragS *fragP,
-			  long stretch ATTRIBUTE_UNUSED,
+			  long stretch,
 			  relax_info_t *relax_info,
 			  enum nds32_br_range branch_range_type)
 {
@@ -6638,6 +6646,7 @@ nds32_calc_branch_offset (segT segment, fragS *fragP,
   offsetT branch_offset = fragP->fr_offset;
   offsetT branch_target_address;
   offsetT branch_insn_address;
+  fragS *sym_frag;
   long offset = 0;
 
   if ((S_GET_SEGMENT (branch_symbol) != segment)
@@ -6650,12 +6659,21 @@ nds32_calc_branch_offset (segT segment, fragS *fragP,
     {
       /* Calculate symbol-to-instruction offset.  */
       branch_target_address = S_GET_VALUE (branch_symbol) + branch_offset;
-      /* If the destination symbol is beyond current frag address,
-	 STRETCH will take effect to symbol's position.  */
-      if (S_GET_VALUE (branch_symbol) > fragP->fr_address)
-	branch_target_address += stretch;
-
       branch_insn_address = fragP->fr_address + fragP->fr_fix;
+
+      /* If the destination frag has yet to be reached on this pass, it
+	 will move by STRETCH just as we did, unless an alignment frag in
+	 between absorbs it.  Same as relax_frag, the relax marker tells
+	 the two apart, which a comparison of addresses can not do once
+	 frags in between have changed size.  */
+      sym_frag = symbol_get_frag (branch_symbol);
+      if (stretch != 0 && sym_frag->relax_marker != fragP->relax_marker)
+	{
+	  if (stretch < 0 || sym_frag->region == fragP->region)
+	    branch_target_address += stretch;
+	  else if (branch_target_address < branch_insn_address)
+	    branch_target_address = fragP->fr_next->fr_address + stretch;
+	}
       branch_insn_address -= opcode->isize;
 
       /* Update BRANCH_INSN_ADDRESS to relaxed position.  */
@@ -6714,9 +6732,22 @@ nds32_elf_get_set_cond (relax_info_t *relax_info, int offset, uint32_t *insn,
     }
 }
 
+/* Return the branch pattern for the opcode of FRAGP.  The result is
+   cached in the frag so that relaxation passes do not repeat the
+   hash lookup for every branch.  */
+
+static relax_info_t *
+nds32_frag_relax_info (fragS *fragP)
+{
+  if (fragP->tc_frag_data.relax_info == NULL)
+    fragP->tc_frag_data.relax_info =
+      hash_find (nds32_relax_info_hash, fragP->tc_frag_data.opcode->opcode);
+  return fragP->tc_frag_data.relax_info;
+}
+
 static int
 nds32_relax_branch_instructions (segT segment, fragS *fragP,
-				 long stretch ATTRIBUTE_UNUSED,
+				 long stretch,
 				 int init)
 {
   enum nds32_br_range branch_range_type;
@@ -6726,12 +6757,7 @@ nds32_relax_branch_instructions (segT segment, fragS *fragP,
   int adjust = 0;
   relax_info_t *relax_info;
   int diff = 0;
-  int i, j, k;
-  int code_seq_size;
-  uint32_t *code_seq;
-  uint32_t insn;
-  int insn_size;
-  int code_seq_offset;
+  int i;
 
   /* Replace with gas_assert (fragP->fr_symbol != NULL); */
   if (fragP->fr_symbol == NULL)
@@ -6757,7 +6783,7 @@ nds32_relax_branch_instructions (segT segment, fragS *fragP,
 	return 0;
     }
 
-  relax_info = hash_find (nds32_relax_info_hash, opcode->opcode);
+  relax_info = nds32_frag_relax_info (fragP);
 
   if (relax_info == NULL)
     return adjust;
@@ -6799,33 +6825,6 @@ nds32_relax_branch_instructions (segT segment, fragS *fragP,
 	    diff = relax_info->relax_code_size[i]
 	      - relax_info->relax_code_size[branch_range_type];
 
-	  /* If the instruction could be converted to 16-bits,
-	     minus the difference.  */
-	  code_seq_offset = 0;
-	  j = 0;
-	  k = 0;
-	  code_seq_size = relax_info->relax_code_size[i];
-	  code_seq = relax_info->relax_code_seq[i];
-	  while (code_seq_offset < code_seq_size)
-	    {
-	      insn = code_seq[j];
-	      if (insn & 0x80000000) /* 16-bits instruction.  */
-		{
-		  insn_size = 2;
-		}
-	      else /* 32-bits instruction.  */
-		{
-		  insn_size = 4;
-
-		  while (relax_info->relax_fixup[i][k].size !=0
-			 && relax_info->relax_fixup[i][k].offset < code_seq_offset)
-		    k++;
-		}
-
-	      code_seq_offset += insn_size;
-	      j++;
-	    }
-
 	  /* Update fr_subtype to new NDS32_BR_RANGE.  */
 	  fragP->fr_subtype = real_range_type;
 	  break;
@@ -6871,21 +6870,19 @@ nds32_get_align (addressT address, int align)
   return (new_address - address);
 }
 
-/* Check the prev_frag is legal.  */
-static void
+/* Check the prev_frag is legal.  Return the number of bytes FRAGP has
+   moved when the previous relaxable frag is restored to 32 bits to align
+   it, so that the caller can pass the move on to the frags behind it in
+   the same pass instead of leaving it to the next relax_segment round.  */
+static int
 invalid_prev_frag (fragS * fragP, fragS **prev_frag, bfd_boolean relax)
 {
   addressT address;
   fragS *frag_start = *prev_frag;
+  int adj = 0;
 
   if (!frag_start || !relax)
-    return;
-
-  if (frag_start->last_fr_address >= fragP->last_fr_address)
-    {
-      *prev_frag = NULL;
-      return;
-    }
+    return 0;
 
   fragS *frag_t = *prev_frag;
   while (frag_t != fragP)
@@ -6898,7 +6895,7 @@ invalid_prev_frag (fragS * fragP, fragS **prev_frag, bfd_boolean relax)
 	  if (frag_t->tc_frag_data.flag & NDS32_FRAG_LABEL)
 	    {
 	      prev_frag = NULL;
-	      return;
+	      return 0;
 	    }
 	  /* Relax previous relaxable to align rs_align frag.  */
 	  address = frag_t->fr_address + frag_t->fr_fix;
@@ -6911,8 +6908,9 @@ invalid_prev_frag (fragS * fragP, fragS **prev_frag, bfd_boolean relax)
 		      & 0x2) == 0)
 		nds32_adjust_relaxable_frag (*prev_frag, frag_t);
 	    }
+	  /* The alignment absorbs the move, FRAGP stays in place.  */
 	  *prev_frag = NULL;
-	  return;
+	  return 0;
 	}
       frag_t = frag_t->fr_next;
     }
@@ -6927,37 +6925,167 @@ invalid_prev_frag (fragS * fragP, fragS **prev_frag, bfd_boolean relax)
 	  if (!((*prev_frag)->tc_frag_data.flag & NDS32_FRAG_LABEL)
 	      || (((*prev_frag)->fr_address + (*prev_frag)->fr_fix  - 2 )
 		  & 0x2) == 0)
-	    nds32_adjust_relaxable_frag (*prev_frag, fragP);
+	    adj = nds32_adjust_relaxable_frag (*prev_frag, fragP);
 	}
       *prev_frag = NULL;
-      return;
     }
+
+  return adj;
+}
+
+/* The last relaxable frag seen in the current relaxation pass.  */
+static fragS *relax_prev_frag = NULL;
+
+/* Relaxation statistics for -mrelax-stats.  One record is kept per
+   relax_segment pass over a section; pass 0 is the initial size
+   estimate done by md_estimate_size_before_relax.  */
+
+struct nds32_relax_pass_stat
+{
+  segT seg;
+  int round;
+  int pass;
+  /* Branch frags examined and branch frags that changed size.  */
+  unsigned long branches;
+  unsigned long resized;
+  /* Run time of the pass in microseconds.  */
+  long run_time;
+  struct nds32_relax_pass_stat *next;
+};
+
+static struct nds32_relax_pass_stat *relax_stats_head;
+static struct nds32_relax_pass_stat *relax_stats_tail;
+static long relax_stats_start;
+
+/* Close the pass in progress, if any.  */
+
+static void
+nds32_relax_stats_close (void)
+{
+  if (relax_stats_tail != NULL && relax_stats_start != 0)
+    relax_stats_tail->run_time += get_run_time () - relax_stats_start;
+  relax_stats_start = 0;
+}
+
+/* Return the record for the pass over SEG that FRAGP is visited by,
+   opening a new one when a new pass starts.  ESTIMATE is nonzero when
+   called from md_estimate_size_before_relax.  */
+
+static struct nds32_relax_pass_stat *
+nds32_relax_stats_pass (segT seg, fragS *fragP, int estimate)
+{
+  static int marker;
+  struct nds32_relax_pass_stat *stat = relax_stats_tail;
+  struct nds32_relax_pass_stat *prev;
+
+  /* relax_segment resets every relax_marker before the estimate and
+     flips them all at the start of each pass.  */
+  if (stat != NULL && stat->seg == seg
+      && (estimate ? stat->pass == 0 : (stat->pass != 0
+					&& fragP->relax_marker == marker)))
+    return stat;
+
+  nds32_relax_stats_close ();
+
+  stat = XCNEW (struct nds32_relax_pass_stat);
+  stat->seg = seg;
+  if (estimate)
+    {
+      stat->round = 1;
+      for (prev = relax_stats_head; prev != NULL; prev = prev->next)
+	if (prev->seg == seg)
+	  stat->round = prev->round + 1;
+    }
+  else
+    {
+      stat->round = relax_stats_tail->round;
+      stat->pass = relax_stats_tail->pass + 1;
+    }
+  marker = fragP->relax_marker;
+
+  if (relax_stats_tail != NULL)
+    relax_stats_tail->next = stat;
+  else
+    relax_stats_head = stat;
+  relax_stats_tail = stat;
+  relax_stats_start = get_run_time ();
+  return stat;
+}
+
+/* Print and release the records collected for -mrelax-stats.  */
+
+static void
+nds32_relax_stats_report (void)
+{
+  struct nds32_relax_pass_stat *stat, *next;
+  unsigned long passes = 0;
+  long run_time = 0;
+
+  nds32_relax_stats_close ();
+  for (stat = relax_stats_head; stat != NULL; stat = next)
+    {
+      next = stat->next;
+      fprintf (stderr, _("relax %s round %d pass %d: %lu branches, "
+			 "%lu resized, %ld.%06ld sec\n"),
+	       segment_name (stat->seg), stat->round, stat->pass,
+	       stat->branches, stat->resized,
+	       stat->run_time / 1000000, stat->run_time % 1000000);
+      if (stat->pass != 0)
+	passes++;
+      run_time += stat->run_time;
+      free (stat);
+    }
+  fprintf (stderr, _("relax total: %lu passes, %ld.%06ld sec\n"),
+	   passes, run_time / 1000000, run_time % 1000000);
+  relax_stats_head = relax_stats_tail = NULL;
 }
 
 /* md_relax_frag  */
 
 int
-nds32_relax_frag (segT segment, fragS *fragP, long stretch ATTRIBUTE_UNUSED)
+nds32_relax_frag (segT segment, fragS *fragP, long stretch)
 {
   /* Currently, there are two kinds of relaxation in nds32 assembler.
      1. relax for branch
      2. relax for 32-bits to 16-bits  */
 
-  static fragS *prev_frag = NULL;
+  static int marker;
   int adjust = 0;
+  int diff;
+
+  /* relax_segment flips every relax_marker at the start of a pass, do not
+     carry the previous relaxable frag over into the next one.  */
+  if (fragP->relax_marker != marker)
+    {
+      marker = fragP->relax_marker;
+      relax_prev_frag = NULL;
+    }
 
-  invalid_prev_frag (fragP, &prev_frag, TRUE);
+  adjust = invalid_prev_frag (fragP, &relax_prev_frag, TRUE);
 
   if (fragP->tc_frag_data.flag & NDS32_FRAG_BRANCH)
-    adjust = nds32_relax_branch_instructions (segment, fragP, stretch, 0);
+    {
+      diff = nds32_relax_branch_instructions (segment, fragP,
+					      stretch + adjust, 0);
+      adjust += diff;
+      if (nds32_relax_stats)
+	{
+	  struct nds32_relax_pass_stat *stat;
+
+	  stat = nds32_relax_stats_pass (segment, fragP, 0);
+	  stat->branches++;
+	  if (diff != 0)
+	    stat->resized++;
+	}
+    }
   if (fragP->tc_frag_data.flag & NDS32_FRAG_LABEL)
-    prev_frag = NULL;
+    relax_prev_frag = NULL;
   if (fragP->tc_frag_data.flag & NDS32_FRAG_RELAXABLE
       && (fragP->tc_frag_data.flag & NDS32_FRAG_RELAXED) == 0)
     /* Here is considered relaxed case originally.  But it may cause
        an endless loop when relaxing.  Once the instruction is relaxed,
        it can not be undone.  */
-    prev_frag = fragP;
+    relax_prev_frag = fragP;
 
   return adjust;
 }
@@ -6984,9 +7112,22 @@ md_estimate_size_before_relax (fragS *fragP, segT segment)
   int adjust = 0;
 
   invalid_prev_frag (fragP, &prev_frag, FALSE);
+  /* A new relax_segment round starts over.  */
+  relax_prev_frag = NULL;
 
   if (fragP->tc_frag_data.flag & NDS32_FRAG_BRANCH)
-    adjust = nds32_relax_branch_instructions (segment, fragP, 0, 1);
+    {
+      adjust = nds32_relax_branch_instructions (segment, fragP, 0, 1);
+      if (nds32_relax_stats)
+	{
+	  struct nds32_relax_pass_stat *stat;
+
+	  stat = nds32_relax_stats_pass (segment, fragP, 1);
+	  stat->branches++;
+	  if (adjust != 0)
+	    stat->resized++;
+	}
+    }
   if (fragP->tc_frag_data.flag & NDS32_FRAG_LABEL)
     prev_frag = NULL;
   if (fragP->tc_frag_data.flag & NDS32_FRAG_RELAXED)
@@ -7046,7 +7187,7 @@ md_convert_frag (bfd *abfd ATTRIBUTE_UNUSED, segT sec, fragS *fragP)
 
   if (fragP->tc_frag_data.flag & NDS32_FRAG_RELAXABLE_BRANCH)
     {
-      relax_info = hash_find (nds32_relax_info_hash, opcode->opcode);
+      relax_info = nds32_frag_relax_info (fragP);
 
       if (relax_info == NULL)
 	return;
@@ -7106,7 +7247,7 @@ md_convert_frag (bfd *abfd ATTRIBUTE_UNUSED, segT sec, fragS *fragP)
   else if (fragP->tc_frag_data.flag & NDS32_FRAG_BRANCH)
     {
       /* Branch instruction adjust and append relocations.  */
-      relax_info = hash_find (nds32_relax_info_hash, opcode->opcode);
+      relax_info = nds32_frag_relax_info (fragP);
 
       if (relax_info == NULL)
 	return;
@@ -7545,7 +7686,10 @@ nds32_allow_local_subtract (expressionS *expr_l ATTRIBUTE_UNUSED,
    their relative order.  For example, RELAX_ENTRY must be the very first
    relocation entry.
 
-   Currently, this function implements insertion-sort.  */
+   The fixups md_convert_frag creates are appended to the end of the
+   chain, so the relocations can be far out of order and an insertion
+   sort of them is quadratic.  nds32_sort_relent is a bottom-up merge
+   sort instead.  */
 
 static int
 compar_relent (const void *lhs, const void *rhs)
@@ -7561,6 +7705,47 @@ compar_relent (const void *lhs, const void *rhs)
     return -1;
 }
 
+static void
+nds32_sort_relent (arelent **relocs, unsigned int n)
+{
+  arelent **tmp, **src, **dst, **swap;
+  unsigned int width, lo, mid, hi, l, r, k;
+
+  if (n < 2)
+    return;
+
+  src = relocs;
+  dst = tmp = XNEWVEC (arelent *, n);
+  for (width = 1; width < n; width *= 2)
+    {
+      for (lo = 0; lo < n; lo = hi)
+	{
+	  mid = n - lo > width ? lo + width : n;
+	  hi = n - mid > width ? mid + width : n;
+	  l = lo;
+	  r = mid;
+	  k = lo;
+	  /* The left run wins ties, which keeps the sort stable.  */
+	  while (l < mid && r < hi)
+	    if (compar_relent (&src[r], &src[l]) < 0)
+	      dst[k++] = src[r++];
+	    else
+	      dst[k++] = src[l++];
+	  while (l < mid)
+	    dst[k++] = src[l++];
+	  while (r < hi)
+	    dst[k++] = src[r++];
+	}
+      swap = src;
+      src = dst;
+      dst = swap;
+    }
+
+  if (src != relocs)
+    memcpy (relocs, src, n * sizeof (arelent *));
+  free (tmp);
+}
+
 /* SET_SECTION_RELOCS ()
 
    Although this macro is originally used to set a relocation for each section,
@@ -7573,8 +7758,7 @@ nds32_set_section_relocs (asection *sec, arelent ** relocs ATTRIBUTE_UNUSED,
 {
   bfd *abfd ATTRIBUTE_UNUSED = sec->owner;
   if (bfd_get_section_flags (abfd, sec) & (flagword) SEC_RELOC)
-    nds32_insertion_sort (sec->orelocation, sec->reloc_count,
-			  sizeof (arelent**), compar_relent);
+    nds32_sort_relent (sec->orelocation, sec->reloc_count);
 }
 
 long
@@ -7590,12 +7774,55 @@ nds32_pcrel_from_section (fixS *fixP, segT sec ATTRIBUTE_UNUSED)
   return fixP->fx_frag->fr_address + fixP->fx_where;
 }
 
+/* Lay out the frags of SEC with every relaxable instruction in its
+   shortest form.  Before the first relax_segment round no frag has an
+   address yet, so md_estimate_size_before_relax would see every forward
+   branch target at address zero and pick a long branch that the next
+   passes have to shrink back.  */
+
+static void
+nds32_seed_frag_address (bfd *abfd ATTRIBUTE_UNUSED, asection *sec,
+			 void *xxx ATTRIBUTE_UNUSED)
+{
+  segment_info_type *seginfo = seg_info (sec);
+  frchainS *frchainP;
+  fragS *fragP;
+  addressT address = 0;
+
+  if (seginfo == NULL)
+    return;
+
+  for (frchainP = seginfo->frchainP; frchainP != NULL;
+       frchainP = frchainP->frch_next)
+    for (fragP = frchainP->frch_root; fragP != NULL; fragP = fragP->fr_next)
+      {
+	fragP->fr_address = address;
+	address += fragP->fr_fix;
+	if (fragP->fr_type == rs_fill)
+	  address += fragP->fr_offset * fragP->fr_var;
+	else if (fragP->fr_type == rs_align
+		 || fragP->fr_type == rs_align_code)
+	  address += nds32_get_align (address, (int) fragP->fr_offset);
+      }
+}
+
+/* md_pre_relax_hook ()
+   Seed the frag addresses of every section.  */
+
+void
+nds32_pre_relax_hook (void)
+{
+  bfd_map_over_sections (stdoutput, nds32_seed_frag_address, NULL);
+}
+
 /* md_post_relax_hook ()
    Insert relax entry relocation into sections.  */
 
 void
 nds32_post_relax_hook (void)
 {
+  if (nds32_relax_stats)
+    nds32_relax_stats_report ();
   bfd_map_over_sections (stdoutput, nds32_insert_relax_entry, NULL);
 }
 
@@ -83,6 +83,7 @@ extern bfd_boolean nds32_allow_local_subtract (expressionS *, expressionS *, seg
 extern long nds32_pcrel_from_section (struct fix *, segT);
 extern bfd_boolean nds32_fix_adjustable (struct fix *);
 extern void nds32_frob_file (void);
+extern void nds32_pre_relax_hook (void);
 extern void nds32_post_relax_hook (void);
 extern void nds32_frob_file_before_fix (void);
 extern void elf_nds32_final_processing (void);
@@ -100,6 +101,7 @@ extern void tc_nds32_frame_initial_instructions (void);
 #define TC_FINALIZE_SYMS_BEFORE_SIZE_SEG	0
 #define tc_fix_adjustable(FIX)			nds32_fix_adjustable (FIX)
 #define md_apply_fix(fixP, addn, seg)		nds32_apply_fix (fixP, addn, seg)
+#define md_pre_relax_hook			nds32_pre_relax_hook ()
 #define md_post_relax_hook			nds32_post_relax_hook ()
 #define tc_frob_file_before_fix()		nds32_frob_file_before_fix ()
 #define elf_tc_final_processing()		elf_nds32_final_processing ()
@@ -183,6 +185,8 @@ struct nds32_frag_type
 {
   relax_substateT flag;
   struct nds32_opcode *opcode;
+  /* Branch pattern of OPCODE, looked up once at estimate time.  */
+  struct nds32_relax_info *relax_info;
   uint32_t insn;
   /* To Save previous label fixup if existence.  */
   struct fix *fixup;
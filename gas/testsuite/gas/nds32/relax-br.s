@@ -0,0 +1,10 @@
+back:
+	beqz $r0, near
+	bnez $r1, far
+	beqz38 $r2, back
+near:
+	bgez $r3, back
+	.skip 0x10000
+	bltz $r4, back
+far:
+	bnez $r5, near
@@ -0,0 +1,155 @@
+/* Compression of remote protocol packets for GDB, the GNU debugger.
+
+   Copyright (C) 2019 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include "common-defs.h"
+#include "rsp-compress.h"
+#include "rsp-low.h"
+
+/* The bytes a sync flush ends with, which are not sent.  */
+
+static const gdb_byte sync_flush_tail[] = { 0x00, 0x00, 0xff, 0xff };
+
+/* Deflate favors speed: on a fast link, the time spent compressing
+   must not exceed the time saved sending, and the hex data most
+   packets carry compresses well even at the lowest level.  */
+
+#define RSP_COMPRESSION_LEVEL Z_BEST_SPEED
+
+rsp_deflater::rsp_deflater ()
+{
+  memset (&m_stream, 0, sizeof (m_stream));
+
+  /* A raw stream: the zlib header and checksum are of no use inside
+     checksummed packets.  */
+  if (deflateInit2 (&m_stream, RSP_COMPRESSION_LEVEL, Z_DEFLATED,
+		    -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    error (_("Cannot initialize remote protocol compression"));
+}
+
+rsp_deflater::~rsp_deflater ()
+{
+  deflateEnd (&m_stream);
+}
+
+/* See rsp-compress.h.  */
+
+std::string
+rsp_deflater::compress (const char *buf, int len)
+{
+  /* zlib refuses a flush with nothing to flush.  An empty payload is
+     sent as is.  */
+  if (len == 0)
+    return std::string ();
+
+  gdb::byte_vector z (len + len / 8 + 64);
+  size_t used = 0;
+
+  m_stream.next_in = (Bytef *) buf;
+  m_stream.avail_in = len;
+  while (1)
+    {
+      m_stream.next_out = z.data () + used;
+      m_stream.avail_out = z.size () - used;
+
+      int ret = deflate (&m_stream, Z_SYNC_FLUSH);
+      gdb_assert (ret == Z_OK);
+
+      used = z.size () - m_stream.avail_out;
+      if (m_stream.avail_out != 0)
+	break;
+      z.resize (z.size () * 2);
+    }
+
+  gdb_assert (used >= sizeof (sync_flush_tail)
+	      && memcmp (z.data () + used - sizeof (sync_flush_tail),
+			 sync_flush_tail, sizeof (sync_flush_tail)) == 0);
+  used -= sizeof (sync_flush_tail);
+
+  /* At worst, every byte needs escaping.  */
+  std::string out (2 * used, '\0');
+  int escaped_units;
+  int out_len = remote_escape_output (z.data (), used, 1,
+				      (gdb_byte *) &out[0], &escaped_units,
+				      out.size ());
+
+  gdb_assert ((size_t) escaped_units == used);
+  out.resize (out_len);
+  return out;
+}
+
+rsp_inflater::rsp_inflater ()
+{
+  memset (&m_stream, 0, sizeof (m_stream));
+
+  if (inflateInit2 (&m_stream, -MAX_WBITS) != Z_OK)
+    error (_("Cannot initialize remote protocol compression"));
+}
+
+rsp_inflater::~rsp_inflater ()
+{
+  inflateEnd (&m_stream);
+}
+
+/* See rsp-compress.h.  */
+
+bool
+rsp_inflater::decompress (const char *buf, int len, std::string *out)
+{
+  out->clear ();
+  if (len == 0)
+    return true;
+
+  gdb::byte_vector z (len + sizeof (sync_flush_tail));
+  int z_len = remote_unescape_input ((const gdb_byte *) buf, len,
+				     z.data (), len);
+
+  memcpy (z.data () + z_len, sync_flush_tail, sizeof (sync_flush_tail));
+  z_len += sizeof (sync_flush_tail);
+
+  /* Hex data typically shrinks to less than a third.  */
+  size_t used = 0;
+
+  out->resize (4 * z_len);
+  m_stream.next_in = z.data ();
+  m_stream.avail_in = z_len;
+  while (1)
+    {
+      m_stream.next_out = (Bytef *) &(*out)[used];
+      m_stream.avail_out = out->size () - used;
+
+      int ret = inflate (&m_stream, Z_SYNC_FLUSH);
+
+      /* Z_BUF_ERROR only means there was nothing left to do.  */
+      if (ret != Z_OK && ret != Z_BUF_ERROR)
+	return false;
+
+      used = out->size () - m_stream.avail_out;
+      if (m_stream.avail_out != 0)
+	break;
+      out->resize (out->size () * 2);
+    }
+
+  /* Everything received must have been consumed, or the stream has
+     lost sync.  */
+  if (m_stream.avail_in != 0)
+    return false;
+
+  out->resize (used);
+  return true;
+}
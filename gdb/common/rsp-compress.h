@@ -0,0 +1,78 @@
+/* Compression of remote protocol packets for GDB, the GNU debugger.
+
+   Copyright (C) 2019 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifndef COMMON_RSP_COMPRESS_H
+#define COMMON_RSP_COMPRESS_H
+
+#include <zlib.h>
+
+/* Once GDB and the stub agree to it with the QStartCompression
+   packet, each direction of the connection carries a single deflate
+   stream.  The payload of every packet, notifications included, is
+   the next piece of that stream, ended by a sync flush so that it can
+   be decompressed as soon as it is received, and escaped like binary
+   data.  The four bytes (00 00 ff ff) every sync flush ends with are
+   left out, and put back by the receiver.  Packet framing, checksums,
+   acknowledgments and interrupts are not compressed.
+
+   Since the stream carries history from packet to packet, each packet
+   must be decompressed exactly once, and in the order it was sent.
+   With acknowledgments, that can't be guaranteed: either side resends
+   a packet whose acknowledgment is late, not only one that arrived
+   corrupted, and the receiver can't tell the copy from a new packet.
+   Compression is therefore only started in noack mode.  */
+
+/* The sending side of a compressed connection.  */
+
+class rsp_deflater
+{
+public:
+  rsp_deflater ();
+  ~rsp_deflater ();
+
+  DISABLE_COPY_AND_ASSIGN (rsp_deflater);
+
+  /* Compress the LEN bytes at BUF, the payload of the next packet
+     sent, and return the escaped result.  */
+  std::string compress (const char *buf, int len);
+
+private:
+  z_stream m_stream;
+};
+
+/* The receiving side of a compressed connection.  */
+
+class rsp_inflater
+{
+public:
+  rsp_inflater ();
+  ~rsp_inflater ();
+
+  DISABLE_COPY_AND_ASSIGN (rsp_inflater);
+
+  /* Decompress the LEN escaped bytes at BUF, the payload of the next
+     packet received, into *OUT.  Return false if the data is
+     corrupt.  */
+  bool decompress (const char *buf, int len, std::string *out);
+
+private:
+  z_stream m_stream;
+};
+
+#endif /* COMMON_RSP_COMPRESS_H */
@@ -23,7 +23,10 @@
 #include "gdbcore.h"
 #include "target-dcache.h"
 #include "inferior.h"
-#include "splay-tree.h"
+#include "memattr.h"
+#include "common/byte-vector.h"
+#include <algorithm>
+#include <vector>
 
 /* Commands with a prefix of `{set,show} dcache'.  */
 static struct cmd_list_element *dcache_set_list = NULL;
@@ -42,28 +45,47 @@ static struct cmd_list_element *dcache_show_list = NULL;
    significantly.  This is most useful when accessing a large amount
    of data, such as when performing a backtrace.
 
-   The cache is a splay tree along with a linked list for replacement.
-   Each block caches a LINE_SIZE area of memory.  Within each line we
-   remember the address of the line (which must be a multiple of
-   LINE_SIZE) and the actual data block.
+   The cache is an open-addressed hash table keyed by line address,
+   along with a circular list of the lines for replacement, which
+   follows the CLOCK algorithm.  Each block caches a LINE_SIZE area of
+   memory.  Within each line we remember the address of the line (which
+   must be a multiple of LINE_SIZE) and the actual data block.
 
    Lines are only allocated as needed, so DCACHE_SIZE really specifies the
    *maximum* number of lines in the cache.
 
-   At present, the cache is write-through rather than writeback: as soon
-   as data is written to the cache, it is also immediately written to
-   the target.  Therefore, cache lines are never "dirty".  Whether a given
-   line is valid or not depends on where it is stored in the dcache_struct;
-   there is no per-block valid flag.  */
+   By default, the cache is write-through: as soon as data is written
+   to the cache, it is also immediately written to the target, and
+   cache lines are never "dirty".  With "set dcache write-back on",
+   writes to cached memory only update the cache and mark the range
+   they cover dirty; the dirty ranges are written back, adjacent ones
+   coalesced into a single transfer, before the target is resumed or
+   detached, before the line is evicted, and before memory overlapping
+   them is read without going through the cache.  A line stays dirty
+   until the write succeeds, so a failed write back can be retried.
+   Whether a given line is valid or not depends on where it is stored
+   in the dcache_struct; there is no per-block valid flag.
+
+   Misses are tracked per memory region (see memattr.c).  In a region
+   with the "cache" attribute, a miss on the line right after the last
+   one filled in the same region is taken as a sequential walk, and
+   the following lines are read ahead in the same transfer, doubling
+   the amount read each time up to DCACHE_PREFETCH_LIMIT lines.  Any
+   other miss halves it again.  In effect, each region gets its own
+   line size, growing for memory that is walked (large structures,
+   "find", "x" dumps) and staying small for memory that is accessed at
+   random.  Other memory, which is all of it when no region is
+   defined, is only read as asked: it may have no known end, and
+   reading past it may hit device registers.  */
 
 /* NOTE: Interaction of dcache and memory region attributes
 
    As there is no requirement that memory region attributes be aligned
-   to or be a multiple of the dcache page size, dcache_read_line() and
-   dcache_write_line() must break up the page by memory region.  If a
-   chunk does not have the cache attribute set, an invalid memory type
-   is set, etc., then the chunk is skipped.  Those chunks are handled
-   in target_xfer_memory() (or target_xfer_memory_partial()).
+   to or be a multiple of the dcache page size, dcache_read_span()
+   must break up the range it reads by memory region.  If a chunk does
+   not have the cache attribute set, an invalid memory type is set,
+   etc., then the chunk is skipped.  Those chunks are handled in
+   target_xfer_memory() (or target_xfer_memory_partial()).
 
    This doesn't occur very often.  The most common occurance is when
    the last bit of the .text segment and the first bit of the .data
@@ -82,6 +104,18 @@ static unsigned dcache_size = DCACHE_DEFAULT_SIZE;
 #define DCACHE_DEFAULT_LINE_SIZE 64
 static unsigned dcache_line_size = DCACHE_DEFAULT_LINE_SIZE;
 
+/* The maximum number of lines read by a single miss.  0 or 1 disables
+   reading ahead.  */
+#define DCACHE_DEFAULT_PREFETCH_LIMIT 16
+static unsigned dcache_prefetch_limit = DCACHE_DEFAULT_PREFETCH_LIMIT;
+
+/* Whether writes to cached memory are deferred until the target is
+   resumed.  */
+static int dcache_write_back = 0;
+
+/* The number of memory regions whose access pattern is tracked.  */
+#define DCACHE_REGION_SLOTS 8
+
 /* Each cache block holds LINE_SIZE bytes of data
    starting at a multiple-of-LINE_SIZE address.  */
 
@@ -91,21 +125,60 @@ static unsigned dcache_line_size = DCACHE_DEFAULT_LINE_SIZE;
 
 struct dcache_block
 {
-  /* For least-recently-allocated and free lists.  */
+  /* For the clock and free lists.  */
   struct dcache_block *prev;
   struct dcache_block *next;
 
   CORE_ADDR addr;		/* address of data */
   int refs;			/* # hits */
+
+  /* Non-zero if the line was used since the clock hand last passed
+     it.  */
+  int referenced;
+
+  /* The part of the line written but not yet written back, as offsets
+     into DATA.  Both are zero if the line is clean.  */
+  int dirty_lo, dirty_hi;
+
+  /* Non-zero if the line was read ahead and has not been used yet.  */
+  int prefetched;
+
   gdb_byte data[1];		/* line_size bytes at given address */
 };
 
-struct dcache_struct
+/* Sequential access tracking for one memory region.  */
+
+struct dcache_region
 {
-  splay_tree tree;
-  struct dcache_block *oldest; /* least-recently-allocated list.  */
+  /* Bounds of the region, as in struct mem_region.  Both are zero for
+     an unused slot.  */
+  CORE_ADDR lo, hi;
+
+  /* The line whose miss would continue the current sequential walk,
+     i.e. the one following the last line filled.  */
+  CORE_ADDR next_miss;
+
+  /* Number of lines to read on the next miss.  */
+  unsigned fill;
 
-  /* The free list is maintained identically to OLDEST to simplify
+  /* Value of the owning cache's REGION_CLOCK when last used.  */
+  unsigned long last_use;
+};
+
+struct dcache_struct
+{
+  /* Hash table of the in-use blocks, indexed by dcache_hash and
+     resolved by linear probing.  It has 1 << TABLE_BITS slots, kept
+     at least twice the number of lines so that probe sequences stay
+     short.  */
+  struct dcache_block **table;
+  int table_bits;
+
+  /* The in-use blocks, as a circular list in which HAND points to the
+     next candidate for replacement.  */
+  struct dcache_block *hand;
+
+  /* The free list is maintained identically to HAND to simplify
      the code: we only need one set of accessors.  */
   struct dcache_block *freelist;
 
@@ -115,16 +188,39 @@ struct dcache_struct
 
   /* The ptid of last inferior to use cache or null_ptid.  */
   ptid_t ptid;
+
+  /* The number of lines with a dirty range.  */
+  int dirty_count;
+
+  /* Non-zero while dirty lines are being written to the target.  */
+  int writing_back;
+
+  /* Access pattern of the most recently used memory regions.  */
+  struct dcache_region regions[DCACHE_REGION_SLOTS];
+  unsigned long region_clock;
+
+  /* Statistics for "info dcache".  These survive invalidation.  */
+  ULONGEST misses;		/* lines filled on demand */
+  ULONGEST prefetched;		/* lines read ahead */
+  ULONGEST prefetch_hits;	/* lines read ahead, then used */
+  ULONGEST reads;		/* target reads to fill lines */
+  ULONGEST written_back;	/* dirty lines written back */
+  ULONGEST write_backs;		/* target writes to write them back */
 };
 
 typedef void (block_func) (struct dcache_block *block, void *param);
 
 static struct dcache_block *dcache_hit (DCACHE *dcache, CORE_ADDR addr);
 
-static int dcache_read_line (DCACHE *dcache, struct dcache_block *db);
+static struct dcache_block *dcache_fill (DCACHE *dcache, CORE_ADDR addr);
 
 static struct dcache_block *dcache_alloc (DCACHE *dcache, CORE_ADDR addr);
 
+static void dcache_write_back_block (DCACHE *dcache,
+				     struct dcache_block *db);
+
+static void dcache_discard_block (DCACHE *dcache, struct dcache_block *db);
+
 static int dcache_enabled_p = 0; /* OBSOLETE */
 
 static void
@@ -136,8 +232,8 @@ show_dcache_enabled_p (struct ui_file *file, int from_tty,
 
 /* Add BLOCK to circular block list BLIST, behind the block at *BLIST.
    *BLIST is not updated (unless it was previously NULL of course).
-   This is for the least-recently-allocated list's sake:
-   BLIST points to the oldest block.
+   This is for the clock list's sake: BLIST points to the hand, and a
+   new block is the last one the hand reaches.
    ??? This makes for poor cache usage of the free list,
    but is it measurable?  */
 
@@ -151,7 +247,7 @@ append_block (struct dcache_block **blist, struct dcache_block *block)
       block->prev->next = block;
       (*blist)->prev = block;
       /* We don't update *BLIST here to maintain the invariant that for the
-	 least-recently-allocated list *BLIST points to the oldest block.  */
+	 clock list *BLIST points to the hand.  */
     }
   else
     {
@@ -174,9 +270,8 @@ remove_block (struct dcache_block **blist, struct dcache_block *block)
     {
       block->next->prev = block->prev;
       block->prev->next = block->next;
-      /* If we removed the block *BLIST points to, shift it to the next block
-	 to maintain the invariant that for the least-recently-allocated list
-	 *BLIST points to the oldest block.  */
+      /* If we removed the block *BLIST points to, shift it to the next block,
+	 which is where the clock hand moves on to.  */
       if (*blist == block)
 	*blist = block->next;
     }
@@ -218,61 +313,254 @@ free_block (struct dcache_block *block, void *param)
 void
 dcache_free (DCACHE *dcache)
 {
-  splay_tree_delete (dcache->tree);
-  for_each_block (&dcache->oldest, free_block, NULL);
+  /* Any dirty lines are dropped: the address space they belong to is
+     going away.  */
+  for_each_block (&dcache->hand, free_block, NULL);
   for_each_block (&dcache->freelist, free_block, NULL);
+  xfree (dcache->table);
   xfree (dcache);
 }
 
 
-/* BLOCK_FUNC function for dcache_invalidate.
-   This doesn't remove the block from the oldest list on purpose.
-   dcache_invalidate will do it later.  */
+/* BLOCK_FUNC function for dcache_discard.
+   This doesn't remove the block from the clock list or the hash table
+   on purpose.  dcache_discard will do it later.  */
 
 static void
 invalidate_block (struct dcache_block *block, void *param)
 {
   DCACHE *dcache = (DCACHE *) param;
 
-  splay_tree_remove (dcache->tree, (splay_tree_key) block->addr);
   append_block (&dcache->freelist, block);
 }
 
-/* Free all the data cache blocks, thus discarding all cached data.  */
+/* BLOCK_FUNC function for dcache_invalidate, when some lines could
+   not be written back.  Discard BLOCK unless it is dirty.  */
+
+static void
+invalidate_clean_block (struct dcache_block *block, void *param)
+{
+  DCACHE *dcache = (DCACHE *) param;
+
+  if (block->dirty_hi == 0)
+    dcache_discard_block (dcache, block);
+}
+
+/* Free all the data cache blocks, thus discarding all cached data.
+   Dirty lines are written back first; if that fails, the error is
+   reported and only the clean lines are discarded, keeping the dirty
+   ones, and the line size they were cached with, for a later write
+   back to retry.  */
 
 void
 dcache_invalidate (DCACHE *dcache)
 {
-  for_each_block (&dcache->oldest, invalidate_block, dcache);
+  TRY
+    {
+      dcache_flush (dcache);
+    }
+  CATCH (ex, RETURN_MASK_ERROR)
+    {
+      exception_print (gdb_stderr, ex);
+    }
+  END_CATCH
+
+  if (dcache->dirty_count != 0)
+    {
+      for_each_block (&dcache->hand, invalidate_clean_block, dcache);
+      return;
+    }
 
-  dcache->oldest = NULL;
+  dcache_discard (dcache);
+}
+
+/* See dcache.h.  */
+
+void
+dcache_discard (DCACHE *dcache)
+{
+  for_each_block (&dcache->hand, invalidate_block, dcache);
+
+  dcache->hand = NULL;
+  memset (dcache->table, 0,
+	  ((size_t) 1 << dcache->table_bits) * sizeof (*dcache->table));
   dcache->size = 0;
+  dcache->dirty_count = 0;
   dcache->ptid = null_ptid;
 
   if (dcache->line_size != dcache_line_size)
     {
       /* We've been asked to use a different line size.
-	 All of our freelist blocks are now the wrong size, so free them.  */
+	 All of our freelist blocks are now the wrong size, so free them.
+	 What we learned about access patterns was in lines of the old
+	 size, so forget it too.  */
 
       for_each_block (&dcache->freelist, free_block, dcache);
       dcache->freelist = NULL;
       dcache->line_size = dcache_line_size;
+      memset (dcache->regions, 0, sizeof (dcache->regions));
+    }
+}
+
+/* Return the home slot of the line at address LINE in DCACHE's hash
+   table.  This is Fibonacci hashing: the top bits of the product are
+   well mixed even for lines that are a power of two apart.  */
+
+static inline unsigned
+dcache_hash (DCACHE *dcache, CORE_ADDR line)
+{
+  return (unsigned) (((ULONGEST) line * 0x9e3779b97f4a7c15ULL)
+		     >> (64 - dcache->table_bits));
+}
+
+/* Return the mask for wrapping slot indices of DCACHE's hash table.  */
+
+static inline unsigned
+dcache_table_mask (DCACHE *dcache)
+{
+  return (1u << dcache->table_bits) - 1;
+}
+
+/* Add DB to DCACHE's hash table.  */
+
+static void
+dcache_table_insert (DCACHE *dcache, struct dcache_block *db)
+{
+  unsigned mask = dcache_table_mask (dcache);
+  unsigned i = dcache_hash (dcache, db->addr);
+
+  while (dcache->table[i] != NULL)
+    i = (i + 1) & mask;
+  dcache->table[i] = db;
+}
+
+/* Remove DB, which must be present, from DCACHE's hash table.  */
+
+static void
+dcache_table_remove (DCACHE *dcache, struct dcache_block *db)
+{
+  unsigned mask = dcache_table_mask (dcache);
+  unsigned i = dcache_hash (dcache, db->addr);
+  unsigned j;
+
+  while (dcache->table[i] != db)
+    i = (i + 1) & mask;
+
+  /* Rather than leaving a tombstone, move later entries of the probe
+     sequence back into the hole, so that lookups can still stop at
+     the first empty slot.  An entry can move unless its home slot lies
+     cyclically between the hole and itself.  */
+  for (j = (i + 1) & mask; dcache->table[j] != NULL; j = (j + 1) & mask)
+    {
+      unsigned home = dcache_hash (dcache, dcache->table[j]->addr);
+
+      if (((j - home) & mask) >= ((j - i) & mask))
+	{
+	  dcache->table[i] = dcache->table[j];
+	  i = j;
+	}
     }
+
+  dcache->table[i] = NULL;
+}
+
+/* BLOCK_FUNC routine for dcache_resize_table.  */
+
+static void
+rehash_block (struct dcache_block *block, void *param)
+{
+  dcache_table_insert ((DCACHE *) param, block);
 }
 
-/* Invalidate the line associated with ADDR.  */
+/* Make DCACHE's hash table large enough for LINES lines, rehashing
+   the lines it holds.  */
+
+static void
+dcache_resize_table (DCACHE *dcache, unsigned lines)
+{
+  int bits = 4;
+
+  while (bits < 31 && ((size_t) 1 << bits) < (size_t) lines * 2)
+    bits++;
+
+  if (dcache->table != NULL && bits <= dcache->table_bits)
+    return;
+
+  xfree (dcache->table);
+  dcache->table = XCNEWVEC (struct dcache_block *, (size_t) 1 << bits);
+  dcache->table_bits = bits;
+  for_each_block (&dcache->hand, rehash_block, dcache);
+}
+
+/* Return the block caching ADDR, or NULL if ADDR is not cached.
+   Unlike dcache_hit, this does not count as a reference.  */
+
+static struct dcache_block *
+dcache_lookup (DCACHE *dcache, CORE_ADDR addr)
+{
+  CORE_ADDR line = MASK (dcache, addr);
+  unsigned mask = dcache_table_mask (dcache);
+  unsigned i = dcache_hash (dcache, line);
+  struct dcache_block *db;
+
+  for (; (db = dcache->table[i]) != NULL; i = (i + 1) & mask)
+    if (db->addr == line)
+      return db;
+
+  return NULL;
+}
+
+/* Move DB, which must be in use, to the free list.  */
+
+static void
+dcache_discard_block (DCACHE *dcache, struct dcache_block *db)
+{
+  dcache_table_remove (dcache, db);
+  remove_block (&dcache->hand, db);
+  append_block (&dcache->freelist, db);
+  --dcache->size;
+}
+
+/* BLOCK_FUNC routine for dcache_sorted_blocks.  */
+
+static void
+collect_block (struct dcache_block *block, void *param)
+{
+  std::vector<struct dcache_block *> *blocks
+    = (std::vector<struct dcache_block *> *) param;
+
+  blocks->push_back (block);
+}
+
+/* Return the in-use blocks of DCACHE in address order.  */
+
+static std::vector<struct dcache_block *>
+dcache_sorted_blocks (DCACHE *dcache)
+{
+  std::vector<struct dcache_block *> blocks;
+
+  blocks.reserve (dcache->size);
+  for_each_block (&dcache->hand, collect_block, &blocks);
+  std::sort (blocks.begin (), blocks.end (),
+	     [] (const dcache_block *a, const dcache_block *b)
+	     {
+	       return a->addr < b->addr;
+	     });
+  return blocks;
+}
+
+/* Invalidate the line associated with ADDR, writing it back first if
+   it is dirty.  */
 
 static void
 dcache_invalidate_line (DCACHE *dcache, CORE_ADDR addr)
 {
-  struct dcache_block *db = dcache_hit (dcache, addr);
+  struct dcache_block *db = dcache_lookup (dcache, addr);
 
   if (db)
     {
-      splay_tree_remove (dcache->tree, (splay_tree_key) db->addr);
-      remove_block (&dcache->oldest, db);
-      append_block (&dcache->freelist, db);
-      --dcache->size;
+      dcache_write_back_block (dcache, db);
+      dcache_discard_block (dcache, db);
     }
 }
 
@@ -282,36 +570,34 @@ dcache_invalidate_line (DCACHE *dcache, CORE_ADDR addr)
 static struct dcache_block *
 dcache_hit (DCACHE *dcache, CORE_ADDR addr)
 {
-  struct dcache_block *db;
-
-  splay_tree_node node = splay_tree_lookup (dcache->tree,
-					    (splay_tree_key) MASK (dcache, addr));
+  struct dcache_block *db = dcache_lookup (dcache, addr);
 
-  if (!node)
+  if (!db)
     return NULL;
 
-  db = (struct dcache_block *) node->value;
   db->refs++;
+  db->referenced = 1;
+  if (db->prefetched)
+    {
+      db->prefetched = 0;
+      dcache->prefetch_hits++;
+    }
   return db;
 }
 
-/* Fill a cache line from target memory.
-   The result is 1 for success, 0 if the (entire) cache line
-   wasn't readable.  */
+/* Read LEN bytes of target memory at MEMADDR into MYADDR, skipping
+   write-only memory regions.  The result is 1 for success, 0 if the
+   (entire) range wasn't readable.  */
 
 static int
-dcache_read_line (DCACHE *dcache, struct dcache_block *db)
+dcache_read_span (DCACHE *dcache, CORE_ADDR memaddr, gdb_byte *myaddr,
+		  int len)
 {
-  CORE_ADDR memaddr;
-  gdb_byte *myaddr;
-  int len;
   int res;
   int reg_len;
   struct mem_region *region;
 
-  len = dcache->line_size;
-  memaddr = db->addr;
-  myaddr  = db->data;
+  dcache->reads++;
 
   while (len > 0)
     {
@@ -344,6 +630,131 @@ dcache_read_line (DCACHE *dcache, struct dcache_block *db)
   return 1;
 }
 
+/* Return the access tracking slot for the memory region REGION,
+   recycling the least recently used slot if REGION has none yet.  */
+
+static struct dcache_region *
+dcache_region_lookup (DCACHE *dcache, const struct mem_region *region)
+{
+  struct dcache_region *dr = NULL;
+  int i;
+
+  for (i = 0; i < DCACHE_REGION_SLOTS; i++)
+    {
+      struct dcache_region *slot = &dcache->regions[i];
+
+      if (slot->fill != 0 && slot->lo == region->lo && slot->hi == region->hi)
+	{
+	  dr = slot;
+	  break;
+	}
+      if (dr == NULL || slot->last_use < dr->last_use)
+	dr = slot;
+    }
+
+  if (dr->fill == 0 || dr->lo != region->lo || dr->hi != region->hi)
+    {
+      dr->lo = region->lo;
+      dr->hi = region->hi;
+      dr->next_miss = 0;
+      dr->fill = 1;
+    }
+
+  dr->last_use = ++dcache->region_clock;
+  return dr;
+}
+
+/* Fill the cache line containing ADDR from target memory, and return
+   it, or NULL if the line wasn't readable.  On a sequential miss the
+   following lines are read ahead in the same transfer; see the comment
+   at the top of the file.  */
+
+static struct dcache_block *
+dcache_fill (DCACHE *dcache, CORE_ADDR addr)
+{
+  CORE_ADDR line = MASK (dcache, addr);
+  struct mem_region *region = lookup_mem_region (line);
+  CORE_ADDR region_hi = region->hi;
+  struct dcache_region *dr = dcache_region_lookup (dcache, region);
+  unsigned limit = (region->attrib.cache
+		    ? std::max (std::min (dcache_prefetch_limit, dcache_size),
+				1u)
+		    : 1);
+  struct dcache_block *db;
+  unsigned n;
+
+  if (line == dr->next_miss)
+    dr->fill = std::min (dr->fill * 2, limit);
+  else
+    dr->fill = std::max (dr->fill / 2, 1u);
+  dr->fill = std::min (dr->fill, limit);
+
+  /* Don't read ahead past the end of the region, into lines we
+     already have, or around the end of the address space.  */
+  for (n = 1; n < dr->fill; n++)
+    {
+      CORE_ADDR next = line + n * dcache->line_size;
+
+      if (next == 0
+	  || (region_hi != 0 && next >= region_hi)
+	  || dcache_lookup (dcache, next) != NULL)
+	break;
+    }
+
+  dcache->misses++;
+
+  if (n > 1)
+    {
+      gdb::byte_vector buf (n * dcache->line_size);
+
+      if (dcache_read_span (dcache, line, buf.data (), buf.size ()))
+	{
+	  struct dcache_block *first = NULL;
+	  unsigned i;
+
+	  /* The first line is marked used as soon as it is allocated.
+	     Otherwise, if the lines ahead of the clock hand are all in
+	     use, allocating the next line would sweep round to the
+	     first and evict it.  Marked, it is passed over like any
+	     other line in use; the sweep clears the lines it passes,
+	     so the N - 1 older lines it then meets are evicted
+	     before it comes round again.  */
+	  for (i = 0; i < n; i++)
+	    {
+	      db = dcache_alloc (dcache, line + i * dcache->line_size);
+	      memcpy (db->data, buf.data () + i * dcache->line_size,
+		      dcache->line_size);
+	      db->prefetched = i != 0;
+	      if (i == 0)
+		{
+		  first = db;
+		  first->referenced = 1;
+		}
+	    }
+
+	  dcache->prefetched += n - 1;
+	  dr->next_miss = line + n * dcache->line_size;
+	  return first;
+	}
+
+      /* Some of the lines weren't readable.  Settle for the one we
+	 were asked for.  */
+      dr->fill = 1;
+    }
+
+  db = dcache_alloc (dcache, line);
+  if (!dcache_read_span (dcache, line, db->data, dcache->line_size))
+    {
+      /* Discard the line so we don't have a partially read line.  */
+      dcache_discard_block (dcache, db);
+      return NULL;
+    }
+
+  dr->next_miss = line + dcache->line_size;
+  db->referenced = 1;
+  return db;
+}
+
 /* Get a free cache block, put or keep it on the valid list,
    and return its address.  */
 
@@ -354,14 +765,28 @@ dcache_alloc (DCACHE *dcache, CORE_ADDR addr)
 
   if (dcache->size >= dcache_size)
     {
-      /* Evict the least recently allocated line.  */
-      db = dcache->oldest;
-      remove_block (&dcache->oldest, db);
+      /* Sweep the clock hand round to the first line not used since
+	 the hand last passed it, clearing the reference bits on the
+	 way, and evict that line after writing it back if it is
+	 dirty.  */
+      db = dcache->hand;
+      while (db->referenced)
+	{
+	  db->referenced = 0;
+	  db = db->next;
+	}
+      dcache->hand = db;
+      dcache_write_back_block (dcache, db);
+      remove_block (&dcache->hand, db);
 
-      splay_tree_remove (dcache->tree, (splay_tree_key) db->addr);
+      dcache_table_remove (dcache, db);
     }
   else
     {
+      /* The size of the cache may have been raised since the table
+	 was made.  */
+      dcache_resize_table (dcache, dcache->size + 1);
+
       db = dcache->freelist;
       if (db)
 	remove_block (&dcache->freelist, db);
@@ -375,85 +800,91 @@ dcache_alloc (DCACHE *dcache, CORE_ADDR addr)
 
   db->addr = MASK (dcache, addr);
   db->refs = 0;
+  db->referenced = 0;
+  db->dirty_lo = db->dirty_hi = 0;
+  db->prefetched = 0;
 
-  /* Put DB at the end of the list, it's the newest.  */
-  append_block (&dcache->oldest, db);
+  /* Put DB just behind the hand, it's the newest.  */
+  append_block (&dcache->hand, db);
 
-  splay_tree_insert (dcache->tree, (splay_tree_key) db->addr,
-		     (splay_tree_value) db);
+  dcache_table_insert (dcache, db);
 
   return db;
 }
 
-/* Using the data cache DCACHE, store in *PTR the contents of the byte at
-   address ADDR in the remote machine.  
-
-   Returns 1 for success, 0 for error.  */
+/* Allocate and initialize a data cache.  */
 
-static int
-dcache_peek_byte (DCACHE *dcache, CORE_ADDR addr, gdb_byte *ptr)
+DCACHE *
+dcache_init (void)
 {
-  struct dcache_block *db = dcache_hit (dcache, addr);
-
-  if (!db)
-    {
-      db = dcache_alloc (dcache, addr);
+  DCACHE *dcache = XNEW (DCACHE);
 
-      if (!dcache_read_line (dcache, db))
-         return 0;
-    }
+  dcache->table = NULL;
+  dcache->table_bits = 0;
+  dcache->hand = NULL;
+  dcache->freelist = NULL;
+  dcache->size = 0;
+  dcache->line_size = dcache_line_size;
+  dcache->ptid = null_ptid;
+  dcache->dirty_count = 0;
+  dcache->writing_back = 0;
+  memset (dcache->regions, 0, sizeof (dcache->regions));
+  dcache->region_clock = 0;
+  dcache->misses = 0;
+  dcache->prefetched = 0;
+  dcache->prefetch_hits = 0;
+  dcache->reads = 0;
+  dcache->written_back = 0;
+  dcache->write_backs = 0;
+  dcache_resize_table (dcache, dcache_size);
 
-  *ptr = db->data[XFORM (dcache, addr)];
-  return 1;
+  return dcache;
 }
 
-/* Write the byte at PTR into ADDR in the data cache.
-
-   The caller should have written the data through to target memory
-   already.
-
-   If ADDR is not in cache, this function does nothing; writing to an
-   area of memory which wasn't present in the cache doesn't cause it
-   to be loaded in.  */
+/* Make DCACHE cache the memory of PTID, if it isn't already.  The
+   lines cached for the previous ptid are discarded.  Dirty ones are
+   written back first if they belong to another thread of the same
+   process, as the current one, since that writes the memory they were
+   meant for; but lines of another process, or that can't be written
+   back, are discarded too, as they must never be written to PTID's
+   memory.  */
 
 static void
-dcache_poke_byte (DCACHE *dcache, CORE_ADDR addr, const gdb_byte *ptr)
+dcache_set_ptid (DCACHE *dcache, ptid_t ptid)
 {
-  struct dcache_block *db = dcache_hit (dcache, addr);
+  if (ptid == dcache->ptid)
+    return;
 
-  if (db)
-    db->data[XFORM (dcache, addr)] = *ptr;
-}
+  if (dcache->dirty_count != 0
+      && ptid.pid () == dcache->ptid.pid ()
+      && inferior_ptid.pid () == dcache->ptid.pid ())
+    {
+      TRY
+	{
+	  dcache_flush (dcache);
+	}
+      CATCH (ex, RETURN_MASK_ERROR)
+	{
+	  exception_print (gdb_stderr, ex);
+	}
+      END_CATCH
+    }
 
-static int
-dcache_splay_tree_compare (splay_tree_key a, splay_tree_key b)
-{
-  if (a > b)
-    return 1;
-  else if (a == b)
-    return 0;
-  else
-    return -1;
+  if (dcache->dirty_count != 0)
+    warning (_("Discarding %d dirty cache lines of %s."),
+	     dcache->dirty_count, target_pid_to_str (dcache->ptid));
+
+  dcache_discard (dcache);
+  dcache->ptid = ptid;
 }
 
-/* Allocate and initialize a data cache.  */
+/* If this is a different inferior from what we've recorded, flush
+   DCACHE.  */
 
-DCACHE *
-dcache_init (void)
+static void
+dcache_check_ptid (DCACHE *dcache)
 {
-  DCACHE *dcache = XNEW (DCACHE);
-
-  dcache->tree = splay_tree_new (dcache_splay_tree_compare,
-				 NULL,
-				 NULL);
-
-  dcache->oldest = NULL;
-  dcache->freelist = NULL;
-  dcache->size = 0;
-  dcache->line_size = dcache_line_size;
-  dcache->ptid = null_ptid;
-
-  return dcache;
+  dcache_set_ptid (dcache, inferior_ptid);
 }
 
 
@@ -467,32 +898,37 @@ dcache_read_memory_partial (struct target_ops *ops, DCACHE *dcache,
 			    CORE_ADDR memaddr, gdb_byte *myaddr,
 			    ULONGEST len, ULONGEST *xfered_len)
 {
-  ULONGEST i;
+  ULONGEST i = 0;
 
-  /* If this is a different inferior from what we've recorded,
-     flush the cache.  */
+  dcache_check_ptid (dcache);
 
-  if (inferior_ptid != dcache->ptid)
+  /* Copy out of one line at a time.  */
+  while (i < len)
     {
-      dcache_invalidate (dcache);
-      dcache->ptid = inferior_ptid;
-    }
+      CORE_ADDR addr = memaddr + i;
+      struct dcache_block *db = dcache_hit (dcache, addr);
+      int offset = XFORM (dcache, addr);
+      ULONGEST n;
 
-  for (i = 0; i < len; i++)
-    {
-      if (!dcache_peek_byte (dcache, memaddr + i, myaddr + i))
+      if (!db)
 	{
-	  /* That failed.  Discard its cache line so we don't have a
-	     partially read line.  */
-	  dcache_invalidate_line (dcache, memaddr + i);
-	  break;
+	  /* On failure, dcache_fill has already discarded the line so
+	     that we don't have a partially read line.  */
+	  db = dcache_fill (dcache, addr);
+	  if (!db)
+	    break;
 	}
+
+      n = std::min ((ULONGEST) (dcache->line_size - offset), len - i);
+      memcpy (myaddr + i, db->data + offset, n);
+      i += n;
     }
 
   if (i == 0)
     {
       /* Even though reading the whole line failed, we may be able to
 	 read a piece starting where the caller wanted.  */
+      dcache_flush_range (dcache, memaddr, len);
       return raw_memory_xfer_partial (ops, myaddr, NULL, memaddr, len,
 				      xfered_len);
     }
@@ -503,35 +939,251 @@ dcache_read_memory_partial (struct target_ops *ops, DCACHE *dcache,
     }
 }
 
-/* FIXME: There would be some benefit to making the cache write-back and
-   moving the writeback operation to a higher layer, as it could occur
-   after a sequence of smaller writes have been completed (as when a stack
-   frame is constructed for an inferior function call).  Note that only
-   moving it up one level to target_xfer_memory[_partial]() is not
-   sufficient since we want to coalesce memory transfers that are
-   "logically" connected but not actually a single call to one of the
-   memory transfer functions.  */
+/* Write LEN bytes from MYADDR to MEMADDR in the cache only, marking
+   them dirty, if the cache is in write-back mode.  This lets a
+   sequence of small writes (as when a stack frame is constructed for
+   an inferior function call) reach the target as a few large ones.
+   If ALLOCATE, lines not in the cache are read in first; otherwise
+   the write stops at the first line that isn't cached.  Returns
+   non-zero and sets *XFERED_LEN if anything was written; zero means
+   the caller should write through to the target.  */
+
+int
+dcache_write_memory_partial (DCACHE *dcache, CORE_ADDR memaddr,
+			     const gdb_byte *myaddr, ULONGEST len,
+			     int allocate, ULONGEST *xfered_len)
+{
+  ULONGEST done = 0;
+
+  if (!dcache_write_back)
+    return 0;
+
+  dcache_check_ptid (dcache);
+
+  while (done < len)
+    {
+      CORE_ADDR addr = memaddr + done;
+      struct dcache_block *db = dcache_lookup (dcache, addr);
+      int offset = XFORM (dcache, addr);
+      int n;
+
+      if (db == NULL && allocate)
+	db = dcache_fill (dcache, addr);
+      if (db == NULL)
+	break;
+
+      n = std::min ((ULONGEST) (dcache->line_size - offset), len - done);
+      memcpy (db->data + offset, myaddr + done, n);
+
+      if (db->dirty_hi == 0)
+	{
+	  db->dirty_lo = offset;
+	  db->dirty_hi = offset + n;
+	  dcache->dirty_count++;
+	}
+      else
+	{
+	  db->dirty_lo = std::min (db->dirty_lo, offset);
+	  db->dirty_hi = std::max (db->dirty_hi, offset + n);
+	}
+
+      done += n;
+    }
+
+  *xfered_len = done;
+  return done != 0;
+}
+
+/* Write COUNT bytes at BUF, which are the contents of dirty lines,
+   back to ADDR.  The write updates the cache through dcache_update,
+   which WRITING_BACK tells to leave the lines alone: they already
+   hold the data, and must stay dirty if the write fails.  */
+
+static void
+dcache_write_back_raw (DCACHE *dcache, CORE_ADDR addr, const gdb_byte *buf,
+		       ULONGEST count)
+{
+  scoped_restore restore_writing_back
+    = make_scoped_restore (&dcache->writing_back, 1);
+
+  dcache->write_backs++;
+  if (target_write_raw_memory (addr, buf, count) != 0)
+    error (_("Cannot write back cached memory at %s."),
+	   paddress (target_gdbarch (), addr));
+}
+
+/* Mark DB, whose dirty range was just written back, clean.  */
+
+static void
+dcache_mark_clean (DCACHE *dcache, struct dcache_block *db)
+{
+  db->dirty_lo = db->dirty_hi = 0;
+  dcache->dirty_count--;
+  dcache->written_back++;
+}
+
+/* Write the dirty range of DB, if any, back to the target.  */
+
+static void
+dcache_write_back_block (DCACHE *dcache, struct dcache_block *db)
+{
+  int lo = db->dirty_lo;
+  int len = db->dirty_hi - db->dirty_lo;
+
+  if (len == 0)
+    return;
+
+  dcache_write_back_raw (dcache, db->addr + lo, db->data + lo, len);
+  dcache_mark_clean (dcache, db);
+}
+
+/* Write RUN, the dirty ranges of BLOCKS laid end to end, back to ADDR,
+   and mark BLOCKS clean.  */
+
+static void
+dcache_write_back_run (DCACHE *dcache, CORE_ADDR addr,
+		       const gdb::byte_vector &run,
+		       const std::vector<struct dcache_block *> &blocks)
+{
+  dcache_write_back_raw (dcache, addr, run.data (), run.size ());
+  for (struct dcache_block *db : blocks)
+    dcache_mark_clean (dcache, db);
+}
+
+/* See dcache.h.  */
+
+void
+dcache_flush (DCACHE *dcache)
+{
+  gdb::byte_vector run;
+  std::vector<struct dcache_block *> run_blocks;
+  CORE_ADDR run_addr = 0;
+
+  if (dcache->dirty_count == 0)
+    return;
+
+  /* Coalesce dirty ranges that touch into a single write.  */
+  for (struct dcache_block *db : dcache_sorted_blocks (dcache))
+    {
+      CORE_ADDR addr = db->addr + db->dirty_lo;
+
+      if (db->dirty_hi == 0)
+	continue;
+
+      if (!run.empty () && addr != run_addr + run.size ())
+	{
+	  dcache_write_back_run (dcache, run_addr, run, run_blocks);
+	  run.clear ();
+	  run_blocks.clear ();
+	}
+      if (run.empty ())
+	run_addr = addr;
+
+      run.insert (run.end (), db->data + db->dirty_lo,
+		  db->data + db->dirty_hi);
+      run_blocks.push_back (db);
+    }
+
+  if (!run.empty ())
+    dcache_write_back_run (dcache, run_addr, run, run_blocks);
+}
+
+/* See dcache.h.  */
+
+void
+dcache_flush_range (DCACHE *dcache, CORE_ADDR memaddr, ULONGEST len)
+{
+  ULONGEST nlines, i;
+  CORE_ADDR line;
+
+  if (dcache->dirty_count == 0 || len == 0)
+    return;
+
+  line = MASK (dcache, memaddr);
+  nlines = (memaddr + len - line + dcache->line_size - 1) / dcache->line_size;
+
+  /* Looking up every line of a large range costs more than writing
+     back everything.  */
+  if (nlines >= (ULONGEST) dcache->dirty_count)
+    {
+      dcache_flush (dcache);
+      return;
+    }
+
+  for (i = 0; i < nlines; i++, line += dcache->line_size)
+    {
+      struct dcache_block *db = dcache_lookup (dcache, line);
+
+      if (db != NULL)
+	dcache_write_back_block (dcache, db);
+    }
+}
 
 /* Just update any cache lines which are already present.  This is
    called by the target_xfer_partial machinery when writing raw
-   memory.  */
+   memory.  Writing to an area of memory which wasn't present in the
+   cache doesn't cause it to be loaded in.  */
 
 void
 dcache_update (DCACHE *dcache, enum target_xfer_status status,
 	       CORE_ADDR memaddr, const gdb_byte *myaddr,
 	       ULONGEST len)
 {
-  ULONGEST i;
+  ULONGEST i = 0;
+
+  /* This is a write back of the cache's own dirty lines.  */
+  if (dcache->writing_back)
+    return;
+
+  while (i < len)
+    {
+      CORE_ADDR addr = memaddr + i;
+      int offset = XFORM (dcache, addr);
+      ULONGEST n = std::min ((ULONGEST) (dcache->line_size - offset),
+			     len - i);
+
+      if (status == TARGET_XFER_OK)
+	{
+	  struct dcache_block *db = dcache_hit (dcache, addr);
+
+	  if (db)
+	    memcpy (db->data + offset, myaddr + i, n);
+	}
+      else
+	{
+	  /* Discard the whole cache line so we don't have a partially
+	     valid line.  */
+	  dcache_invalidate_line (dcache, addr);
+	}
+
+      i += n;
+    }
+}
+
+/* See dcache.h.  */
+
+void
+dcache_prime (DCACHE *dcache, ptid_t ptid, CORE_ADDR memaddr,
+	      const gdb_byte *myaddr, ULONGEST len)
+{
+  ULONGEST offset;
 
-  for (i = 0; i < len; i++)
-    if (status == TARGET_XFER_OK)
-      dcache_poke_byte (dcache, memaddr + i, myaddr + i);
-    else
-      {
-	/* Discard the whole cache line so we don't have a partially
-	   valid line.  */
-	dcache_invalidate_line (dcache, memaddr + i);
-      }
+  dcache_set_ptid (dcache, ptid);
+
+  /* Only whole lines can be cached.  Lines already present are left
+     alone, so that nothing written to them is lost.  */
+  offset = (dcache->line_size - XFORM (dcache, memaddr)) % dcache->line_size;
+  for (; offset + dcache->line_size <= len; offset += dcache->line_size)
+    {
+      CORE_ADDR addr = memaddr + offset;
+      struct dcache_block *db;
+
+      if (dcache_lookup (dcache, addr) != NULL)
+	continue;
+
+      db = dcache_alloc (dcache, addr);
+      memcpy (db->data, myaddr + offset, dcache->line_size);
+    }
 }
 
 /* Print DCACHE line INDEX.  */
@@ -539,9 +1191,8 @@ dcache_update (DCACHE *dcache, enum target_xfer_status status,
 static void
 dcache_print_line (DCACHE *dcache, int index)
 {
-  splay_tree_node n;
   struct dcache_block *db;
-  int i, j;
+  int j;
 
   if (dcache == NULL)
     {
@@ -549,25 +1200,19 @@ dcache_print_line (DCACHE *dcache, int index)
       return;
     }
 
-  n = splay_tree_min (dcache->tree);
-
-  for (i = index; i > 0; --i)
-    {
-      if (!n)
-	break;
-      n = splay_tree_successor (dcache->tree, n->key);
-    }
+  std::vector<struct dcache_block *> blocks = dcache_sorted_blocks (dcache);
 
-  if (!n)
+  if ((size_t) index >= blocks.size ())
     {
       printf_filtered (_("No such cache line exists.\n"));
       return;
     }
-    
-  db = (struct dcache_block *) n->value;
 
-  printf_filtered (_("Line %d: address %s [%d hits]\n"),
-		   index, paddress (target_gdbarch (), db->addr), db->refs);
+  db = blocks[index];
+
+  printf_filtered (_("Line %d: address %s [%d hits]%s\n"),
+		   index, paddress (target_gdbarch (), db->addr), db->refs,
+		   db->dirty_hi != 0 ? _(" dirty") : "");
 
   for (j = 0; j < dcache->line_size; j++)
     {
@@ -585,7 +1230,6 @@ dcache_print_line (DCACHE *dcache, int index)
 static void
 dcache_info_1 (DCACHE *dcache, const char *exp)
 {
-  splay_tree_node n;
   int i, refcount;
 
   if (exp)
@@ -618,23 +1262,39 @@ dcache_info_1 (DCACHE *dcache, const char *exp)
 		   target_pid_to_str (dcache->ptid));
 
   refcount = 0;
-
-  n = splay_tree_min (dcache->tree);
   i = 0;
 
-  while (n)
+  for (struct dcache_block *db : dcache_sorted_blocks (dcache))
     {
-      struct dcache_block *db = (struct dcache_block *) n->value;
-
-      printf_filtered (_("Line %d: address %s [%d hits]\n"),
-		       i, paddress (target_gdbarch (), db->addr), db->refs);
+      printf_filtered (_("Line %d: address %s [%d hits]%s\n"),
+		       i, paddress (target_gdbarch (), db->addr), db->refs,
+		       db->dirty_hi != 0 ? _(" dirty") : "");
       i++;
       refcount += db->refs;
-
-      n = splay_tree_successor (dcache->tree, n->key);
     }
 
   printf_filtered (_("Cache state: %d active lines, %d hits\n"), i, refcount);
+  printf_filtered (_("Misses: %s, with %s lines read ahead (%s used), "
+		     "in %s reads\n"),
+		   pulongest (dcache->misses), pulongest (dcache->prefetched),
+		   pulongest (dcache->prefetch_hits),
+		   pulongest (dcache->reads));
+  printf_filtered (_("Write-back: %d dirty lines, %s lines written back "
+		     "in %s writes\n"),
+		   dcache->dirty_count, pulongest (dcache->written_back),
+		   pulongest (dcache->write_backs));
+
+  for (i = 0; i < DCACHE_REGION_SLOTS; i++)
+    {
+      struct dcache_region *dr = &dcache->regions[i];
+
+      if (dr->fill > 1)
+	printf_filtered (_("Region %s-%s: reading %u lines per miss\n"),
+			 paddress (target_gdbarch (), dr->lo),
+			 dr->hi == 0 ? "end" : paddress (target_gdbarch (),
+							 dr->hi),
+			 dr->fill);
+    }
 }
 
 static void
@@ -669,6 +1329,14 @@ set_dcache_line_size (const char *args, int from_tty,
   target_dcache_invalidate ();
 }
 
+static void
+set_dcache_write_back (const char *args, int from_tty,
+		       struct cmd_list_element *c)
+{
+  /* Write back anything left dirty when turning write-back off.  */
+  target_dcache_invalidate ();
+}
+
 static void
 set_dcache_command (const char *arg, int from_tty)
 {
@@ -729,4 +1397,25 @@ Show number of dcache lines."),
 			     set_dcache_size,
 			     NULL,
 			     &dcache_set_list, &dcache_show_list);
+  add_setshow_zuinteger_cmd ("prefetch-limit", class_obscure,
+			     &dcache_prefetch_limit, _("\
+Set the maximum number of dcache lines read by one miss."), _("\
+Show the maximum number of dcache lines read by one miss."), _("\
+When a miss continues a sequential walk through a memory region with\n\
+the \"cache\" attribute, the dcache reads the following lines in the\n\
+same transfer, doubling the number of lines read on each such miss up\n\
+to this limit.  0 or 1 disables reading ahead."),
+			     NULL,
+			     NULL,
+			     &dcache_set_list, &dcache_show_list);
+  add_setshow_boolean_cmd ("write-back", class_obscure,
+			   &dcache_write_back, _("\
+Set whether writes to cached memory are deferred."), _("\
+Show whether writes to cached memory are deferred."), _("\
+When on, writes to memory held in the dcache only update the cache;\n\
+the written ranges are sent to the target, coalesced, before it is\n\
+resumed.  When off, writes go straight through to the target."),
+			   set_dcache_write_back,
+			   NULL,
+			   &dcache_set_list, &dcache_show_list);
 }
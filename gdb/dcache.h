@@ -28,6 +28,10 @@ typedef struct dcache_struct DCACHE;
 /* Invalidate DCACHE.  */
 void dcache_invalidate (DCACHE *dcache);
 
+/* Discard every line of DCACHE, dirty ones included, without writing
+   anything back.  */
+void dcache_discard (DCACHE *dcache);
+
 /* Initialize DCACHE.  */
 DCACHE *dcache_init (void);
 
@@ -43,4 +47,21 @@ void dcache_update (DCACHE *dcache, enum target_xfer_status status,
 		    CORE_ADDR memaddr, const gdb_byte *myaddr,
 		    ULONGEST len);
 
+int dcache_write_memory_partial (DCACHE *dcache, CORE_ADDR memaddr,
+				 const gdb_byte *myaddr, ULONGEST len,
+				 int allocate, ULONGEST *xfered_len);
+
+/* Write all dirty lines of DCACHE back to the target.  */
+void dcache_flush (DCACHE *dcache);
+
+/* Write the dirty lines of DCACHE that overlap the LEN bytes at
+   MEMADDR back to the target.  */
+void dcache_flush_range (DCACHE *dcache, CORE_ADDR memaddr, ULONGEST len);
+
+/* Add the LEN bytes at MYADDR, the contents of memory at MEMADDR as
+   seen by PTID, to DCACHE.  Only the lines entirely within the range
+   and not already cached are added.  */
+void dcache_prime (DCACHE *dcache, ptid_t ptid, CORE_ADDR memaddr,
+		   const gdb_byte *myaddr, ULONGEST len);
+
 #endif /* DCACHE_H */
@@ -225,6 +225,7 @@ struct gdbarch
   gdbarch_register_sim_regno_ftype *register_sim_regno;
   gdbarch_cannot_fetch_register_ftype *cannot_fetch_register;
   gdbarch_cannot_store_register_ftype *cannot_store_register;
+  gdbarch_fetch_register_on_demand_ftype *fetch_register_on_demand;
   gdbarch_get_longjmp_target_ftype *get_longjmp_target;
   int believe_pcc_promotion;
   gdbarch_convert_register_p_ftype *convert_register_p;
@@ -419,6 +420,7 @@ gdbarch_alloc (const struct gdbarch_info *info,
   gdbarch->register_sim_regno = legacy_register_sim_regno;
   gdbarch->cannot_fetch_register = cannot_register_not;
   gdbarch->cannot_store_register = cannot_register_not;
+  gdbarch->fetch_register_on_demand = cannot_register_not;
   gdbarch->convert_register_p = generic_convert_register_p;
   gdbarch->value_from_register = default_value_from_register;
   gdbarch->pointer_to_address = unsigned_pointer_to_address;
@@ -587,6 +589,7 @@ verify_gdbarch (struct gdbarch *gdbarch)
   /* Skip verify of register_sim_regno, invalid_p == 0 */
   /* Skip verify of cannot_fetch_register, invalid_p == 0 */
   /* Skip verify of cannot_store_register, invalid_p == 0 */
+  /* Skip verify of fetch_register_on_demand, invalid_p == 0 */
   /* Skip verify of get_longjmp_target, has predicate.  */
   /* Skip verify of convert_register_p, invalid_p == 0 */
   /* Skip verify of value_from_register, invalid_p == 0 */
@@ -989,6 +992,9 @@ gdbarch_dump (struct gdbarch *gdbarch, struct ui_file *file)
   fprintf_unfiltered (file,
                       "gdbarch_dump: fetch_pointer_argument = <%s>\n",
                       host_address_to_string (gdbarch->fetch_pointer_argument));
+  fprintf_unfiltered (file,
+                      "gdbarch_dump: fetch_register_on_demand = <%s>\n",
+                      host_address_to_string (gdbarch->fetch_register_on_demand));
   fprintf_unfiltered (file,
                       "gdbarch_dump: gdbarch_fetch_tls_load_module_address_p() = %d\n",
                       gdbarch_fetch_tls_load_module_address_p (gdbarch));
@@ -2528,6 +2534,23 @@ set_gdbarch_cannot_store_register (struct gdbarch *gdbarch,
   gdbarch->cannot_store_register = cannot_store_register;
 }
 
+int
+gdbarch_fetch_register_on_demand (struct gdbarch *gdbarch, int regnum)
+{
+  gdb_assert (gdbarch != NULL);
+  gdb_assert (gdbarch->fetch_register_on_demand != NULL);
+  if (gdbarch_debug >= 2)
+    fprintf_unfiltered (gdb_stdlog, "gdbarch_fetch_register_on_demand called\n");
+  return gdbarch->fetch_register_on_demand (gdbarch, regnum);
+}
+
+void
+set_gdbarch_fetch_register_on_demand (struct gdbarch *gdbarch,
+                                      gdbarch_fetch_register_on_demand_ftype fetch_register_on_demand)
+{
+  gdbarch->fetch_register_on_demand = fetch_register_on_demand;
+}
+
 int
 gdbarch_get_longjmp_target_p (struct gdbarch *gdbarch)
 {
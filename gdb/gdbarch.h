@@ -472,6 +472,13 @@ typedef int (gdbarch_cannot_store_register_ftype) (struct gdbarch *gdbarch, int
 extern int gdbarch_cannot_store_register (struct gdbarch *gdbarch, int regnum);
 extern void set_gdbarch_cannot_store_register (struct gdbarch *gdbarch, gdbarch_cannot_store_register_ftype *cannot_store_register);
 
+/* Return non-zero if REGNUM should only be fetched from the target when
+   it is needed, on its own, rather than along with the other registers. */
+
+typedef int (gdbarch_fetch_register_on_demand_ftype) (struct gdbarch *gdbarch, int regnum);
+extern int gdbarch_fetch_register_on_demand (struct gdbarch *gdbarch, int regnum);
+extern void set_gdbarch_fetch_register_on_demand (struct gdbarch *gdbarch, gdbarch_fetch_register_on_demand_ftype *fetch_register_on_demand);
+
 /* Determine the address where a longjmp will land and save this address
    in PC.  Return nonzero on success.
   
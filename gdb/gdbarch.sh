@@ -508,6 +508,9 @@ M;void;print_vector_info;struct ui_file *file, struct frame_info *frame, const c
 m;int;register_sim_regno;int reg_nr;reg_nr;;legacy_register_sim_regno;;0
 m;int;cannot_fetch_register;int regnum;regnum;;cannot_register_not;;0
 m;int;cannot_store_register;int regnum;regnum;;cannot_register_not;;0
+# Return non-zero if REGNUM should only be fetched from the target when
+# it is needed, on its own, rather than along with the other registers.
+m;int;fetch_register_on_demand;int regnum;regnum;;cannot_register_not;;0
 
 # Determine the address where a longjmp will land and save this address
 # in PC.  Return nonzero on success.
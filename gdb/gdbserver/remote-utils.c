@@ -25,6 +25,9 @@
 #include "tdesc.h"
 #include "dll.h"
 #include "rsp-low.h"
+#ifdef HAVE_LIBZ
+#include "rsp-compress.h"
+#endif
 #include "gdbthread.h"
 #include "netstuff.h"
 #include "filestuff.h"
@@ -114,6 +117,17 @@ static int remote_is_stdio = 0;
 static gdb_fildes_t remote_desc = INVALID_DESCRIPTOR;
 static gdb_fildes_t listen_desc = INVALID_DESCRIPTOR;
 
+#ifdef HAVE_LIBZ
+/* The compression of the packets we send and receive, once GDB has
+   asked for it with QStartCompression.  See rsp-compress.h.  */
+static std::unique_ptr<rsp_deflater> deflater;
+static std::unique_ptr<rsp_inflater> inflater;
+
+/* True if the packets we send are to be compressed once the reply to
+   QStartCompression, which is not, has been sent.  */
+static bool deflate_after_reply;
+#endif
+
 /* FIXME headerize? */
 extern int using_threads;
 extern int debug_threads;
@@ -437,6 +451,12 @@ remote_close (void)
   remote_desc = INVALID_DESCRIPTOR;
 
   reset_readchar ();
+
+#ifdef HAVE_LIBZ
+  deflater.reset ();
+  inflater.reset ();
+  deflate_after_reply = false;
+#endif
 }
 
 #endif
@@ -650,6 +670,23 @@ putpkt_binary_1 (char *buf, int cnt, int is_notif)
   char *p;
   int cc;
 
+#ifdef HAVE_LIBZ
+  std::string compressed;
+
+  if (deflater != NULL)
+    {
+      if (remote_debug)
+	{
+	  debug_printf ("putpkt (\"%.*s\"); [compressed]\n", cnt, buf);
+	  debug_flush ();
+	}
+
+      compressed = deflater->compress (buf, cnt);
+      buf = &compressed[0];
+      cnt = compressed.size ();
+    }
+#endif
+
   buf2 = (char *) xmalloc (strlen ("$") + cnt + strlen ("#nn") + 1);
 
   /* Copy the packet into buffer BUF2, encapsulating it
@@ -722,6 +759,15 @@ putpkt_binary_1 (char *buf, int cnt, int is_notif)
   while (cc != '+');
 
   free (buf2);
+
+#ifdef HAVE_LIBZ
+  if (deflate_after_reply && !is_notif)
+    {
+      deflater.reset (new rsp_deflater ());
+      deflate_after_reply = false;
+    }
+#endif
+
   return 1;			/* Success! */
 }
 
@@ -747,6 +793,22 @@ putpkt_notif (char *buf)
   return putpkt_binary_1 (buf, strlen (buf), 1);
 }
 
+#ifdef HAVE_LIBZ
+
+/* Start compressing the packets of the connection, as requested by
+   the QStartCompression packet being handled.  The packets received
+   from now on are compressed; the packets sent are once the reply to
+   QStartCompression has been sent.  */
+
+void
+remote_start_compression (void)
+{
+  inflater.reset (new rsp_inflater ());
+  deflate_after_reply = true;
+}
+
+#endif
+
 /* Come here when we get an input interrupt from the remote side.  This
    interrupt should only be active while we are waiting for the child to do
    something.  Thus this assumes readchar:bufcnt is 0.
@@ -980,6 +1042,9 @@ getpkt (char *buf)
   char *bp;
   unsigned char csum, c1, c2;
   int c;
+#ifdef HAVE_LIBZ
+  std::string frame;
+#endif
 
   while (1)
     {
@@ -1010,6 +1075,9 @@ getpkt (char *buf)
 	}
 
       bp = buf;
+#ifdef HAVE_LIBZ
+      frame.clear ();
+#endif
       while (1)
 	{
 	  c = readchar ();
@@ -1017,7 +1085,13 @@ getpkt (char *buf)
 	    return -1;
 	  if (c == '#')
 	    break;
-	  *bp++ = c;
+#ifdef HAVE_LIBZ
+	  /* A compressed packet may be longer than BUF.  */
+	  if (inflater != NULL)
+	    frame.push_back (c);
+	  else
+#endif
+	    *bp++ = c;
 	  csum += c;
 	}
       *bp = 0;
@@ -1044,6 +1118,24 @@ getpkt (char *buf)
 	return -1;
     }
 
+#ifdef HAVE_LIBZ
+  if (inflater != NULL)
+    {
+      std::string packet;
+
+      if (!inflater->decompress (frame.data (), frame.size (), &packet)
+	  || packet.size () >= PBUFSIZ)
+	{
+	  fprintf (stderr, "Bad compressed packet, closing connection\n");
+	  return -1;
+	}
+
+      memcpy (buf, packet.data (), packet.size ());
+      bp = buf + packet.size ();
+      *bp = 0;
+    }
+#endif
+
   if (!cs.noack_mode)
     {
       if (remote_debug)
@@ -1128,11 +1220,88 @@ outreg (struct regcache *regcache, int regno, char *buf)
   return buf;
 }
 
+/* Append to BUF, for the "expedite-memory" feature, a
+   "mem:ADDR,CONTENTS;" field with the EXPEDITE_MEMORY_SIZE-aligned
+   block of memory around the address held in each register of
+   REGCACHE's expedite set, followed by the valid registers not in
+   that set.  Registers are left out once the reply that starts at
+   START would take more than half of the packet buffer.  Return the
+   new end of BUF.  */
+
+static char *
+outexpedited (struct regcache *regcache, const char *start, char *buf)
+{
+  const struct target_desc *tdesc = regcache->tdesc;
+  CORE_ADDR blocks[8];
+  int expedited[8];
+  int nblocks = 0, nexpedited = 0;
+  const char **regp;
+
+  for (regp = tdesc->expedite_regs; *regp != NULL; regp++)
+    {
+      int regno = find_regno (tdesc, *regp);
+      unsigned char mem[EXPEDITE_MEMORY_SIZE];
+      ULONGEST value;
+      CORE_ADDR addr;
+      int i;
+
+      if (nexpedited < ARRAY_SIZE (expedited))
+	expedited[nexpedited++] = regno;
+
+      if (regcache_raw_read_unsigned (regcache, regno, &value) != REG_VALID)
+	continue;
+
+      /* Registers holding nearby addresses, like the stack and frame
+	 pointers, share a block.  */
+      addr = value & ~(CORE_ADDR) (EXPEDITE_MEMORY_SIZE - 1);
+      for (i = 0; i < nblocks; i++)
+	if (blocks[i] == addr)
+	  break;
+      if (i < nblocks || nblocks == ARRAY_SIZE (blocks))
+	continue;
+      blocks[nblocks++] = addr;
+
+      if (read_inferior_memory (addr, mem, EXPEDITE_MEMORY_SIZE) != 0)
+	continue;
+
+      sprintf (buf, "mem:%s,", phex_nz (addr, sizeof (addr)));
+      buf += strlen (buf);
+      bin2hex (mem, buf, EXPEDITE_MEMORY_SIZE);
+      buf += 2 * EXPEDITE_MEMORY_SIZE;
+      *buf++ = ';';
+    }
+
+  for (int regno = 0; regno < tdesc->reg_defs.size (); regno++)
+    {
+      int size = register_size (tdesc, regno);
+      int i;
+
+      if (size == 0 || regcache->register_status[regno] != REG_VALID)
+	continue;
+
+      for (i = 0; i < nexpedited; i++)
+	if (expedited[i] == regno)
+	  break;
+      if (i < nexpedited)
+	continue;
+
+      /* Leave room for the register number and the fields that
+	 follow.  */
+      if (buf - start + 2 * size + 8 > PBUFSIZ / 2)
+	break;
+
+      buf = outreg (regcache, regno, buf);
+    }
+
+  return buf;
+}
+
 void
 prepare_resume_reply (char *buf, ptid_t ptid,
 		      struct target_waitstatus *status)
 {
   client_state &cs = get_client_state ();
+  const char *start = buf;
   if (debug_threads)
     debug_printf ("Writing resume reply for %s:%d\n",
 		  target_pid_to_str (ptid), status->kind);
@@ -1256,6 +1425,11 @@ prepare_resume_reply (char *buf, ptid_t ptid,
 	    buf = outreg (regcache, find_regno (regcache->tdesc, *regp), buf);
 	    regp ++;
 	  }
+
+	/* Save GDB the requests it would make to examine the frame the
+	   thread stopped in.  */
+	if (cs.expedite_memory && status->kind == TARGET_WAITKIND_STOPPED)
+	  buf = outexpedited (regcache, start, buf);
 	*buf = '\0';
 
 	/* Formerly, if the debugger had not used any thread features
@@ -1415,6 +1589,20 @@ decode_X_packet (char *from, int packet_len, CORE_ADDR *mem_addr_ptr,
   return 0;
 }
 
+/* Write the reply to an 'x' packet into BUF: a 'b' followed by as
+   many of the LEN bytes at DATA as fit, escaped.  Returns the length
+   of the (binary) reply.  */
+
+int
+write_x_reply (char *buf, const unsigned char *data, int len)
+{
+  int out_len;
+
+  buf[0] = 'b';
+  return remote_escape_output (data, len, 1, (unsigned char *) buf + 1,
+			       &out_len, PBUFSIZ - 2) + 1;
+}
+
 /* Decode a qXfer write request.  */
 
 int
@@ -1545,6 +1733,28 @@ look_up_one_symbol (const char *name, CORE_ADDR *addrp, int may_ask_gdb)
 	  if (putpkt (cs.own_buf) < 0)
 	    return -1;
 	}
+      else if (cs.own_buf[0] == 'x')
+	{
+	  CORE_ADDR mem_addr;
+	  unsigned char *mem_buf;
+	  unsigned int mem_len;
+	  int reply_len;
+
+	  decode_m_packet (&cs.own_buf[1], &mem_addr, &mem_len);
+	  if (mem_len > PBUFSIZ - 2)
+	    mem_len = PBUFSIZ - 2;
+	  mem_buf = (unsigned char *) xmalloc (mem_len);
+	  if (read_inferior_memory (mem_addr, mem_buf, mem_len) == 0)
+	    reply_len = write_x_reply (cs.own_buf, mem_buf, mem_len);
+	  else
+	    {
+	      write_enn (cs.own_buf);
+	      reply_len = strlen (cs.own_buf);
+	    }
+	  free (mem_buf);
+	  if (putpkt_binary (cs.own_buf, reply_len) < 0)
+	    return -1;
+	}
       else if (cs.own_buf[0] == 'v')
 	{
 	  int new_len = -1;
@@ -1622,11 +1832,13 @@ relocate_instruction (CORE_ADDR *to, CORE_ADDR oldloc)
      wait for the qRelocInsn "response".  That requires re-entering
      the main loop.  For now, this is an adequate approximation; allow
      GDB to access memory.  */
-  while (cs.own_buf[0] == 'm' || cs.own_buf[0] == 'M' || cs.own_buf[0] == 'X')
+  while (cs.own_buf[0] == 'm' || cs.own_buf[0] == 'x'
+	 || cs.own_buf[0] == 'M' || cs.own_buf[0] == 'X')
     {
       CORE_ADDR mem_addr;
       unsigned char *mem_buf = NULL;
       unsigned int mem_len;
+      int reply_len = -1;
 
       if (cs.own_buf[0] == 'm')
 	{
@@ -1637,6 +1849,17 @@ relocate_instruction (CORE_ADDR *to, CORE_ADDR oldloc)
 	  else
 	    write_enn (cs.own_buf);
 	}
+      else if (cs.own_buf[0] == 'x')
+	{
+	  decode_m_packet (&cs.own_buf[1], &mem_addr, &mem_len);
+	  if (mem_len > PBUFSIZ - 2)
+	    mem_len = PBUFSIZ - 2;
+	  mem_buf = (unsigned char *) xmalloc (mem_len);
+	  if (read_inferior_memory (mem_addr, mem_buf, mem_len) == 0)
+	    reply_len = write_x_reply (cs.own_buf, mem_buf, mem_len);
+	  else
+	    write_enn (cs.own_buf);
+	}
       else if (cs.own_buf[0] == 'X')
 	{
 	  if (decode_X_packet (&cs.own_buf[1], len - 1, &mem_addr,
@@ -1655,7 +1878,12 @@ relocate_instruction (CORE_ADDR *to, CORE_ADDR oldloc)
 	    write_enn (cs.own_buf);
 	}
       free (mem_buf);
-      if (putpkt (cs.own_buf) < 0)
+      if (reply_len != -1)
+	{
+	  if (putpkt_binary (cs.own_buf, reply_len) < 0)
+	    return -1;
+	}
+      else if (putpkt (cs.own_buf) < 0)
 	return -1;
       len = getpkt (cs.own_buf);
       if (len < 0)
@@ -32,6 +32,7 @@ char *write_ptid (char *buf, ptid_t ptid);
 int putpkt (char *buf);
 int putpkt_binary (char *buf, int len);
 int putpkt_notif (char *buf);
+void remote_start_compression (void);
 int getpkt (char *buf);
 void remote_prepare (const char *name);
 void remote_open (const char *name);
@@ -53,6 +54,7 @@ void decode_M_packet (char *from, CORE_ADDR * mem_addr_ptr,
 		      unsigned int *len_ptr, unsigned char **to_p);
 int decode_X_packet (char *from, int packet_len, CORE_ADDR * mem_addr_ptr,
 		     unsigned int *len_ptr, unsigned char **to_p);
+int write_x_reply (char *buf, const unsigned char *data, int len);
 int decode_xfer_write (char *buf, int packet_len,
 		       CORE_ADDR *offset, unsigned int *len,
 		       unsigned char *data);
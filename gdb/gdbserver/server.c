@@ -725,6 +725,29 @@ handle_general_set (char *own_buf)
       return;
     }
 
+#ifdef HAVE_LIBZ
+  if (strcmp (own_buf, "QStartCompression") == 0)
+    {
+      /* A packet resent for want of an acknowledgment would be
+	 decompressed twice.  See rsp-compress.h.  */
+      if (!cs.noack_mode)
+	{
+	  write_enn (own_buf);
+	  return;
+	}
+
+      if (remote_debug)
+	{
+	  debug_printf ("[compression enabled]\n");
+	  debug_flush ();
+	}
+
+      remote_start_compression ();
+      write_ok (own_buf);
+      return;
+    }
+#endif
+
   if (startswith (own_buf, "QNonStop:"))
     {
       char *mode = own_buf + 9;
@@ -2329,6 +2352,12 @@ handle_query (char *own_buf, int packet_len, int *new_packet_len_p)
 		  if (target_supports_stopped_by_hw_breakpoint ())
 		    cs.hwbreak_feature = 1;
 		}
+	      else if (strcmp (p, "expedite-memory+") == 0)
+		{
+		  /* GDB wants stop replies to carry all the registers
+		     and the memory around the stack and the PC.  */
+		  cs.expedite_memory = 1;
+		}
 	      else if (strcmp (p, "fork-events+") == 0)
 		{
 		  /* GDB supports and wants fork events if possible.  */
@@ -2379,8 +2408,8 @@ handle_query (char *own_buf, int packet_len, int *new_packet_len_p)
 	       "PacketSize=%x;QPassSignals+;QProgramSignals+;"
 	       "QStartupWithShell+;QEnvironmentHexEncoded+;"
 	       "QEnvironmentReset+;QEnvironmentUnset+;"
-	       "QSetWorkingDir+",
-	       PBUFSIZ - 1);
+	       "QSetWorkingDir+;MemoryWriteWindow=%x;binary-upload+",
+	       PBUFSIZ - 1, MEMORY_WRITE_WINDOW);
 
       if (target_supports_catch_syscall ())
 	strcat (own_buf, ";QCatchSyscalls+");
@@ -2414,7 +2443,14 @@ handle_query (char *own_buf, int packet_len, int *new_packet_len_p)
       strcat (own_buf, ";qXfer:features:read+");
 
       if (cs.transport_is_reliable)
-	strcat (own_buf, ";QStartNoAckMode+");
+	{
+	  strcat (own_buf, ";QStartNoAckMode+");
+
+#ifdef HAVE_LIBZ
+	  /* Compression requires noack mode.  */
+	  strcat (own_buf, ";QStartCompression+");
+#endif
+	}
 
       if (the_target->qxfer_osdata != NULL)
 	strcat (own_buf, ";qXfer:osdata:read+");
@@ -2474,6 +2510,8 @@ handle_query (char *own_buf, int packet_len, int *new_packet_len_p)
       if (target_supports_stopped_by_hw_breakpoint ())
 	strcat (own_buf, ";hwbreak+");
 
+      strcat (own_buf, ";expedite-memory+");
+
       if (the_target->pid_to_exec_file != NULL)
 	strcat (own_buf, ";qXfer:exec-file:read+");
 
@@ -3857,6 +3895,7 @@ captured_main (int argc, char *argv[])
       cs.cont_thread = null_ptid;
       cs.swbreak_feature = 0;
       cs.hwbreak_feature = 0;
+      cs.expedite_memory = 0;
       cs.vCont_supported = 0;
 
       remote_open (port);
@@ -4185,6 +4224,21 @@ process_serial_event (void)
 	  bin2hex (mem_buf, cs.own_buf, res);
       }
       break;
+    case 'x':
+      {
+	require_running_or_break (cs.own_buf);
+	decode_m_packet (&cs.own_buf[1], &mem_addr, &len);
+	/* MEM_BUF holds PBUFSIZ bytes, and the reply can carry no more
+	   than this even if nothing needs escaping.  */
+	if (len > PBUFSIZ - 2)
+	  len = PBUFSIZ - 2;
+	int res = gdb_read_memory (mem_addr, mem_buf, len);
+	if (res < 0)
+	  write_enn (cs.own_buf);
+	else
+	  new_packet_len = write_x_reply (cs.own_buf, mem_buf, res);
+      }
+      break;
     case 'M':
       require_running_or_break (cs.own_buf);
       decode_M_packet (&cs.own_buf[1], &mem_addr, &len, &mem_buf);
@@ -115,6 +115,19 @@ extern int in_queued_stop_replies (ptid_t ptid);
    as large as the largest register set supported by gdbserver.  */
 #define PBUFSIZ 18432
 
+/* The number of memory write packets GDB may send before waiting for
+   their replies, advertised with the "MemoryWriteWindow" qSupported
+   feature.  Packets that arrive early simply wait in the connection's
+   buffers until the previous one has been handled.  */
+#define MEMORY_WRITE_WINDOW 16
+
+/* The size of the blocks of memory sent in a stop reply with the
+   "expedite-memory" feature, one around the address held in each
+   register the target description expedites (the stack pointer and
+   the program counter, typically).  A power of two, and a multiple of
+   GDB's default dcache line size so that GDB can cache the blocks.  */
+#define EXPEDITE_MEMORY_SIZE 128
+
 /* Definition for an unknown syscall, used basically in error-cases.  */
 #define UNKNOWN_SYSCALL (-1)
 
@@ -169,6 +182,11 @@ struct client_state
      Only enabled if the target supports it.  */
   int hwbreak_feature = 0;
 
+  /* True if the "expedite-memory+" feature is active.  In that case,
+     GDB wants stop replies to carry all the registers, and the memory
+     around the stack pointer and program counter.  */
+  int expedite_memory = 0;
+
   /* True if the "vContSupported" feature is active.  In that case, GDB
      wants us to report whether single step is supported in the reply to
      "vCont?" packet.  */
@@ -37,7 +37,16 @@
 #include "top.h"		/* set_prompt () */
 #include "ui-out.h"		/* current_uiout */
 #include "exceptions.h"
+#include "common/rsp-low.h"
+#include "common/byte-vector.h"
+#include "common/pathstuff.h"
+#include "event-loop.h"
+#include "observable.h"
+#include "common/filestuff.h"
+#include "sha1.h"
 #include <ctype.h>
+#include <algorithm>
+#include <map>
 
 #include "elf-bfd.h"		/* elf_elfheader () */
 #include "objfiles.h"
@@ -120,166 +129,992 @@ nds_issue_qrcmd (const char *cmd, string_file &str)
   return 0;
 }
 
+/* One row of profiling data.  The first column is the address the
+   row is about; the remaining fields are kept as the target sent
+   them.  */
+
+struct nds_profiling_row
+{
+  CORE_ADDR addr = 0;
+  /* Value of the sort column, if any.  */
+  double key = 0;
+  /* Order in which the row was received, used to keep sorting stable.  */
+  size_t seq = 0;
+  std::vector<std::string> fields;
+};
+
+/* Streaming parser for the reply of "set CPU profiling ide-query".
+   The reply is a list of ';'-separated fields: "Row=R;Column=C;",
+   then C column names, then R - 1 rows of C fields each.  The parser
+   is installed as gdb_stdtarg, so it consumes the qRcmd output as each
+   chunk arrives instead of copying the whole reply first.
+
+   If TOP_N is non-zero, only the TOP_N first rows (or, with a sort
+   column, the TOP_N greatest rows) are kept.  */
+
+class nds_profiling_parser : public ui_file
+{
+public:
+  nds_profiling_parser (const char *sort_column, size_t top_n)
+    : m_sort_column (sort_column), m_top_n (top_n)
+  {}
+
+  void write (const char *buf, long length_buf) override;
+
+  long read (char *buf, long length_buf) override
+  { gdb_assert_not_reached ("a nds_profiling_parser is not readable"); }
+
+  /* Flush the last field and validate what has been parsed; a row
+     left incomplete is an error.  */
+  void finish ();
+
+  int rows () const { return m_rows; }
+  const std::vector<std::string> &columns () const { return m_columns; }
+
+  /* Return the parsed rows, sorted if a sort column was given.  */
+  std::vector<nds_profiling_row> &result ();
+
+private:
+  void field (std::string &&text);
+  void add_row (nds_profiling_row &&row);
+
+  /* Return true if row A should be printed before row B.  */
+  static bool row_before (const nds_profiling_row &a,
+			  const nds_profiling_row &b)
+  {
+    if (a.key != b.key)
+      return a.key > b.key;
+    return a.seq < b.seq;
+  }
+
+  const char *m_sort_column;
+  size_t m_top_n;
+
+  /* Number of header fields ("Row=", "Column=") seen so far.  */
+  int m_header = 0;
+  bool m_failed = false;
+  int m_rows = -1;
+  int m_cols = -1;
+  int m_sort_index = -1;
+  size_t m_seq = 0;
+
+  std::string m_token;
+  std::vector<std::string> m_columns;
+  nds_profiling_row m_current;
+  std::vector<nds_profiling_row> m_result;
+};
+
+void
+nds_profiling_parser::write (const char *buf, long length_buf)
+{
+  const char *end = buf + length_buf;
+
+  while (buf < end)
+    {
+      const char *sc = (const char *) memchr (buf, ';', end - buf);
+
+      if (sc == NULL)
+	{
+	  m_token.append (buf, end - buf);
+	  return;
+	}
+
+      m_token.append (buf, sc - buf);
+      field (std::move (m_token));
+      m_token.clear ();
+      buf = sc + 1;
+    }
+}
+
+/* Strip leading and trailing white space from TEXT.  */
+
+static void
+nds_strip_field (std::string &text)
+{
+  const char *ws = " \t\f\v\n\r";
+  size_t first = text.find_first_not_of (ws);
+
+  if (first == std::string::npos)
+    {
+      text.clear ();
+      return;
+    }
+  text.erase (text.find_last_not_of (ws) + 1);
+  text.erase (0, first);
+}
+
+void
+nds_profiling_parser::field (std::string &&text)
+{
+  nds_strip_field (text);
+
+  /* Errors are reported by finish, once target_rcmd has returned.  */
+  if (m_failed)
+    return;
+
+  if (m_header == 0)
+    {
+      if (sscanf (text.c_str (), "Row=%d", &m_rows) != 1)
+	m_failed = true;
+      m_header++;
+      return;
+    }
+  else if (m_header == 1)
+    {
+      if (sscanf (text.c_str (), "Column=%d", &m_cols) != 1 || m_cols <= 0)
+	m_failed = true;
+      m_header++;
+      m_columns.reserve (m_cols);
+      return;
+    }
+
+  if ((int) m_columns.size () < m_cols)
+    {
+      if (m_sort_column != NULL && text == m_sort_column)
+	m_sort_index = m_columns.size ();
+      m_columns.push_back (std::move (text));
+      return;
+    }
+
+  if (m_current.fields.empty ())
+    {
+      m_current.fields.reserve (m_cols);
+      /* Assume first column is address.  */
+      m_current.addr = strtoulst (text.c_str (), NULL, 16);
+    }
+  if ((int) m_current.fields.size () == m_sort_index)
+    m_current.key = strtod (text.c_str (), NULL);
+  m_current.fields.push_back (std::move (text));
+
+  if ((int) m_current.fields.size () == m_cols)
+    {
+      m_current.seq = m_seq++;
+      add_row (std::move (m_current));
+      m_current = nds_profiling_row ();
+    }
+}
+
+void
+nds_profiling_parser::add_row (nds_profiling_row &&row)
+{
+  if (m_top_n == 0)
+    {
+      m_result.push_back (std::move (row));
+      return;
+    }
+
+  /* Without a sort column, the first TOP_N rows win.  */
+  if (m_sort_index == -1)
+    {
+      if (m_result.size () < m_top_n)
+	m_result.push_back (std::move (row));
+      return;
+    }
+
+  /* Keep a heap of the TOP_N best rows seen so far, with the worst one
+     at the front.  */
+  if (m_result.size () < m_top_n)
+    {
+      m_result.push_back (std::move (row));
+      std::push_heap (m_result.begin (), m_result.end (), row_before);
+    }
+  else if (row_before (row, m_result.front ()))
+    {
+      std::pop_heap (m_result.begin (), m_result.end (), row_before);
+      m_result.back () = std::move (row);
+      std::push_heap (m_result.begin (), m_result.end (), row_before);
+    }
+}
+
+void
+nds_profiling_parser::finish ()
+{
+  /* The reply normally ends with a ';', but a last field without one
+     is still a field.  */
+  nds_strip_field (m_token);
+  if (!m_token.empty ())
+    field (std::move (m_token));
+  m_token.clear ();
+
+  if (m_failed || m_header < 2 || !m_current.fields.empty ())
+    error (_("Failed to query profiling data"));
+  if (m_sort_column != NULL && m_sort_index == -1)
+    error (_("No profiling column named `%s'"), m_sort_column);
+}
+
+std::vector<nds_profiling_row> &
+nds_profiling_parser::result ()
+{
+  if (m_sort_index != -1)
+    std::sort (m_result.begin (), m_result.end (), row_before);
+  return m_result;
+}
+
+/* Look up the minimal symbol of every address of ADDRS in one pass, in
+   address order, so that addresses inside the same minimal symbol share
+   a single lookup.  MSYMBOLS[i] receives the symbol of ADDRS[i].  */
+
+static void
+nds_lookup_msymbols (const std::vector<CORE_ADDR> &addrs,
+		     std::vector<bound_minimal_symbol> &msymbols)
+{
+  std::vector<size_t> order (addrs.size ());
+  struct bound_minimal_symbol msymbol;
+  CORE_ADDR start = 0, end = 0;
+
+  for (size_t i = 0; i < order.size (); i++)
+    order[i] = i;
+  std::sort (order.begin (), order.end (),
+	     [&] (size_t a, size_t b) { return addrs[a] < addrs[b]; });
+
+  msymbols.resize (addrs.size ());
+  for (size_t i : order)
+    {
+      CORE_ADDR addr = addrs[i];
+
+      if (msymbol.minsym == NULL || addr < start || addr >= end)
+	{
+	  msymbol = lookup_minimal_symbol_by_pc (addr);
+	  if (msymbol.minsym == NULL)
+	    continue;
+	  start = BMSYMBOL_VALUE_ADDRESS (msymbol);
+	  end = minimal_symbol_upper_bound (msymbol);
+	}
+
+      msymbols[i] = msymbol;
+    }
+}
+
+/* Resolve the symbol of every row of ROWS.  SYMBOLS[i] receives the
+   text printed for ROWS[i].  */
+
+static void
+nds_profiling_symbolize (const std::vector<nds_profiling_row> &rows,
+			 std::vector<std::string> &symbols)
+{
+  std::vector<CORE_ADDR> addrs (rows.size ());
+  std::vector<bound_minimal_symbol> msymbols;
+
+  for (size_t i = 0; i < rows.size (); i++)
+    addrs[i] = rows[i].addr;
+  nds_lookup_msymbols (addrs, msymbols);
+
+  symbols.resize (rows.size ());
+  for (size_t i = 0; i < rows.size (); i++)
+    {
+      if (msymbols[i].minsym == NULL)
+	continue;
+
+      const char *name = MSYMBOL_PRINT_NAME (msymbols[i].minsym);
+      int offset = addrs[i] - BMSYMBOL_VALUE_ADDRESS (msymbols[i]);
+
+      if (offset)
+	symbols[i] = string_printf ("%s + 0x%x", name, offset);
+      else
+	symbols[i] = name;
+    }
+}
+
 /* Pretty-print for profiling data.  */
 
 static void
-nds_print_human_table (int col, int row, const char *scsv)
+nds_print_human_table (nds_profiling_parser &parser)
+{
+  const std::vector<std::string> &columns = parser.columns ();
+  std::vector<nds_profiling_row> &rows = parser.result ();
+  std::vector<std::string> symbols;
+  int col = columns.size ();
+  int i;
+
+  nds_profiling_symbolize (rows, symbols);
+
+  /* Output table.  The symbol of each row is printed as an extra
+     column so that MI consumers get it as a field too.  */
+  ui_out_emit_table table_emitter (current_uiout, col + 1, rows.size (),
+				   "ProfilingTable");
+  for (i = 0; i < col; i++)
+    {
+      int width;
+
+      if (columns[i][0] == '%')
+	width = 6;
+      else
+	width = columns[i].size () + 1;
+
+      current_uiout->table_header (width, ui_right, columns[i].c_str (),
+				   columns[i].c_str ());
+    }
+  current_uiout->table_header (1, ui_noalign, "symbol", "");
+
+  current_uiout->table_body ();
+
+  for (size_t r = 0; r < rows.size (); r++)
+    {
+      ui_out_emit_tuple tuple_emitter (current_uiout, "row");
+
+      for (i = 0; i < col; i++)
+	current_uiout->field_string (columns[i].c_str (),
+				     rows[r].fields[i].c_str ());
+      current_uiout->field_string ("symbol", symbols[r].c_str ());
+      current_uiout->text ("\n");
+    }
+}
+
+/* Callback for "nds query profiling" command.
+
+   Usage: nds query profiling [CPU] [human|ide] [sort=COLUMN] [top=N]  */
+
+static void
+nds_query_profiling_command (const char *args, int from_tty)
+{
+  /* For profiling, there will be multiple responses.  */
+  char cmd[256];
+  const char *arg_cpu = "cpu";
+  int arg_human = 1;
+  const char *arg_sort = NULL;
+  size_t arg_top = 0;
+  int i;
+
+  gdb_argv argv (args);
+
+  /* operator!= is overloading, so it can be used to check if args is NULL.  */
+  if (argv != NULL)
+    {
+      for (i = 0; argv[i] != NULL; i++)
+	{
+	  if (strcmp (argv[i], "ide") == 0)
+	    arg_human = 0;
+	  else if (strcmp (argv[i], "human") == 0)
+	    arg_human = 1;
+	  else if (startswith (argv[i], "sort="))
+	    arg_sort = argv[i] + 5;
+	  else if (startswith (argv[i], "top="))
+	    {
+	      LONGEST top = parse_and_eval_long (argv[i] + 4);
+
+	      if (top < 0)
+		error (_("Invalid row count: %s"), argv[i] + 4);
+	      arg_top = top;
+	    }
+	  else if (i == 0 && *argv[i] != '\0')
+	    arg_cpu = argv[i];
+	}
+    }
+
+  xsnprintf (cmd, sizeof (cmd), "set %s profiling ide-query", arg_cpu);
+
+  if (arg_human == 0)
+    {
+      string_file res;
+
+      if (nds_issue_qrcmd (cmd, res) == -1)
+	return;
+
+      fprintf_unfiltered (gdb_stdtarg,
+			  "=profiling,reason=\"fast_l1_profiling\",data=\"%s\"\n",
+			  res.c_str() );
+      return;
+    }
+
+  /* The first response is Row=%d;Column=%d;
+     and then comes 'Row' rows, including head row */
+  nds_profiling_parser parser (arg_sort, arg_top);
+
+  {
+    scoped_restore save_stdtarg = make_scoped_restore (&gdb_stdtarg,
+						       (ui_file *) &parser);
+
+    TRY
+      {
+	target_rcmd (cmd, &parser);
+      }
+    CATCH (except, RETURN_MASK_ERROR)
+      {
+	return;
+      }
+    END_CATCH
+  }
+
+  parser.finish ();
+
+  /* Print human-mode table here.  */
+  nds_print_human_table (parser);
+}
+
+/* Continuous profiling.
+
+   "nds profile record start" periodically drains the target's
+   profiling buffer ("set CPU profiling ide-query") from a timer in the
+   event loop, and appends one (address, samples) record per address
+   whose count grew since the previous drain to a ring file on disk.
+   The buffer is never reset, so no sample taken between two monitor
+   commands is lost.  Instead, the counts found by a first drain when
+   recording starts serve as the baseline, and are not recorded.  The
+   ring file can then be turned into a flat
+   profile with "nds profile report", or into a gprof-compatible
+   histogram with "nds profile gmon".
+
+   In all-stop mode the remote protocol cannot carry qRcmd while the
+   target is running.  Draining a running target therefore needs the
+   connection to be in non-stop mode, which "maint set target-non-stop
+   on" provides even when GDB presents all-stop; otherwise a drain
+   that falls due while the target runs is done at the next stop.
+
+   The ring file holds a header followed by CAPACITY records; once it
+   is full the oldest records are overwritten.  Everything is stored
+   in host byte order, as the file is only meant to be read back by
+   GDB on the same host.  */
+
+#define NDS_PROFILE_MAGIC	"NDSPROF"
+#define NDS_PROFILE_VERSION	2
+#define NDS_PROFILE_HDR_SIZE	24
+#define NDS_PROFILE_REC_SIZE	16
+
+struct nds_profile_ring
+{
+  gdb_file_up file;
+  uint32_t capacity = 0;
+  /* Number of records ever appended.  */
+  uint64_t head = 0;
+};
+
+/* State of "nds profile record".  */
+
+static struct
+{
+  bool active;
+  std::string cpu;
+  int interval;
+  int timer_id;
+  nds_profile_ring ring;
+  /* The target's count for each address at the previous drain.  */
+  std::map<CORE_ADDR, ULONGEST> counts;
+  /* False until COUNTS holds the baseline, taken by the first drain.  */
+  bool have_baseline;
+  /* True if a drain fell due while the target could not be drained.  */
+  bool due;
+  /* Number of drains and records written during this recording.  */
+  unsigned long drains;
+  unsigned long records;
+} nds_profile_state;
+
+/* Write the header of RING back to its file.  */
+
+static void
+nds_profile_ring_write_header (nds_profile_ring &ring)
+{
+  gdb_byte hdr[NDS_PROFILE_HDR_SIZE] = { 0 };
+  uint32_t version = NDS_PROFILE_VERSION;
+
+  memcpy (hdr, NDS_PROFILE_MAGIC, sizeof (NDS_PROFILE_MAGIC));
+  memcpy (hdr + 8, &version, 4);
+  memcpy (hdr + 12, &ring.capacity, 4);
+  memcpy (hdr + 16, &ring.head, 8);
+
+  if (fseek (ring.file.get (), 0, SEEK_SET) != 0
+      || fwrite (hdr, sizeof (hdr), 1, ring.file.get ()) != 1
+      || fflush (ring.file.get ()) != 0)
+    error (_("Cannot write profile ring file: %s"),
+	   safe_strerror (errno));
+}
+
+/* Open the ring file FILENAME into RING.  If CAPACITY is non-zero, the
+   file is created (or truncated) to hold CAPACITY records; otherwise
+   an existing file is opened for reading.  */
+
+static void
+nds_profile_ring_open (nds_profile_ring &ring, const char *filename,
+		       uint32_t capacity)
+{
+  gdb_byte hdr[NDS_PROFILE_HDR_SIZE];
+  uint32_t version;
+
+  ring.file = gdb_fopen_cloexec (filename, capacity != 0 ? "w+b" : "rb");
+  if (ring.file == NULL)
+    perror_with_name (filename);
+
+  if (capacity != 0)
+    {
+      ring.capacity = capacity;
+      ring.head = 0;
+      nds_profile_ring_write_header (ring);
+      return;
+    }
+
+  if (fread (hdr, sizeof (hdr), 1, ring.file.get ()) != 1
+      || memcmp (hdr, NDS_PROFILE_MAGIC, sizeof (NDS_PROFILE_MAGIC)) != 0)
+    error (_("`%s' is not a profile ring file"), filename);
+
+  memcpy (&version, hdr + 8, 4);
+  if (version != NDS_PROFILE_VERSION)
+    error (_("`%s' has unsupported version %u"), filename, version);
+
+  memcpy (&ring.capacity, hdr + 12, 4);
+  memcpy (&ring.head, hdr + 16, 8);
+  if (ring.capacity == 0)
+    error (_("`%s' is not a profile ring file"), filename);
+}
+
+/* Append the record (ADDR, COUNT) to RING.  */
+
+static void
+nds_profile_ring_append (nds_profile_ring &ring, uint64_t addr,
+			 uint64_t count)
+{
+  uint64_t rec[2] = { addr, count };
+  long offset = (NDS_PROFILE_HDR_SIZE
+		 + (ring.head % ring.capacity) * NDS_PROFILE_REC_SIZE);
+
+  if (fseek (ring.file.get (), offset, SEEK_SET) != 0
+      || fwrite (rec, sizeof (rec), 1, ring.file.get ()) != 1)
+    error (_("Cannot write profile ring file: %s"),
+	   safe_strerror (errno));
+  ring.head++;
+}
+
+/* Read every valid record of RING, summing the samples of records with
+   the same address into SAMPLES.  */
+
+static void
+nds_profile_ring_read (nds_profile_ring &ring,
+		       std::map<CORE_ADDR, ULONGEST> &samples)
+{
+  uint64_t n = std::min (ring.head, (uint64_t) ring.capacity);
+  uint64_t rec[2];
+
+  if (fseek (ring.file.get (), NDS_PROFILE_HDR_SIZE, SEEK_SET) != 0)
+    perror_with_name (_("profile ring file"));
+
+  for (uint64_t i = 0; i < n; i++)
+    {
+      if (fread (rec, sizeof (rec), 1, ring.file.get ()) != 1)
+	error (_("Profile ring file is truncated"));
+      samples[rec[0]] += rec[1];
+    }
+}
+
+/* Drain the target's profiling buffer into the ring file.  The first
+   drain of a recording only takes the baseline counts.  */
+
+static void
+nds_profile_drain (void)
+{
+  char cmd[256];
+  nds_profiling_parser parser (NULL, 0);
+
+  xsnprintf (cmd, sizeof (cmd), "set %s profiling ide-query",
+	     nds_profile_state.cpu.c_str ());
+
+  {
+    scoped_restore save_stdtarg = make_scoped_restore (&gdb_stdtarg,
+						       (ui_file *) &parser);
+    target_rcmd (cmd, &parser);
+  }
+  parser.finish ();
+
+  /* The second column holds the number of samples of each address
+     since the buffer was last reset; record what was added since the
+     previous drain.  */
+  for (const nds_profiling_row &row : parser.result ())
+    {
+      ULONGEST count = 1;
+
+      if (row.fields.size () > 1)
+	count = strtoulst (row.fields[1].c_str (), NULL, 10);
+
+      ULONGEST &last = nds_profile_state.counts[row.addr];
+      /* A smaller count means the buffer was reset behind our back,
+	 so all of it is new.  */
+      ULONGEST delta = count >= last ? count - last : count;
+
+      last = count;
+      if (delta == 0 || !nds_profile_state.have_baseline)
+	continue;
+
+      nds_profile_ring_append (nds_profile_state.ring, row.addr, delta);
+      nds_profile_state.records++;
+    }
+
+  if (!nds_profile_state.have_baseline)
+    {
+      nds_profile_state.have_baseline = true;
+      return;
+    }
+
+  nds_profile_ring_write_header (nds_profile_state.ring);
+  nds_profile_state.drains++;
+}
+
+/* Return true if a monitor command can be sent to the target now.  */
+
+static bool
+nds_profile_can_drain (void)
+{
+  return (target_has_execution
+	  && (target_is_non_stop_p () || !threads_are_executing ()));
+}
+
+/* Drain the profiling buffer, reporting rather than propagating any
+   error since this runs from the event loop.  */
+
+static void
+nds_profile_try_drain (void)
+{
+  if (!nds_profile_state.active || !nds_profile_can_drain ())
+    return;
+
+  nds_profile_state.due = false;
+  TRY
+    {
+      nds_profile_drain ();
+    }
+  CATCH (except, RETURN_MASK_ERROR)
+    {
+      exception_print (gdb_stderr, except);
+    }
+  END_CATCH
+}
+
+/* Timer callback of "nds profile record".  */
+
+static void
+nds_profile_timer (gdb_client_data data)
+{
+  nds_profile_state.timer_id = -1;
+  if (!nds_profile_state.active)
+    return;
+
+  if (nds_profile_can_drain ())
+    nds_profile_try_drain ();
+  else
+    nds_profile_state.due = true;
+
+  if (nds_profile_state.active)
+    nds_profile_state.timer_id
+      = create_timer (nds_profile_state.interval, nds_profile_timer, NULL);
+}
+
+/* Observer of normal_stop; drain what was profiled while running, if
+   the timer expired meanwhile.  Stops that come sooner, as when
+   stepping, cost no round trip.  */
+
+static void
+nds_profile_normal_stop (struct bpstats *bs, int print_frame)
+{
+  if (nds_profile_state.due)
+    nds_profile_try_drain ();
+}
+
+/* Callback for "nds profile" command.  */
+
+static void
+nds_profile_command (const char *args, int from_tty)
+{
+  error (_("Usage: nds profile (record|report|gmon) ..."));
+}
+
+/* Callback for "nds profile record" command.  */
+
+static void
+nds_profile_record_command (const char *args, int from_tty)
+{
+  error (_("Usage: nds profile record (start|stop)"));
+}
+
+/* Callback for "nds profile record start" command.
+
+   Usage: nds profile record start [FILE] [interval=MS] [capacity=N]
+	  [cpu=CPU]  */
+
+static void
+nds_profile_record_start_command (const char *args, int from_tty)
+{
+  const char *filename = "nds-profile.ring";
+  const char *cpu = "cpu";
+  LONGEST interval = 1000;
+  LONGEST capacity = 65536;
+  int i;
+
+  if (nds_profile_state.active)
+    error (_("Profile recording is already active."));
+
+  gdb_argv argv (args);
+
+  if (argv != NULL)
+    {
+      for (i = 0; argv[i] != NULL; i++)
+	{
+	  if (startswith (argv[i], "interval="))
+	    interval = parse_and_eval_long (argv[i] + 9);
+	  else if (startswith (argv[i], "capacity="))
+	    capacity = parse_and_eval_long (argv[i] + 9);
+	  else if (startswith (argv[i], "cpu="))
+	    cpu = argv[i] + 4;
+	  else
+	    filename = argv[i];
+	}
+    }
+
+  if (interval <= 0)
+    error (_("Invalid interval %s"), plongest (interval));
+  if (capacity <= 0 || capacity > UINT32_MAX)
+    error (_("Invalid capacity %s"), plongest (capacity));
+
+  nds_profile_state.cpu = cpu;
+  nds_profile_state.counts.clear ();
+  nds_profile_state.have_baseline = false;
+
+  /* Samples the target took before now belong to no recording.  Take
+     the baseline now if we can; otherwise the first drain does, and
+     the samples taken until then are lost too.  */
+  if (nds_profile_can_drain ())
+    nds_profile_drain ();
+
+  nds_profile_ring_open (nds_profile_state.ring, filename, capacity);
+  nds_profile_state.interval = interval;
+  nds_profile_state.due = false;
+  nds_profile_state.drains = 0;
+  nds_profile_state.records = 0;
+  nds_profile_state.active = true;
+  nds_profile_state.timer_id
+    = create_timer (nds_profile_state.interval, nds_profile_timer, NULL);
+
+  if (from_tty)
+    printf_filtered (_("Recording profile samples to `%s' every %s ms.\n"),
+		     filename, plongest (interval));
+  if (target_has_execution && !target_is_non_stop_p ())
+    warning (_("The target is in all-stop mode, so samples are only "
+	       "drained while it is stopped.\n"
+	       "Use \"maint set target-non-stop on\" before connecting "
+	       "to drain them while it runs."));
+}
+
+/* Callback for "nds profile record stop" command.  */
+
+static void
+nds_profile_record_stop_command (const char *args, int from_tty)
+{
+  if (!nds_profile_state.active)
+    error (_("Profile recording is not active."));
+
+  /* Collect what is left in the target's buffer.  */
+  nds_profile_try_drain ();
+
+  nds_profile_state.active = false;
+  if (nds_profile_state.timer_id != -1)
+    {
+      delete_timer (nds_profile_state.timer_id);
+      nds_profile_state.timer_id = -1;
+    }
+  nds_profile_state.ring.file.reset ();
+  nds_profile_state.counts.clear ();
+
+  if (from_tty)
+    printf_filtered (_("Recorded %lu records in %lu drains.\n"),
+		     nds_profile_state.records, nds_profile_state.drains);
+}
+
+/* Callback for "nds profile report" command, which prints a flat
+   profile of a ring file, one row per function.
+
+   Usage: nds profile report [FILE] [top=N]  */
+
+static void
+nds_profile_report_command (const char *args, int from_tty)
 {
+  const char *filename = "nds-profile.ring";
+  LONGEST top = 0;
+  nds_profile_ring ring;
+  std::map<CORE_ADDR, ULONGEST> samples;
+  std::vector<CORE_ADDR> addrs;
+  std::vector<bound_minimal_symbol> msymbols;
+  ULONGEST total = 0;
   int i;
-  char *buf = NULL;
-  char symbol_text[256];
-  struct cleanup *cleanup = NULL;
-
-  buf = xstrdup (scsv);
-  cleanup = make_cleanup (xfree, buf);
-
-  /* Allocate header structures.  */
-  gdb::unique_xmalloc_ptr<char *[]> col_fldname
-    ((char **) xmalloc (sizeof (char *) * col));
-  gdb::unique_xmalloc_ptr<char *[]> col_hdrtext
-    ((char **) xmalloc (sizeof (char *) * col));
-  gdb::unique_xmalloc_ptr<int[]> col_width
-    ((int *) xmalloc (sizeof (int) * col));
-  gdb::unique_xmalloc_ptr<enum ui_align[]> col_align
-    ((enum ui_align *) xmalloc (sizeof (enum ui_align) * col));
-
-  /* Parsing column header.  */
-  i = 0;
-  while (*buf != '\0' && i < col)
-    {
-      char *sc = strchr (buf, ';');
-
-      *sc = '\0';
-      col_fldname[i] = buf;
-      col_hdrtext[i] = col_fldname[i];
-      if (col_fldname[i][0] == '%')
-	col_width[i] = 6;
-      else
-	col_width[i] = strlen (col_hdrtext[i]) + 1;
 
-      col_align[i] = ui_right;
+  gdb_argv argv (args);
 
-      i++;
-      buf = sc + 1;
+  if (argv != NULL)
+    {
+      for (i = 0; argv[i] != NULL; i++)
+	{
+	  if (startswith (argv[i], "top="))
+	    {
+	      top = parse_and_eval_long (argv[i] + 4);
+	      if (top < 0)
+		error (_("Invalid row count: %s"), argv[i] + 4);
+	    }
+	  else
+	    filename = argv[i];
+	}
     }
 
-  gdb_assert (col == i);
+  nds_profile_ring_open (ring, filename, 0);
+  nds_profile_ring_read (ring, samples);
 
-  /* Output table.  */
-  ui_out_emit_table table_emitter (current_uiout, col, row - 1, "ProfilingTable");
-  for (i = 0; i < col; i++)
-    current_uiout->table_header (col_width[i], col_align[i],
-				 col_fldname[i], col_hdrtext[i]);
+  for (const auto &it : samples)
+    {
+      addrs.push_back (it.first);
+      total += it.second;
+    }
+  nds_lookup_msymbols (addrs, msymbols);
 
+  /* Sum the samples per function.  Samples outside any known symbol
+     are reported under their own address.  */
+  std::map<std::string, ULONGEST> functions;
+  size_t n = 0;
+
+  for (const auto &it : samples)
+    {
+      std::string name;
+
+      if (msymbols[n].minsym != NULL)
+	name = MSYMBOL_PRINT_NAME (msymbols[n].minsym);
+      else
+	name = core_addr_to_string (it.first);
+      functions[name] += it.second;
+      n++;
+    }
+
+  std::vector<std::pair<std::string, ULONGEST>> flat (functions.begin (),
+						       functions.end ());
+  std::stable_sort (flat.begin (), flat.end (),
+		    [] (const std::pair<std::string, ULONGEST> &a,
+			const std::pair<std::string, ULONGEST> &b)
+		    { return a.second > b.second; });
+  if (top > 0 && (ULONGEST) top < flat.size ())
+    flat.resize (top);
+
+  ui_out_emit_table table_emitter (current_uiout, 3, flat.size (),
+				   "FlatProfile");
+  current_uiout->table_header (7, ui_right, "percent", "%");
+  current_uiout->table_header (10, ui_right, "samples", "Samples");
+  current_uiout->table_header (1, ui_left, "function", "Function");
   current_uiout->table_body ();
 
-  /* Parse buf into col/row.  */
-  while (*buf != '\0')
+  for (const auto &it : flat)
     {
       ui_out_emit_tuple tuple_emitter (current_uiout, "row");
-      char *sc = NULL;
-
-      symbol_text[0] = '\0';
-      for (i = 0; i < col; i++, buf = sc + 1)
-	{
-	  sc = strchr (buf, ';');
 
-	  if (sc == NULL)
-	    /* Expected ';' is not found, finish display.  */
-	    goto bye;
+      current_uiout->field_fmt ("percent", "%.2f",
+				total ? 100.0 * it.second / total : 0.0);
+      current_uiout->field_string ("samples", pulongest (it.second));
+      current_uiout->field_string ("function", it.first.c_str ());
+      current_uiout->text ("\n");
+    }
+}
 
-	  *sc = '\0';
-	  current_uiout->field_string (col_fldname[i], buf);
+/* gprof's gmon.out format, see gprof/gmon_out.h.  */
 
-	  if (i == 0)
-	    {
-	      /* Assume first column is address.  */
-	      CORE_ADDR addr = strtol (buf, NULL, 16);
-	      struct bound_minimal_symbol msymbol
-		= lookup_minimal_symbol_by_pc (addr);
-
-	      /* Get msymbol name to be output at end of row.  */
-	      if (!msymbol.minsym)
-		{
-		  strcpy (symbol_text, "\n");
-		}
-	      else
-		{
-		  const char *name = MSYMBOL_PRINT_NAME (msymbol.minsym);
-		  int offset = addr - BMSYMBOL_VALUE_ADDRESS (msymbol);
-
-		  if (offset)
-		    xsnprintf (symbol_text, sizeof (symbol_text),
-			       "%s + 0x%x\n", name, offset);
-		  else
-		    xsnprintf (symbol_text, sizeof (symbol_text), "%s\n",
-			       name);
-		}
-	    }
-	}
+#define NDS_GMON_MAGIC		"gmon"
+#define NDS_GMON_VERSION	1
+#define NDS_GMON_TAG_TIME_HIST	0
 
-      current_uiout->text (symbol_text);
-    }
+/* Largest number of histogram bins written to gmon.out.  */
+#define NDS_GMON_MAX_BINS	(1 << 20)
 
-bye:
-  do_cleanups (cleanup);
-}
+/* Callback for "nds profile gmon" command, which converts a ring file
+   into a gmon.out histogram that gprof can read together with the
+   executable.
 
-/* Callback for "nds query profiling" command.  */
+   Usage: nds profile gmon [FILE] [OUTPUT]  */
 
 static void
-nds_query_profiling_command (const char *args, int from_tty)
+nds_profile_gmon_command (const char *args, int from_tty)
 {
-  /* For profiling, there will be multiple responses.  */
-  char cmd[256];
-  int row, col;
-  string_file res;
-  int i;
-  const char *arg_cpu = "cpu";
-  int arg_human = 1;
-  const char *p;
+  const char *filename = "nds-profile.ring";
+  const char *output = "gmon.out";
+  nds_profile_ring ring;
+  std::map<CORE_ADDR, ULONGEST> samples;
+  int addr_size;
 
-  scoped_restore save_stdtarg = make_scoped_restore (&gdb_stdtarg, &res);
+  if (exec_bfd == NULL)
+    error (_("Cannot write gmon.out without executable.\n"
+	     "Use the \"file\" or \"exec-file\" command."));
 
   gdb_argv argv (args);
 
-  /* operator!= is overloading, so it can be used to check if args is NULL.  */
-  if (argv != NULL)
+  if (argv != NULL && argv[0] != NULL)
     {
-      if (argv[0] != NULL && *argv[0] != '\0')
-	arg_cpu = argv[0];
-
-      if (argv[1] != NULL && strcmp (argv[1], "ide") == 0)
-	arg_human = 0;
+      filename = argv[0];
+      if (argv[1] != NULL)
+	output = argv[1];
     }
 
-  xsnprintf (cmd, sizeof (cmd), "set %s profiling ide-query", arg_cpu);
-  if (nds_issue_qrcmd (cmd, res) == -1)
-    return;
+  nds_profile_ring_open (ring, filename, 0);
+  nds_profile_ring_read (ring, samples);
+  if (samples.empty ())
+    error (_("No samples in `%s'"), filename);
 
-  if (arg_human == 0)
-    {
-      fprintf_unfiltered (gdb_stdtarg,
-			  "=profiling,reason=\"fast_l1_profiling\",data=\"%s\"\n",
-			  res.c_str() );
-      return;
-    }
+  /* Instructions are at least 2 bytes long, so that is the finest
+     useful bin; widen the bins if the sampled range is too large.  */
+  CORE_ADDR low = samples.begin ()->first & ~(CORE_ADDR) 1;
+  CORE_ADDR high = (samples.rbegin ()->first + 2) & ~(CORE_ADDR) 1;
+  CORE_ADDR bin_size = 2;
 
-  /* The first response is Row=%d;Column=%d;
-     and then comes 'Row' rows, including head row */
-  i = sscanf (res.c_str (), "Row=%d;Column=%d;", &row, &col);
-  if (i != 2)
-    error (_("Failed to query profiling data"));
+  while ((high - low) / bin_size > NDS_GMON_MAX_BINS)
+    bin_size *= 2;
+  high = low + align_up (high - low, bin_size);
 
-  p = res.c_str ();
+  size_t nbins = (high - low) / bin_size;
+  std::vector<ULONGEST> bins (nbins);
 
-  /* Skip "Row=r;Column=c;".  */
-  for (i = 0; i < 2 && p; i++)
-    p = strchr (p + 1, ';');
-  p++;
+  for (const auto &it : samples)
+    bins[(it.first - low) / bin_size] += it.second;
 
-  /* Print human-mode table here.  */
-  nds_print_human_table (col, row, p);
+  /* gprof reads numbers in the byte order and address size of the
+     executable.  */
+  addr_size = bfd_arch_bits_per_address (exec_bfd) / 8;
+  std::vector<gdb_byte> buf;
+  gdb_byte word[8];
+
+  auto put = [&] (ULONGEST val, int size)
+    {
+      switch (size)
+	{
+	case 1:
+	  word[0] = val;
+	  break;
+	case 2:
+	  bfd_put_16 (exec_bfd, val, word);
+	  break;
+	case 4:
+	  bfd_put_32 (exec_bfd, val, word);
+	  break;
+	default:
+	  bfd_put_64 (exec_bfd, val, word);
+	  break;
+	}
+      buf.insert (buf.end (), word, word + size);
+    };
+
+  /* struct gmon_hdr.  */
+  buf.insert (buf.end (), NDS_GMON_MAGIC, NDS_GMON_MAGIC + 4);
+  put (NDS_GMON_VERSION, 4);
+  buf.insert (buf.end (), 12, 0);
+
+  /* Histogram record.  The profiling rate is unknown, so report the
+     samples as plain counts with a 1 Hz rate.  */
+  put (NDS_GMON_TAG_TIME_HIST, 1);
+  put (low, addr_size);
+  put (high, addr_size);
+  put (nbins, 4);
+  put (1, 4);
+  const char dimen[15] = "samples";
+  buf.insert (buf.end (), dimen, dimen + sizeof (dimen));
+  put ('s', 1);
+
+  for (ULONGEST count : bins)
+    put (std::min (count, (ULONGEST) 0xffff), 2);
+
+  gdb_file_up out = gdb_fopen_cloexec (output, "wb");
+  if (out == NULL)
+    perror_with_name (output);
+  if (fwrite (buf.data (), buf.size (), 1, out.get ()) != 1)
+    perror_with_name (output);
+
+  if (from_tty)
+    printf_filtered (_("Wrote %s histogram bins to `%s'.\n"),
+		     pulongest (nbins), output);
 }
 
 /* Callback for "nds query perfmeter" command.  */
@@ -596,7 +1431,130 @@ nds_handle_ace(const char *ace_lib_path)
 #endif
 }
 
-/* Callback for "nds read_acedesc" command.  */
+/* Directory where downloaded ACE shared libraries are kept, named
+   after the content hash the target reports for them.  */
+
+static char *nds_ace_cache_directory;
+
+/* Length of the content hash of an ACE library, the SHA-1 digest of
+   the library in hex.  */
+
+#define NDS_ACE_HASH_LEN	40
+
+/* Return HASH in lower case if it is a well-formed content hash, or an
+   empty string otherwise.  */
+
+static std::string
+nds_ace_hash_normalize (const char *hash)
+{
+  std::string result;
+
+  for (; *hash != '\0'; hash++)
+    {
+      if (!isxdigit (*hash))
+	return std::string ();
+      result += tolower (*hash);
+    }
+
+  if (result.size () != NDS_ACE_HASH_LEN)
+    return std::string ();
+  return result;
+}
+
+/* Return the content hash of the file FILENAME, or an empty string if
+   it cannot be read.  */
+
+static std::string
+nds_ace_file_hash (const char *filename)
+{
+  gdb_file_up file = gdb_fopen_cloexec (filename, "rb");
+  gdb_byte digest[NDS_ACE_HASH_LEN / 2];
+
+  if (file == NULL || sha1_stream (file.get (), digest) != 0)
+    return std::string ();
+  return bin2hex (digest, sizeof (digest));
+}
+
+/* Return the name of the cached ACE library with content hash HASH,
+   fetching it from the remote file FILENAME into the cache first if
+   needed.  Return an empty string if the cache cannot be used.  A
+   library is only used if its content matches HASH, whether it comes
+   from the cache or was just downloaded.  */
+
+static std::string
+nds_ace_cache_lookup (const char *filename, const char *target_hash,
+		      int from_tty)
+{
+  std::string hash = nds_ace_hash_normalize (target_hash);
+
+  if (nds_ace_cache_directory == NULL || *nds_ace_cache_directory == '\0'
+      || hash.empty ())
+    return std::string ();
+
+  std::string cached = string_printf ("%s/libace-%s.so",
+				      nds_ace_cache_directory, hash.c_str ());
+  struct stat st;
+
+  if (stat (cached.c_str (), &st) == 0 && S_ISREG (st.st_mode))
+    {
+      if (nds_ace_file_hash (cached.c_str ()) == hash)
+	return cached;
+
+      warning (_("Cached ACE library `%s' is corrupt; fetching it again."),
+	       cached.c_str ());
+      unlink (cached.c_str ());
+    }
+
+  if (!mkdir_recursive (nds_ace_cache_directory))
+    {
+      warning (_("Could not make ACE cache directory `%s': %s"),
+	       nds_ace_cache_directory, safe_strerror (errno));
+      return std::string ();
+    }
+
+  /* Download under a temporary name and rename it into place, so that
+     an interrupted transfer never leaves a truncated library that a
+     later session would trust.  */
+  std::string tmp = string_printf ("%s.%ld.tmp", cached.c_str (),
+				   (long) getpid ());
+
+  TRY
+    {
+      remote_file_get (filename, tmp.c_str (), from_tty);
+    }
+  CATCH (except, RETURN_MASK_ERROR)
+    {
+      unlink (tmp.c_str ());
+      throw_exception (except);
+    }
+  END_CATCH
+
+  if (nds_ace_file_hash (tmp.c_str ()) != hash)
+    {
+      unlink (tmp.c_str ());
+      error (_("The ACE library `%s' does not match the hash the target "
+	       "reported for it."), filename);
+    }
+
+  if (rename (tmp.c_str (), cached.c_str ()) != 0)
+    {
+      unlink (tmp.c_str ());
+      warning (_("Could not store ACE library in cache: %s"),
+	       safe_strerror (errno));
+      return std::string ();
+    }
+
+  return cached;
+}
+
+/* Callback for "nds read_acedesc" command.
+
+   The library is kept in nds_ace_cache_directory when the target
+   reports a content hash for it ("nds ace-hash SYSNAME", answered
+   with the SHA-1 digest of the library in hex), so that
+   reconnecting to a target with the same ACE configuration does not
+   transfer it again.  Targets that don't report a hash fall back to a
+   one-shot download into the current directory.  */
 
 static void
 nds_read_ace_desc_command (const char *args, int from_tty)
@@ -609,26 +1567,39 @@ nds_read_ace_desc_command (const char *args, int from_tty)
     {
       string_file str;
       char qrcmd[80];
-      const char *filename = NULL;
+      std::string filename;
 
-      sprintf (qrcmd, "nds ace %s", os.sysname);
+      xsnprintf (qrcmd, sizeof (qrcmd), "nds ace %s", os.sysname);
       if (nds_issue_qrcmd (qrcmd, str) == -1)
 	return;
 
-      filename = str.c_str ();
-      if (strlen (filename) != 0)
+      filename = str.string ();
+      if (filename.empty ())
+	return;
+
+      xsnprintf (qrcmd, sizeof (qrcmd), "nds ace-hash %s", os.sysname);
+      if (nds_issue_qrcmd (qrcmd, str) == 0)
 	{
-	  const char *lib = "./libace.so";
+	  std::string cached = nds_ace_cache_lookup (filename.c_str (),
+						     str.c_str (), from_tty);
 
-	  remote_file_get (filename, lib, from_tty);
-	  nds_handle_ace (lib);
-	  unlink (lib);
+	  if (!cached.empty ())
+	    {
+	      nds_handle_ace (cached.c_str ());
+	      return;
+	    }
 	}
+
+      const char *lib = "./libace.so";
+
+      remote_file_get (filename.c_str (), lib, from_tty);
+      nds_handle_ace (lib);
+      unlink (lib);
     }
 #endif
 }
-
 
+
 static int
 nds_get_acr_info (struct gdbarch *gdbarch, const char *name,
 		  int *regnum, int *len)
@@ -648,29 +1619,73 @@ nds_get_acr_info (struct gdbarch *gdbarch, const char *name,
   return 0;
 }
 
-#define MAX_ACR_BIT		1024
-#define MAX_ACR_HEX_DIGIT	(MAX_ACR_BIT/4)
+/* Return the content LEN bytes of an ACR in BUF, stored in BYTE_ORDER,
+   as a hex string without leading zeros.  */
+
+static std::string
+nds_acr_to_hex (const gdb_byte *buf, int len, enum bfd_endian byte_order)
+{
+  gdb::byte_vector msb_first (buf, buf + len);
+  std::string hex;
+  size_t nz;
+
+  if (byte_order != BFD_ENDIAN_BIG)
+    std::reverse (msb_first.begin (), msb_first.end ());
+
+  hex = bin2hex (msb_first.data (), len);
+  nz = hex.find_first_not_of ('0');
+  if (nz == std::string::npos)
+    return "0";
+  return hex.substr (nz);
+}
+
+/* Fill the LEN bytes of BUF with the value of hex string STR (with or
+   without a 0x prefix), stored in BYTE_ORDER.  Digits that do not fit
+   in LEN bytes are dropped from the most significant end; the target
+   does the accurate truncation.  */
+
+static void
+nds_acr_from_hex (const char *str, gdb_byte *buf, int len,
+		  enum bfd_endian byte_order)
+{
+  std::string hex;
+  int nbytes;
+
+  if (str[0] == '0' && (str[1] == 'x' || str[1] == 'X'))
+    str += 2;
+
+  if (str[0] == '\0' || str[strspn (str, "0123456789abcdefABCDEF")] != '\0')
+    error (_("Given value contains invalid hex digit"));
 
-static char tohex[] = "0123456789abcdef";
+  hex = str;
+  if (hex.size () % 2 != 0)
+    hex.insert (0, 1, '0');
+  nbytes = hex.size () / 2;
+  if (nbytes > len)
+    {
+      hex.erase (0, 2 * (nbytes - len));
+      nbytes = len;
+    }
+
+  /* Right-align the value, most significant byte first.  */
+  memset (buf, 0, len);
+  hex2bin (hex.c_str (), buf + len - nbytes, nbytes);
+
+  if (byte_order != BFD_ENDIAN_BIG)
+    std::reverse (buf, buf + len);
+}
 
 /* Callback for "nds print" command, which is used to construct a
-   hex string from the content of ACR.  */
+   hex string from the content of one or more ACRs.  The contents are
+   taken directly from the register values of the selected frame.  */
 
 static void
 nds_print_acr_command (const char *args, int from_tty)
 {
-  struct regcache *regcache = get_current_regcache ();
-  struct gdbarch *gdbarch = regcache->arch ();
-  enum bfd_endian byte_order = gdbarch_byte_order (gdbarch);
-  int regnum;
-  char *name = NULL;
-  int len, i;
-  /* Flag used to trim leading-zero.  */
-  int flag_lz;
-  /* +1 for null terminating char.  */
-  char val_str[MAX_ACR_HEX_DIGIT + 1];
-  char *str_p;
-  gdb_byte *acr_content;
+  struct frame_info *frame;
+  struct gdbarch *gdbarch;
+  enum bfd_endian byte_order;
+  int regnum, len, i;
 
   /* Parse arguments.  */
   gdb_argv argv (args);
@@ -678,103 +1693,50 @@ nds_print_acr_command (const char *args, int from_tty)
   /* operator== is overloading, so it can be used to check if args is NULL.  */
   if (argv == NULL || argv[0] == NULL)
     {
-      fprintf_unfiltered (gdb_stdout, "<usage>: nds print <acr_name>\n");
+      fprintf_unfiltered (gdb_stdout,
+			  "<usage>: nds print <acr_name> [<acr_name>...]\n");
       return;
     }
 
-  name = argv[0];
-  if (nds_get_acr_info (gdbarch, name, &regnum, &len) == -1)
-    return;
-
-  /* Allocate space for ACR.  */
-  acr_content = (gdb_byte *) xcalloc (1, len);
+  frame = get_selected_frame (NULL);
+  gdbarch = get_frame_arch (frame);
+  byte_order = gdbarch_byte_order (gdbarch);
 
-  get_frame_register (get_selected_frame (NULL), regnum, acr_content);
-
-  /* Construct val_str from ACR byte buffer, and start from the MSB of
-     val_str, so that the leading zero case can be handled more easily.  */
-  flag_lz = 1;
-  str_p = val_str;
-  if (byte_order == BFD_ENDIAN_BIG)
+  for (i = 0; argv[i] != NULL; i++)
     {
-      for (i = 0; i < len; i++)
-	{
-	  gdb_byte b;
+      const char *name = argv[i];
+      struct value *val;
 
-	  b = acr_content[i];
-	  if (flag_lz == 1 && b == 0)
-	    continue;
-	  else
-	    flag_lz = 0;
+      if (nds_get_acr_info (gdbarch, name, &regnum, &len) == -1)
+	continue;
 
-	  str_p[0] = tohex[(b >> 4) & 0xf];
-	  str_p[1] = tohex[(b & 0xf)];
-	  str_p += 2;
-	}
-    }
-  else
-    {
-      for (i = len - 1; i >= 0; i--)
+      val = value_of_register (regnum, frame);
+      if (value_optimized_out (val) || !value_entirely_available (val))
 	{
-	  gdb_byte b;
-
-	  b = acr_content[i];
-	  if (flag_lz == 1 && b == 0)
-	    continue;
-	  else
-	    flag_lz = 0;
-
-	  str_p[0] = tohex[(b >> 4) & 0xf];
-	  str_p[1] = tohex[(b & 0xf)];
-	  str_p += 2;
+	  fprintf_filtered (gdb_stdout, "The value of %s is <unavailable>\n",
+			    name);
+	  continue;
 	}
-    }
-  str_p[0] = '\0';
 
-  /* Handle null string specially.  */
-  str_p = val_str;
-  while (*str_p == '0')
-    str_p++;
-  if (*str_p == '\0')
-    {
-      str_p[0] = '0';
-      str_p[1] = '\0';
+      fprintf_filtered (gdb_stdout, "The value of %s is 0x%s\n", name,
+			nds_acr_to_hex (value_contents (val), len,
+					byte_order).c_str ());
     }
-
-  fprintf_filtered (gdb_stdout, "The value of %s is 0x%s\n", name, str_p);
-
-  xfree (acr_content);
-}
-
-/* Convert hex digit A to a number.  */
-
-static int
-fromhex (int a)
-{
-  if (a >= '0' && a <= '9')
-    return a - '0';
-  else if (a >= 'a' && a <= 'f')
-    return a - 'a' + 10;
-  else if (a >= 'A' && a <= 'F')
-    return a - 'A' + 10;
-  else
-    error (_("Given value contains invalid hex digit %d"), a);
 }
 
 /* Callback for "nds set" command, which is used to construct
-   the content of ACR from the given hex string.  */
+   the content of one or more ACRs from the given hex strings.  All the
+   values are converted before any register is written.  */
 
 static void
 nds_set_acr_command (const char *args, int from_tty)
 {
   struct regcache *regcache = get_current_regcache ();
+  struct frame_info *frame;
   struct gdbarch *gdbarch = regcache->arch ();
   enum bfd_endian byte_order = gdbarch_byte_order (gdbarch);
-  int regnum;
-  char *name = NULL;
-  int len, i;
-  const char *val_str, *str_p;
-  gdb_byte *acr_content = NULL;
+  std::vector<std::pair<int, gdb::byte_vector>> writes;
+  int regnum, len, i;
 
   /* Parse arguments.  */
   gdb_argv argv (args);
@@ -783,71 +1745,82 @@ nds_set_acr_command (const char *args, int from_tty)
   if (argv == NULL || argv[0] == NULL || argv[1] == NULL)
     {
       fprintf_unfiltered (gdb_stdout,
-			  "<usage>: nds set <acr_name> <hex_str>\n");
+			  "<usage>: nds set <acr_name> <hex_str> "
+			  "[<acr_name> <hex_str>...]\n");
       return;
     }
 
-  name = argv[0];
-  if (nds_get_acr_info (gdbarch, name, &regnum, &len) == -1)
-    return;
-
-  val_str = argv[1];
-  if (val_str[0] == '0' && (val_str[1] == 'x' || val_str[1] == 'X'))
-    val_str += 2;
+  for (i = 0; argv[i] != NULL; i += 2)
+    {
+      if (argv[i + 1] == NULL)
+	error (_("No value given for %s"), argv[i]);
 
-  acr_content = (gdb_byte *) xcalloc (1, len);
+      if (nds_get_acr_info (gdbarch, argv[i], &regnum, &len) == -1)
+	return;
 
-  /* Construct ACR byte buffer from val_str, and start from the LSB of
-     val_str, so that the leading zero case can be handled more easily.  */
-  str_p = val_str + strlen (val_str);
-  if (byte_order == BFD_ENDIAN_BIG)
-    {
-      for (i = len - 1; i >= 0; i--)
-	{
-	  str_p -= 2;
-	  if (str_p >= val_str)
-	    acr_content[i] = (fromhex (str_p[0]) << 4) + fromhex (str_p[1]);
-	  else if (str_p == val_str - 1)
-	    acr_content[i] = fromhex (str_p[1]);
-	  else
-	    break;
-	}
-    }
-  else
-    {
-      for (i = 0; i < len; i++)
-	{
-	  str_p -= 2;
-	  if (str_p >= val_str)
-	    acr_content[i] = (fromhex (str_p[0]) << 4) + fromhex (str_p[1]);
-	  else if (str_p == val_str - 1)
-	    acr_content[i] = fromhex (str_p[1]);
-	  else
-	    break;
-	}
+      gdb::byte_vector content (len);
+      nds_acr_from_hex (argv[i + 1], content.data (), len, byte_order);
+      writes.emplace_back (regnum, std::move (content));
     }
 
-  put_frame_register (get_selected_frame (NULL), regnum, acr_content);
+  frame = get_selected_frame (NULL);
+  for (const auto &w : writes)
+    put_frame_register (frame, w.first, w.second.data ());
 
   /* The accurate bitsize info is necessary to do the truncation in GDB.
      Currently, the truncation is actually done at target side, so the
      regcache invalidation is necessary.  */
-  regcache->invalidate (regnum);
+  for (const auto &w : writes)
+    regcache->invalidate (w.first);
+}
 
-  xfree (acr_content);
+/* Implementation of the convenience function $_nds_acr, which returns
+   the value of the ACR named by its string argument in the selected
+   frame.  Scripts can use it in expressions instead of parsing the
+   output of "nds print".  */
+
+static struct value *
+nds_acr_internal_fn (struct gdbarch *gdbarch,
+		     const struct language_defn *language,
+		     void *cookie, int argc, struct value **argv)
+{
+  gdb::unique_xmalloc_ptr<gdb_byte> buffer;
+  struct type *char_type;
+  const char *charset;
+  struct frame_info *frame;
+  int regnum, len, length;
+
+  if (argc != 1)
+    error (_("You must provide one argument for $_nds_acr."));
+
+  language->la_get_string (argv[0], &buffer, &length, &char_type, &charset);
+  if (TYPE_LENGTH (char_type) != 1)
+    error (_("The argument of $_nds_acr must be a string."));
+  std::string name ((const char *) buffer.get (), length);
+
+  frame = get_selected_frame (NULL);
+  if (nds_get_acr_info (get_frame_arch (frame), name.c_str (),
+			&regnum, &len) == -1)
+    error (_("Invalid register name \"%s\"."), name.c_str ());
+
+  return value_of_register (regnum, frame);
 }
 
 
+/* Runs shorter than this are sorted by straight insertion before
+   being merged.  */
+#define NDS_SORT_RUN	32
+
 /* nds_insertion_sort sorts an array with nmemb elements of size size.
-   This prototype is the same as qsort ().  */
+   This prototype is the same as qsort ().  TMP is a scratch buffer of
+   at least SIZE bytes.  */
 
 static void
-nds_insertion_sort (void *base, size_t nmemb, size_t size,
-		    int (*compar) (const void *lhs, const void *rhs))
+nds_insertion_sort (char *ptr, size_t nmemb, size_t size,
+		    int (*compar) (const void *lhs, const void *rhs),
+		    char *tmp)
 {
-  char *ptr = (char *) base;
-  int i, j;
-  char *tmp = (char *) xmalloc (size);
+  size_t i, j;
 
   /* If i is less than j, i is inserted before j.
 
@@ -856,14 +1829,12 @@ nds_insertion_sort (void *base, size_t nmemb, size_t size,
 	 sorted		unsorted
    */
 
-  for (i = 1; i < (int) nmemb; i++)
+  for (i = 1; i < nmemb; i++)
     {
-      for (j = (i - 1); j >= 0; j--)
-	if (compar (ptr + i * size, ptr + j * size) >= 0)
+      for (j = i; j > 0; j--)
+	if (compar (ptr + i * size, ptr + (j - 1) * size) >= 0)
 	  break;
 
-      j++;
-
       if (i == j)
 	continue; /* i is in order.  */
 
@@ -871,17 +1842,174 @@ nds_insertion_sort (void *base, size_t nmemb, size_t size,
       memmove (ptr + (j + 1) * size, ptr + j * size, (i - j) * size);
       memcpy (ptr + j * size, tmp, size);
     }
-  free (tmp);
 }
 
+/* Merge the sorted runs [SRC, SRC + N1 * SIZE) and
+   [SRC + N1 * SIZE, SRC + (N1 + N2) * SIZE) into DST.  Elements of the
+   left run win ties, which keeps the merge stable.  */
+
+static void
+nds_merge_runs (char *dst, const char *src, size_t n1, size_t n2,
+		size_t size,
+		int (*compar) (const void *lhs, const void *rhs))
+{
+  const char *l = src;
+  const char *l_end = src + n1 * size;
+  const char *r = l_end;
+  const char *r_end = r + n2 * size;
+
+  /* The runs are already in order; this is common for symbol tables
+     that are mostly sorted by address.  */
+  if (n1 == 0 || n2 == 0 || compar (l_end - size, r) <= 0)
+    {
+      memcpy (dst, src, (n1 + n2) * size);
+      return;
+    }
+
+  while (l < l_end && r < r_end)
+    {
+      if (compar (l, r) <= 0)
+	{
+	  memcpy (dst, l, size);
+	  l += size;
+	}
+      else
+	{
+	  memcpy (dst, r, size);
+	  r += size;
+	}
+      dst += size;
+    }
+
+  if (l < l_end)
+    memcpy (dst, l, l_end - l);
+  else if (r < r_end)
+    memcpy (dst, r, r_end - r);
+}
+
+/* nds_stable_sort sorts an array with nmemb elements of size size in
+   O(n log n), keeping equal elements in their original order.  Short
+   runs are insertion sorted and then merged bottom-up, ping-ponging
+   between BASE and a scratch buffer.  This prototype is the same as
+   qsort ().  */
+
+static void
+nds_stable_sort (void *base, size_t nmemb, size_t size,
+		 int (*compar) (const void *lhs, const void *rhs))
+{
+  char *ptr = (char *) base;
+  size_t i, width;
+
+  if (nmemb < 2 || size == 0)
+    return;
+
+  gdb::unique_xmalloc_ptr<char> tmp ((char *) xmalloc (size));
+
+  for (i = 0; i < nmemb; i += NDS_SORT_RUN)
+    nds_insertion_sort (ptr + i * size,
+			std::min ((size_t) NDS_SORT_RUN, nmemb - i),
+			size, compar, tmp.get ());
+
+  if (nmemb <= NDS_SORT_RUN)
+    return;
+
+  gdb::unique_xmalloc_ptr<char> buf ((char *) xmalloc (nmemb * size));
+  char *src = ptr;
+  char *dst = buf.get ();
+
+  for (width = NDS_SORT_RUN; width < nmemb; width *= 2)
+    {
+      for (i = 0; i < nmemb; i += 2 * width)
+	{
+	  size_t n1 = std::min (width, nmemb - i);
+	  size_t n2 = std::min (width, nmemb - i - n1);
+
+	  nds_merge_runs (dst + i * size, src + i * size, n1, n2, size,
+			  compar);
+	}
+      std::swap (src, dst);
+    }
+
+  if (src != ptr)
+    memcpy (ptr, src, nmemb * size);
+}
+
+/* The engines "maint set nds sort-engine" selects between.  Straight
+   insertion is the quadratic sort the override used to forward to; it
+   is kept so that the two can be compared on real tables.  */
+
+static const char nds_sort_engine_merge[] = "merge";
+static const char nds_sort_engine_insertion[] = "insertion";
+static const char *const nds_sort_engine_enums[] =
+{
+  nds_sort_engine_merge,
+  nds_sort_engine_insertion,
+  NULL
+};
+static const char *nds_sort_engine = nds_sort_engine_merge;
+
+/* Override the C library qsort, which is not stable.  Several callers
+   (minimal symbols, FDE tables, breakpoint locations, the section map)
+   rely on equal elements keeping their input order on this host.  */
+
 void
 qsort (void *base, size_t nmemb, size_t size,
        int (*compar) (const void *lhs, const void *rhs))
 {
-  nds_insertion_sort (base, nmemb, size, compar);
+  if (nds_sort_engine == nds_sort_engine_insertion && size != 0)
+    {
+      gdb::unique_xmalloc_ptr<char> tmp ((char *) xmalloc (size));
+
+      nds_insertion_sort ((char *) base, nmemb, size, compar, tmp.get ());
+    }
+  else
+    nds_stable_sort (base, nmemb, size, compar);
+}
+
+/* The lists of "maint set nds" and "maint show nds" commands.  */
+
+static struct cmd_list_element *maint_set_nds_cmdlist;
+static struct cmd_list_element *maint_show_nds_cmdlist;
+
+static void
+maint_set_nds_command (const char *args, int from_tty)
+{
+  help_list (maint_set_nds_cmdlist, "maintenance set nds ", all_commands,
+	     gdb_stdout);
+}
+
+static void
+maint_show_nds_command (const char *args, int from_tty)
+{
+  cmd_show_list (maint_show_nds_cmdlist, from_tty, "");
+}
+
+/* The lists of "set nds" and "show nds" commands.  */
+
+static struct cmd_list_element *set_nds_cmdlist;
+static struct cmd_list_element *show_nds_cmdlist;
+
+/* The set callback for the "set nds" prefix command.  */
+
+static void
+set_nds_command (const char *args, int from_tty)
+{
+  printf_unfiltered
+    (_("\"set nds\" must be followed by an appropriate subcommand.\n"));
+  help_list (set_nds_cmdlist, "set nds ", all_commands, gdb_stdout);
+}
+
+/* The show callback for the "show nds" prefix command.  */
+
+static void
+show_nds_command (const char *args, int from_tty)
+{
+  cmd_show_list (show_nds_cmdlist, from_tty, "");
 }
 
 static struct cmd_list_element *nds_pipeline_cmdlist;
+static struct cmd_list_element *nds_profile_cmdlist;
+static struct cmd_list_element *nds_profile_record_cmdlist;
 static struct cmd_list_element *nds_query_cmdlist;
 static struct cmd_list_element *nds_reset_cmdlist;
 
@@ -941,11 +2069,61 @@ nds_init_remote_cmds (void)
   add_cmd ("off", no_class, nds_pipeline_off_command,
 	   _("Turn off pipeline for profiling."), &nds_pipeline_cmdlist);
 
+  /* nds profile (record (start|stop)|report|gmon)  */
+  add_prefix_cmd ("profile", no_class, nds_profile_command,
+		  _("Continuous profiling through the target's profiling "
+		    "buffer."),
+		  &nds_profile_cmdlist, "profile ", 0, &nds_cmdlist);
+  add_prefix_cmd ("record", no_class, nds_profile_record_command,
+		  _("Record profiling samples into a ring file."),
+		  &nds_profile_record_cmdlist, "profile record ", 0,
+		  &nds_profile_cmdlist);
+  add_cmd ("start", no_class, nds_profile_record_start_command,
+	   _("Start draining profiling samples periodically.\n\
+Usage: nds profile record start [FILE] [interval=MS] [capacity=N] \
+[cpu=CPU]"),
+	   &nds_profile_record_cmdlist);
+  add_cmd ("stop", no_class, nds_profile_record_stop_command,
+	   _("Stop recording profiling samples."),
+	   &nds_profile_record_cmdlist);
+  add_cmd ("report", no_class, nds_profile_report_command,
+	   _("Print a flat profile of recorded samples.\n\
+Usage: nds profile report [FILE] [top=N]"),
+	   &nds_profile_cmdlist);
+  add_cmd ("gmon", no_class, nds_profile_gmon_command,
+	   _("Convert recorded samples to a gprof gmon.out file.\n\
+Usage: nds profile gmon [FILE] [OUTPUT]"),
+	   &nds_profile_cmdlist);
+
+  nds_profile_state.timer_id = -1;
+  gdb::observers::normal_stop.attach (nds_profile_normal_stop);
+
+  add_prefix_cmd ("nds", no_class, set_nds_command,
+		  _("ANDES specific commands."),
+		  &set_nds_cmdlist, "set nds ", 0, &setlist);
+  add_prefix_cmd ("nds", no_class, show_nds_command,
+		  _("ANDES specific commands."),
+		  &show_nds_cmdlist, "show nds ", 0, &showlist);
+
   /* nds read_acedesc  */
   add_cmd ("read_acedesc", no_class, nds_read_ace_desc_command,
 	   _("Request the ACE or coprocessor description file from remote."),
 	     &nds_cmdlist);
 
+  std::string cache_dir = get_standard_cache_dir ();
+  if (!cache_dir.empty ())
+    nds_ace_cache_directory = xstrdup ((cache_dir + "/ace").c_str ());
+
+  add_setshow_filename_cmd ("ace-cache-directory", class_files,
+			    &nds_ace_cache_directory,
+			    _("Set the directory of the ACE library cache."),
+			    _("Show the directory of the ACE library cache."),
+			    _("\
+ACE shared libraries fetched by \"nds read_acedesc\" are kept in this\n\
+directory, named after their content hash.  An empty directory name\n\
+disables the cache."),
+			    NULL, NULL, &set_nds_cmdlist, &show_nds_cmdlist);
+
   /* nds print  */
   add_cmd ("print", no_class, nds_print_acr_command,
 	   _("Print the value of ACR in hex format."), &nds_cmdlist);
@@ -954,6 +2132,31 @@ nds_init_remote_cmds (void)
   add_cmd ("set", no_class, nds_set_acr_command,
 	   _("Set the value of ACR in hex format."), &nds_cmdlist);
 
+  add_internal_function ("_nds_acr", _("\
+Return the value of an ACR in the selected frame.\n\
+Usage: $_nds_acr (\"ACR-NAME\")"),
+			 nds_acr_internal_fn, NULL);
+
   create_internalvar_type_lazy ("_nds_target_type", &nds_target_type_funcs,
 				NULL);
+
+  add_prefix_cmd ("nds", class_maintenance, maint_set_nds_command,
+		  _("Set ANDES specific maintenance variables."),
+		  &maint_set_nds_cmdlist, "maintenance set nds ",
+		  0, &maintenance_set_cmdlist);
+  add_prefix_cmd ("nds", class_maintenance, maint_show_nds_command,
+		  _("Show ANDES specific maintenance variables."),
+		  &maint_show_nds_cmdlist, "maintenance show nds ",
+		  0, &maintenance_show_cmdlist);
+
+  /* maint set nds sort-engine (merge|insertion)  */
+  add_setshow_enum_cmd ("sort-engine", class_maintenance,
+			nds_sort_engine_enums, &nds_sort_engine, _("\
+Set the algorithm GDB's qsort uses."), _("\
+Show the algorithm GDB's qsort uses."), _("\
+\"merge\" is a stable O(n log n) merge sort, the default.\n\
+\"insertion\" is the quadratic insertion sort used before it, kept\n\
+only to compare the two; see gdb.perf/qsort.exp."),
+			NULL, NULL,
+			&maint_set_nds_cmdlist, &maint_show_nds_cmdlist);
 }
@@ -37,6 +37,13 @@
 #include "dwarf2-frame.h"
 #include "remote.h"
 #include "target-descriptions.h"
+#include "observable.h"
+#include "objfiles.h"
+#include "gdbcmd.h"
+#include "sim-regno.h"
+#include "record.h"
+#include "record-full.h"
+#include "selftest.h"
 
 #include "nds32-tdep.h"
 #include "elf/nds32.h"
@@ -313,6 +320,19 @@ nds32_dwarf2_reg_to_regnum (struct gdbarch *gdbarch, int num)
   return -1;
 }
 
+/* Implement the "register_sim_regno" gdbarch method.  */
+
+static int
+nds32_register_sim_regno (struct gdbarch *gdbarch, int regnum)
+{
+  /* The simulator only models the core registers, which it numbers
+     like GDB does.  */
+  if (regnum >= 0 && regnum < NDS32_NUM_REGS)
+    return regnum;
+
+  return LEGACY_SIM_REGNO_IGNORE;
+}
+
 /* NDS32 register groups.  */
 static struct reggroup *nds32_cr_reggroup;
 static struct reggroup *nds32_ir_reggroup;
@@ -418,6 +438,16 @@ nds32_pseudo_register_type (struct gdbarch *gdbarch, int regnum)
   return NULL;
 }
 
+/* Implement the "fetch_register_on_demand" gdbarch method.  The
+   hundreds of system registers are fetched one by one as they are
+   displayed, rather than along with the GPRs at every stop.  */
+
+static int
+nds32_fetch_register_on_demand (struct gdbarch *gdbarch, int regnum)
+{
+  return nds32_register_reggroup_p (gdbarch, regnum, system_reggroup);
+}
+
 /* Implement the "pseudo_register_name" tdesc_arch_data method.  */
 
 static const char *
@@ -607,25 +637,97 @@ nds32_push_multiple_words (struct nds32_frame_cache *cache, int rb, int re,
   cache->sp_offset = sp_offset;
 }
 
+/* Instructions are fetched from the target in blocks of this many
+   bytes, so that analyzing a prologue or an epilogue does not cost one
+   target round trip per instruction.  */
+#define NDS32_CODE_BLOCK_SIZE 128
+
+/* A window of code bytes read with a single target_read_code.  Going
+   through TARGET_OBJECT_CODE_MEMORY also lets the read be served by the
+   code cache, or by the executable file when trust-readonly-sections is
+   enabled.  */
+
+struct nds32_code_reader
+{
+  /* Address of the first byte in BUF.  */
+  CORE_ADDR start;
+  /* Number of valid bytes in BUF.  */
+  int len;
+  gdb_byte buf[NDS32_CODE_BLOCK_SIZE];
+};
+
+/* Initialize READER to hold no bytes.  */
+
+static void
+nds32_code_reader_init (struct nds32_code_reader *reader)
+{
+  reader->start = 0;
+  reader->len = 0;
+}
+
+/* Return the 4 bytes at PC as a big-endian word, the same as
+   read_memory_unsigned_integer (PC, 4, BFD_ENDIAN_BIG) would.  LIMIT_PC
+   bounds how far ahead the block read may go; bytes up to LIMIT_PC + 2
+   may be fetched since a 16-bit instruction at LIMIT_PC - 2 is read
+   as a word.  */
+
+static uint32_t
+nds32_read_insn (struct nds32_code_reader *reader, CORE_ADDR pc,
+		 CORE_ADDR limit_pc)
+{
+  if (pc < reader->start || pc + 4 > reader->start + reader->len)
+    {
+      int len = NDS32_CODE_BLOCK_SIZE;
+
+      if (limit_pc > pc && limit_pc - pc + 2 < len)
+	len = limit_pc - pc + 2;
+      if (len < 4)
+	len = 4;
+
+      /* The block may run past the end of readable memory even though
+	 the instruction itself is readable; retry with just the word
+	 before reporting an error.  */
+      if (target_read_code (pc, reader->buf, len) != 0)
+	{
+	  len = 4;
+	  read_code (pc, reader->buf, len);
+	}
+
+      reader->start = pc;
+      reader->len = len;
+    }
+
+  return extract_unsigned_integer (reader->buf + (pc - reader->start), 4,
+				   BFD_ENDIAN_BIG);
+}
+
 /* Analyze the instructions within the given address range.  If CACHE
    is non-NULL, fill it in.  Return the first address beyond the given
    address range.  If CACHE is NULL, return the first address not
-   recognized as a prologue instruction.  */
+   recognized as a prologue instruction.
+
+   If LAST_CHANGE_P is non-NULL, set it to the address following the
+   last instruction that changed CACHE.  */
 
 static CORE_ADDR
 nds32_analyze_prologue (struct gdbarch *gdbarch, CORE_ADDR pc,
-			CORE_ADDR limit_pc, struct nds32_frame_cache *cache)
+			CORE_ADDR limit_pc, struct nds32_frame_cache *cache,
+			CORE_ADDR *last_change_p = NULL)
 {
   struct gdbarch_tdep *tdep = gdbarch_tdep (gdbarch);
   int abi_use_fpr = nds32_abi_use_fpr (tdep->elf_abi);
+  struct nds32_code_reader reader;
   /* Current scanning status.  */
   int in_prologue_bb = 0;
   int val_ta = 0;
   uint32_t insn, insn_len;
+  CORE_ADDR last_change = pc;
+
+  nds32_code_reader_init (&reader);
 
   for (; pc < limit_pc; pc += insn_len)
     {
-      insn = read_memory_unsigned_integer (pc, 4, BFD_ENDIAN_BIG);
+      insn = nds32_read_insn (&reader, pc, limit_pc);
 
       if ((insn & 0x80000000) == 0)
 	{
@@ -642,6 +744,7 @@ nds32_analyze_prologue (struct gdbarch *gdbarch, CORE_ADDR pc,
 		  if (cache != NULL)
 		    cache->sp_offset += -imm15s;
 
+		  last_change = pc + insn_len;
 		  in_prologue_bb = 1;
 		  continue;
 		}
@@ -656,6 +759,7 @@ nds32_analyze_prologue (struct gdbarch *gdbarch, CORE_ADDR pc,
 		  if (cache != NULL)
 		    cache->fp_offset = cache->sp_offset - imm15s;
 
+		  last_change = pc + insn_len;
 		  in_prologue_bb = 1;
 		  continue;
 		}
@@ -668,6 +772,7 @@ nds32_analyze_prologue (struct gdbarch *gdbarch, CORE_ADDR pc,
 		nds32_push_multiple_words (cache, N32_RT5 (insn),
 					   N32_RB5 (insn),
 					   N32_LSMW_ENABLE4 (insn));
+	      last_change = pc + insn_len;
 	      in_prologue_bb = 1;
 	      continue;
 	    }
@@ -681,6 +786,7 @@ nds32_analyze_prologue (struct gdbarch *gdbarch, CORE_ADDR pc,
 		  if (cache != NULL)
 		    cache->sp_offset += -val_ta;
 
+		  last_change = pc + insn_len;
 		  in_prologue_bb = 1;
 		  continue;
 		}
@@ -797,6 +903,7 @@ nds32_analyze_prologue (struct gdbarch *gdbarch, CORE_ADDR pc,
 		  if (cache != NULL)
 		    cache->sp_offset += -imm10s;
 
+		  last_change = pc + insn_len;
 		  in_prologue_bb = 1;
 		  continue;
 		}
@@ -817,6 +924,7 @@ nds32_analyze_prologue (struct gdbarch *gdbarch, CORE_ADDR pc,
 		  cache->sp_offset += imm8u;
 		}
 
+	      last_change = pc + insn_len;
 	      in_prologue_bb = 1;
 	      continue;
 	    }
@@ -867,6 +975,9 @@ nds32_analyze_prologue (struct gdbarch *gdbarch, CORE_ADDR pc,
 	}
     }
 
+  if (last_change_p != NULL)
+    *last_change_p = last_change;
+
   return pc;
 }
 
@@ -904,6 +1015,210 @@ nds32_skip_prologue (struct gdbarch *gdbarch, CORE_ADDR pc)
   return nds32_analyze_prologue (gdbarch, pc, limit_pc, NULL);
 }
 
+/* Unwind summary of one function, derived from analyzing its prologue
+   so that the same function is not re-scanned on every stop.  Since the
+   scan stops at the frame's PC, the summary only holds for a range of
+   PCs: the same offsets are produced by any scan limit from FROM_PC,
+   the address following the last instruction that changed the offsets,
+   up to TO_PC.  FROM_PC and TO_PC are relative to the function start,
+   and FUNC_ADDR is relative to the offset of its objfile section, so
+   that the summary survives objfile relocation.  */
+
+struct nds32_unwind_summary
+{
+  CORE_ADDR func_addr;
+  CORE_ADDR from_pc;
+  CORE_ADDR to_pc;
+  CORE_ADDR sp_offset;
+  CORE_ADDR fp_offset;
+  CORE_ADDR saved_regs[NDS32_NUM_SAVED_REGS];
+};
+
+/* Per-objfile table of unwind summaries, sorted by FUNC_ADDR and
+   filled in lazily as functions are unwound.  */
+
+struct nds32_unwind_table
+{
+  std::vector<nds32_unwind_summary> entries;
+};
+
+static const struct objfile_data *nds32_unwind_table_key;
+
+/* Counters reported by "maint info nds32-unwind-table".  */
+
+static struct
+{
+  unsigned long lookups;
+  unsigned long hits;
+  unsigned long scans;
+  unsigned long invalidations;
+} nds32_unwind_stats;
+
+/* Free the unwind table attached to an objfile.  */
+
+static void
+nds32_unwind_table_free (struct objfile *objfile, void *arg)
+{
+  delete (struct nds32_unwind_table *) arg;
+}
+
+/* Return the unwind table of OBJFILE, creating it if necessary.  */
+
+static struct nds32_unwind_table *
+nds32_get_unwind_table (struct objfile *objfile)
+{
+  struct nds32_unwind_table *table
+    = (struct nds32_unwind_table *) objfile_data (objfile,
+						  nds32_unwind_table_key);
+
+  if (table == NULL)
+    {
+      table = new struct nds32_unwind_table;
+      set_objfile_data (objfile, nds32_unwind_table_key, table);
+    }
+
+  return table;
+}
+
+/* Drop all unwind summaries of OBJFILE.  */
+
+static void
+nds32_unwind_table_clear (struct objfile *objfile)
+{
+  struct nds32_unwind_table *table
+    = (struct nds32_unwind_table *) objfile_data (objfile,
+						  nds32_unwind_table_key);
+
+  if (table != NULL && !table->entries.empty ())
+    {
+      table->entries.clear ();
+      nds32_unwind_stats.invalidations++;
+    }
+}
+
+/* Observers used to invalidate the unwind tables when the code they
+   were derived from may have changed.  Reloading an objfile discards
+   its table along with the rest of the objfile data.  */
+
+static void
+nds32_unwind_table_memory_changed (struct inferior *inf, CORE_ADDR addr,
+				   ssize_t len, const bfd_byte *data)
+{
+  /* The write may start outside any code section and extend into
+     one, so check every section it overlaps.  */
+  for (objfile *objfile : current_program_space->objfiles ())
+    {
+      struct obj_section *osect;
+
+      ALL_OBJFILE_OSECTIONS (objfile, osect)
+	if ((bfd_get_section_flags (objfile->obfd, osect->the_bfd_section)
+	     & SEC_CODE) != 0
+	    && obj_section_addr (osect) < addr + len
+	    && addr < obj_section_endaddr (osect))
+	  {
+	    nds32_unwind_table_clear (objfile);
+	    break;
+	  }
+    }
+}
+
+static void
+nds32_unwind_table_inferior_created (struct target_ops *target,
+				     int from_tty)
+{
+  for (objfile *objfile : current_program_space->objfiles ())
+    nds32_unwind_table_clear (objfile);
+}
+
+/* Return true if the FUNC_ADDR of LHS is less than KEY.  */
+
+static bool
+nds32_unwind_summary_less (const nds32_unwind_summary &lhs, CORE_ADDR key)
+{
+  return lhs.func_addr < key;
+}
+
+/* Fill in CACHE with the prologue analysis of the function starting at
+   FUNC_ADDR up to LIMIT_PC, using the unwind table of the objfile
+   containing the function when possible.  */
+
+static void
+nds32_analyze_prologue_cached (struct gdbarch *gdbarch, CORE_ADDR func_addr,
+			       CORE_ADDR limit_pc,
+			       struct nds32_frame_cache *cache)
+{
+  struct obj_section *osect = find_pc_section (func_addr);
+  struct nds32_unwind_table *table;
+  struct nds32_unwind_summary entry;
+  CORE_ADDR key, from_pc, end_pc;
+
+  if (osect == NULL || limit_pc < func_addr)
+    {
+      nds32_analyze_prologue (gdbarch, func_addr, limit_pc, cache);
+      return;
+    }
+
+  table = nds32_get_unwind_table (osect->objfile);
+  key = func_addr - obj_section_offset (osect);
+  nds32_unwind_stats.lookups++;
+
+  auto it = std::lower_bound (table->entries.begin (), table->entries.end (),
+			      key, nds32_unwind_summary_less);
+  if (it != table->entries.end () && it->func_addr == key
+      && it->from_pc <= limit_pc - func_addr
+      && limit_pc - func_addr <= it->to_pc)
+    {
+      cache->sp_offset = it->sp_offset;
+      cache->fp_offset = it->fp_offset;
+      memcpy (cache->saved_regs, it->saved_regs, sizeof (cache->saved_regs));
+      nds32_unwind_stats.hits++;
+      return;
+    }
+
+  end_pc = nds32_analyze_prologue (gdbarch, func_addr, limit_pc, cache,
+				   &from_pc);
+  nds32_unwind_stats.scans++;
+
+  entry.func_addr = key;
+  entry.from_pc = from_pc - func_addr;
+  /* A scan that stopped before LIMIT_PC hit a branch, so any larger
+     limit gives the same result.  */
+  entry.to_pc = end_pc < limit_pc ? (CORE_ADDR) -1 : limit_pc - func_addr;
+  entry.sp_offset = cache->sp_offset;
+  entry.fp_offset = cache->fp_offset;
+  memcpy (entry.saved_regs, cache->saved_regs, sizeof (entry.saved_regs));
+
+  if (it != table->entries.end () && it->func_addr == key)
+    *it = entry;
+  else
+    table->entries.insert (it, entry);
+}
+
+/* Implement the "maint info nds32-unwind-table" command.  */
+
+static void
+maintenance_info_nds32_unwind_table (const char *args, int from_tty)
+{
+  for (objfile *objfile : current_program_space->objfiles ())
+    {
+      struct nds32_unwind_table *table
+	= (struct nds32_unwind_table *) objfile_data (objfile,
+						      nds32_unwind_table_key);
+
+      if (table == NULL || table->entries.empty ())
+	continue;
+
+      printf_filtered (_("%s: %s functions\n"), objfile_name (objfile),
+		       pulongest (table->entries.size ()));
+    }
+
+  printf_filtered (_("Lookups: %lu\n"), nds32_unwind_stats.lookups);
+  printf_filtered (_("Hits: %lu\n"), nds32_unwind_stats.hits);
+  printf_filtered (_("Prologue scans: %lu\n"), nds32_unwind_stats.scans);
+  printf_filtered (_("Invalidations: %lu\n"),
+		   nds32_unwind_stats.invalidations);
+}
+
 /* Allocate and fill in *THIS_CACHE with information about the prologue of
    *THIS_FRAME.  Do not do this if *THIS_CACHE was already allocated.  Return
    a pointer to the current nds32_frame_cache in *THIS_CACHE.  */
@@ -926,7 +1241,7 @@ nds32_frame_cache (struct frame_info *this_frame, void **this_cache)
 
   cache->pc = get_frame_func (this_frame);
   current_pc = get_frame_pc (this_frame);
-  nds32_analyze_prologue (gdbarch, cache->pc, current_pc, cache);
+  nds32_analyze_prologue_cached (gdbarch, cache->pc, current_pc, cache);
 
   /* Compute the previous frame's stack pointer (which is also the
      frame's ID's stack address), and this frame's base pointer.  */
@@ -1178,6 +1493,7 @@ nds32_analyze_epilogue (struct gdbarch *gdbarch, CORE_ADDR pc,
 {
   struct gdbarch_tdep *tdep = gdbarch_tdep (gdbarch);
   int abi_use_fpr = nds32_abi_use_fpr (tdep->elf_abi);
+  struct nds32_code_reader reader;
   CORE_ADDR limit_pc;
   uint32_t insn, insn_len;
   int insn_type = INSN_NORMAL;
@@ -1187,9 +1503,11 @@ nds32_analyze_epilogue (struct gdbarch *gdbarch, CORE_ADDR pc,
   else
     limit_pc = pc + 16;
 
+  nds32_code_reader_init (&reader);
+
   for (; pc < limit_pc; pc += insn_len)
     {
-      insn = read_memory_unsigned_integer (pc, 4, BFD_ENDIAN_BIG);
+      insn = nds32_read_insn (&reader, pc, limit_pc);
 
       if ((insn & 0x80000000) == 0)
 	{
@@ -1919,6 +2237,914 @@ nds32_get_longjmp_target (struct frame_info *frame, CORE_ADDR *pc)
   return 1;
 }
 
+/* Process record and replay.
+
+   An instruction is decoded into a summary of the state it may change:
+   a set of GPRs and FPU registers, a few other registers, and at most
+   one memory range, given as a base register plus either a constant or
+   a shifted index register.  Only the registers needed to resolve that
+   range are read when the instruction is recorded.
+
+   Summaries are kept in a small direct-mapped cache keyed by the
+   address and the raw bits of the instruction, so that a loop is
+   decoded once however many times it is stepped, and modified code is
+   decoded again.  */
+
+/* Bits of nds32_record_insn.sregs.  The first four index
+   gdbarch_tdep.usr_d_regnum.  */
+#define NDS32_RECORD_D0LO	(1 << 0)
+#define NDS32_RECORD_D0HI	(1 << 1)
+#define NDS32_RECORD_D1LO	(1 << 2)
+#define NDS32_RECORD_D1HI	(1 << 3)
+#define NDS32_RECORD_IFC_LP	(1 << 4)
+#define NDS32_RECORD_FPCSR	(1 << 5)
+
+#define NDS32_RECORD_GPR(n)	((uint32_t) 1 << (n))
+
+/* The libgloss system call numbers process record knows about.  */
+#define NDS32_SYS_EXIT		1
+#define NDS32_SYS_OPEN		2
+#define NDS32_SYS_CLOSE		3
+#define NDS32_SYS_READ		4
+#define NDS32_SYS_WRITE		5
+#define NDS32_SYS_LSEEK		6
+#define NDS32_SYS_UNLINK	7
+#define NDS32_SYS_GETPID	8
+#define NDS32_SYS_KILL		9
+#define NDS32_SYS_ARGVLEN	12
+#define NDS32_SYS_CHDIR		14
+#define NDS32_SYS_CHMOD		16
+#define NDS32_SYS_UTIME		17
+#define NDS32_SYS_TIME		18
+#define NDS32_SYS_GETTIMEOFDAY	19
+#define NDS32_SYS_TIMES		20
+#define NDS32_SYS_LINK		21
+
+enum nds32_record_mem
+{
+  /* No memory is written.  */
+  NDS32_RECORD_MEM_NONE,
+  /* MEM_SIZE bytes at MEM_BASE + MEM_OFF.  */
+  NDS32_RECORD_MEM_IMM,
+  /* MEM_SIZE bytes at MEM_BASE + (MEM_INDEX << MEM_SHIFT).  */
+  NDS32_RECORD_MEM_REG,
+  /* System call MEM_OFF.  */
+  NDS32_RECORD_MEM_SYSCALL
+};
+
+struct nds32_record_insn
+{
+  /* The address and the raw bits this summary was decoded from, the
+     latter as returned by nds32_read_insn.  LEN is 0 for an unused
+     cache entry.  */
+  CORE_ADDR pc;
+  uint32_t insn;
+  int len;
+
+  /* Zero if the instruction can not be recorded.  */
+  int supported;
+
+  /* GPRs, FDRs and FSRs written, one bit per register.  */
+  uint32_t gprs;
+  uint32_t fdrs;
+  uint32_t fsrs;
+  /* Other registers written, a mask of NDS32_RECORD_* bits.  */
+  unsigned int sregs;
+
+  enum nds32_record_mem mem;
+  int mem_base;
+  int mem_index;
+  int mem_shift;
+  int mem_size;
+  int32_t mem_off;
+};
+
+/* Number of entries in the decode cache; must be a power of two.  */
+#define NDS32_RECORD_CACHE_SIZE 256
+
+static struct nds32_record_insn nds32_record_cache[NDS32_RECORD_CACHE_SIZE];
+
+/* Set R to write SIZE bytes at BASE + OFF.  */
+
+static void
+nds32_record_mem_imm (struct nds32_record_insn *r, int base, int32_t off,
+		      int size)
+{
+  r->mem = NDS32_RECORD_MEM_IMM;
+  r->mem_base = base;
+  r->mem_off = off;
+  r->mem_size = size;
+}
+
+/* Set R to write SIZE bytes at BASE + (INDEX << SHIFT).  */
+
+static void
+nds32_record_mem_reg (struct nds32_record_insn *r, int base, int index,
+		      int shift, int size)
+{
+  r->mem = NDS32_RECORD_MEM_REG;
+  r->mem_base = base;
+  r->mem_index = index;
+  r->mem_shift = shift;
+  r->mem_size = size;
+}
+
+/* Summarize a load/store multiple words of registers RB-RE and those
+   selected by ENABLE4 with base RA, in addressing mode ABDIM.  */
+
+static void
+nds32_record_lsmw (struct nds32_record_insn *r, int store_p, int ra,
+		   int rb, int re, int enable4, int abdim)
+{
+  uint32_t regs = 0;
+  int i, n = 0;
+
+  /* RB == RE == SP selects no register from the range.  */
+  if (!(rb == REG_SP && re == REG_SP))
+    for (i = rb; i <= re; i++, n++)
+      regs |= NDS32_RECORD_GPR (i);
+  for (i = 0; i < 4; i++)
+    if (enable4 & (1 << i))
+      {
+	regs |= NDS32_RECORD_GPR (REG_SP - i);
+	n++;
+      }
+
+  if (!store_p)
+    r->gprs |= regs;
+  else if (n > 0)
+    {
+      int32_t off = (abdim & 4) ? 4 : 0;
+
+      /* Decrementing modes store the words below the base.  */
+      if (abdim & 2)
+	off = -(n - 1) * 4 - off;
+      nds32_record_mem_imm (r, ra, off, n * 4);
+    }
+
+  /* Base register update.  */
+  if (abdim & 1)
+    r->gprs |= NDS32_RECORD_GPR (ra);
+}
+
+/* Summarize the FPU instruction INSN, a COP instruction for CP0.
+   Return zero if it is not recognized.  */
+
+static int
+nds32_record_fpu (struct nds32_record_insn *r, uint32_t insn)
+{
+  int rt = N32_RT5 (insn);
+  int ra = N32_RA5 (insn);
+  int sub = __GF (insn, 6, 4);
+  int f2op = __GF (insn, 10, 5);
+  int size = 4;
+
+  switch (N32_COP_SUB (insn))
+    {
+    case N32_FPU_FS1:
+      r->sregs |= NDS32_RECORD_FPCSR;
+      if (sub == N32_FPU_FS1_F2OP && f2op == N32_FPU_FS1_F2OP_FS2D)
+	r->fdrs |= NDS32_RECORD_GPR (rt);
+      else
+	r->fsrs |= NDS32_RECORD_GPR (rt);
+      return 1;
+
+    case N32_FPU_FD1:
+      r->sregs |= NDS32_RECORD_FPCSR;
+      if (sub == N32_FPU_FD1_F2OP
+	  && (f2op == N32_FPU_FD1_F2OP_FD2S
+	      || f2op == N32_FPU_FD1_F2OP_FD2UI
+	      || f2op == N32_FPU_FD1_F2OP_FD2UI_Z
+	      || f2op == N32_FPU_FD1_F2OP_FD2SI
+	      || f2op == N32_FPU_FD1_F2OP_FD2SI_Z))
+	r->fsrs |= NDS32_RECORD_GPR (rt);
+      else
+	r->fdrs |= NDS32_RECORD_GPR (rt);
+      return 1;
+
+    case N32_FPU_FS2:
+    case N32_FPU_FD2:
+      /* Compares.  */
+      r->sregs |= NDS32_RECORD_FPCSR;
+      r->fsrs |= NDS32_RECORD_GPR (rt);
+      return 1;
+
+    case N32_FPU_MFCP:
+      r->gprs |= NDS32_RECORD_GPR (rt);
+      /* fmfdr writes a register pair.  */
+      if (sub == N32_FPU_MFCP_FMFDR && rt < REG_SP)
+	r->gprs |= NDS32_RECORD_GPR (rt + 1);
+      return 1;
+
+    case N32_FPU_MTCP:
+      if (sub == N32_FPU_MTCP_FMTSR)
+	r->fsrs |= NDS32_RECORD_GPR (ra);
+      else if (sub == N32_FPU_MTCP_FMTDR)
+	r->fdrs |= NDS32_RECORD_GPR (ra);
+      else if (sub == N32_FPU_MTCP_XR && f2op == N32_FPU_MTCP_XR_FMTCSR)
+	r->sregs |= NDS32_RECORD_FPCSR;
+      else
+	return 0;
+      return 1;
+
+    case N32_FPU_FLS:
+    case N32_FPU_FLD:
+      if (N32_COP_SUB (insn) == N32_FPU_FLS)
+	r->fsrs |= NDS32_RECORD_GPR (rt);
+      else
+	r->fdrs |= NDS32_RECORD_GPR (rt);
+      /* Post-increment forms.  */
+      if (insn & N32_BIT (7))
+	r->gprs |= NDS32_RECORD_GPR (ra);
+      return 1;
+
+    case N32_FPU_FSD:
+      size = 8;
+      /* Fall through.  */
+    case N32_FPU_FSS:
+      if (insn & N32_BIT (7))
+	{
+	  nds32_record_mem_imm (r, ra, 0, size);
+	  r->gprs |= NDS32_RECORD_GPR (ra);
+	}
+      else
+	nds32_record_mem_reg (r, ra, N32_RB5 (insn), __GF (insn, 8, 2),
+			      size);
+      return 1;
+    }
+
+  return 0;
+}
+
+/* Summarize the 32-bit instruction INSN.  Return zero if it is not
+   recognized.  */
+
+static int
+nds32_record_decode32 (struct nds32_record_insn *r, uint32_t insn)
+{
+  int rt = N32_RT5 (insn);
+  int ra = N32_RA5 (insn);
+  int rb = N32_RB5 (insn);
+  uint32_t rt_bit = NDS32_RECORD_GPR (rt);
+  uint32_t ra_bit = NDS32_RECORD_GPR (ra);
+
+  switch (N32_OP6 (insn))
+    {
+    case N32_OP6_LBI:
+    case N32_OP6_LHI:
+    case N32_OP6_LWI:
+    case N32_OP6_LBSI:
+    case N32_OP6_LHSI:
+    case N32_OP6_LBGP:
+    case N32_OP6_MOVI:
+    case N32_OP6_SETHI:
+    case N32_OP6_ADDI:
+    case N32_OP6_SUBRI:
+    case N32_OP6_ANDI:
+    case N32_OP6_XORI:
+    case N32_OP6_ORI:
+    case N32_OP6_BITCI:
+    case N32_OP6_SLTI:
+    case N32_OP6_SLTSI:
+    case N32_OP6_SIMD:
+      r->gprs |= rt_bit;
+      return 1;
+
+    case N32_OP6_LBI_BI:
+    case N32_OP6_LHI_BI:
+    case N32_OP6_LWI_BI:
+    case N32_OP6_LBSI_BI:
+    case N32_OP6_LHSI_BI:
+      r->gprs |= rt_bit | ra_bit;
+      return 1;
+
+    case N32_OP6_SBI:
+      nds32_record_mem_imm (r, ra, N32_IMM15S (insn), 1);
+      return 1;
+    case N32_OP6_SHI:
+      nds32_record_mem_imm (r, ra, N32_IMM15S (insn) << 1, 2);
+      return 1;
+    case N32_OP6_SWI:
+      nds32_record_mem_imm (r, ra, N32_IMM15S (insn) << 2, 4);
+      return 1;
+
+    case N32_OP6_SBI_BI:
+    case N32_OP6_SHI_BI:
+    case N32_OP6_SWI_BI:
+      nds32_record_mem_imm (r, ra, 0,
+			    1 << (N32_OP6 (insn) - N32_OP6_SBI_BI));
+      r->gprs |= ra_bit;
+      return 1;
+
+    case N32_OP6_DPREFI:
+      return 1;
+
+    case N32_OP6_SBGP:
+      /* addi.gp or sbi.gp.  */
+      if (insn & N32_BIT (19))
+	r->gprs |= rt_bit;
+      else
+	nds32_record_mem_imm (r, REG_GP, N32_IMMS (insn, 19), 1);
+      return 1;
+
+    case N32_OP6_HWGP:
+      switch (__GF (insn, 17, 3))
+	{
+	case 4: case 5:
+	  nds32_record_mem_imm (r, REG_GP, N32_IMMS (insn, 18) << 1, 2);
+	  break;
+	case 7:
+	  nds32_record_mem_imm (r, REG_GP, N32_IMMS (insn, 17) << 2, 4);
+	  break;
+	default:
+	  r->gprs |= rt_bit;
+	  break;
+	}
+      return 1;
+
+    case N32_OP6_MEM:
+      switch (N32_SUB6 (insn))
+	{
+	case N32_MEM_LB:
+	case N32_MEM_LH:
+	case N32_MEM_LW:
+	case N32_MEM_LBS:
+	case N32_MEM_LHS:
+	case N32_MEM_LBUP:
+	case N32_MEM_LWUP:
+	case N32_MEM_LLW:
+	  r->gprs |= rt_bit;
+	  return 1;
+	case N32_MEM_LB_BI:
+	case N32_MEM_LH_BI:
+	case N32_MEM_LW_BI:
+	case N32_MEM_LBS_BI:
+	case N32_MEM_LHS_BI:
+	  r->gprs |= rt_bit | ra_bit;
+	  return 1;
+	case N32_MEM_SB:
+	case N32_MEM_SBUP:
+	  nds32_record_mem_reg (r, ra, rb, __GF (insn, 8, 2), 1);
+	  return 1;
+	case N32_MEM_SH:
+	  nds32_record_mem_reg (r, ra, rb, __GF (insn, 8, 2), 2);
+	  return 1;
+	case N32_MEM_SW:
+	case N32_MEM_SWUP:
+	  nds32_record_mem_reg (r, ra, rb, __GF (insn, 8, 2), 4);
+	  return 1;
+	case N32_MEM_SCW:
+	  nds32_record_mem_reg (r, ra, rb, __GF (insn, 8, 2), 4);
+	  r->gprs |= rt_bit;
+	  return 1;
+	case N32_MEM_SB_BI:
+	case N32_MEM_SH_BI:
+	case N32_MEM_SW_BI:
+	  nds32_record_mem_imm (r, ra, 0,
+				1 << (N32_SUB6 (insn) - N32_MEM_SB_BI));
+	  r->gprs |= ra_bit;
+	  return 1;
+	case N32_MEM_DPREF:
+	  return 1;
+	}
+      return 0;
+
+    case N32_OP6_LSMW:
+      /* lmwzb/smwzb are not supported.  */
+      if (__GF (insn, 0, 2) != N32_LSMW_LSMW
+	  && __GF (insn, 0, 2) != N32_LSMW_LSMWA)
+	return 0;
+      nds32_record_lsmw (r, insn & N32_BIT (5), ra, rt, rb,
+			 N32_LSMW_ENABLE4 (insn), __GF (insn, 2, 3));
+      return 1;
+
+    case N32_OP6_ALU1:
+      r->gprs |= rt_bit;
+      if (N32_SUB5 (insn) == N32_ALU1_DIVSR
+	  || N32_SUB5 (insn) == N32_ALU1_DIVR)
+	r->gprs |= NDS32_RECORD_GPR (N32_RD5 (insn));
+      return 1;
+
+    case N32_OP6_ALU2:
+      {
+	/* The D0/D1 selector of the 64-bit multiply and divide forms.  */
+	unsigned int d = (insn & N32_BIT (21))
+			 ? NDS32_RECORD_D1LO : NDS32_RECORD_D0LO;
+
+	switch (__GF (insn, 0, 10))
+	  {
+	  case N32_ALU2_MAX:
+	  case N32_ALU2_MIN:
+	  case N32_ALU2_AVE:
+	  case N32_ALU2_ABS:
+	  case N32_ALU2_CLIPS:
+	  case N32_ALU2_CLIP:
+	  case N32_ALU2_CLO:
+	  case N32_ALU2_CLZ:
+	  case N32_ALU2_BSET:
+	  case N32_ALU2_BCLR:
+	  case N32_ALU2_BTGL:
+	  case N32_ALU2_BTST:
+	  case N32_ALU2_FFB:
+	  case N32_ALU2_FFMISM:
+	  case N32_ALU2_FFZMISM:
+	  case N32_ALU2_MFUSR:
+	  case N32_ALU2_MUL:
+	  case N32_BIT (6) | N32_ALU2_FFBI:
+	  case N32_BIT (6) | N32_ALU2_FLMISM:
+	  case N32_BIT (6) | N32_ALU2_MADDR32:
+	  case N32_BIT (6) | N32_ALU2_MSUBR32:
+	    r->gprs |= rt_bit;
+	    return 1;
+	  case N32_ALU2_BSE:
+	  case N32_ALU2_BSP:
+	    r->gprs |= rt_bit | NDS32_RECORD_GPR (rb);
+	    return 1;
+	  case N32_BIT (6) | N32_ALU2_MULSR64:
+	  case N32_BIT (6) | N32_ALU2_MULR64:
+	    r->gprs |= rt_bit;
+	    if (rt < REG_SP)
+	      r->gprs |= NDS32_RECORD_GPR (rt + 1);
+	    return 1;
+	  case N32_ALU2_MTUSR:
+	    {
+	      int usr = __GF (insn, 15, 5);
+
+	      /* Only group 0: D0, D1 and the PC.  */
+	      if (__GF (insn, 10, 5) != 0)
+		return 0;
+	      if (usr <= 3)
+		r->sregs |= NDS32_RECORD_D0LO << usr;
+	      else if (usr != 31)
+		return 0;
+	      return 1;
+	    }
+	  case N32_ALU2_MULTS64:
+	  case N32_ALU2_MULT64:
+	  case N32_ALU2_MADDS64:
+	  case N32_ALU2_MADD64:
+	  case N32_ALU2_MSUBS64:
+	  case N32_ALU2_MSUB64:
+	  case N32_ALU2_DIVS:
+	  case N32_ALU2_DIV:
+	    r->sregs |= d | (d << 1);
+	    return 1;
+	  case N32_ALU2_MULT32:
+	  case N32_ALU2_MADD32:
+	  case N32_ALU2_MSUB32:
+	    r->sregs |= d;
+	    return 1;
+	  }
+	return 0;
+      }
+
+    case N32_OP6_JI:
+      /* jal.  */
+      if (insn & N32_BIT (24))
+	r->gprs |= NDS32_RECORD_GPR (REG_LP);
+      return 1;
+
+    case N32_OP6_JREG:
+      if (N32_SUB5 (insn) == N32_JREG_JRAL
+	  || N32_SUB5 (insn) == N32_JREG_JRALNEZ)
+	r->gprs |= rt_bit;
+      return 1;
+
+    case N32_OP6_BR1:
+    case N32_OP6_BR3:
+      return 1;
+
+    case N32_OP6_BR2:
+      switch (N32_BR2_SUB (insn))
+	{
+	case N32_BR2_SOP0:
+	  /* ifcall.  */
+	  r->sregs |= NDS32_RECORD_IFC_LP;
+	  return 1;
+	case N32_BR2_BEQZ:
+	case N32_BR2_BNEZ:
+	case N32_BR2_BGEZ:
+	case N32_BR2_BLTZ:
+	case N32_BR2_BGTZ:
+	case N32_BR2_BLEZ:
+	  return 1;
+	case N32_BR2_BGEZAL:
+	case N32_BR2_BLTZAL:
+	  r->gprs |= NDS32_RECORD_GPR (REG_LP);
+	  return 1;
+	}
+      return 0;
+
+    case N32_OP6_MISC:
+      switch (N32_SUB5 (insn))
+	{
+	case N32_MISC_STANDBY:
+	case N32_MISC_TRAP:
+	case N32_MISC_TEQZ:
+	case N32_MISC_TNEZ:
+	case N32_MISC_DSB:
+	case N32_MISC_ISB:
+	case N32_MISC_BREAK:
+	case N32_MISC_MSYNC:
+	case N32_MISC_ISYNC:
+	  return 1;
+	case N32_MISC_CCTL:
+	case N32_MISC_MFSR:
+	case N32_MISC_BPICK:
+	  r->gprs |= rt_bit;
+	  return 1;
+	case N32_MISC_SYSCALL:
+	  r->mem = NDS32_RECORD_MEM_SYSCALL;
+	  r->mem_off = __GF (insn, 5, 15);
+	  r->gprs |= NDS32_RECORD_GPR (0);
+	  return 1;
+	}
+      /* System register writes, iret and TLB operations change state
+	 that can not be restored.  */
+      return 0;
+
+    case N32_OP6_LWC:
+    case N32_OP6_SWC:
+    case N32_OP6_LDC:
+    case N32_OP6_SDC:
+      /* Only CP0, the FPU.  */
+      if (__GF (insn, 13, 2) != 0)
+	return 0;
+      if (N32_OP6 (insn) == N32_OP6_LWC)
+	r->fsrs |= rt_bit;
+      else if (N32_OP6 (insn) == N32_OP6_LDC)
+	r->fdrs |= rt_bit;
+      else if (insn & N32_BIT (12))
+	nds32_record_mem_imm (r, ra, 0,
+			      N32_OP6 (insn) == N32_OP6_SWC ? 4 : 8);
+      else
+	nds32_record_mem_imm (r, ra, N32_IMM12S (insn) << 2,
+			      N32_OP6 (insn) == N32_OP6_SWC ? 4 : 8);
+      /* Post-increment forms.  */
+      if (insn & N32_BIT (12))
+	r->gprs |= ra_bit;
+      return 1;
+
+    case N32_OP6_COP:
+      if (N32_COP_CP (insn) != 0)
+	return 0;
+      return nds32_record_fpu (r, insn);
+    }
+
+  return 0;
+}
+
+/* Summarize the 16-bit instruction INSN.  Return zero if it is not
+   recognized.  */
+
+static int
+nds32_record_decode16 (struct nds32_record_insn *r, uint32_t insn)
+{
+  switch (__GF (insn, 9, 6))
+    {
+    case 0x4: case 0x5: case 0x6: case 0x7:	/* add45 ... subi45 */
+    case 0x8: case 0x9:			/* srai45, srli45 */
+    case 0x19: case 0x1a:		/* lwi45.fe, lwi450 */
+    case 0x3d:				/* movpi45 */
+      r->gprs |= NDS32_RECORD_GPR (N16_RT4 (insn));
+      return 1;
+
+    case 0xa: case 0xc: case 0xd:	/* slli333, add333, sub333 */
+    case 0xe: case 0xf:			/* addi333, subi333 */
+    case 0xb:				/* BFMI333 */
+    case 0x10: case 0x12: case 0x13:	/* lwi333, lhi333, lbi333 */
+    case 0x18:				/* addri36.sp */
+      r->gprs |= NDS32_RECORD_GPR (N16_RT3 (insn));
+      return 1;
+
+    case 0x3f:				/* MISC33 */
+      if (__GF (insn, 0, 3) < N16_MISC33_NEG33)
+	return 0;
+      r->gprs |= NDS32_RECORD_GPR (N16_RT3 (insn));
+      return 1;
+
+    case 0x11:				/* lwi333.bi */
+      r->gprs |= (NDS32_RECORD_GPR (N16_RT3 (insn))
+		  | NDS32_RECORD_GPR (N16_RA3 (insn)));
+      return 1;
+
+    case 0x14:				/* swi333 */
+      nds32_record_mem_imm (r, N16_RA3 (insn), N16_IMM3U (insn) << 2, 4);
+      return 1;
+    case 0x16:				/* shi333 */
+      nds32_record_mem_imm (r, N16_RA3 (insn), N16_IMM3U (insn) << 1, 2);
+      return 1;
+    case 0x17:				/* sbi333 */
+      nds32_record_mem_imm (r, N16_RA3 (insn), N16_IMM3U (insn), 1);
+      return 1;
+    case 0x15:				/* swi333.bi */
+      nds32_record_mem_imm (r, N16_RA3 (insn), 0, 4);
+      r->gprs |= NDS32_RECORD_GPR (N16_RA3 (insn));
+      return 1;
+    case 0x1b:				/* swi450 */
+      nds32_record_mem_imm (r, N16_RA5 (insn), 0, 4);
+      return 1;
+
+    case 0x30: case 0x31: case 0x32: case 0x33:	/* slt[s][i]45 */
+      r->gprs |= NDS32_RECORD_GPR (REG_TA);
+      return 1;
+
+    case 0x34:				/* beqzs8, bnezs8 */
+      return 1;
+
+    case 0x35:				/* break16, ex9.it */
+      return __GF (insn, 5, 4) == 0;
+
+    case 0x3c:				/* ifcall9 */
+      r->sregs |= NDS32_RECORD_IFC_LP;
+      return 1;
+
+    case 0x3e:
+      if (insn & N32_BIT (8))
+	{
+	  /* movd44 */
+	  int rt = __GF (insn, 4, 4) << 1;
+
+	  r->gprs |= NDS32_RECORD_GPR (rt) | NDS32_RECORD_GPR (rt + 1);
+	}
+      else
+	{
+	  /* push25 is smw.adm $r6, [$sp], Re, #0xe, then sp -= imm8u;
+	     pop25 is sp += imm8u, then lmw.bim $r6, [$sp], Re, #0xe.  */
+	  static const int re_map[] = { 6, 8, 10, 14 };
+	  int re = re_map[__GF (insn, 5, 2)];
+
+	  if (__GF (insn, 7, 8) == N16_T25_PUSH25)
+	    nds32_record_lsmw (r, 1, REG_SP, 6, re, 0xe, N32_LSMW_ADM);
+	  else
+	    nds32_record_lsmw (r, 0, REG_SP, 6, re, 0xe, N32_LSMW_BIM);
+	}
+      return 1;
+    }
+
+  switch (__GF (insn, 10, 5))
+    {
+    case 0x0:				/* mov55 or ifret16 */
+    case 0x1:				/* movi55 */
+      r->gprs |= NDS32_RECORD_GPR (N16_RT5 (insn));
+      return 1;
+    case 0x1b:				/* addi10s */
+      r->gprs |= NDS32_RECORD_GPR (REG_SP);
+      return 1;
+    }
+
+  switch (__GF (insn, 11, 4))
+    {
+    case 0x7:				/* lwi37.fp/swi37.fp */
+    case 0xe:				/* lwi37.sp/swi37.sp */
+      if (insn & N32_BIT (7))
+	nds32_record_mem_imm (r, __GF (insn, 11, 4) == 0x7 ? REG_FP : REG_SP,
+			      N16_IMM7U (insn) << 2, 4);
+      else
+	r->gprs |= NDS32_RECORD_GPR (N16_RT38 (insn));
+      return 1;
+
+    case 0x8: case 0x9: case 0xa:	/* beqz38, bnez38, beqs38/j8 */
+      return 1;
+
+    case 0xb:				/* bnes38 and others */
+      if (N16_RT38 (insn) != 5)
+	return 1;
+      switch (__GF (insn, 5, 3))
+	{
+	case 0:				/* jr5 */
+	case 4:				/* ret5 */
+	  return 1;
+	case 1:				/* jral5 */
+	  r->gprs |= NDS32_RECORD_GPR (REG_LP);
+	  return 1;
+	case 5:				/* add5.pc */
+	  r->gprs |= NDS32_RECORD_GPR (N16_RA5 (insn));
+	  return 1;
+	}
+      /* ex9.it executes an instruction from a table we do not
+	 decode.  */
+      return 0;
+    }
+
+  return 0;
+}
+
+/* Summarize INSN, as returned by nds32_read_insn, into R.  */
+
+static void
+nds32_record_decode_insn (struct nds32_record_insn *r, uint32_t insn)
+{
+  memset (r, 0, sizeof (*r));
+  r->mem = NDS32_RECORD_MEM_NONE;
+
+  if ((insn & 0x80000000) == 0)
+    {
+      r->insn = insn;
+      r->len = 4;
+      r->supported = nds32_record_decode32 (r, insn);
+    }
+  else
+    {
+      r->insn = insn & 0xffff0000;
+      r->len = 2;
+      r->supported = nds32_record_decode16 (r, insn >> 16);
+    }
+}
+
+/* Return the summary of the instruction at PC, decoding it unless the
+   cache has it already.  */
+
+static const struct nds32_record_insn *
+nds32_record_decode (CORE_ADDR pc)
+{
+  struct nds32_record_insn *r;
+  gdb_byte buf[4];
+  uint32_t insn;
+
+  /* A 16-bit instruction may be the last thing in readable memory.  */
+  if (target_read_code (pc, buf, 4) != 0)
+    {
+      read_code (pc, buf, 2);
+      if (buf[0] & 0x80)
+	buf[2] = buf[3] = 0;
+      else
+	read_code (pc, buf, 4);
+    }
+  insn = extract_unsigned_integer (buf, 4, BFD_ENDIAN_BIG);
+  if (insn & 0x80000000)
+    insn &= 0xffff0000;
+
+  r = &nds32_record_cache[(pc >> 1) & (NDS32_RECORD_CACHE_SIZE - 1)];
+  if (r->len == 0 || r->pc != pc || r->insn != insn)
+    {
+      nds32_record_decode_insn (r, insn);
+      r->pc = pc;
+    }
+
+  return r;
+}
+
+/* Record the memory libgloss system call NUMBER writes.  The arguments
+   are in $r0 to $r2.  Return -1 if the system call is not supported,
+   which is the case for those writing memory whose layout is not
+   known here, such as fstat, stat and argv.  */
+
+static int
+nds32_record_syscall (struct regcache *regcache, int number)
+{
+  ULONGEST arg1, arg2;
+
+  switch (number)
+    {
+    case NDS32_SYS_EXIT:
+    case NDS32_SYS_OPEN:
+    case NDS32_SYS_CLOSE:
+    case NDS32_SYS_WRITE:
+    case NDS32_SYS_LSEEK:
+    case NDS32_SYS_UNLINK:
+    case NDS32_SYS_GETPID:
+    case NDS32_SYS_KILL:
+    case NDS32_SYS_ARGVLEN:
+    case NDS32_SYS_CHDIR:
+    case NDS32_SYS_CHMOD:
+    case NDS32_SYS_UTIME:
+    case NDS32_SYS_LINK:
+      return 0;
+
+    case NDS32_SYS_READ:
+      /* read (fd, buf, count) fills BUF.  */
+      regcache_raw_read_unsigned (regcache, NDS32_R0_REGNUM + 1, &arg1);
+      regcache_raw_read_unsigned (regcache, NDS32_R0_REGNUM + 2, &arg2);
+      if (arg2 != 0 && record_full_arch_list_add_mem (arg1, arg2))
+	return -1;
+      return 0;
+
+    case NDS32_SYS_TIME:
+      /* time (t) stores a 4-byte time_t at T, if not null.  */
+      regcache_raw_read_unsigned (regcache, NDS32_R0_REGNUM, &arg1);
+      if (arg1 != 0 && record_full_arch_list_add_mem (arg1, 4))
+	return -1;
+      return 0;
+
+    case NDS32_SYS_GETTIMEOFDAY:
+      /* gettimeofday (tv, tz) fills an 8-byte struct timeval and an
+	 8-byte struct timezone, either of which may be null.  */
+      regcache_raw_read_unsigned (regcache, NDS32_R0_REGNUM, &arg1);
+      regcache_raw_read_unsigned (regcache, NDS32_R0_REGNUM + 1, &arg2);
+      if ((arg1 != 0 && record_full_arch_list_add_mem (arg1, 8))
+	  || (arg2 != 0 && record_full_arch_list_add_mem (arg2, 8)))
+	return -1;
+      return 0;
+
+    case NDS32_SYS_TIMES:
+      /* times (buf) fills a struct tms, four 4-byte clock_t.  */
+      regcache_raw_read_unsigned (regcache, NDS32_R0_REGNUM, &arg1);
+      if (arg1 != 0 && record_full_arch_list_add_mem (arg1, 16))
+	return -1;
+      return 0;
+    }
+
+  printf_unfiltered (_("Process record does not support system call "
+		       "%d.\n"), number);
+  return -1;
+}
+
+/* Implement the "process_record" gdbarch method.  */
+
+static int
+nds32_process_record (struct gdbarch *gdbarch, struct regcache *regcache,
+		      CORE_ADDR addr)
+{
+  struct gdbarch_tdep *tdep = gdbarch_tdep (gdbarch);
+  const struct nds32_record_insn *r;
+  ULONGEST base, index;
+  int i;
+
+  if (record_debug > 1)
+    fprintf_unfiltered (gdb_stdlog, "Process record: nds32_process_record "
+			"addr = %s\n", paddress (gdbarch, addr));
+
+  r = nds32_record_decode (addr);
+  if (!r->supported
+      || ((r->fdrs | r->fsrs) != 0 && tdep->fpu_freg == -1))
+    {
+      printf_unfiltered (_("Process record does not support instruction "
+			   "0x%x at address %s.\n"),
+			 r->len == 2 ? r->insn >> 16 : r->insn,
+			 paddress (gdbarch, addr));
+      return -1;
+    }
+
+  switch (r->mem)
+    {
+    case NDS32_RECORD_MEM_NONE:
+      break;
+
+    case NDS32_RECORD_MEM_IMM:
+      regcache_raw_read_unsigned (regcache, r->mem_base, &base);
+      if (record_full_arch_list_add_mem ((uint32_t) (base + r->mem_off),
+					 r->mem_size))
+	return -1;
+      break;
+
+    case NDS32_RECORD_MEM_REG:
+      regcache_raw_read_unsigned (regcache, r->mem_base, &base);
+      regcache_raw_read_unsigned (regcache, r->mem_index, &index);
+      if (record_full_arch_list_add_mem
+	    ((uint32_t) (base + (index << r->mem_shift)), r->mem_size))
+	return -1;
+      break;
+
+    case NDS32_RECORD_MEM_SYSCALL:
+      if (nds32_record_syscall (regcache, r->mem_off))
+	return -1;
+      break;
+    }
+
+  for (i = 0; i < 32; i++)
+    if ((r->gprs & NDS32_RECORD_GPR (i))
+	&& record_full_arch_list_add_reg (regcache, NDS32_R0_REGNUM + i))
+      return -1;
+
+  if (tdep->fpu_freg != -1)
+    for (i = 0; i < 32; i++)
+      {
+	if ((r->fdrs & NDS32_RECORD_GPR (i))
+	    && i < num_fdr_map[tdep->fpu_freg]
+	    && record_full_arch_list_add_reg (regcache, NDS32_FD0_REGNUM + i))
+	  return -1;
+
+	/* A pseudo FSR is half of an FDR.  */
+	if ((r->fsrs & NDS32_RECORD_GPR (i))
+	    && i < num_fsr_map[tdep->fpu_freg]
+	    && record_full_arch_list_add_reg (regcache,
+					      tdep->use_pseudo_fsrs
+					      ? NDS32_FD0_REGNUM + (i >> 1)
+					      : tdep->fs0_regnum + i))
+	  return -1;
+      }
+
+  for (i = 0; i < 4; i++)
+    if ((r->sregs & (NDS32_RECORD_D0LO << i))
+	&& tdep->usr_d_regnum[i] != -1
+	&& record_full_arch_list_add_reg (regcache, tdep->usr_d_regnum[i]))
+      return -1;
+  if ((r->sregs & NDS32_RECORD_IFC_LP) && tdep->ifc_lp_regnum != -1
+      && record_full_arch_list_add_reg (regcache, tdep->ifc_lp_regnum))
+    return -1;
+  if ((r->sregs & NDS32_RECORD_FPCSR) && tdep->fpcsr_regnum != -1
+      && record_full_arch_list_add_reg (regcache, tdep->fpcsr_regnum))
+    return -1;
+
+  if (record_full_arch_list_add_reg (regcache, NDS32_PC_REGNUM))
+    return -1;
+  if (record_full_arch_list_add_end ())
+    return -1;
+
+  return 0;
+}
+
 /* Validate the given TDESC, and fixed-number some registers in it.
    Return 0 if the given TDESC does not contain the required feature
    or not contain required registers.  */
@@ -2012,6 +3238,28 @@ nds32_validate_tdesc_p (const struct target_desc *tdesc,
   return 1;
 }
 
+/* Return the number of the raw or pseudo register of GDBARCH named
+   NAME, or -1 if there is none.  The user register name space is not
+   searched, as user_reg_map_name_to_regnum would do: it is not set up
+   until the gdbarch has been initialized.  */
+
+static int
+nds32_cooked_regnum (struct gdbarch *gdbarch, const char *name)
+{
+  int maxregs = gdbarch_num_cooked_regs (gdbarch);
+  int regnum;
+
+  for (regnum = 0; regnum < maxregs; regnum++)
+    {
+      const char *regname = gdbarch_register_name (gdbarch, regnum);
+
+      if (regname != NULL && strcmp (regname, name) == 0)
+	return regnum;
+    }
+
+  return -1;
+}
+
 /* Initialize the current architecture based on INFO.  If possible,
    re-use an architecture from ARCHES, which is a list of
    architectures already created during this debugging session.
@@ -2030,7 +3278,7 @@ nds32_gdbarch_init (struct gdbarch_info info, struct gdbarch_list *arches)
   int elf_abi = E_NDS_ABI_AABI;
   int fpu_freg = -1;
   int use_pseudo_fsrs = 0;
-  int i, num_regs, maxregs;
+  int i, num_regs;
 
   /* Extract the elf_flags if available.  */
   if (info.abfd && bfd_get_flavour (info.abfd) == bfd_target_elf_flavour)
@@ -2098,26 +3346,19 @@ nds32_gdbarch_init (struct gdbarch_info info, struct gdbarch_list *arches)
   if (fpu_freg != -1)
     tdep->fs0_regnum = user_reg_map_name_to_regnum (gdbarch, "fs0", -1);
 
-  /* Add NDS32 register aliases.  To avoid search in user register name space,
-     user_reg_map_name_to_regnum is not used.  */
-  maxregs = gdbarch_num_cooked_regs (gdbarch);
+  /* Cache the register numbers the process record may need.  */
+  tdep->usr_d_regnum[0] = nds32_cooked_regnum (gdbarch, "d0lo");
+  tdep->usr_d_regnum[1] = nds32_cooked_regnum (gdbarch, "d0hi");
+  tdep->usr_d_regnum[2] = nds32_cooked_regnum (gdbarch, "d1lo");
+  tdep->usr_d_regnum[3] = nds32_cooked_regnum (gdbarch, "d1hi");
+  tdep->ifc_lp_regnum = nds32_cooked_regnum (gdbarch, "ifc_lp");
+  tdep->fpcsr_regnum = nds32_cooked_regnum (gdbarch, "fpcsr");
+
+  /* Add NDS32 register aliases.  */
   for (i = 0; i < ARRAY_SIZE (nds32_register_aliases); i++)
     {
-      int regnum, j;
-
-      regnum = -1;
-      /* Search register name space.  */
-      for (j = 0; j < maxregs; j++)
-	{
-	  const char *regname = gdbarch_register_name (gdbarch, j);
-
-	  if (regname != NULL
-	      && strcmp (regname, nds32_register_aliases[i].name) == 0)
-	    {
-	      regnum = j;
-	      break;
-	    }
-	}
+      int regnum = nds32_cooked_regnum (gdbarch,
+					nds32_register_aliases[i].name);
 
       /* Try next alias entry if the given name can not be found in register
 	 name space.  */
@@ -2136,6 +3377,8 @@ nds32_gdbarch_init (struct gdbarch_info info, struct gdbarch_list *arches)
 
   /* Override tdesc_register callbacks for system registers.  */
   set_gdbarch_register_reggroup_p (gdbarch, nds32_register_reggroup_p);
+  set_gdbarch_fetch_register_on_demand (gdbarch,
+				       nds32_fetch_register_on_demand);
 
   set_gdbarch_sp_regnum (gdbarch, NDS32_SP_REGNUM);
   set_gdbarch_pc_regnum (gdbarch, NDS32_PC_REGNUM);
@@ -2143,6 +3386,7 @@ nds32_gdbarch_init (struct gdbarch_info info, struct gdbarch_list *arches)
   set_gdbarch_unwind_pc (gdbarch, nds32_unwind_pc);
   set_gdbarch_stack_frame_destroyed_p (gdbarch, nds32_stack_frame_destroyed_p);
   set_gdbarch_dwarf2_reg_to_regnum (gdbarch, nds32_dwarf2_reg_to_regnum);
+  set_gdbarch_register_sim_regno (gdbarch, nds32_register_sim_regno);
 
   set_gdbarch_push_dummy_call (gdbarch, nds32_push_dummy_call);
   set_gdbarch_return_value (gdbarch, nds32_return_value);
@@ -2161,6 +3405,9 @@ nds32_gdbarch_init (struct gdbarch_info info, struct gdbarch_list *arches)
   /* Handle longjmp.  */
   set_gdbarch_get_longjmp_target (gdbarch, nds32_get_longjmp_target);
 
+  /* Support reverse debugging.  */
+  set_gdbarch_process_record (gdbarch, nds32_process_record);
+
   /* The order of appending is the order it check frame.  */
   dwarf2_append_unwinders (gdbarch);
   frame_unwind_append_unwinder (gdbarch, &nds32_epilogue_frame_unwind);
@@ -2169,6 +3416,77 @@ nds32_gdbarch_init (struct gdbarch_info info, struct gdbarch_list *arches)
   return gdbarch;
 }
 
+#if GDB_SELF_TEST
+namespace selftests
+{
+
+/* Check the summaries of a few instructions.  */
+
+static void
+nds32_process_record_test (void)
+{
+  struct nds32_record_insn r;
+
+  /* swi $r1, [$sp + 8] */
+  nds32_record_decode_insn (&r, N32_TYPE2 (SWI, 1, REG_SP, 2));
+  SELF_CHECK (r.supported && r.len == 4);
+  SELF_CHECK (r.gprs == 0);
+  SELF_CHECK (r.mem == NDS32_RECORD_MEM_IMM);
+  SELF_CHECK (r.mem_base == REG_SP && r.mem_off == 8 && r.mem_size == 4);
+
+  /* sw.bi $r2, [$r3], $r4 << 2 */
+  nds32_record_decode_insn (&r, N32_MEM (SW_BI, 2, 3, 4, 2));
+  SELF_CHECK (r.supported);
+  SELF_CHECK (r.gprs == NDS32_RECORD_GPR (3));
+  SELF_CHECK (r.mem == NDS32_RECORD_MEM_IMM && r.mem_base == 3
+	      && r.mem_off == 0 && r.mem_size == 4);
+
+  /* smw.adm $r6, [$sp], $r8, #0xa */
+  nds32_record_decode_insn (&r, N32_TYPE4 (LSMW, 6, REG_SP, 8,
+					   (0xa << 1) | 1, N32_LSMW_ADM << 2));
+  SELF_CHECK (r.supported);
+  SELF_CHECK (r.gprs == NDS32_RECORD_GPR (REG_SP));
+  SELF_CHECK (r.mem == NDS32_RECORD_MEM_IMM && r.mem_base == REG_SP
+	      && r.mem_off == -20 && r.mem_size == 20);
+
+  /* push25 $r10, #16 */
+  nds32_record_decode_insn (&r, N16_TYPE25 (PUSH25, 2, 2) << 16);
+  SELF_CHECK (r.supported && r.len == 2);
+  SELF_CHECK (r.gprs == NDS32_RECORD_GPR (REG_SP));
+  SELF_CHECK (r.mem_off == -32 && r.mem_size == 32);
+
+  /* pop25 $r6, #0 */
+  nds32_record_decode_insn (&r, N16_TYPE25 (POP25, 0, 0) << 16);
+  SELF_CHECK (r.supported);
+  SELF_CHECK (r.gprs == (NDS32_RECORD_GPR (6) | NDS32_RECORD_GPR (REG_FP)
+			 | NDS32_RECORD_GPR (REG_GP)
+			 | NDS32_RECORD_GPR (REG_LP)
+			 | NDS32_RECORD_GPR (REG_SP)));
+  SELF_CHECK (r.mem == NDS32_RECORD_MEM_NONE);
+
+  /* slts45 $r0, $r1 */
+  nds32_record_decode_insn (&r, N16_TYPE45 (SLTS45, 0, 1) << 16);
+  SELF_CHECK (r.supported && r.gprs == NDS32_RECORD_GPR (REG_TA));
+
+  /* mult64 $d1, $r0, $r1 */
+  nds32_record_decode_insn (&r, N32_ALU2 (MULT64, 1 << 1, 0, 1));
+  SELF_CHECK (r.supported && r.gprs == 0);
+  SELF_CHECK (r.sregs == (NDS32_RECORD_D1LO | NDS32_RECORD_D1HI));
+
+  /* syscall #4 */
+  nds32_record_decode_insn (&r, N32_TYPE0 (MISC, (4 << 5)
+					   | N32_MISC_SYSCALL));
+  SELF_CHECK (r.supported && r.gprs == NDS32_RECORD_GPR (0));
+  SELF_CHECK (r.mem == NDS32_RECORD_MEM_SYSCALL && r.mem_off == 4);
+
+  /* mtsr $r0, $psw */
+  nds32_record_decode_insn (&r, N32_TYPE0 (MISC, N32_MISC_MTSR));
+  SELF_CHECK (!r.supported);
+}
+
+} // namespace selftests
+#endif /* GDB_SELF_TEST */
+
 void
 _initialize_nds32_tdep (void)
 {
@@ -2177,4 +3495,20 @@ _initialize_nds32_tdep (void)
 
   initialize_tdesc_nds32 ();
   nds32_init_reggroups ();
+
+  nds32_unwind_table_key
+    = register_objfile_data_with_cleanup (NULL, nds32_unwind_table_free);
+  gdb::observers::memory_changed.attach (nds32_unwind_table_memory_changed);
+  gdb::observers::inferior_created.attach
+    (nds32_unwind_table_inferior_created);
+
+  add_cmd ("nds32-unwind-table", class_maintenance,
+	   maintenance_info_nds32_unwind_table,
+	   _("Show statistics about the NDS32 prologue unwind table."),
+	   &maintenanceinfolist);
+
+#if GDB_SELF_TEST
+  selftests::register_test ("nds32-process-record",
+			    selftests::nds32_process_record_test);
+#endif
 }
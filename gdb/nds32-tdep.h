@@ -50,5 +50,11 @@ struct gdbarch_tdep
   int fs0_regnum;
   /* ELF ABI info.  */
   int elf_abi;
+  /* Cached regnums of D0.LO, D0.HI, D1.LO and D1.HI, of IFC_LP and
+     of FPCSR, or -1 if the target description lacks them.  Used by
+     the process record.  */
+  int usr_d_regnum[4];
+  int ifc_lp_regnum;
+  int fpcsr_regnum;
 };
 #endif /* NDS32_TDEP_H */
@@ -42,9 +42,11 @@
 #include "cli/cli-decode.h"
 #include "cli/cli-setshow.h"
 #include "target-descriptions.h"
+#include "target-dcache.h"
 #include "gdb_bfd.h"
 #include "filestuff.h"
 #include "rsp-low.h"
+#include "rsp-compress.h"
 #include "disasm.h"
 #include "location.h"
 
@@ -77,6 +79,8 @@
 #include "environ.h"
 #include "common/byte-vector.h"
 #include <unordered_map>
+#include <chrono>
+#include <deque>
 
 /* The remote target.  */
 
@@ -275,6 +279,17 @@ public: /* data */
      reliable.  */
   bool noack_mode = false;
 
+  /* The compression of the packets we send and receive, once the
+     stub has accepted the QStartCompression packet.  NULL while the
+     connection is not compressed.  */
+  std::unique_ptr<rsp_deflater> deflater;
+  std::unique_ptr<rsp_inflater> inflater;
+
+  /* The number of memory write packets the stub accepts before GDB
+     must wait for their replies, as reported by the
+     "MemoryWriteWindow" qSupported feature.  1 if not reported.  */
+  int memory_write_window = 1;
+
   /* True if we're connected in extended remote mode.  */
   bool extended = false;
 
@@ -644,6 +659,8 @@ public:
   int verify_memory (const gdb_byte *data,
 		     CORE_ADDR memaddr, ULONGEST size) override;
 
+  bool can_verify_memory_cheaply () override;
+
 
   bool get_tib_address (ptid_t ptid, CORE_ADDR *addr) override;
 
@@ -823,6 +840,10 @@ public: /* Remote specific methods.  */
   void remote_packet_size (const protocol_feature *feature,
 			   packet_support support, const char *value);
 
+  void remote_memory_write_window (const protocol_feature *feature,
+				   packet_support support,
+				   const char *value);
+
   void remote_serial_quit_handler ();
 
   void remote_detach_pid (int pid);
@@ -850,6 +871,11 @@ public: /* Remote specific methods.  */
 
   void check_binary_download (CORE_ADDR addr);
 
+  int build_memory_write_packet (const char *header, CORE_ADDR memaddr,
+				 const gdb_byte *myaddr, ULONGEST len_units,
+				 int unit_size, int *units_written,
+				 char packet_format, int use_length);
+
   target_xfer_status remote_write_bytes_aux (const char *header,
 					     CORE_ADDR memaddr,
 					     const gdb_byte *myaddr,
@@ -859,6 +885,14 @@ public: /* Remote specific methods.  */
 					     char packet_format,
 					     int use_length);
 
+  int get_memory_write_window ();
+
+  target_xfer_status remote_write_bytes_windowed (CORE_ADDR memaddr,
+						  const gdb_byte *myaddr,
+						  ULONGEST len_units,
+						  int unit_size, int window,
+						  ULONGEST *xfered_len_units);
+
   target_xfer_status remote_write_bytes (CORE_ADDR memaddr,
 					 const gdb_byte *myaddr, ULONGEST len,
 					 int unit_size, ULONGEST *xfered_len);
@@ -899,6 +933,7 @@ public: /* Remote specific methods.  */
 
   void skip_frame ();
   long read_frame (gdb::char_vector *buf_p);
+  long decompress_frame (gdb::char_vector *buf_p, long len);
   void getpkt (gdb::char_vector *buf, int forever);
   int getpkt_or_notif_sane_1 (gdb::char_vector *buf, int forever,
 			      int expecting_notif, int *is_notif);
@@ -1714,6 +1749,26 @@ show_memory_write_packet_size (const char *args, int from_tty)
   show_memory_packet_size (&memory_write_packet_config);
 }
 
+/* The maximum number of memory write packets GDB keeps in flight
+   without waiting for their replies.  The stub may lower this with
+   the "MemoryWriteWindow" qSupported feature.  -1 means no limit
+   other than the stub's.  */
+
+static int memory_write_window_limit = 16;
+
+static void
+show_memory_write_window (struct ui_file *file, int from_tty,
+			  struct cmd_list_element *c, const char *value)
+{
+  remote_target *remote = get_current_remote_target ();
+
+  fprintf_filtered (file, _("The maximum number of memory write packets "
+			    "in flight is %s.\n"), value);
+  if (remote != NULL)
+    fprintf_filtered (file, _("The current target allows %d.\n"),
+		      remote->get_memory_write_window ());
+}
+
 /* Show the number of hardware watchpoints that can be used.  */
 
 static void
@@ -2108,6 +2163,15 @@ enum {
   /* Support TARGET_WAITKIND_NO_RESUMED.  */
   PACKET_no_resumed,
 
+  /* Support for the 'x' binary memory read packet.  */
+  PACKET_x,
+
+  /* Support for expedite-memory+ feature.  */
+  PACKET_expedite_memory_feature,
+
+  /* Support for compressing the connection.  */
+  PACKET_QStartCompression,
+
   PACKET_MAX
 };
 
@@ -4532,6 +4596,7 @@ remote_target::start_remote (int from_tty, int extended_p)
 {
   struct remote_state *rs = get_remote_state ();
   struct packet_config *noack_config;
+  struct packet_config *compression_config;
   char *wait_status = NULL;
 
   /* Signal other parts that we're going through the initial setup,
@@ -4600,6 +4665,30 @@ remote_target::start_remote (int from_tty, int extended_p)
 	rs->noack_mode = 1;
     }
 
+  /* Next, start compressing the connection, if the user asked for it
+     with "set remote compression-packet on".  Compression costs CPU
+     time on both sides and only pays off over slow links, so it is
+     not used just because the stub supports it.  The stub's reply to
+     QStartCompression is not compressed; every packet that follows
+     it, in either direction, is.
+
+     This is only done in noack mode.  A compressed packet must be
+     decompressed exactly once, but with acknowledgments, putpkt
+     resends a packet whose '+' is late, and so does the stub, and
+     the receiver can't tell the copy from a new packet.  */
+
+  compression_config = &remote_protocol_packets[PACKET_QStartCompression];
+  if (rs->noack_mode && compression_config->detect == AUTO_BOOLEAN_TRUE)
+    {
+      putpkt ("QStartCompression");
+      getpkt (&rs->buf, 0);
+      if (packet_ok (rs->buf, compression_config) == PACKET_OK)
+	{
+	  rs->deflater.reset (new rsp_deflater ());
+	  rs->inflater.reset (new rsp_inflater ());
+	}
+    }
+
   if (extended_p)
     {
       /* Tell the remote that we are using the extended protocol.  */
@@ -5086,6 +5175,46 @@ remote_packet_size (remote_target *remote, const protocol_feature *feature,
   remote->remote_packet_size (feature, support, value);
 }
 
+void
+remote_target::remote_memory_write_window (const protocol_feature *feature,
+					   enum packet_support support,
+					   const char *value)
+{
+  struct remote_state *rs = get_remote_state ();
+
+  int window;
+  char *value_end;
+
+  if (support != PACKET_ENABLE)
+    return;
+
+  if (value == NULL || *value == '\0')
+    {
+      warning (_("Remote target reported \"%s\" without a size."),
+	       feature->name);
+      return;
+    }
+
+  errno = 0;
+  window = strtol (value, &value_end, 16);
+  if (errno != 0 || *value_end != '\0' || window < 1)
+    {
+      warning (_("Remote target reported \"%s\" with a bad size: \"%s\"."),
+	       feature->name, value);
+      return;
+    }
+
+  rs->memory_write_window = window;
+}
+
+static void
+remote_memory_write_window (remote_target *remote,
+			    const protocol_feature *feature,
+			    enum packet_support support, const char *value)
+{
+  remote->remote_memory_write_window (feature, support, value);
+}
+
 static const struct protocol_feature remote_protocol_features[] = {
   { "PacketSize", PACKET_DISABLE, remote_packet_size, -1 },
   { "qXfer:auxv:read", PACKET_DISABLE, remote_supported_packet,
@@ -5193,6 +5322,12 @@ static const struct protocol_feature remote_protocol_features[] = {
   { "vContSupported", PACKET_DISABLE, remote_supported_packet, PACKET_vContSupported },
   { "QThreadEvents", PACKET_DISABLE, remote_supported_packet, PACKET_QThreadEvents },
   { "no-resumed", PACKET_DISABLE, remote_supported_packet, PACKET_no_resumed },
+  { "MemoryWriteWindow", PACKET_DISABLE, remote_memory_write_window, -1 },
+  { "binary-upload", PACKET_DISABLE, remote_supported_packet, PACKET_x },
+  { "expedite-memory", PACKET_DISABLE, remote_supported_packet,
+    PACKET_expedite_memory_feature },
+  { "QStartCompression", PACKET_DISABLE, remote_supported_packet,
+    PACKET_QStartCompression },
 };
 
 static char *remote_support_xml;
@@ -5264,6 +5399,9 @@ remote_target::remote_query_supported ()
 	remote_query_supported_append (&q, "swbreak+");
       if (packet_set_cmd_state (PACKET_hwbreak_feature) != AUTO_BOOLEAN_FALSE)
 	remote_query_supported_append (&q, "hwbreak+");
+      if (packet_set_cmd_state (PACKET_expedite_memory_feature)
+	  != AUTO_BOOLEAN_FALSE)
+	remote_query_supported_append (&q, "expedite-memory+");
 
       remote_query_supported_append (&q, "qRelocInsn+");
 
@@ -5564,6 +5702,9 @@ remote_target::open_1 (const char *name, int from_tty, int extended_p)
   rs->cached_wait_status = 0;
   rs->explicit_packet_size = 0;
   rs->noack_mode = 0;
+  rs->deflater.reset ();
+  rs->inflater.reset ();
+  rs->memory_write_window = 1;
   rs->extended = extended_p;
   rs->waiting_for_stop_reply = 0;
   rs->ctrlc_pending_p = 0;
@@ -6820,6 +6961,17 @@ remote_console_output (const char *msg)
 
 DEF_VEC_O(cached_reg_t);
 
+/* A block of target memory sent along with a stop reply.  */
+
+typedef struct cached_mem
+{
+  CORE_ADDR addr;
+  int len;
+  gdb_byte *data;
+} cached_mem_t;
+
+DEF_VEC_O(cached_mem_t);
+
 typedef struct stop_reply
 {
   struct notif_event base;
@@ -6843,6 +6995,12 @@ typedef struct stop_reply
      fetch them is avoided).  */
   VEC(cached_reg_t) *regcache;
 
+  /* Expedited memory, typically the memory around the stack pointer
+     and the program counter, sent with the "expedite-memory"
+     feature.  It saves the requests made to unwind the frame the
+     thread stopped in.  */
+  VEC(cached_mem_t) *memory;
+
   enum target_stop_reason stop_reason;
 
   CORE_ADDR watch_data_address;
@@ -6856,6 +7014,20 @@ stop_reply_xfree (struct stop_reply *r)
   notif_event_xfree ((struct notif_event *) r);
 }
 
+/* Discard the expedited memory of the stop reply R.  */
+
+static void
+stop_reply_free_memory (struct stop_reply *r)
+{
+  cached_mem_t *mem;
+  int ix;
+
+  for (ix = 0; VEC_iterate (cached_mem_t, r->memory, ix, mem); ix++)
+    xfree (mem->data);
+
+  VEC_free (cached_mem_t, r->memory);
+}
+
 /* Return the length of the stop reply queue.  */
 
 int
@@ -6919,6 +7091,7 @@ stop_reply_dtr (struct notif_event *event)
     xfree (reg->data);
 
   VEC_free (cached_reg_t, r->regcache);
+  stop_reply_free_memory (r);
 }
 
 static struct notif_event *
@@ -7217,6 +7390,7 @@ remote_target::remote_parse_stop_reply (const char *buf, stop_reply *event)
   event->ws.value.integer = 0;
   event->stop_reason = TARGET_STOPPED_BY_NO_REASON;
   event->regcache = NULL;
+  event->memory = NULL;
   event->core = -1;
 
   switch (buf[0])
@@ -7304,6 +7478,35 @@ Packet: '%s'\n"),
 	      /* See above.  */
 	      p = strchrnul (p1 + 1, ';');
 	    }
+	  else if (strprefix (p, p1, "mem"))
+	    {
+	      ULONGEST mem_addr;
+	      cached_mem_t mem;
+	      const char *end;
+
+	      /* Make sure the stub doesn't forget to indicate support
+		 with qSupported.  */
+	      if (packet_support (PACKET_expedite_memory_feature)
+		  != PACKET_ENABLE)
+		error (_("Unexpected expedited memory"));
+
+	      p = unpack_varlen_hex (++p1, &mem_addr);
+	      if (*p != ',')
+		error (_("Malformed expedited memory in packet: %s"), buf);
+	      p++;
+	      end = strchrnul (p, ';');
+
+	      mem.addr = mem_addr;
+	      mem.len = (end - p) / 2;
+	      mem.data = (gdb_byte *) xmalloc (mem.len);
+	      if (hex2bin (p, mem.data, mem.len) != mem.len)
+		{
+		  xfree (mem.data);
+		  error (_("Malformed expedited memory in packet: %s"), buf);
+		}
+	      VEC_safe_push (cached_mem_t, event->memory, &mem);
+	      p = end;
+	    }
 	  else if (strprefix (p, p1, "library"))
 	    {
 	      event->ws.kind = TARGET_WAITKIND_LOADED;
@@ -7690,6 +7893,26 @@ remote_target::process_stop_reply (struct stop_reply *stop_reply,
       remote_thr->stop_reason = stop_reply->stop_reason;
       remote_thr->watch_data_address = stop_reply->watch_data_address;
       remote_thr->vcont_resumed = 0;
+
+      /* Expedited memory.  It is only current if every thread is
+	 stopped, and can only be cached if the thread shares the
+	 current address space.  */
+      inferior *inf = find_inferior_ptid (ptid);
+
+      if (stop_reply->memory != NULL
+	  && !target_is_non_stop_p ()
+	  && inf != NULL
+	  && inf->aspace == current_program_space->aspace)
+	{
+	  cached_mem_t *mem;
+	  int ix;
+
+	  for (ix = 0;
+	       VEC_iterate (cached_mem_t, stop_reply->memory, ix, mem);
+	       ix++)
+	    target_dcache_prime (ptid, mem->addr, mem->data, mem->len);
+	}
+      stop_reply_free_memory (stop_reply);
     }
 
   stop_reply_xfree (stop_reply);
@@ -7770,7 +7993,12 @@ remote_target::wait_as (ptid_t ptid, target_waitstatus *status, int options)
 
   stop_reply = queued_stop_reply (ptid);
   if (stop_reply != NULL)
-    return process_stop_reply (stop_reply, status);
+    {
+      /* The memory sent with a queued event may have changed since;
+	 don't cache it.  */
+      stop_reply_free_memory (stop_reply);
+      return process_stop_reply (stop_reply, status);
+    }
 
   if (rs->cached_wait_status)
     /* Use the cached wait status, but only once.  */
@@ -8176,6 +8404,13 @@ remote_target::fetch_registers (struct regcache *regcache, int regnum)
 
       gdb_assert (reg != NULL);
 
+      /* A register the architecture fetches on demand is read on its
+	 own, so that displaying it does not pull in every other
+	 register.  */
+      if (gdbarch_fetch_register_on_demand (gdbarch, regnum)
+	  && fetch_register_using_p (regcache, reg))
+	return;
+
       /* If this register might be in the 'g' packet, try that first -
 	 we are likely to read more than one register.  If this is the
 	 first 'g' packet, we might be overly optimistic about its
@@ -8198,8 +8433,11 @@ remote_target::fetch_registers (struct regcache *regcache, int regnum)
 
   fetch_registers_using_g (regcache);
 
+  /* Registers fetched on demand that the 'g' packet did not carry are
+     left for the regcache to fetch if they are ever read.  */
   for (i = 0; i < gdbarch_num_regs (gdbarch); i++)
-    if (!rsa->regs[i].in_g_packet)
+    if (!rsa->regs[i].in_g_packet
+	&& !gdbarch_fetch_register_on_demand (gdbarch, i))
       if (!fetch_register_using_p (regcache, &rsa->regs[i]))
 	{
 	  /* This register is not available.  */
@@ -8494,64 +8732,31 @@ align_for_efficient_write (int todo, CORE_ADDR memaddr)
   return ((memaddr + todo) & ~(REMOTE_ALIGN_WRITES - 1)) - memaddr;
 }
 
-/* Write memory data directly to the remote machine.
-   This does not inform the data cache; the data cache uses this.
-   HEADER is the starting part of the packet.
-   MEMADDR is the address in the remote memory space.
-   MYADDR is the address of the buffer in our space.
-   LEN_UNITS is the number of addressable units to write.
-   UNIT_SIZE is the length in bytes of an addressable unit.
-   PACKET_FORMAT should be either 'X' or 'M', and indicates if we
-   should send data as binary ('X'), or hex-encoded ('M').
-
-   The function creates packet of the form
-       <HEADER><ADDRESS>,<LENGTH>:<DATA>
-
-   where encoding of <DATA> is terminated by PACKET_FORMAT.
-
-   If USE_LENGTH is 0, then the <LENGTH> field and the preceding comma
-   are omitted.
-
-   Return the transferred status, error or OK (an
-   'enum target_xfer_status' value).  Save the number of addressable units
-   transferred in *XFERED_LEN_UNITS.  Only transfer a single packet.
-
-   On a platform with an addressable memory size of 2 bytes (UNIT_SIZE == 2), an
-   exchange between gdb and the stub could look like (?? in place of the
-   checksum):
-
-   -> $m1000,4#??
-   <- aaaabbbbccccdddd
-
-   -> $M1000,3:eeeeffffeeee#??
-   <- OK
-
-   -> $m1000,4#??
-   <- eeeeffffeeeedddd  */
+/* Build into RS->BUF a single memory write packet in the format
+   described at remote_write_bytes_aux, holding as many of the
+   LEN_UNITS units at MYADDR as fit.  Save the number of units the
+   packet carries in *UNITS_WRITTEN and return the length of the
+   packet.  LEN_UNITS must be non-zero.  */
 
-target_xfer_status
-remote_target::remote_write_bytes_aux (const char *header, CORE_ADDR memaddr,
-				       const gdb_byte *myaddr,
-				       ULONGEST len_units,
-				       int unit_size,
-				       ULONGEST *xfered_len_units,
-				       char packet_format, int use_length)
+int
+remote_target::build_memory_write_packet (const char *header,
+					  CORE_ADDR memaddr,
+					  const gdb_byte *myaddr,
+					  ULONGEST len_units, int unit_size,
+					  int *units_written,
+					  char packet_format, int use_length)
 {
   struct remote_state *rs = get_remote_state ();
   char *p;
   char *plen = NULL;
   int plenlen = 0;
   int todo_units;
-  int units_written;
   int payload_capacity_bytes;
   int payload_length_bytes;
 
   if (packet_format != 'X' && packet_format != 'M')
     internal_error (__FILE__, __LINE__,
-		    _("remote_write_bytes_aux: bad packet format"));
-
-  if (len_units == 0)
-    return TARGET_XFER_EOF;
+		    _("build_memory_write_packet: bad packet format"));
 
   payload_capacity_bytes = get_memory_write_packet_size ();
 
@@ -8633,32 +8838,33 @@ remote_target::remote_write_bytes_aux (const char *header, CORE_ADDR memaddr,
 	 characters.  */
       payload_length_bytes =
 	  remote_escape_output (myaddr, todo_units, unit_size, (gdb_byte *) p,
-				&units_written, payload_capacity_bytes);
+				units_written, payload_capacity_bytes);
 
       /* If not all TODO units fit, then we'll need another packet.  Make
 	 a second try to keep the end of the packet aligned.  Don't do
 	 this if the packet is tiny.  */
-      if (units_written < todo_units && units_written > 2 * REMOTE_ALIGN_WRITES)
+      if (*units_written < todo_units
+	  && *units_written > 2 * REMOTE_ALIGN_WRITES)
 	{
 	  int new_todo_units;
 
-	  new_todo_units = align_for_efficient_write (units_written, memaddr);
+	  new_todo_units = align_for_efficient_write (*units_written, memaddr);
 
-	  if (new_todo_units != units_written)
+	  if (new_todo_units != *units_written)
 	    payload_length_bytes =
 		remote_escape_output (myaddr, new_todo_units, unit_size,
-				      (gdb_byte *) p, &units_written,
+				      (gdb_byte *) p, units_written,
 				      payload_capacity_bytes);
 	}
 
       p += payload_length_bytes;
-      if (use_length && units_written < todo_units)
+      if (use_length && *units_written < todo_units)
 	{
 	  /* Escape chars have filled up the buffer prematurely,
 	     and we have actually sent fewer units than planned.
 	     Fix-up the length field of the packet.  Use the same
 	     number of characters as before.  */
-	  plen += hexnumnstr (plen, (ULONGEST) units_written,
+	  plen += hexnumnstr (plen, (ULONGEST) *units_written,
 			      plenlen);
 	  *plen = ':';  /* overwrite \0 from hexnumnstr() */
 	}
@@ -8669,10 +8875,67 @@ remote_target::remote_write_bytes_aux (const char *header, CORE_ADDR memaddr,
 	 increasing byte addresses.  Each byte is encoded as a two hex
 	 value.  */
       p += 2 * bin2hex (myaddr, p, todo_units * unit_size);
-      units_written = todo_units;
+      *units_written = todo_units;
     }
 
-  putpkt_binary (rs->buf.data (), (int) (p - rs->buf.data ()));
+  return p - rs->buf.data ();
+}
+
+/* Write memory data directly to the remote machine.
+   This does not inform the data cache; the data cache uses this.
+   HEADER is the starting part of the packet.
+   MEMADDR is the address in the remote memory space.
+   MYADDR is the address of the buffer in our space.
+   LEN_UNITS is the number of addressable units to write.
+   UNIT_SIZE is the length in bytes of an addressable unit.
+   PACKET_FORMAT should be either 'X' or 'M', and indicates if we
+   should send data as binary ('X'), or hex-encoded ('M').
+
+   The function creates packet of the form
+       <HEADER><ADDRESS>,<LENGTH>:<DATA>
+
+   where encoding of <DATA> is terminated by PACKET_FORMAT.
+
+   If USE_LENGTH is 0, then the <LENGTH> field and the preceding comma
+   are omitted.
+
+   Return the transferred status, error or OK (an
+   'enum target_xfer_status' value).  Save the number of addressable units
+   transferred in *XFERED_LEN_UNITS.  Only transfer a single packet.
+
+   On a platform with an addressable memory size of 2 bytes (UNIT_SIZE == 2), an
+   exchange between gdb and the stub could look like (?? in place of the
+   checksum):
+
+   -> $m1000,4#??
+   <- aaaabbbbccccdddd
+
+   -> $M1000,3:eeeeffffeeee#??
+   <- OK
+
+   -> $m1000,4#??
+   <- eeeeffffeeeedddd  */
+
+target_xfer_status
+remote_target::remote_write_bytes_aux (const char *header, CORE_ADDR memaddr,
+				       const gdb_byte *myaddr,
+				       ULONGEST len_units,
+				       int unit_size,
+				       ULONGEST *xfered_len_units,
+				       char packet_format, int use_length)
+{
+  struct remote_state *rs = get_remote_state ();
+  int units_written;
+  int len;
+
+  if (len_units == 0)
+    return TARGET_XFER_EOF;
+
+  len = build_memory_write_packet (header, memaddr, myaddr, len_units,
+				   unit_size, &units_written,
+				   packet_format, use_length);
+
+  putpkt_binary (rs->buf.data (), len);
   getpkt (&rs->buf, 0);
 
   if (rs->buf[0] == 'E')
@@ -8692,7 +8955,9 @@ remote_target::remote_write_bytes_aux (const char *header, CORE_ADDR memaddr,
 
    Return the transferred status, error or OK (an
    'enum target_xfer_status' value).  Save the number of bytes
-   transferred in *XFERED_LEN.  Only transfer a single packet.  */
+   transferred in *XFERED_LEN.  Only transfer a single packet, or a
+   bounded run of pipelined packets if the connection allows it (see
+   get_memory_write_window).  */
 
 target_xfer_status
 remote_target::remote_write_bytes (CORE_ADDR memaddr, const gdb_byte *myaddr,
@@ -8719,11 +8984,123 @@ remote_target::remote_write_bytes (CORE_ADDR memaddr, const gdb_byte *myaddr,
       internal_error (__FILE__, __LINE__, _("bad switch"));
     }
 
+  int window = get_memory_write_window ();
+  if (window > 1)
+    return remote_write_bytes_windowed (memaddr, myaddr, len, unit_size,
+					window, xfered_len);
+
   return remote_write_bytes_aux (packet_format,
 				 memaddr, myaddr, len, unit_size, xfered_len,
 				 packet_format[0], 1);
 }
 
+/* Return the number of memory write packets that may be in flight at
+   once on the current connection.  Pipelining is only possible in
+   no-ack mode, since otherwise putpkt would discard the replies to
+   earlier packets while waiting for the '+' of a later one, and only
+   with the 'X' packet, which is the one stubs advertise a window
+   for.  */
+
+int
+remote_target::get_memory_write_window ()
+{
+  struct remote_state *rs = get_remote_state ();
+  int window = rs->memory_write_window;
+
+  if (!rs->noack_mode || packet_support (PACKET_X) != PACKET_ENABLE)
+    return 1;
+
+  if (memory_write_window_limit >= 0)
+    window = std::min (window, memory_write_window_limit);
+  return std::max (window, 1);
+}
+
+/* Like remote_write_bytes_aux with an 'X' packet, but send up to
+   WINDOW packets before waiting for the reply to the first of them,
+   so that the link stays busy while the stub is writing.  At most a
+   few windows' worth of packets are sent per call, so that callers
+   still get to report progress and check for quit requests.
+
+   The replies arrive in the order the packets were sent.  Once one of
+   them reports an error, no more packets are sent; the replies to
+   those already in flight are drained and the units acknowledged
+   before the failing packet are reported as transferred.  */
+
+target_xfer_status
+remote_target::remote_write_bytes_windowed (CORE_ADDR memaddr,
+					    const gdb_byte *myaddr,
+					    ULONGEST len_units,
+					    int unit_size, int window,
+					    ULONGEST *xfered_len_units)
+{
+  struct remote_state *rs = get_remote_state ();
+  std::deque<int> in_flight;
+  ULONGEST sent_units = 0;
+  ULONGEST acked_units = 0;
+  int packets_left = window <= INT_MAX / 4 ? 4 * window : INT_MAX;
+  bool failed = false;
+
+  if (len_units == 0)
+    return TARGET_XFER_EOF;
+
+  auto start = std::chrono::steady_clock::now ();
+
+  while (true)
+    {
+      bool can_send = (!failed && sent_units < len_units
+		       && packets_left > 0);
+
+      if (can_send && in_flight.size () < (size_t) window)
+	{
+	  int units;
+	  int len;
+
+	  len = build_memory_write_packet ("X", memaddr + sent_units,
+					   myaddr + sent_units * unit_size,
+					   len_units - sent_units,
+					   unit_size, &units, 'X', 1);
+	  putpkt_binary (rs->buf.data (), len);
+	  in_flight.push_back (units);
+	  sent_units += units;
+	  packets_left--;
+	  continue;
+	}
+
+      if (in_flight.empty ())
+	break;
+
+      getpkt (&rs->buf, 0);
+      if (rs->buf[0] == 'E')
+	failed = true;
+      else if (!failed)
+	acked_units += in_flight.front ();
+      in_flight.pop_front ();
+    }
+
+  if (remote_debug)
+    {
+      auto elapsed = std::chrono::steady_clock::now () - start;
+      auto usecs
+	= std::chrono::duration_cast<std::chrono::microseconds> (elapsed);
+      ULONGEST bytes = acked_units * unit_size;
+
+      fprintf_unfiltered (gdb_stdlog,
+			  "Wrote %s bytes at %s with a window of %d "
+			  "in %s us (%s bytes/s)\n",
+			  pulongest (bytes), core_addr_to_string (memaddr),
+			  window, plongest (usecs.count ()),
+			  pulongest (usecs.count () > 0
+				     ? bytes * 1000000 / usecs.count ()
+				     : 0));
+    }
+
+  if (acked_units == 0)
+    return failed ? TARGET_XFER_E_IO : TARGET_XFER_EOF;
+
+  *xfered_len_units = acked_units;
+  return TARGET_XFER_OK;
+}
+
 /* Read memory data directly from the remote machine.
    This does not use the data cache; the data cache uses this.
    MEMADDR is the address in the remote memory space.
@@ -8731,6 +9108,10 @@ remote_target::remote_write_bytes (CORE_ADDR memaddr, const gdb_byte *myaddr,
    LEN_UNITS is the number of addressable memory units to read..
    UNIT_SIZE is the length in bytes of an addressable unit.
 
+   If the stub supports it, the binary 'x' packet is used, whose reply
+   carries one character per byte instead of the two of the hex 'm'
+   packet.
+
    Return the transferred status, error or OK (an
    'enum target_xfer_status' value).  Save the number of bytes
    transferred in *XFERED_LEN_UNITS.
@@ -8748,33 +9129,56 @@ remote_target::remote_read_bytes_1 (CORE_ADDR memaddr, gdb_byte *myaddr,
   char *p;
   int todo_units;
   int decoded_bytes;
+  int packet_len;
+  bool binary = packet_support (PACKET_x) == PACKET_ENABLE;
 
   buf_size_bytes = get_memory_read_packet_size ();
   /* The packet buffer will be large enough for the payload;
      get_memory_packet_size ensures this.  */
 
-  /* Number of units that will fit.  */
-  todo_units = std::min (len_units,
-			 (ULONGEST) (buf_size_bytes / unit_size) / 2);
+  /* Number of units that will fit.  A binary reply needs a single
+     character per byte, plus the leading 'b'; if escapes make it
+     longer than that, the stub returns fewer bytes.  */
+  if (binary)
+    todo_units = std::min (len_units,
+			   (ULONGEST) (buf_size_bytes - 1) / unit_size);
+  else
+    todo_units = std::min (len_units,
+			   (ULONGEST) (buf_size_bytes / unit_size) / 2);
 
-  /* Construct "m"<memaddr>","<len>".  */
+  /* Construct "m"<memaddr>","<len>" or "x"<memaddr>","<len>".  */
   memaddr = remote_address_masked (memaddr);
   p = rs->buf.data ();
-  *p++ = 'm';
+  *p++ = binary ? 'x' : 'm';
   p += hexnumstr (p, (ULONGEST) memaddr);
   *p++ = ',';
   p += hexnumstr (p, (ULONGEST) todo_units);
   *p = '\0';
   putpkt (rs->buf);
-  getpkt (&rs->buf, 0);
+  packet_len = getpkt_sane (&rs->buf, 0);
+  if (packet_len < 0)
+    return TARGET_XFER_E_IO;
   if (rs->buf[0] == 'E'
       && isxdigit (rs->buf[1]) && isxdigit (rs->buf[2])
       && rs->buf[3] == '\0')
     return TARGET_XFER_E_IO;
-  /* Reply describes memory byte by byte, each byte encoded as two hex
-     characters.  */
-  p = rs->buf.data ();
-  decoded_bytes = hex2bin (p, myaddr, todo_units * unit_size);
+  if (binary)
+    {
+      /* Reply is a 'b' followed by the memory contents, with the
+	 special characters escaped.  */
+      if (rs->buf[0] != 'b')
+	error (_("Unknown remote x reply: %s"), rs->buf.data ());
+      decoded_bytes = remote_unescape_input ((gdb_byte *) rs->buf.data () + 1,
+					     packet_len - 1, myaddr,
+					     todo_units * unit_size);
+    }
+  else
+    {
+      /* Reply describes memory byte by byte, each byte encoded as two
+	 hex characters.  */
+      p = rs->buf.data ();
+      decoded_bytes = hex2bin (p, myaddr, todo_units * unit_size);
+    }
   /* Return what we have.  Let higher layers handle partial reads.  */
   *xfered_len_units = (ULONGEST) (decoded_bytes / unit_size);
   return (*xfered_len_units != 0) ? TARGET_XFER_OK : TARGET_XFER_EOF;
@@ -9142,6 +9546,7 @@ remote_target::putpkt_binary (const char *buf, int cnt)
   int ch;
   int tcount = 0;
   char *p;
+  std::string compressed;
 
   /* Catch cases like trying to read memory or listing threads while
      we're waiting for a stop reply.  The remote server wouldn't be
@@ -9163,6 +9568,24 @@ remote_target::putpkt_binary (const char *buf, int cnt)
      stale cached response.  */
   rs->cached_wait_status = 0;
 
+  if (rs->deflater != nullptr)
+    {
+      if (remote_debug)
+	{
+	  std::string str
+	    = escape_buffer (buf, std::min (cnt, REMOTE_DEBUG_MAX_CHAR));
+
+	  fprintf_unfiltered (gdb_stdlog, "Compressing packet: %s\n",
+			      str.c_str ());
+	}
+
+      compressed = rs->deflater->compress (buf, cnt);
+      buf = compressed.data ();
+      cnt = compressed.size ();
+      data.resize (cnt + 6);
+      buf2 = data.data ();
+    }
+
   /* Copy the packet into buffer BUF2, encapsulating it
      and giving it a checksum.  */
 
@@ -9435,11 +9858,11 @@ remote_target::read_frame (gdb::char_vector *buf_p)
 	       don't have any way to indicate a packet retransmission
 	       is necessary.  */
 	    if (rs->noack_mode)
-	      return bc;
+	      return decompress_frame (buf_p, bc);
 
 	    pktcsum = (fromhex (check_0) << 4) | fromhex (check_1);
 	    if (csum == pktcsum)
-              return bc;
+	      return decompress_frame (buf_p, bc);
 
 	    if (remote_debug)
 	      {
@@ -9498,6 +9921,36 @@ remote_target::read_frame (gdb::char_vector *buf_p)
     }
 }
 
+/* If the connection is compressed, replace the LEN bytes of packet
+   payload read into *BUF_P by read_frame with what they decompress
+   to, and return the new length.  Otherwise just return LEN.  A
+   packet that can't be decompressed leaves the connection unusable,
+   so the target is disconnected.  */
+
+long
+remote_target::decompress_frame (gdb::char_vector *buf_p, long len)
+{
+  struct remote_state *rs = get_remote_state ();
+  std::string packet;
+
+  if (rs->inflater == nullptr)
+    return len;
+
+  if (!rs->inflater->decompress (buf_p->data (), len, &packet))
+    {
+      remote_unpush_target ();
+      throw_error (TARGET_CLOSE_ERROR,
+		   _("Remote communication error: bad compressed packet.  "
+		     "Target disconnected."));
+    }
+
+  if (packet.size () >= buf_p->size ())
+    buf_p->resize (packet.size () + 1);
+  memcpy (buf_p->data (), packet.data (), packet.size ());
+  (*buf_p)[packet.size ()] = '\0';
+  return packet.size ();
+}
+
 /* Read a packet from the remote machine, with error checking, and
    store it in *BUF.  Resize *BUF if necessary to hold the result.  If
    FOREVER, wait forever rather than timing out; this is used (in
@@ -10659,6 +11112,16 @@ remote_target::verify_memory (const gdb_byte *data, CORE_ADDR lma, ULONGEST size
   return simple_verify_memory (this, data, lma, size);
 }
 
+/* Implement the "can_verify_memory_cheaply" target method.  Until the
+   stub has answered a qCRC packet, it is assumed to support it.  */
+
+bool
+remote_target::can_verify_memory_cheaply ()
+{
+  return (target_has_execution
+	  && packet_support (PACKET_qCRC) != PACKET_DISABLE);
+}
+
 /* compare-sections command
 
    With no arguments, compares each loadable section in the exec bfd
@@ -14437,6 +14900,19 @@ Specify \"unlimited\" for unlimited hardware breakpoints."),
 			    NULL, show_hardware_breakpoint_limit,
 			    &remote_set_cmdlist, &remote_show_cmdlist);
 
+  add_setshow_zuinteger_unlimited_cmd ("memory-write-window", no_class,
+				       &memory_write_window_limit, _("\
+Set the maximum number of memory write packets in flight."), _("\
+Show the maximum number of memory write packets in flight."), _("\
+When loading large amounts of memory, GDB sends up to this many\n\
+memory write packets before waiting for the first reply, if the\n\
+connection is in no-ack mode and the target supports binary downloads.\n\
+The target may advertise a lower limit.  Specify \"unlimited\" to use\n\
+the target's limit.  A value of 0 or 1 disables pipelining."),
+				       NULL, show_memory_write_window,
+				       &remote_set_cmdlist,
+				       &remote_show_cmdlist);
+
   add_setshow_zuinteger_cmd ("remoteaddresssize", class_obscure,
 			     &remote_address_size, _("\
 Set the maximum size of the address (in bits) in a memory packet."), _("\
@@ -14703,6 +15179,16 @@ Show the maximum size of the address (in bits) in a memory packet."), NULL,
   add_packet_config_cmd (&remote_protocol_packets[PACKET_no_resumed],
 			 "N stop reply", "no-resumed-stop-reply", 0);
 
+  add_packet_config_cmd (&remote_protocol_packets[PACKET_x],
+			 "x", "binary-upload", 0);
+
+  add_packet_config_cmd
+    (&remote_protocol_packets[PACKET_expedite_memory_feature],
+     "expedite-memory-feature", "expedite-memory-feature", 0);
+
+  add_packet_config_cmd (&remote_protocol_packets[PACKET_QStartCompression],
+			 "QStartCompression", "compression", 0);
+
   /* Assert that we've registered "set remote foo-packet" commands
      for all packet configs.  */
   {
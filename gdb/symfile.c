@@ -1820,6 +1820,18 @@ load_command (const char *arg, int from_tty)
 
 static int validate_download = 0;
 
+/* When non-zero, "load" only writes the blocks of each section whose
+   contents differ from the target's, as determined by
+   target_verify_memory (the qCRC packet on remote targets).  */
+
+static int load_differential = 0;
+
+/* Size of the blocks compared by a differential load.  Blocks are
+   aligned to this size, so that they line up with flash sectors when
+   it is a multiple of the sector size.  */
+
+static unsigned int load_differential_block_size = 4096;
+
 /* Callback service function for generic_load (bfd_map_over_sections).  */
 
 static void
@@ -1837,6 +1849,8 @@ struct load_progress_data
   unsigned long write_count = 0;
   unsigned long data_count = 0;
   bfd_size_type total_size = 0;
+  /* Bytes a differential load found unchanged on the target.  */
+  unsigned long skipped_count = 0;
 };
 
 /* Opaque data for load_progress for a single section.  */
@@ -1944,6 +1958,74 @@ load_progress (ULONGEST bytes, void *untyped_arg)
 				   totals->total_size);
 }
 
+/* Queue a request to write the LEN bytes at DATA, part of section
+   SECT_NAME, to ADDR.  */
+
+static void
+load_queue_request (struct load_section_data *args, const char *sect_name,
+		    ULONGEST addr, const gdb_byte *data, ULONGEST len)
+{
+  gdb_byte *buffer = (gdb_byte *) xmalloc (len);
+
+  memcpy (buffer, data, len);
+
+  load_progress_section_data *section_data
+    = new load_progress_section_data (args->progress_data, sect_name, len,
+				      addr, buffer);
+
+  args->requests.emplace_back (addr, addr + len, buffer, section_data);
+}
+
+/* Queue requests for the parts of section SECT_NAME, whose SIZE bytes
+   of CONTENTS load at BEGIN, that differ from the target's memory.
+   Runs of differing blocks are merged into a single request.  */
+
+static void
+load_differential_section (struct load_section_data *args,
+			   const char *sect_name, ULONGEST begin,
+			   const gdb_byte *contents, ULONGEST size)
+{
+  ULONGEST block = load_differential_block_size;
+  ULONGEST end = begin + size;
+  ULONGEST addr, run_start = 0;
+  bool in_run = false;
+
+  /* Reloading an unchanged image is the common case; check the whole
+     section at once first.  */
+  if (target_verify_memory (contents, begin, size) == 1)
+    {
+      args->progress_data->skipped_count += size;
+      return;
+    }
+
+  for (addr = begin; addr < end; )
+    {
+      ULONGEST next = std::min (end, (addr / block + 1) * block);
+
+      if (target_verify_memory (contents + (addr - begin), addr,
+				next - addr) == 1)
+	{
+	  if (in_run)
+	    load_queue_request (args, sect_name, run_start,
+				contents + (run_start - begin),
+				addr - run_start);
+	  in_run = false;
+	  args->progress_data->skipped_count += next - addr;
+	}
+      else if (!in_run)
+	{
+	  run_start = addr;
+	  in_run = true;
+	}
+
+      addr = next;
+    }
+
+  if (in_run)
+    load_queue_request (args, sect_name, run_start,
+			contents + (run_start - begin), end - run_start);
+}
+
 /* Callback service function for generic_load (bfd_map_over_sections).  */
 
 static void
@@ -1964,6 +2046,13 @@ load_section_callback (bfd *abfd, asection *asec, void *data)
   gdb_byte *buffer = (gdb_byte *) xmalloc (size);
   bfd_get_section_contents (abfd, asec, buffer, 0, size);
 
+  if (load_differential)
+    {
+      load_differential_section (args, sect_name, begin, buffer, size);
+      xfree (buffer);
+      return;
+    }
+
   load_progress_section_data *section_data
     = new load_progress_section_data (args->progress_data, sect_name, size,
 				      begin, buffer);
@@ -2025,7 +2114,11 @@ generic_load (const char *args, int from_tty)
 
   steady_clock::time_point start_time = steady_clock::now ();
 
-  if (target_write_memory_blocks (cbdata.requests, flash_discard,
+  /* A differential load may leave parts of a flash sector unwritten;
+     keep their contents when the sector is erased.  */
+  if (target_write_memory_blocks (cbdata.requests,
+				  load_differential
+				  ? flash_preserve : flash_discard,
 				  load_progress) != 0)
     error (_("Load failed"));
 
@@ -2038,6 +2131,14 @@ generic_load (const char *args, int from_tty)
   uiout->text (", load size ");
   uiout->field_fmt ("load-size", "%lu", total_progress.data_count);
   uiout->text ("\n");
+  if (load_differential)
+    {
+      uiout->text ("Differential load: ");
+      uiout->field_fmt ("skipped-size", "%lu", total_progress.skipped_count);
+      uiout->text (" bytes unchanged, ");
+      uiout->field_fmt ("written-size", "%lu", total_progress.data_count);
+      uiout->text (" bytes written\n");
+    }
   regcache_write_pc (get_current_regcache (), entry);
 
   /* Reset breakpoints, now that we have changed the load image.  For
@@ -3993,6 +4094,24 @@ full  == print messages for the executable,\n\
 			NULL,
 			&setprintlist, &showprintlist);
 
+  add_setshow_boolean_cmd ("load-differential", class_support,
+			   &load_differential, _("\
+Set whether \"load\" skips blocks that the target already holds."), _("\
+Show whether \"load\" skips blocks that the target already holds."), _("\
+When on, each loadable section is split into blocks whose checksums are\n\
+compared with the target's memory, and only the blocks that differ are\n\
+written.  Remote targets compare checksums with the qCRC packet."),
+			   NULL, NULL, &setlist, &showlist);
+
+  add_setshow_uinteger_cmd ("load-differential-block-size", class_support,
+			    &load_differential_block_size, _("\
+Set the size of the blocks compared by a differential load."), _("\
+Show the size of the blocks compared by a differential load."), _("\
+Blocks are aligned to their size.  Use a multiple of the flash sector\n\
+size to avoid rewriting unchanged data when loading into flash.\n\
+\"unlimited\" compares whole sections."),
+			    NULL, NULL, &setlist, &showlist);
+
   add_setshow_boolean_cmd ("separate-debug-file", no_class,
 			   &separate_debug_file_debug, _("\
 Set printing of separate debug info file search debug."), _("\
@@ -59,6 +59,60 @@ target_dcache_invalidate (void)
     dcache_invalidate (dcache);
 }
 
+/* Discard the target dcache, dirty lines included, as when the
+   process whose memory they hold is gone.  */
+
+void
+target_dcache_discard (void)
+{
+  DCACHE *dcache
+    = (DCACHE *) address_space_data (current_program_space->aspace,
+				     target_dcache_aspace_key);
+
+  if (dcache != NULL)
+    dcache_discard (dcache);
+}
+
+/* Write the dirty lines of the target dcache back to the target.  */
+
+void
+target_dcache_flush (void)
+{
+  DCACHE *dcache
+    = (DCACHE *) address_space_data (current_program_space->aspace,
+				     target_dcache_aspace_key);
+
+  if (dcache != NULL)
+    dcache_flush (dcache);
+}
+
+/* Write the dirty lines of the target dcache overlapping the LEN bytes
+   at MEMADDR back to the target.  */
+
+void
+target_dcache_flush_range (CORE_ADDR memaddr, ULONGEST len)
+{
+  DCACHE *dcache
+    = (DCACHE *) address_space_data (current_program_space->aspace,
+				     target_dcache_aspace_key);
+
+  if (dcache != NULL)
+    dcache_flush_range (dcache, memaddr, len);
+}
+
+/* Add the LEN bytes at DATA, the contents of memory at MEMADDR as
+   seen by PTID, to the target dcache, if it is used at all.  */
+
+void
+target_dcache_prime (ptid_t ptid, CORE_ADDR memaddr, const gdb_byte *data,
+		     ULONGEST len)
+{
+  if (!stack_cache_enabled_p () && !code_cache_enabled_p ())
+    return;
+
+  dcache_prime (target_dcache_get_or_init (), ptid, memaddr, data, len);
+}
+
 /* Return the target dcache.  Return NULL if target dcache is not
    initialized yet.  */
 
@@ -22,6 +22,15 @@
 
 extern void target_dcache_invalidate (void);
 
+extern void target_dcache_discard (void);
+
+extern void target_dcache_flush (void);
+
+extern void target_dcache_flush_range (CORE_ADDR memaddr, ULONGEST len);
+
+extern void target_dcache_prime (ptid_t ptid, CORE_ADDR memaddr,
+				 const gdb_byte *data, ULONGEST len);
+
 extern DCACHE *target_dcache_get (void);
 
 extern DCACHE *target_dcache_get_or_init (void);
@@ -134,6 +134,7 @@ struct dummy_target : public target_ops
   bool set_trace_notes (const char *arg0, const char *arg1, const char *arg2) override;
   int core_of_thread (ptid_t arg0) override;
   int verify_memory (const gdb_byte *arg0, CORE_ADDR arg1, ULONGEST arg2) override;
+  bool can_verify_memory_cheaply () override;
   bool get_tib_address (ptid_t arg0, CORE_ADDR *arg1) override;
   void set_permissions () override;
   bool static_tracepoint_marker_at (CORE_ADDR arg0, static_tracepoint_marker *arg1) override;
@@ -301,6 +302,7 @@ struct debug_target : public target_ops
   bool set_trace_notes (const char *arg0, const char *arg1, const char *arg2) override;
   int core_of_thread (ptid_t arg0) override;
   int verify_memory (const gdb_byte *arg0, CORE_ADDR arg1, ULONGEST arg2) override;
+  bool can_verify_memory_cheaply () override;
   bool get_tib_address (ptid_t arg0, CORE_ADDR *arg1) override;
   void set_permissions () override;
   bool static_tracepoint_marker_at (CORE_ADDR arg0, static_tracepoint_marker *arg1) override;
@@ -3467,6 +3469,31 @@ debug_target::verify_memory (const gdb_byte *arg0, CORE_ADDR arg1, ULONGEST arg2
   return result;
 }
 
+bool
+target_ops::can_verify_memory_cheaply ()
+{
+  return this->beneath ()->can_verify_memory_cheaply ();
+}
+
+bool
+dummy_target::can_verify_memory_cheaply ()
+{
+  return false;
+}
+
+bool
+debug_target::can_verify_memory_cheaply ()
+{
+  bool result;
+  fprintf_unfiltered (gdb_stdlog, "-> %s->can_verify_memory_cheaply (...)\n", this->beneath ()->shortname ());
+  result = this->beneath ()->can_verify_memory_cheaply ();
+  fprintf_unfiltered (gdb_stdlog, "<- %s->can_verify_memory_cheaply (", this->beneath ()->shortname ());
+  fputs_unfiltered (") = ", gdb_stdlog);
+  target_debug_print_bool (result);
+  fputs_unfiltered ("\n", gdb_stdlog);
+  return result;
+}
+
 bool
 target_ops::get_tib_address (ptid_t arg0, CORE_ADDR *arg1)
 {
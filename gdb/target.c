@@ -37,6 +37,8 @@
 #include "gdbthread.h"
 #include "solib.h"
 #include "exec.h"
+#include "gdb_bfd.h"
+#include "observable.h"
 #include "inline-frame.h"
 #include "tracepoint.h"
 #include "gdb/fileio.h"
@@ -82,6 +84,11 @@ static int default_verify_memory (struct target_ops *self,
 				  const gdb_byte *data,
 				  CORE_ADDR memaddr, ULONGEST size);
 
+static void readonly_section_checks_clear ();
+
+static void readonly_section_checks_invalidate (CORE_ADDR memaddr,
+						ULONGEST len);
+
 static void tcomplain (void) ATTRIBUTE_NORETURN;
 
 static struct target_ops *find_default_run_target (const char *);
@@ -131,10 +138,11 @@ current_top_target ()
 
 static struct cmd_list_element *targetlist = NULL;
 
-/* Nonzero if we should trust readonly sections from the
-   executable when reading memory.  */
+/* Whether we should trust readonly sections from the executable when
+   reading memory.  AUTO_BOOLEAN_AUTO trusts the parts of them that were
+   found to match the target's memory.  */
 
-static int trust_readonly = 0;
+static enum auto_boolean trust_readonly = AUTO_BOOLEAN_FALSE;
 
 /* Nonzero if we should show true memory content including
    memory breakpoint inserted by gdb.  */
@@ -312,6 +320,8 @@ add_deprecated_target_alias (const target_info &tinfo, const char *alias)
 void
 target_kill (void)
 {
+  /* Writes left in the dcache die with the process.  */
+  target_dcache_discard ();
   current_top_target ()->kill ();
 }
 
@@ -320,6 +330,10 @@ target_load (const char *arg, int from_tty)
 {
   target_dcache_invalidate ();
   current_top_target ()->load (arg, from_tty);
+
+  /* The target may not have loaded the program through
+     target_xfer_partial.  */
+  readonly_section_checks_clear ();
 }
 
 /* Define it.  */
@@ -990,6 +1004,212 @@ raw_memory_xfer_partial (struct target_ops *ops, gdb_byte *readbuf,
   return res;
 }
 
+/* The size of the blocks in which "set trust-readonly-sections auto"
+   checks read-only sections against the target's memory.  */
+#define READONLY_CHECK_BLOCK_SIZE 4096
+
+/* Whether a block of a read-only section is known to match the
+   target's memory.  */
+
+enum readonly_block_state
+{
+  READONLY_BLOCK_UNKNOWN,
+  READONLY_BLOCK_MATCHES,
+  READONLY_BLOCK_DIFFERS
+};
+
+/* What "set trust-readonly-sections auto" knows about one read-only
+   section.  */
+
+struct readonly_section_check
+{
+  /* The program space and section this is about, and the address of
+     the section in that program space.  */
+  struct program_space *pspace;
+  asection *the_bfd_section;
+  CORE_ADDR addr;
+
+  /* Whether the section as a whole has been checked yet.  */
+  bool whole_checked;
+
+  /* The state of each READONLY_CHECK_BLOCK_SIZE block.  */
+  std::vector<readonly_block_state> blocks;
+};
+
+static std::vector<readonly_section_check> readonly_section_checks;
+
+/* Non-zero while a read-only section is being checked, so that a
+   target that checks by reading memory really reads it.  */
+static int readonly_section_checking;
+
+/* Forget everything known about read-only sections.  Called when the
+   target or the executable changes.  */
+
+static void
+readonly_section_checks_clear ()
+{
+  readonly_section_checks.clear ();
+}
+
+/* Forget that the target's memory in [MEMADDR, MEMADDR + LEN) matches
+   the read-only sections there, because it is being written.  The
+   blocks are checked again the next time they are read.  */
+
+static void
+readonly_section_checks_invalidate (CORE_ADDR memaddr, ULONGEST len)
+{
+  for (readonly_section_check &check : readonly_section_checks)
+    {
+      CORE_ADDR end = (check.addr
+		       + check.blocks.size () * READONLY_CHECK_BLOCK_SIZE);
+      size_t first, last;
+
+      if (memaddr >= end || memaddr + len <= check.addr)
+	continue;
+
+      first = (memaddr > check.addr
+	       ? (memaddr - check.addr) / READONLY_CHECK_BLOCK_SIZE : 0);
+      last = std::min ((memaddr + len - 1 - check.addr)
+		       / READONLY_CHECK_BLOCK_SIZE,
+		       (ULONGEST) check.blocks.size () - 1);
+      for (size_t i = first; i <= last; i++)
+	check.blocks[i] = READONLY_BLOCK_UNKNOWN;
+    }
+}
+
+/* Observer for free_objfile: forget the sections of OBJFILE.  */
+
+static void
+readonly_section_checks_free_objfile (struct objfile *objfile)
+{
+  readonly_section_checks.erase
+    (std::remove_if (readonly_section_checks.begin (),
+		     readonly_section_checks.end (),
+		     [=] (const readonly_section_check &check)
+		     {
+		       return check.the_bfd_section->owner == objfile->obfd;
+		     }),
+     readonly_section_checks.end ());
+}
+
+/* Compare the SIZE bytes of section contents at DATA with the target's
+   memory at MEMADDR.  Return 1 if they match, 0 if they differ or
+   can't be compared.  */
+
+static int
+readonly_section_verify (const gdb_byte *data, CORE_ADDR memaddr,
+			 ULONGEST size)
+{
+  scoped_restore restore_checking
+    = make_scoped_restore (&readonly_section_checking, 1);
+  int res;
+
+  TRY
+    {
+      /* The target must see what was written to the dcache.  */
+      target_dcache_flush_range (memaddr, size);
+      res = target_verify_memory (data, memaddr, size) > 0;
+    }
+  CATCH (ex, RETURN_MASK_ERROR)
+    {
+      res = 0;
+    }
+  END_CATCH
+
+  return res;
+}
+
+/* Read from the read-only section SECP for "set trust-readonly-sections
+   auto".  If the target's memory at MEMADDR is known, or can now be
+   shown, to match the section's contents, copy up to LEN bytes of the
+   contents, mapped from the executable file, to READBUF, set
+   *XFERED_LEN and return 1.  Otherwise return 0 and leave the read to
+   the target.
+
+   Checking only pays off if the target can compare memory without
+   reading it back, as a remote target does with the qCRC packet; if
+   not, every read is left to the target.  The block read is checked
+   first, then, if the target still compares cheaply, the section as
+   a whole, which for a remote target costs a single qCRC packet.  A
+   stub that turns out not to support qCRC thus costs at most one
+   block read.  Blocks written since, or in a section that failed the
+   whole check, are checked again as they are read.  */
+
+static int
+readonly_section_read (struct target_section *secp, gdb_byte *readbuf,
+		       ULONGEST memaddr, ULONGEST len, ULONGEST *xfered_len)
+{
+  asection *asect = secp->the_bfd_section;
+  const gdb_byte *contents;
+  bfd_size_type size;
+  readonly_section_check *check = NULL;
+
+  /* Only a live target can be checked; and sections with relocations
+     don't hold the final contents.  */
+  if (readonly_section_checking
+      || !target_has_execution
+      || !target_can_verify_memory_cheaply ()
+      || (bfd_get_section_flags (asect->owner, asect)
+	  & (SEC_HAS_CONTENTS | SEC_RELOC)) != SEC_HAS_CONTENTS)
+    return 0;
+
+  contents = gdb_bfd_map_section (asect, &size);
+  if (contents == NULL || size != secp->endaddr - secp->addr)
+    return 0;
+
+  for (readonly_section_check &c : readonly_section_checks)
+    if (c.pspace == current_program_space
+	&& c.the_bfd_section == asect
+	&& c.addr == secp->addr)
+      {
+	check = &c;
+	break;
+      }
+
+  if (check == NULL)
+    {
+      readonly_section_checks.emplace_back ();
+      check = &readonly_section_checks.back ();
+      check->pspace = current_program_space;
+      check->the_bfd_section = asect;
+      check->addr = secp->addr;
+      check->whole_checked = false;
+      check->blocks.assign ((size + READONLY_CHECK_BLOCK_SIZE - 1)
+			    / READONLY_CHECK_BLOCK_SIZE,
+			    READONLY_BLOCK_UNKNOWN);
+    }
+
+  ULONGEST offset = memaddr - check->addr;
+  size_t block = offset / READONLY_CHECK_BLOCK_SIZE;
+  ULONGEST block_start = block * READONLY_CHECK_BLOCK_SIZE;
+  ULONGEST block_end = std::min (block_start + READONLY_CHECK_BLOCK_SIZE,
+				 (ULONGEST) size);
+
+  if (check->blocks[block] == READONLY_BLOCK_UNKNOWN)
+    check->blocks[block]
+      = (readonly_section_verify (contents + block_start,
+				  check->addr + block_start,
+				  block_end - block_start)
+	 ? READONLY_BLOCK_MATCHES : READONLY_BLOCK_DIFFERS);
+
+  if (!check->whole_checked && target_can_verify_memory_cheaply ())
+    {
+      check->whole_checked = true;
+      if (check->blocks.size () > 1
+	  && check->blocks[block] == READONLY_BLOCK_MATCHES
+	  && readonly_section_verify (contents, check->addr, size))
+	std::fill (check->blocks.begin (), check->blocks.end (),
+		   READONLY_BLOCK_MATCHES);
+    }
+
+  if (check->blocks[block] != READONLY_BLOCK_MATCHES)
+    return 0;
+
+  *xfered_len = std::min (len, block_end - offset);
+  memcpy (readbuf, contents + offset, *xfered_len);
+  return 1;
+}
+
 /* Perform a partial memory transfer.
    For docs see target.h, to_xfer_partial.  */
 
@@ -1024,8 +1244,9 @@ memory_xfer_partial_1 (struct target_ops *ops, enum target_object object,
 	}
     }
 
-  /* Try the executable files, if "trust-readonly-sections" is set.  */
-  if (readbuf != NULL && trust_readonly)
+  /* Try the executable files, if "trust-readonly-sections" is set, or
+     is "auto" and the target's memory matches them.  */
+  if (readbuf != NULL && trust_readonly != AUTO_BOOLEAN_FALSE)
     {
       struct target_section *secp;
       struct target_section_table *table;
@@ -1036,12 +1257,22 @@ memory_xfer_partial_1 (struct target_ops *ops, enum target_object object,
 				     secp->the_bfd_section)
 	      & SEC_READONLY))
 	{
-	  table = target_get_section_table (ops);
-	  return section_table_xfer_memory_partial (readbuf, writebuf,
-						    memaddr, len, xfered_len,
-						    table->sections,
-						    table->sections_end,
-						    NULL);
+	  if (trust_readonly == AUTO_BOOLEAN_AUTO)
+	    {
+	      if (readonly_section_read (secp, readbuf, memaddr, len,
+					 xfered_len))
+		return TARGET_XFER_OK;
+	    }
+	  else
+	    {
+	      table = target_get_section_table (ops);
+	      return section_table_xfer_memory_partial (readbuf, writebuf,
+							memaddr, len,
+							xfered_len,
+							table->sections,
+							table->sections_end,
+							NULL);
+	    }
 	}
     }
 
@@ -1072,6 +1303,29 @@ memory_xfer_partial_1 (struct target_ops *ops, enum target_object object,
 					 reg_len, xfered_len);
     }
 
+  /* In write-back mode, writes to memory the dcache holds only go to
+     the cache.  Memory regions marked cacheable are read into the cache
+     for the purpose; for the stack and code caches, only lines already
+     present are written this way.  */
+  if (inf != NULL
+      && writebuf != NULL
+      && get_traceframe_number () == -1
+      && !region->attrib.verify
+      && (region->attrib.cache
+	  || ((stack_cache_enabled_p () || code_cache_enabled_p ())
+	      && target_dcache_init_p ())))
+    {
+      DCACHE *dcache = target_dcache_get_or_init ();
+
+      if (dcache_write_memory_partial (dcache, memaddr, writebuf, reg_len,
+				       region->attrib.cache, xfered_len))
+	return TARGET_XFER_OK;
+    }
+
+  /* Reads that bypass the dcache must see what was written to it.  */
+  if (readbuf != NULL)
+    target_dcache_flush_range (memaddr, reg_len);
+
   /* If none of those methods found the memory we wanted, fall back
      to a target partial transfer.  Normally a single call to
      to_xfer_partial is enough; if it doesn't recognize an object
@@ -1163,6 +1417,16 @@ target_xfer_partial (struct target_ops *ops,
 
   *xfered_len = 0;
 
+  /* Memory that is written may no longer match the executable
+     file.  */
+  if (writebuf != NULL
+      && (object == TARGET_OBJECT_MEMORY
+	  || object == TARGET_OBJECT_STACK_MEMORY
+	  || object == TARGET_OBJECT_CODE_MEMORY
+	  || object == TARGET_OBJECT_RAW_MEMORY
+	  || object == TARGET_OBJECT_FLASH))
+    readonly_section_checks_invalidate (offset, len);
+
   /* If this is a memory transfer, let the memory-specific code
      have a look at it instead.  Memory transfers are more
      complicated.  */
@@ -1182,6 +1446,12 @@ target_xfer_partial (struct target_ops *ops,
 				     NULL))
 	return TARGET_XFER_E_IO;
 
+      /* Reads of raw memory must see what was written to the dcache
+	 in write-back mode.  The dcache's own line fills only read
+	 lines it doesn't hold, so they never write anything back.  */
+      if (readbuf != NULL)
+	target_dcache_flush_range (offset, len);
+
       /* Request the normal memory object from other layers.  */
       retval = raw_memory_xfer_partial (ops, readbuf, writebuf, offset, len,
 					xfered_len);
@@ -1387,6 +1657,7 @@ target_memory_map (void)
 void
 target_flash_erase (ULONGEST address, LONGEST length)
 {
+  readonly_section_checks_invalidate (address, length);
   current_top_target ()->flash_erase (address, length);
 }
 
@@ -1941,6 +2212,13 @@ target_pre_inferior (int from_tty)
   current_inferior ()->highest_thread_num = 0;
 
   agent_capability_invalidate ();
+
+  /* Nothing cached for a previous process may reach the new one.  */
+  target_dcache_discard ();
+
+  /* The new target's memory has not been checked against the
+     executable yet.  */
+  readonly_section_checks_clear ();
 }
 
 /* Callback for iterate_over_inferiors.  Gets rid of the given
@@ -2018,6 +2296,9 @@ target_detach (inferior *inf, int from_tty)
        breakpoints before detaching.  */
     remove_breakpoints_inf (current_inferior ());
 
+  /* Don't leave writes behind in the dcache.  */
+  target_dcache_flush ();
+
   prepare_for_detach ();
 
   current_top_target ()->detach (inf, from_tty);
@@ -2031,6 +2312,9 @@ target_disconnect (const char *args, int from_tty)
      disconnecting.  */
   remove_breakpoints ();
 
+  /* Don't leave writes behind in the dcache.  */
+  target_dcache_flush ();
+
   current_top_target ()->disconnect (args, from_tty);
 }
 
@@ -2077,6 +2361,10 @@ target_thread_handle_to_thread_info (const gdb_byte *thread_handle,
 void
 target_resume (ptid_t ptid, int step, enum gdb_signal signal)
 {
+  /* Write back the dcache's dirty lines before letting the inferior
+     run; an error here stops the resumption rather than losing the
+     writes.  */
+  target_dcache_flush ();
   target_dcache_invalidate ();
 
   current_top_target ()->resume (ptid, step, signal);
@@ -2160,6 +2448,9 @@ void
 target_mourn_inferior (ptid_t ptid)
 {
   gdb_assert (ptid == inferior_ptid);
+
+  /* Writes left in the dcache die with the process.  */
+  target_dcache_discard ();
   current_top_target ()->mourn_inferior ();
 
   /* We no longer need to keep handles on any of the object files.
@@ -3975,16 +4266,24 @@ verbose."),
 			     show_targetdebug,
 			     &setdebuglist, &showdebuglist);
 
-  add_setshow_boolean_cmd ("trust-readonly-sections", class_support,
-			   &trust_readonly, _("\
+  add_setshow_auto_boolean_cmd ("trust-readonly-sections", class_support,
+				&trust_readonly, _("\
 Set mode for reading from readonly sections."), _("\
 Show mode for reading from readonly sections."), _("\
 When this mode is on, memory reads from readonly sections (such as .text)\n\
 will be read from the object file instead of from the target.  This will\n\
-result in significant performance improvement for remote targets."),
-			   NULL,
-			   show_trust_readonly,
-			   &setlist, &showlist);
+result in significant performance improvement for remote targets.\n\
+When auto, each readonly section is first checked against the target's\n\
+memory, using the qCRC packet on remote targets, and only the parts that\n\
+match are read from the object file.  They are checked again after they\n\
+are written to, and after \"load\".  Targets that can only check memory\n\
+by reading it, such as remote stubs without qCRC, are always read from."),
+				NULL,
+				show_trust_readonly,
+				&setlist, &showlist);
+
+  gdb::observers::free_objfile.attach (readonly_section_checks_free_objfile);
+  gdb::observers::executable_changed.attach (readonly_section_checks_clear);
 
   add_com ("monitor", class_obscure, do_monitor_command,
 	   _("Send a command to the remote monitor (remote targets only)."));
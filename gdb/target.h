@@ -1070,6 +1070,11 @@ struct target_ops
 			       CORE_ADDR memaddr, ULONGEST size)
       TARGET_DEFAULT_FUNC (default_verify_memory);
 
+    /* Return true if verify_memory can compare memory without reading
+       it all back, as a remote target does with the qCRC packet.  */
+    virtual bool can_verify_memory_cheaply ()
+      TARGET_DEFAULT_RETURN (false);
+
     /* Return the address of the start of the Thread Information Block
        a Windows OS specific feature.  */
     virtual bool get_tib_address (ptid_t ptid, CORE_ADDR *addr)
@@ -2296,6 +2301,10 @@ extern int simple_verify_memory (struct target_ops* ops,
 int target_verify_memory (const gdb_byte *data,
 			  CORE_ADDR memaddr, ULONGEST size);
 
+/* See can_verify_memory_cheaply in struct target_ops.  */
+#define target_can_verify_memory_cheaply() \
+  (current_top_target ()->can_verify_memory_cheaply ())
+
 /* Routines for maintenance of the target structures...
 
    add_target:   Add a target to the list of all possible targets.
@@ -0,0 +1,84 @@
+# Copyright (C) 2019 Free Software Foundation, Inc.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+import re
+import subprocess
+import time
+
+from perftest import perftest
+from perftest import measure
+from perftest import testresult
+
+class MeasurementInsnRate(measure.Measurement):
+    """Measurement on the number of instructions disassembled per second.
+
+    The number of instructions is read from the test case once the
+    measured function has returned."""
+
+    def __init__(self, test, result):
+        super (MeasurementInsnRate, self).__init__ ("insns_per_sec", result)
+        self.test = test
+        self.start_time = 0
+
+    def start(self, id):
+        self.start_time = time.time()
+
+    def stop(self, id):
+        elapsed = time.time() - self.start_time
+        self.result.record (id, self.test.insns / elapsed)
+
+class Nds32Disassemble(perftest.TestCase):
+    def __init__(self, objdump, binfile, size):
+        result_factory = testresult.SingleStatisticResultFactory()
+        measurements = [measure.MeasurementWallTime(result_factory.create_result()),
+                        MeasurementInsnRate(self, result_factory.create_result())]
+        super (Nds32Disassemble, self).__init__ ("nds32-disassemble",
+                                                 measure.Measure(measurements))
+        self.objdump = objdump
+        self.binfile = binfile
+        # objcopy places the image at address 0.
+        self.end = size
+        self.insns = 0
+
+    def warm_up(self):
+        gdb.execute ("x/1000i 0", False, True)
+
+    def _objdump(self):
+        out = subprocess.check_output ([self.objdump, "-d", self.binfile])
+        self.insns = len (re.findall (b"(?m)^ *[0-9a-f]+:\t", out))
+
+    def _x_i(self):
+        arch = gdb.selected_inferior ().architecture ()
+        self.insns = 0
+        addr = 0
+        # No instruction is longer than 4 bytes, so asking for at most a
+        # quarter of the bytes left never reads past the end of the image.
+        while self.end - addr >= 4:
+            count = min ((self.end - addr) // 4, 65536)
+            out = gdb.execute ("x/%di 0x%x" % (count, addr), False, True)
+            self.insns += out.count ("\n")
+            last = int (gdb.parse_and_eval ("$_"))
+            addr = last + arch.disassemble (last)[0]["length"]
+        # A 16-bit instruction may still fit in the last bytes.
+        try:
+            if addr < self.end:
+                out = gdb.execute ("x/i 0x%x" % addr, False, True)
+                self.insns += out.count ("\n")
+        except gdb.MemoryError:
+            pass
+
+    def execute_test(self):
+        self.measure.measure(lambda: self._objdump(), "objdump")
+        self.measure.measure(lambda: self._x_i(), "x/i")
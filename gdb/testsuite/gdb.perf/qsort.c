@@ -0,0 +1,57 @@
+/* This testcase is part of GDB, the GNU debugger.
+
+   Copyright (C) 2019 Free Software Foundation, Inc.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+/* Ten thousand pairs of functions, each with a minimal symbol and an
+   FDE.  Pairing a static function with a global one interleaves them
+   in memory, while the symbol table lists all locals before all
+   globals, so the minimal symbols reach GDB's sort far from address
+   order, as they do in large firmware images.  */
+
+#define FUNC(n)						\
+  static int local_##n (int x) { return x + 1; }	\
+  int global_##n (int x) { return local_##n (x) * 2; }
+
+#define FUNC10(n)					\
+  FUNC (n##0) FUNC (n##1) FUNC (n##2) FUNC (n##3) FUNC (n##4)	\
+  FUNC (n##5) FUNC (n##6) FUNC (n##7) FUNC (n##8) FUNC (n##9)
+
+#define FUNC100(n)					\
+  FUNC10 (n##0) FUNC10 (n##1) FUNC10 (n##2) FUNC10 (n##3)	\
+  FUNC10 (n##4) FUNC10 (n##5) FUNC10 (n##6) FUNC10 (n##7)	\
+  FUNC10 (n##8) FUNC10 (n##9)
+
+#define FUNC1000(n)					\
+  FUNC100 (n##0) FUNC100 (n##1) FUNC100 (n##2) FUNC100 (n##3)	\
+  FUNC100 (n##4) FUNC100 (n##5) FUNC100 (n##6) FUNC100 (n##7)	\
+  FUNC100 (n##8) FUNC100 (n##9)
+
+FUNC1000 (0)
+FUNC1000 (1)
+FUNC1000 (2)
+FUNC1000 (3)
+FUNC1000 (4)
+FUNC1000 (5)
+FUNC1000 (6)
+FUNC1000 (7)
+FUNC1000 (8)
+FUNC1000 (9)
+
+int
+main (void)
+{
+  return global_0000 (0) + global_9999 (0);
+}
@@ -0,0 +1,36 @@
+# Copyright (C) 2019 Free Software Foundation, Inc.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+from perftest import perftest
+
+class QSort (perftest.TestCaseWithBasicMeasurements):
+    def __init__(self, binfile):
+        super (QSort, self).__init__ ("qsort")
+        self.binfile = binfile
+
+    def warm_up(self):
+        self._reload()
+
+    def _reload(self):
+        # Reading the symbols sorts the minimal symbols; the backtrace
+        # then sorts the new objfile's FDE table.
+        gdb.execute ("symbol-file %s" % self.binfile, False, True)
+        gdb.execute ("bt", False, True)
+
+    def execute_test(self):
+        for engine in ("insertion", "merge"):
+            gdb.execute ("maint set nds sort-engine %s" % engine)
+            func = lambda: self._reload()
+            self.measure.measure(func, engine)
@@ -0,0 +1,328 @@
+/* Self tests for the data cache for GDB, the GNU debugger.
+
+   Copyright (C) 2019 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include "defs.h"
+#include "selftest.h"
+#include "dcache.h"
+#include "inferior.h"
+#include "memattr.h"
+#include "target.h"
+#include "test-target.h"
+
+namespace selftests {
+namespace dcache_tests {
+
+/* The number of lines the tests fill the cache with; this is the
+   default cache size.  */
+static const int nlines = 4096;
+
+/* The line size the tests assume; this is the default line size.  */
+static const int line_size = 64;
+
+/* The base address of the memory the tests read.  */
+static const CORE_ADDR base = 0x100000;
+
+/* The contents of the byte at ADDR in the mock target's memory.  */
+
+static gdb_byte
+pattern_byte (CORE_ADDR addr)
+{
+  return (gdb_byte) (addr * 7 + (addr >> 8));
+}
+
+/* A mock target whose memory holds pattern_byte everywhere, and which
+   counts the memory reads that reach it.  If CACHEABLE, its memory
+   map makes all of memory a region with the "cache" attribute, which
+   the dcache reads ahead in.  */
+
+class pattern_memory_target : public test_target_ops
+{
+public:
+  enum target_xfer_status xfer_partial (enum target_object object,
+					const char *annex, gdb_byte *readbuf,
+					const gdb_byte *writebuf,
+					ULONGEST offset, ULONGEST len,
+					ULONGEST *xfered_len) override;
+
+  std::vector<mem_region> memory_map () override;
+
+  unsigned int reads = 0;
+  bool cacheable = false;
+};
+
+std::vector<mem_region>
+pattern_memory_target::memory_map ()
+{
+  std::vector<mem_region> result;
+
+  if (this->cacheable)
+    {
+      mem_attrib attrib;
+
+      attrib.cache = 1;
+      result.emplace_back (0, 0, attrib);
+    }
+  return result;
+}
+
+enum target_xfer_status
+pattern_memory_target::xfer_partial (enum target_object object,
+				     const char *annex, gdb_byte *readbuf,
+				     const gdb_byte *writebuf,
+				     ULONGEST offset, ULONGEST len,
+				     ULONGEST *xfered_len)
+{
+  if (object != TARGET_OBJECT_MEMORY || readbuf == NULL)
+    return TARGET_XFER_E_IO;
+
+  this->reads++;
+  for (ULONGEST i = 0; i < len; i++)
+    readbuf[i] = pattern_byte (offset + i);
+
+  *xfered_len = len;
+  return TARGET_XFER_OK;
+}
+
+/* Read LEN bytes at MEMADDR through DCACHE into MYADDR, failing the
+   test if they can't be read.  */
+
+static void
+read_through (pattern_memory_target *target, DCACHE *dcache,
+	      CORE_ADDR memaddr, gdb_byte *myaddr, ULONGEST len)
+{
+  while (len > 0)
+    {
+      ULONGEST xfered_len;
+      enum target_xfer_status status
+	= dcache_read_memory_partial (target, dcache, memaddr, myaddr, len,
+				      &xfered_len);
+
+      SELF_CHECK (status == TARGET_XFER_OK);
+      memaddr += xfered_len;
+      myaddr += xfered_len;
+      len -= xfered_len;
+    }
+}
+
+/* Check that lookups find every line of a full cache, that reads
+   spanning lines are copied correctly, and report the cost of a
+   lookup.  */
+
+static void
+dcache_lookup_tests ()
+{
+  /* Error out if debugging something, because we're going to push the
+     test target, which would pop any existing target.  */
+  if (current_top_target ()->stratum () >= process_stratum)
+    error (_("target already pushed"));
+
+  pattern_memory_target mock_target;
+
+  push_target (&mock_target);
+
+  /* Pop it again on exit (return/exception).  */
+  struct on_exit
+  {
+    ~on_exit ()
+    {
+      pop_all_targets_at_and_above (process_stratum);
+    }
+  } pop_targets;
+
+  DCACHE *dcache = dcache_init ();
+  std::unique_ptr<DCACHE, void (*) (DCACHE *)> free_dcache (dcache,
+							     dcache_free);
+  gdb_byte buf[3 * line_size];
+
+  /* Fill the cache.  Going downwards, no miss looks like part of a
+     sequential walk, so nothing is read ahead past the lines we
+     want.  */
+  for (int i = nlines - 1; i >= 0; i--)
+    {
+      read_through (&mock_target, dcache, base + i * line_size, buf, 1);
+      SELF_CHECK (buf[0] == pattern_byte (base + i * line_size));
+    }
+
+  /* Every line is now cached, so reading any of it, even across line
+     boundaries, must not go to the target.  */
+  unsigned int reads = mock_target.reads;
+
+  for (int i = 0; i + 3 < nlines; i += 97)
+    {
+      CORE_ADDR addr = base + i * line_size + 13;
+
+      read_through (&mock_target, dcache, addr, buf, sizeof (buf));
+      for (size_t j = 0; j < sizeof (buf); j++)
+	SELF_CHECK (buf[j] == pattern_byte (addr + j));
+    }
+  SELF_CHECK (mock_target.reads == reads);
+
+  /* Single byte reads of cached lines in a scattered order, which is
+     what dominates when printing a large structure, are all served
+     from the cache.  */
+  const int rounds = 100;
+  unsigned int line = 0;
+
+  for (int r = 0; r < rounds; r++)
+    for (int i = 0; i < nlines; i++)
+      {
+	/* Visit the lines in the order of a full-period linear
+	   congruential sequence.  */
+	line = (line * 5 + 1) % nlines;
+	CORE_ADDR addr = base + line * line_size + (r % line_size);
+
+	read_through (&mock_target, dcache, addr, buf, 1);
+	SELF_CHECK (buf[0] == pattern_byte (addr));
+      }
+
+  SELF_CHECK (mock_target.reads == reads);
+
+  /* A line that isn't cached is read from the target, evicting
+     another one.  */
+  CORE_ADDR beyond = base + nlines * line_size;
+
+  read_through (&mock_target, dcache, beyond, buf, 1);
+  SELF_CHECK (buf[0] == pattern_byte (beyond));
+  SELF_CHECK (mock_target.reads == reads + 1);
+}
+
+/* Check that priming the cache with memory sent by the target makes
+   reads of the whole lines it covers free, and only of those.  */
+
+static void
+dcache_prime_tests ()
+{
+  /* See dcache_lookup_tests.  */
+  if (current_top_target ()->stratum () >= process_stratum)
+    error (_("target already pushed"));
+
+  pattern_memory_target mock_target;
+
+  push_target (&mock_target);
+
+  struct on_exit
+  {
+    ~on_exit ()
+    {
+      pop_all_targets_at_and_above (process_stratum);
+    }
+  } pop_targets;
+
+  DCACHE *dcache = dcache_init ();
+  std::unique_ptr<DCACHE, void (*) (DCACHE *)> free_dcache (dcache,
+							     dcache_free);
+
+  /* Prime with 128 bytes that start mid-line: only the one line
+     entirely inside them can be cached.  */
+  CORE_ADDR start = base + line_size / 2;
+  gdb_byte data[2 * line_size];
+  gdb_byte buf[line_size];
+
+  for (size_t i = 0; i < sizeof (data); i++)
+    data[i] = pattern_byte (start + i);
+  dcache_prime (dcache, inferior_ptid, start, data, sizeof (data));
+
+  read_through (&mock_target, dcache, base + line_size, buf, line_size);
+  for (int i = 0; i < line_size; i++)
+    SELF_CHECK (buf[i] == pattern_byte (base + line_size + i));
+  SELF_CHECK (mock_target.reads == 0);
+
+  read_through (&mock_target, dcache, base, buf, 1);
+  SELF_CHECK (mock_target.reads == 1);
+}
+
+/* Check that a sequential miss on a full cache, most of whose lines
+   are in use, returns the line asked for and keeps it along with the
+   lines read ahead.  */
+
+static void
+dcache_prefetch_tests ()
+{
+  /* See dcache_lookup_tests.  */
+  if (current_top_target ()->stratum () >= process_stratum)
+    error (_("target already pushed"));
+
+  pattern_memory_target mock_target;
+
+  mock_target.cacheable = true;
+  push_target (&mock_target);
+  invalidate_target_mem_regions ();
+
+  /* Forget the mock target's memory map too.  */
+  struct on_exit
+  {
+    ~on_exit ()
+    {
+      pop_all_targets_at_and_above (process_stratum);
+      invalidate_target_mem_regions ();
+    }
+  } pop_targets;
+
+  DCACHE *dcache = dcache_init ();
+  std::unique_ptr<DCACHE, void (*) (DCACHE *)> free_dcache (dcache,
+							     dcache_free);
+  gdb_byte buf[1];
+
+  /* Fill the cache downwards, so that nothing is read ahead.  The
+     clock hand is left on the highest line.  */
+  for (int i = nlines - 1; i >= 0; i--)
+    read_through (&mock_target, dcache, base + i * line_size, buf, 1);
+
+  /* A line past the others evicts the highest one, after sweeping
+     round and clearing every line's reference.  The hand is then on
+     the second highest line.  */
+  CORE_ADDR far = base + 2 * nlines * line_size;
+
+  read_through (&mock_target, dcache, far, buf, 1);
+
+  /* Use every line again but the one under the hand.  */
+  for (int i = nlines - 3; i >= 0; i--)
+    read_through (&mock_target, dcache, base + i * line_size, buf, 1);
+
+  /* The line after FAR continues a sequential walk, so the one after
+     that is read ahead in the same transfer.  The first line
+     allocated evicts the unused line under the hand; the second
+     sweeps round all the lines in use.  */
+  unsigned int reads = mock_target.reads;
+
+  read_through (&mock_target, dcache, far + line_size, buf, 1);
+  SELF_CHECK (buf[0] == pattern_byte (far + line_size));
+  SELF_CHECK (mock_target.reads == reads + 1);
+
+  /* Both lines are cached.  */
+  read_through (&mock_target, dcache, far + line_size + 1, buf, 1);
+  SELF_CHECK (buf[0] == pattern_byte (far + line_size + 1));
+  read_through (&mock_target, dcache, far + 2 * line_size, buf, 1);
+  SELF_CHECK (buf[0] == pattern_byte (far + 2 * line_size));
+  SELF_CHECK (mock_target.reads == reads + 1);
+}
+
+} /* namespace dcache_tests */
+} /* namespace selftests */
+
+void
+_initialize_dcache_selftests ()
+{
+  selftests::register_test ("dcache-lookup",
+			    selftests::dcache_tests::dcache_lookup_tests);
+  selftests::register_test ("dcache-prime",
+			    selftests::dcache_tests::dcache_prime_tests);
+  selftests::register_test ("dcache-prefetch",
+			    selftests::dcache_tests::dcache_prefetch_tests);
+}
@@ -0,0 +1,98 @@
+/* Self tests for the compression of remote protocol packets.
+
+   Copyright (C) 2019 Free Software Foundation, Inc.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include "defs.h"
+#include "selftest.h"
+#include "common/rsp-compress.h"
+
+namespace selftests {
+namespace rsp_compress {
+
+/* Send PACKET from DEFLATER to INFLATER, and check that it arrives
+   intact, and that the characters that delimit packets don't appear
+   in between.  Return the number of characters sent.  */
+
+static size_t
+send_packet (rsp_deflater &deflater, rsp_inflater &inflater,
+	     const std::string &packet)
+{
+  std::string sent = deflater.compress (packet.data (), packet.size ());
+  std::string received;
+
+  SELF_CHECK (sent.find_first_of ("$#*") == std::string::npos);
+  SELF_CHECK (inflater.decompress (sent.data (), sent.size (), &received));
+  SELF_CHECK (received == packet);
+  return sent.size ();
+}
+
+/* Test a sequence of packets through one stream.  */
+
+static void
+test_round_trip ()
+{
+  rsp_deflater deflater;
+  rsp_inflater inflater;
+
+  /* A typical exchange, including an empty reply.  */
+  send_packet (deflater, inflater, "qSupported:multiprocess+");
+  send_packet (deflater, inflater, "");
+  send_packet (deflater, inflater, "OK");
+
+  /* Every byte value, which exercises the escapes.  */
+  std::string binary;
+  for (int i = 0; i < 4096; i++)
+    binary.push_back ((char) (i * 37 + (i >> 8)));
+  send_packet (deflater, inflater, "b" + binary);
+
+  /* Hex data shrinks, and repeated packets shrink more since the
+     stream remembers earlier ones.  */
+  std::string hex;
+  unsigned int seed = 1;
+  for (int i = 0; i < 1024; i++)
+    {
+      seed = seed * 1103515245 + 12345;
+      hex += "0123456789abcdef"[(seed >> 16) % 16];
+    }
+  SELF_CHECK (send_packet (deflater, inflater, hex) < hex.size () * 3 / 4);
+  SELF_CHECK (send_packet (deflater, inflater, hex) < 64);
+}
+
+/* Test that data out of sync with the stream is rejected.  */
+
+static void
+test_corrupt ()
+{
+  rsp_inflater inflater;
+  std::string received;
+
+  /* An invalid deflate block type.  */
+  SELF_CHECK (!inflater.decompress ("\x07", 1, &received));
+}
+
+} /* namespace rsp_compress */
+} /* namespace selftests */
+
+void
+_initialize_rsp_compress_selftests ()
+{
+  selftests::register_test ("rsp_compress_round_trip",
+			    selftests::rsp_compress::test_round_trip);
+  selftests::register_test ("rsp_compress_corrupt",
+			    selftests::rsp_compress::test_corrupt);
+}
@@ -0,0 +1,1400 @@
+// nds32.cc -- nds32 target support for gold.
+
+// Copyright (C) 2019 Free Software Foundation, Inc.
+
+// This file is part of gold.
+
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 3 of the License, or
+// (at your option) any later version.
+
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+// MA 02110-1301, USA.
+
+// This port handles statically linked, non-PIC executables and
+// relocatable links.  Linker relaxation is not implemented: the
+// relaxation hints emitted by the assembler are ignored, which gives
+// the same result as "ld --no-relax".  There is no GOT, PLT or
+// dynamic relocation support yet.
+
+#include "gold.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "elfcpp.h"
+#include "nds32.h"
+#include "parameters.h"
+#include "reloc.h"
+#include "object.h"
+#include "symtab.h"
+#include "layout.h"
+#include "output.h"
+#include "target.h"
+#include "target-reloc.h"
+#include "target-select.h"
+#include "errors.h"
+#include "gc.h"
+
+namespace
+{
+
+using namespace gold;
+
+template<int size, bool big_endian>
+class Target_nds32 : public Sized_target<size, big_endian>
+{
+ public:
+  typedef typename elfcpp::Elf_types<size>::Elf_Addr Address;
+
+  Target_nds32()
+    : Sized_target<size, big_endian>(&nds32_info),
+      sda_base_(NULL), needs_sda_base_(false), place_sda_base_(false),
+      issued_non_pic_error_(false), elf_flags_(0), elf_flags_set_(false)
+  {
+  }
+
+  // Process the relocations to determine unreferenced sections for
+  // garbage collection.
+  void
+  gc_process_relocs(Symbol_table* symtab,
+		    Layout* layout,
+		    Sized_relobj_file<size, big_endian>* object,
+		    unsigned int data_shndx,
+		    unsigned int sh_type,
+		    const unsigned char* prelocs,
+		    size_t reloc_count,
+		    Output_section* output_section,
+		    bool needs_special_offset_handling,
+		    size_t local_symbol_count,
+		    const unsigned char* plocal_symbols);
+
+  // Scan the relocations to look for symbol adjustments.
+  void
+  scan_relocs(Symbol_table* symtab,
+	      Layout* layout,
+	      Sized_relobj_file<size, big_endian>* object,
+	      unsigned int data_shndx,
+	      unsigned int sh_type,
+	      const unsigned char* prelocs,
+	      size_t reloc_count,
+	      Output_section* output_section,
+	      bool needs_special_offset_handling,
+	      size_t local_symbol_count,
+	      const unsigned char* plocal_symbols);
+
+  // Finalize the sections.
+  void
+  do_finalize_sections(Layout*, const Input_objects*, Symbol_table*);
+
+  // Relocate a section.
+  void
+  relocate_section(const Relocate_info<size, big_endian>*,
+		   unsigned int sh_type,
+		   const unsigned char* prelocs,
+		   size_t reloc_count,
+		   Output_section* output_section,
+		   bool needs_special_offset_handling,
+		   unsigned char* view,
+		   Address view_address,
+		   section_size_type view_size,
+		   const Reloc_symbol_changes*);
+
+  // Scan the relocs during a relocatable link.
+  void
+  scan_relocatable_relocs(Symbol_table* symtab,
+			  Layout* layout,
+			  Sized_relobj_file<size, big_endian>* object,
+			  unsigned int data_shndx,
+			  unsigned int sh_type,
+			  const unsigned char* prelocs,
+			  size_t reloc_count,
+			  Output_section* output_section,
+			  bool needs_special_offset_handling,
+			  size_t local_symbol_count,
+			  const unsigned char* plocal_symbols,
+			  Relocatable_relocs*);
+
+  // Scan the relocs for --emit-relocs.
+  void
+  emit_relocs_scan(Symbol_table* symtab,
+		   Layout* layout,
+		   Sized_relobj_file<size, big_endian>* object,
+		   unsigned int data_shndx,
+		   unsigned int sh_type,
+		   const unsigned char* prelocs,
+		   size_t reloc_count,
+		   Output_section* output_section,
+		   bool needs_special_offset_handling,
+		   size_t local_symbol_count,
+		   const unsigned char* plocal_syms,
+		   Relocatable_relocs* rr);
+
+  // Emit relocations for a section.
+  void
+  relocate_relocs(const Relocate_info<size, big_endian>*,
+		  unsigned int sh_type,
+		  const unsigned char* prelocs,
+		  size_t reloc_count,
+		  Output_section* output_section,
+		  typename elfcpp::Elf_types<size>::Elf_Off
+                    offset_in_output_section,
+		  unsigned char* view,
+		  Address view_address,
+		  section_size_type view_size,
+		  unsigned char* reloc_view,
+		  section_size_type reloc_view_size);
+
+  // Return whether SYM is defined by the ABI.
+  bool
+  do_is_defined_by_abi(const Symbol* sym) const
+  { return strcmp(sym->name(), "_SDA_BASE_") == 0; }
+
+ protected:
+  // Make an ELF object.
+  Object*
+  do_make_elf_object(const std::string&, Input_file*, off_t,
+		     const elfcpp::Ehdr<size, big_endian>& ehdr);
+
+  void
+  do_adjust_elf_header(unsigned char* view, int len);
+
+  // We use the relaxation hook to place _SDA_BASE_ once section
+  // addresses are known.
+  bool
+  do_may_relax() const
+  { return this->place_sda_base_ || parameters->options().relax(); }
+
+  bool
+  do_relax(int, const Input_objects*, Symbol_table*, Layout*, const Task*);
+
+ private:
+
+  // The class which scans relocations.
+  class Scan
+  {
+  public:
+    inline void
+    local(Symbol_table* symtab, Layout* layout, Target_nds32* target,
+	  Sized_relobj_file<size, big_endian>* object,
+	  unsigned int data_shndx,
+	  Output_section* output_section,
+	  const elfcpp::Rela<size, big_endian>& reloc, unsigned int r_type,
+	  const elfcpp::Sym<size, big_endian>& lsym,
+	  bool is_discarded);
+
+    inline void
+    global(Symbol_table* symtab, Layout* layout, Target_nds32* target,
+	   Sized_relobj_file<size, big_endian>* object,
+	   unsigned int data_shndx,
+	   Output_section* output_section,
+	   const elfcpp::Rela<size, big_endian>& reloc, unsigned int r_type,
+	   Symbol* gsym);
+
+    inline bool
+    local_reloc_may_be_function_pointer(Symbol_table* , Layout* ,
+					Target_nds32* ,
+					Sized_relobj_file<size, big_endian>* ,
+					unsigned int ,
+					Output_section* ,
+					const elfcpp::Rela<size, big_endian>& ,
+					unsigned int ,
+					const elfcpp::Sym<size, big_endian>&)
+    { return false; }
+
+    inline bool
+    global_reloc_may_be_function_pointer(Symbol_table* , Layout* ,
+					 Target_nds32* ,
+					 Sized_relobj_file<size, big_endian>* ,
+					 unsigned int ,
+					 Output_section* ,
+					 const elfcpp::Rela<size,
+							    big_endian>& ,
+					 unsigned int , Symbol*)
+    { return false; }
+
+  private:
+    static void
+    unsupported_reloc_local(Sized_relobj_file<size, big_endian>*,
+			    unsigned int r_type);
+
+    static void
+    unsupported_reloc_global(Sized_relobj_file<size, big_endian>*,
+			     unsigned int r_type, Symbol*);
+
+    // Check a reloc which is only valid in a non-PIC link, and
+    // record whether it needs _SDA_BASE_.  Return false if the reloc
+    // is not one we know how to apply.
+    static bool
+    check_reloc(Relobj*, Target_nds32* target, unsigned int r_type);
+  };
+
+  // The class which implements relocation.
+  class Relocate
+  {
+   public:
+    // Do a relocation.  Return false if the caller should not issue
+    // any warnings about this relocation.
+    inline bool
+    relocate(const Relocate_info<size, big_endian>*, unsigned int,
+	     Target_nds32*, Output_section*, size_t, const unsigned char*,
+	     const Sized_symbol<size>*, const Symbol_value<size>*,
+	     unsigned char*, Address, section_size_type);
+  };
+
+  // Return whether R_TYPE is applied relative to _SDA_BASE_.
+  static inline bool
+  is_sda_reloc(unsigned int r_type);
+
+  // Return whether R_TYPE is a relaxation or other marker reloc which
+  // does not modify the section contents.
+  static inline bool
+  is_ignored_reloc(unsigned int r_type);
+
+  // Define _SDA_BASE_ if it is needed and was not defined by the
+  // program or the linker script.
+  void
+  set_sda_base(Symbol_table*);
+
+  // Move _SDA_BASE_ into the small data region after layout.
+  void
+  place_sda_base(Layout*);
+
+  // Information about this specific target which we pass to the
+  // general Target structure.
+  static const Target::Target_info nds32_info;
+
+  // The _SDA_BASE_ symbol, used by the small data relocs.
+  Sized_symbol<size>* sda_base_;
+  // Whether any input reloc is relative to _SDA_BASE_.
+  bool needs_sda_base_;
+  // Whether we defined _SDA_BASE_ and must place it after layout.
+  bool place_sda_base_;
+  // Whether we have issued an error about a PIC link.
+  bool issued_non_pic_error_;
+  // Accumulated elf header flags.
+  elfcpp::Elf_Word elf_flags_;
+  // Whether elf_flags_ has been set for the first time yet.
+  bool elf_flags_set_;
+};
+
+template<>
+const Target::Target_info Target_nds32<32, false>::nds32_info =
+{
+  32,			// size
+  false,		// is_big_endian
+  elfcpp::EM_NDS32,	// machine_code
+  false,		// has_make_symbol
+  false,		// has_resolve
+  false,		// has_code_fill
+  true,			// is_default_stack_executable
+  false,		// can_icf_inline_merge_sections
+  '\0',			// wrap_char
+  "/lib/ld.so.1",	// dynamic_linker
+  0x500000,		// default_text_segment_address
+  0x20,			// abi_pagesize (overridable by -z max-page-size)
+  0x20,			// common_pagesize (overridable by -z common-page-size)
+  false,                // isolate_execinstr
+  0,                    // rosegment_gap
+  elfcpp::SHN_UNDEF,	// small_common_shndx
+  elfcpp::SHN_UNDEF,	// large_common_shndx
+  0,			// small_common_section_flags
+  0,			// large_common_section_flags
+  NULL,			// attributes_section
+  NULL,			// attributes_vendor
+  "_start",		// entry_symbol_name
+  32,			// hash_entry_size
+  elfcpp::SHT_PROGBITS,	// unwind_section_type
+};
+
+template<>
+const Target::Target_info Target_nds32<32, true>::nds32_info =
+{
+  32,			// size
+  true,			// is_big_endian
+  elfcpp::EM_NDS32,	// machine_code
+  false,		// has_make_symbol
+  false,		// has_resolve
+  false,		// has_code_fill
+  true,			// is_default_stack_executable
+  false,		// can_icf_inline_merge_sections
+  '\0',			// wrap_char
+  "/lib/ld.so.1",	// dynamic_linker
+  0x500000,		// default_text_segment_address
+  0x20,			// abi_pagesize (overridable by -z max-page-size)
+  0x20,			// common_pagesize (overridable by -z common-page-size)
+  false,                // isolate_execinstr
+  0,                    // rosegment_gap
+  elfcpp::SHN_UNDEF,	// small_common_shndx
+  elfcpp::SHN_UNDEF,	// large_common_shndx
+  0,			// small_common_section_flags
+  0,			// large_common_section_flags
+  NULL,			// attributes_section
+  NULL,			// attributes_vendor
+  "_start",		// entry_symbol_name
+  32,			// hash_entry_size
+  elfcpp::SHT_PROGBITS,	// unwind_section_type
+};
+
+// Instructions are always stored big endian, whatever the data
+// endianness.  Each instruction reloc stores
+// (VALUE >> RIGHT_SHIFT) & DST_MASK into the instruction and checks
+// that VALUE >> RIGHT_SHIFT fits in BITSIZE bits.  Instructions are
+// only halfword aligned, so the 32-bit accesses are unaligned.
+
+template<int size, bool big_endian>
+class Nds32_relocate_functions : public Relocate_functions<size, big_endian>
+{
+ private:
+  typedef Relocate_functions<size, big_endian> Base;
+
+ public:
+  typedef typename Base::Overflow_check Overflow_check;
+  typedef typename Base::Reloc_status Reloc_status;
+
+ private:
+  static inline Reloc_status
+  check_overflow(uint32_t value, unsigned int right_shift,
+		 unsigned int bitsize, Overflow_check check)
+  {
+    switch (check)
+      {
+      case Base::CHECK_SIGNED:
+	{
+	  int32_t sval = static_cast<int32_t>(value) >> right_shift;
+	  int32_t limit = static_cast<int32_t>(1) << (bitsize - 1);
+	  if (sval < -limit || sval >= limit)
+	    return Base::RELOC_OVERFLOW;
+	  return Base::RELOC_OK;
+	}
+      case Base::CHECK_UNSIGNED:
+	if ((value >> right_shift) >> bitsize != 0)
+	  return Base::RELOC_OVERFLOW;
+	return Base::RELOC_OK;
+      case Base::CHECK_NONE:
+      default:
+	return Base::RELOC_OK;
+      }
+  }
+
+  template<int valsize>
+  static inline Reloc_status
+  insn(unsigned char* view, uint32_t value, unsigned int right_shift,
+       unsigned int bitsize, uint32_t dst_mask, Overflow_check check)
+  {
+    typedef typename elfcpp::Swap_unaligned<valsize, true>::Valtype Valtype;
+    Valtype val = elfcpp::Swap_unaligned<valsize, true>::readval(view);
+    Valtype reloc = (value >> right_shift) & dst_mask;
+
+    val &= ~dst_mask;
+    elfcpp::Swap_unaligned<valsize, true>::writeval(view, val | reloc);
+    return check_overflow(value, right_shift, bitsize, check);
+  }
+
+ public:
+  // Relocate a 16-bit instruction.
+  static inline Reloc_status
+  insn16(unsigned char* view, uint32_t value, unsigned int right_shift,
+	 unsigned int bitsize, uint32_t dst_mask, Overflow_check check)
+  {
+    return insn<16>(view, value, right_shift, bitsize, dst_mask, check);
+  }
+
+  // Relocate a 32-bit instruction.
+  static inline Reloc_status
+  insn32(unsigned char* view, uint32_t value, unsigned int right_shift,
+	 unsigned int bitsize, uint32_t dst_mask, Overflow_check check)
+  {
+    return insn<32>(view, value, right_shift, bitsize, dst_mask, check);
+  }
+};
+
+// Return whether R_TYPE is applied relative to _SDA_BASE_.
+
+template<int size, bool big_endian>
+inline bool
+Target_nds32<size, big_endian>::is_sda_reloc(unsigned int r_type)
+{
+  switch (r_type)
+    {
+    case elfcpp::R_NDS32_SDA15S3_RELA:
+    case elfcpp::R_NDS32_SDA15S2_RELA:
+    case elfcpp::R_NDS32_SDA15S1_RELA:
+    case elfcpp::R_NDS32_SDA15S0_RELA:
+    case elfcpp::R_NDS32_SDA16S3_RELA:
+    case elfcpp::R_NDS32_SDA17S2_RELA:
+    case elfcpp::R_NDS32_SDA18S1_RELA:
+    case elfcpp::R_NDS32_SDA19S0_RELA:
+    case elfcpp::R_NDS32_SDA12S2_DP_RELA:
+    case elfcpp::R_NDS32_SDA12S2_SP_RELA:
+    case elfcpp::R_NDS32_SDA_FP7U2_RELA:
+      return true;
+
+    default:
+      return false;
+    }
+}
+
+// Return whether R_TYPE is a relaxation or other marker reloc which
+// does not modify the section contents.  The DIFF relocs and their
+// MINUEND and SUBTRAHEND describe values which the assembler has
+// already written, and which only change if relaxation moves code.
+// The other relocs from R_NDS32_RELAX_ENTRY up, which mark TLS
+// descriptor, GOT and load-store sequences for ld to rewrite, are not
+// ignored: we can not apply those sequences, so they are reported as
+// unsupported.
+
+template<int size, bool big_endian>
+inline bool
+Target_nds32<size, big_endian>::is_ignored_reloc(unsigned int r_type)
+{
+  switch (r_type)
+    {
+    case elfcpp::R_NDS32_NONE:
+    case elfcpp::R_NDS32_GNU_VTINHERIT:
+    case elfcpp::R_NDS32_GNU_VTENTRY:
+    case elfcpp::R_NDS32_RELA_GNU_VTINHERIT:
+    case elfcpp::R_NDS32_RELA_GNU_VTENTRY:
+    case elfcpp::R_NDS32_INSN16:
+    case elfcpp::R_NDS32_LABEL:
+    case elfcpp::R_NDS32_LONGCALL1:
+    case elfcpp::R_NDS32_LONGCALL2:
+    case elfcpp::R_NDS32_LONGCALL3:
+    case elfcpp::R_NDS32_LONGCALL4:
+    case elfcpp::R_NDS32_LONGCALL5:
+    case elfcpp::R_NDS32_LONGCALL6:
+    case elfcpp::R_NDS32_LONGJUMP1:
+    case elfcpp::R_NDS32_LONGJUMP2:
+    case elfcpp::R_NDS32_LONGJUMP3:
+    case elfcpp::R_NDS32_LONGJUMP4:
+    case elfcpp::R_NDS32_LONGJUMP5:
+    case elfcpp::R_NDS32_LONGJUMP6:
+    case elfcpp::R_NDS32_LONGJUMP7:
+    case elfcpp::R_NDS32_LOADSTORE:
+    case elfcpp::R_NDS32_9_FIXED_RELA:
+    case elfcpp::R_NDS32_15_FIXED_RELA:
+    case elfcpp::R_NDS32_17_FIXED_RELA:
+    case elfcpp::R_NDS32_25_FIXED_RELA:
+    case elfcpp::R_NDS32_DWARF2_OP1_RELA:
+    case elfcpp::R_NDS32_DWARF2_OP2_RELA:
+    case elfcpp::R_NDS32_DWARF2_LEB_RELA:
+    case elfcpp::R_NDS32_UPDATE_TA_RELA:
+    case elfcpp::R_NDS32_RELAX_ENTRY:
+    case elfcpp::R_NDS32_PTR:
+    case elfcpp::R_NDS32_PTR_COUNT:
+    case elfcpp::R_NDS32_PTR_RESOLVED:
+    case elfcpp::R_NDS32_RELAX_REGION_BEGIN:
+    case elfcpp::R_NDS32_RELAX_REGION_END:
+    case elfcpp::R_NDS32_MINUEND:
+    case elfcpp::R_NDS32_SUBTRAHEND:
+    case elfcpp::R_NDS32_DIFF8:
+    case elfcpp::R_NDS32_DIFF16:
+    case elfcpp::R_NDS32_DIFF32:
+    case elfcpp::R_NDS32_DIFF_ULEB128:
+    case elfcpp::R_NDS32_DATA:
+    case elfcpp::R_NDS32_TRAN:
+    case elfcpp::R_NDS32_TLS_LE_ADD:
+    case elfcpp::R_NDS32_TLS_LE_LS:
+    case elfcpp::R_NDS32_EMPTY:
+    case elfcpp::R_NDS32_RELAX_REMOVE:
+    case elfcpp::R_NDS32_RELAX_GROUP:
+      return true;
+
+    default:
+      return false;
+    }
+}
+
+// Report an unsupported relocation against a local symbol.
+
+template<int size, bool big_endian>
+void
+Target_nds32<size, big_endian>::Scan::unsupported_reloc_local(
+			Sized_relobj_file<size, big_endian>* object,
+			unsigned int r_type)
+{
+  gold_error(_("%s: unsupported reloc %u against local symbol"),
+	     object->name().c_str(), r_type);
+}
+
+// Report an unsupported relocation against a global symbol.
+
+template<int size, bool big_endian>
+void
+Target_nds32<size, big_endian>::Scan::unsupported_reloc_global(
+			Sized_relobj_file<size, big_endian>* object,
+			unsigned int r_type,
+			Symbol* gsym)
+{
+  gold_error(_("%s: unsupported reloc %u against global symbol %s"),
+	     object->name().c_str(), r_type, gsym->demangled_name().c_str());
+}
+
+// Check a reloc for a symbol.  Everything we can apply is resolved at
+// static link time, so none of it is valid when building a shared
+// library or PIE.
+
+template<int size, bool big_endian>
+bool
+Target_nds32<size, big_endian>::Scan::check_reloc(Relobj* object,
+						  Target_nds32* target,
+						  unsigned int r_type)
+{
+  switch (r_type)
+    {
+    case elfcpp::R_NDS32_16_RELA:
+    case elfcpp::R_NDS32_32_RELA:
+    case elfcpp::R_NDS32_20_RELA:
+    case elfcpp::R_NDS32_5_RELA:
+    case elfcpp::R_NDS32_9_PCREL_RELA:
+    case elfcpp::R_NDS32_WORD_9_PCREL_RELA:
+    case elfcpp::R_NDS32_10_UPCREL_RELA:
+    case elfcpp::R_NDS32_10IFCU_PCREL_RELA:
+    case elfcpp::R_NDS32_15_PCREL_RELA:
+    case elfcpp::R_NDS32_17_PCREL_RELA:
+    case elfcpp::R_NDS32_17IFC_PCREL_RELA:
+    case elfcpp::R_NDS32_25_PCREL_RELA:
+    case elfcpp::R_NDS32_25_ABS_RELA:
+    case elfcpp::R_NDS32_HI20_RELA:
+    case elfcpp::R_NDS32_LO12S3_RELA:
+    case elfcpp::R_NDS32_LO12S2_RELA:
+    case elfcpp::R_NDS32_LO12S2_DP_RELA:
+    case elfcpp::R_NDS32_LO12S2_SP_RELA:
+    case elfcpp::R_NDS32_LO12S1_RELA:
+    case elfcpp::R_NDS32_LO12S0_RELA:
+    case elfcpp::R_NDS32_LO12S0_ORI_RELA:
+    case elfcpp::R_NDS32_TLS_LE_HI20:
+    case elfcpp::R_NDS32_TLS_LE_LO12:
+    case elfcpp::R_NDS32_TLS_LE_20:
+    case elfcpp::R_NDS32_TLS_LE_15S0:
+    case elfcpp::R_NDS32_TLS_LE_15S1:
+    case elfcpp::R_NDS32_TLS_LE_15S2:
+      break;
+
+    default:
+      if (!Target_nds32::is_sda_reloc(r_type))
+	return false;
+      target->needs_sda_base_ = true;
+      break;
+    }
+
+  if (parameters->options().output_is_position_independent()
+      && !target->issued_non_pic_error_)
+    {
+      gold_error(_("%s: position-independent output is not supported "
+		   "for nds32"),
+		 object->name().c_str());
+      target->issued_non_pic_error_ = true;
+    }
+  return true;
+}
+
+// Scan a relocation for a local symbol.
+
+template<int size, bool big_endian>
+inline void
+Target_nds32<size, big_endian>::Scan::local(
+			Symbol_table*,
+			Layout*,
+			Target_nds32* target,
+			Sized_relobj_file<size, big_endian>* object,
+			unsigned int,
+			Output_section*,
+			const elfcpp::Rela<size, big_endian>&,
+			unsigned int r_type,
+			const elfcpp::Sym<size, big_endian>&,
+			bool is_discarded)
+{
+  if (is_discarded || Target_nds32::is_ignored_reloc(r_type))
+    return;
+
+  if (!check_reloc(object, target, r_type))
+    unsupported_reloc_local(object, r_type);
+}
+
+// Scan a relocation for a global symbol.
+
+template<int size, bool big_endian>
+inline void
+Target_nds32<size, big_endian>::Scan::global(
+			Symbol_table*,
+			Layout*,
+			Target_nds32* target,
+			Sized_relobj_file<size, big_endian>* object,
+			unsigned int,
+			Output_section*,
+			const elfcpp::Rela<size, big_endian>&,
+			unsigned int r_type,
+			Symbol* gsym)
+{
+  if (Target_nds32::is_ignored_reloc(r_type))
+    return;
+
+  if (gsym->is_from_dynobj())
+    {
+      gold_error(_("%s: reloc %u against %s requires a dynamic relocation, "
+		   "which is not supported for nds32"),
+		 object->name().c_str(), r_type,
+		 gsym->demangled_name().c_str());
+      return;
+    }
+
+  if (!check_reloc(object, target, r_type))
+    unsupported_reloc_global(object, r_type, gsym);
+}
+
+// Process relocations for gc.
+
+template<int size, bool big_endian>
+void
+Target_nds32<size, big_endian>::gc_process_relocs(
+			Symbol_table* symtab,
+			Layout* layout,
+			Sized_relobj_file<size, big_endian>* object,
+			unsigned int data_shndx,
+			unsigned int,
+			const unsigned char* prelocs,
+			size_t reloc_count,
+			Output_section* output_section,
+			bool needs_special_offset_handling,
+			size_t local_symbol_count,
+			const unsigned char* plocal_symbols)
+{
+  typedef Target_nds32<size, big_endian> Nds32;
+  typedef typename Target_nds32<size, big_endian>::Scan Scan;
+  typedef gold::Default_classify_reloc<elfcpp::SHT_RELA, size, big_endian>
+      Classify_reloc;
+
+  gold::gc_process_relocs<size, big_endian, Nds32, Scan, Classify_reloc>(
+    symtab,
+    layout,
+    this,
+    object,
+    data_shndx,
+    prelocs,
+    reloc_count,
+    output_section,
+    needs_special_offset_handling,
+    local_symbol_count,
+    plocal_symbols);
+}
+
+// Scan relocations for a section.
+
+template<int size, bool big_endian>
+void
+Target_nds32<size, big_endian>::scan_relocs(
+			Symbol_table* symtab,
+			Layout* layout,
+			Sized_relobj_file<size, big_endian>* object,
+			unsigned int data_shndx,
+			unsigned int sh_type,
+			const unsigned char* prelocs,
+			size_t reloc_count,
+			Output_section* output_section,
+			bool needs_special_offset_handling,
+			size_t local_symbol_count,
+			const unsigned char* plocal_symbols)
+{
+  typedef Target_nds32<size, big_endian> Nds32;
+  typedef gold::Default_classify_reloc<elfcpp::SHT_RELA, size, big_endian>
+      Classify_reloc;
+
+  if (sh_type == elfcpp::SHT_REL)
+    {
+      gold_error(_("%s: unsupported REL reloc section"),
+		 object->name().c_str());
+      return;
+    }
+
+  gold::scan_relocs<size, big_endian, Nds32, Scan, Classify_reloc>(
+    symtab,
+    layout,
+    this,
+    object,
+    data_shndx,
+    prelocs,
+    reloc_count,
+    output_section,
+    needs_special_offset_handling,
+    local_symbol_count,
+    plocal_symbols);
+}
+
+// Order output sections by address.
+
+static bool
+output_section_address_less(const Output_section* a, const Output_section* b)
+{
+  return a->address() < b->address();
+}
+
+// Define _SDA_BASE_ if it is needed and the program did not define
+// it.  Its value depends on the section addresses, so define it as a
+// constant for now and let place_sda_base move it into the right
+// section once layout is done.
+
+template<int size, bool big_endian>
+void
+Target_nds32<size, big_endian>::set_sda_base(Symbol_table* symtab)
+{
+  Symbol* sym = symtab->lookup("_SDA_BASE_");
+  if (sym != NULL && !sym->is_undefined())
+    {
+      this->sda_base_ = symtab->get_sized_symbol<size>(sym);
+      return;
+    }
+  if (sym == NULL && !this->needs_sda_base_)
+    return;
+
+  sym = symtab->define_as_constant("_SDA_BASE_", NULL,
+				   Symbol_table::PREDEFINED,
+				   0, 0, elfcpp::STT_NOTYPE,
+				   elfcpp::STB_GLOBAL,
+				   elfcpp::STV_DEFAULT, 0,
+				   false, false);
+  this->sda_base_ = symtab->get_sized_symbol<size>(sym);
+  this->place_sda_base_ = true;
+}
+
+// Place _SDA_BASE_ the way ld's nds32_elf_final_sda_base does.  The
+// small data region runs from the first to the last non-empty section
+// among .data, .got, the .sdata_* and .sbss_* sections, extended to
+// .bss if the whole region is smaller than 0x80000 bytes.  The base
+// goes in the middle of it, inside the last of those sections that
+// starts at or below the middle.  ld computes the middle from the
+// pre-relaxation size of the final section, which is zero when
+// nothing was relaxed; we never relax, so we use zero as well.
+// Without any of those sections, fall back to the writable data and
+// bss sections, and then to any allocated section.
+
+template<int size, bool big_endian>
+void
+Target_nds32<size, big_endian>::place_sda_base(Layout* layout)
+{
+  static const char* const sda_sections[] =
+  {
+    ".data", ".got", ".sdata_d", ".sdata_w", ".sdata_h", ".sdata_b",
+    ".sbss_b", ".sbss_h", ".sbss_w", ".sbss_d"
+  };
+  const size_t sda_section_count =
+    sizeof(sda_sections) / sizeof(sda_sections[0]);
+
+  Output_section* first = NULL;
+  Output_section* final = NULL;
+  uint64_t total = 0;
+  for (size_t i = 0; i < sda_section_count; ++i)
+    {
+      Output_section* os = layout->find_output_section(sda_sections[i]);
+      if (os == NULL || os->data_size() == 0)
+	continue;
+      if (first == NULL)
+	first = os;
+      final = os;
+      total += os->data_size();
+    }
+
+  Output_section* bss = layout->find_output_section(".bss");
+  if (bss != NULL && bss->data_size() != 0)
+    {
+      total += bss->data_size();
+      if (total < 0x80000)
+	{
+	  if (first == NULL)
+	    first = bss;
+	  final = bss;
+	}
+    }
+
+  Address sda_base;
+  if (first != NULL)
+    {
+      sda_base = final->address() / 2 + first->address() / 2;
+      for (size_t i = 0; i < sda_section_count; ++i)
+	{
+	  Output_section* os = layout->find_output_section(sda_sections[i]);
+	  if (os == NULL || os->data_size() == 0 || sda_base < os->address())
+	    break;
+	  first = os;
+	}
+    }
+  else
+    {
+      std::vector<Output_section*> sections;
+      const Layout::Section_list& section_list(layout->section_list());
+      for (Layout::Section_list::const_iterator p = section_list.begin();
+	   p != section_list.end();
+	   ++p)
+	if (((*p)->flags() & elfcpp::SHF_ALLOC) != 0
+	    && (*p)->data_size() != 0)
+	  sections.push_back(*p);
+      std::stable_sort(sections.begin(), sections.end(),
+		       output_section_address_less);
+
+      for (std::vector<Output_section*>::const_iterator p = sections.begin();
+	   p != sections.end();
+	   ++p)
+	{
+	  if (((*p)->flags() & elfcpp::SHF_WRITE) == 0
+	      && (*p)->type() != elfcpp::SHT_NOBITS)
+	    continue;
+	  if (first == NULL)
+	    first = *p;
+	  final = *p;
+	}
+      if (first == NULL)
+	{
+	  if (sections.empty())
+	    {
+	      // There is nothing to put _SDA_BASE_ in.
+	      this->sda_base_->set_undefined();
+	      this->sda_base_ = NULL;
+	      return;
+	    }
+	  first = sections.front();
+	}
+
+      if (final != NULL && final->address() - first->address() <= 0x4000)
+	sda_base = final->address() / 2 + first->address() / 2;
+      else
+	sda_base = first->address() + 0x2000;
+    }
+
+  this->sda_base_->set_output_section(first);
+  this->sda_base_->set_value((sda_base - first->address()) & ~7);
+}
+
+// Place _SDA_BASE_ after the first layout pass.  We never change the
+// layout, so there is never a second pass.
+
+template<int size, bool big_endian>
+bool
+Target_nds32<size, big_endian>::do_relax(int pass,
+					 const Input_objects*,
+					 Symbol_table*,
+					 Layout* layout,
+					 const Task*)
+{
+  if (pass == 1 && this->place_sda_base_)
+    this->place_sda_base(layout);
+  return false;
+}
+
+// Finalize the sections.
+
+template<int size, bool big_endian>
+void
+Target_nds32<size, big_endian>::do_finalize_sections(
+    Layout*,
+    const Input_objects*,
+    Symbol_table* symtab)
+{
+  if (!parameters->options().relocatable())
+    this->set_sda_base(symtab);
+}
+
+// Perform a relocation.
+
+template<int size, bool big_endian>
+inline bool
+Target_nds32<size, big_endian>::Relocate::relocate(
+			const Relocate_info<size, big_endian>* relinfo,
+			unsigned int,
+			Target_nds32* target,
+			Output_section*,
+			size_t relnum,
+			const unsigned char* preloc,
+			const Sized_symbol<size>*,
+			const Symbol_value<size>* psymval,
+			unsigned char* view,
+			Address address,
+			section_size_type)
+{
+  if (view == NULL)
+    return true;
+
+  typedef Nds32_relocate_functions<size, big_endian> Reloc;
+  const elfcpp::Rela<size, big_endian> rela(preloc);
+  unsigned int r_type = elfcpp::elf_r_type<size>(rela.get_r_info());
+  const Sized_relobj_file<size, big_endian>* object = relinfo->object;
+  typename elfcpp::Elf_types<size>::Elf_Swxword addend = rela.get_r_addend();
+
+  if (Target_nds32::is_ignored_reloc(r_type))
+    return true;
+
+  uint32_t value = psymval->value(object, addend);
+
+  // Small data relocs are relative to _SDA_BASE_, and must be
+  // aligned to the access size.
+  if (Target_nds32::is_sda_reloc(r_type))
+    {
+      if (target->sda_base_ == NULL)
+	{
+	  gold_error_at_location(relinfo, relnum, rela.get_r_offset(),
+				 _("_SDA_BASE_ is not defined"));
+	  return true;
+	}
+      value -= target->sda_base_->value();
+
+      uint32_t align;
+      switch (r_type)
+	{
+	case elfcpp::R_NDS32_SDA15S3_RELA:
+	case elfcpp::R_NDS32_SDA16S3_RELA:
+	  align = 7;
+	  break;
+	case elfcpp::R_NDS32_SDA15S2_RELA:
+	case elfcpp::R_NDS32_SDA17S2_RELA:
+	case elfcpp::R_NDS32_SDA12S2_DP_RELA:
+	case elfcpp::R_NDS32_SDA12S2_SP_RELA:
+	case elfcpp::R_NDS32_SDA_FP7U2_RELA:
+	  align = 3;
+	  break;
+	case elfcpp::R_NDS32_SDA15S1_RELA:
+	case elfcpp::R_NDS32_SDA18S1_RELA:
+	  align = 1;
+	  break;
+	default:
+	  align = 0;
+	  break;
+	}
+      if ((value & align) != 0)
+	{
+	  gold_error_at_location(relinfo, relnum, rela.get_r_offset(),
+				 _("unaligned small data access of type %u"),
+				 r_type);
+	  return true;
+	}
+    }
+
+  // Thread pointer relative relocs.  The thread pointer points at the
+  // start of the TLS segment, and the value of a TLS symbol is
+  // already its offset in that segment.
+  switch (r_type)
+    {
+    case elfcpp::R_NDS32_TLS_LE_HI20:
+    case elfcpp::R_NDS32_TLS_LE_LO12:
+    case elfcpp::R_NDS32_TLS_LE_20:
+    case elfcpp::R_NDS32_TLS_LE_15S0:
+    case elfcpp::R_NDS32_TLS_LE_15S1:
+    case elfcpp::R_NDS32_TLS_LE_15S2:
+      if (relinfo->layout->tls_segment() == NULL)
+	{
+	  gold_error_at_location(relinfo, relnum, rela.get_r_offset(),
+				 _("TLS reloc but no TLS segment"));
+	  return true;
+	}
+      break;
+
+    default:
+      break;
+    }
+
+  typename Reloc::Reloc_status reloc_status = Reloc::RELOC_OK;
+  switch (r_type)
+    {
+    case elfcpp::R_NDS32_16_RELA:
+      reloc_status = Reloc::rela16_check(view, value, 0,
+					 Reloc::CHECK_SIGNED_OR_UNSIGNED);
+      break;
+
+    case elfcpp::R_NDS32_32_RELA:
+      Reloc::rela32(view, value, 0);
+      break;
+
+    case elfcpp::R_NDS32_20_RELA:
+    case elfcpp::R_NDS32_TLS_LE_20:
+      reloc_status = Reloc::insn32(view, value, 0, 20, 0xfffff,
+				   Reloc::CHECK_SIGNED);
+      break;
+
+    case elfcpp::R_NDS32_5_RELA:
+      reloc_status = Reloc::insn16(view, value, 0, 5, 0x1f,
+				   Reloc::CHECK_SIGNED);
+      break;
+
+    case elfcpp::R_NDS32_9_PCREL_RELA:
+      reloc_status = Reloc::insn16(view, value - address, 1, 8, 0xff,
+				   Reloc::CHECK_SIGNED);
+      break;
+
+    case elfcpp::R_NDS32_WORD_9_PCREL_RELA:
+      reloc_status = Reloc::insn32(view, value - address, 1, 8, 0xff,
+				   Reloc::CHECK_SIGNED);
+      break;
+
+    case elfcpp::R_NDS32_10_UPCREL_RELA:
+    case elfcpp::R_NDS32_10IFCU_PCREL_RELA:
+      reloc_status = Reloc::insn16(view, value - address, 1, 9, 0x1ff,
+				   Reloc::CHECK_UNSIGNED);
+      break;
+
+    case elfcpp::R_NDS32_15_PCREL_RELA:
+      reloc_status = Reloc::insn32(view, value - address, 1, 14, 0x3fff,
+				   Reloc::CHECK_SIGNED);
+      break;
+
+    case elfcpp::R_NDS32_17_PCREL_RELA:
+    case elfcpp::R_NDS32_17IFC_PCREL_RELA:
+      reloc_status = Reloc::insn32(view, value - address, 1, 16, 0xffff,
+				   Reloc::CHECK_SIGNED);
+      break;
+
+    case elfcpp::R_NDS32_25_PCREL_RELA:
+      reloc_status = Reloc::insn32(view, value - address, 1, 24, 0xffffff,
+				   Reloc::CHECK_SIGNED);
+      break;
+
+    case elfcpp::R_NDS32_25_ABS_RELA:
+      reloc_status = Reloc::insn32(view, value, 1, 24, 0xffffff,
+				   Reloc::CHECK_NONE);
+      break;
+
+    case elfcpp::R_NDS32_HI20_RELA:
+    case elfcpp::R_NDS32_TLS_LE_HI20:
+      reloc_status = Reloc::insn32(view, value, 12, 20, 0xfffff,
+				   Reloc::CHECK_NONE);
+      break;
+
+    case elfcpp::R_NDS32_LO12S3_RELA:
+      reloc_status = Reloc::insn32(view, value, 3, 9, 0x1ff,
+				   Reloc::CHECK_NONE);
+      break;
+
+    case elfcpp::R_NDS32_LO12S2_RELA:
+    case elfcpp::R_NDS32_LO12S2_DP_RELA:
+    case elfcpp::R_NDS32_LO12S2_SP_RELA:
+      reloc_status = Reloc::insn32(view, value, 2, 10, 0x3ff,
+				   Reloc::CHECK_NONE);
+      break;
+
+    case elfcpp::R_NDS32_LO12S1_RELA:
+      reloc_status = Reloc::insn32(view, value, 1, 11, 0x7ff,
+				   Reloc::CHECK_NONE);
+      break;
+
+    case elfcpp::R_NDS32_LO12S0_RELA:
+    case elfcpp::R_NDS32_LO12S0_ORI_RELA:
+    case elfcpp::R_NDS32_TLS_LE_LO12:
+      reloc_status = Reloc::insn32(view, value, 0, 12, 0xfff,
+				   Reloc::CHECK_NONE);
+      break;
+
+    case elfcpp::R_NDS32_SDA15S3_RELA:
+      reloc_status = Reloc::insn32(view, value, 3, 15, 0x7fff,
+				   Reloc::CHECK_SIGNED);
+      break;
+
+    case elfcpp::R_NDS32_SDA15S2_RELA:
+    case elfcpp::R_NDS32_TLS_LE_15S2:
+      reloc_status = Reloc::insn32(view, value, 2, 15, 0x7fff,
+				   Reloc::CHECK_SIGNED);
+      break;
+
+    case elfcpp::R_NDS32_SDA15S1_RELA:
+    case elfcpp::R_NDS32_TLS_LE_15S1:
+      reloc_status = Reloc::insn32(view, value, 1, 15, 0x7fff,
+				   Reloc::CHECK_SIGNED);
+      break;
+
+    case elfcpp::R_NDS32_SDA15S0_RELA:
+    case elfcpp::R_NDS32_TLS_LE_15S0:
+      reloc_status = Reloc::insn32(view, value, 0, 15, 0x7fff,
+				   Reloc::CHECK_SIGNED);
+      break;
+
+    case elfcpp::R_NDS32_SDA16S3_RELA:
+      reloc_status = Reloc::insn32(view, value, 3, 16, 0xffff,
+				   Reloc::CHECK_SIGNED);
+      break;
+
+    case elfcpp::R_NDS32_SDA17S2_RELA:
+      reloc_status = Reloc::insn32(view, value, 2, 17, 0x1ffff,
+				   Reloc::CHECK_SIGNED);
+      break;
+
+    case elfcpp::R_NDS32_SDA18S1_RELA:
+      reloc_status = Reloc::insn32(view, value, 1, 18, 0x3ffff,
+				   Reloc::CHECK_SIGNED);
+      break;
+
+    case elfcpp::R_NDS32_SDA19S0_RELA:
+      reloc_status = Reloc::insn32(view, value, 0, 19, 0x7ffff,
+				   Reloc::CHECK_SIGNED);
+      break;
+
+    case elfcpp::R_NDS32_SDA12S2_DP_RELA:
+    case elfcpp::R_NDS32_SDA12S2_SP_RELA:
+      reloc_status = Reloc::insn32(view, value, 2, 12, 0xfff,
+				   Reloc::CHECK_SIGNED);
+      break;
+
+    case elfcpp::R_NDS32_SDA_FP7U2_RELA:
+      reloc_status = Reloc::insn16(view, value, 2, 7, 0x7f,
+				   Reloc::CHECK_UNSIGNED);
+      break;
+
+    default:
+      gold_error_at_location(relinfo, relnum, rela.get_r_offset(),
+			     _("unsupported reloc %u"),
+			     r_type);
+      break;
+    }
+
+  if (reloc_status == Reloc::RELOC_OVERFLOW)
+    gold_error_at_location(relinfo, relnum, rela.get_r_offset(),
+			   _("relocation overflow"));
+
+  return true;
+}
+
+// Relocate section data.
+
+template<int size, bool big_endian>
+void
+Target_nds32<size, big_endian>::relocate_section(
+			const Relocate_info<size, big_endian>* relinfo,
+			unsigned int sh_type,
+			const unsigned char* prelocs,
+			size_t reloc_count,
+			Output_section* output_section,
+			bool needs_special_offset_handling,
+			unsigned char* view,
+			Address address,
+			section_size_type view_size,
+			const Reloc_symbol_changes* reloc_symbol_changes)
+{
+  typedef Target_nds32<size, big_endian> Nds32;
+  typedef typename Target_nds32<size, big_endian>::Relocate Nds32_relocate;
+  typedef gold::Default_classify_reloc<elfcpp::SHT_RELA, size, big_endian>
+      Classify_reloc;
+
+  gold_assert(sh_type == elfcpp::SHT_RELA);
+
+  gold::relocate_section<size, big_endian, Nds32, Nds32_relocate,
+			 gold::Default_comdat_behavior, Classify_reloc>(
+    relinfo,
+    this,
+    prelocs,
+    reloc_count,
+    output_section,
+    needs_special_offset_handling,
+    view,
+    address,
+    view_size,
+    reloc_symbol_changes);
+}
+
+// Scan the relocs during a relocatable link.
+
+template<int size, bool big_endian>
+void
+Target_nds32<size, big_endian>::scan_relocatable_relocs(
+			Symbol_table* symtab,
+			Layout* layout,
+			Sized_relobj_file<size, big_endian>* object,
+			unsigned int data_shndx,
+			unsigned int sh_type,
+			const unsigned char* prelocs,
+			size_t reloc_count,
+			Output_section* output_section,
+			bool needs_special_offset_handling,
+			size_t local_symbol_count,
+			const unsigned char* plocal_symbols,
+			Relocatable_relocs* rr)
+{
+  typedef gold::Default_classify_reloc<elfcpp::SHT_RELA, size, big_endian>
+      Classify_reloc;
+  typedef gold::Default_scan_relocatable_relocs<Classify_reloc>
+      Scan_relocatable_relocs;
+
+  gold_assert(sh_type == elfcpp::SHT_RELA);
+
+  gold::scan_relocatable_relocs<size, big_endian, Scan_relocatable_relocs>(
+    symtab,
+    layout,
+    object,
+    data_shndx,
+    prelocs,
+    reloc_count,
+    output_section,
+    needs_special_offset_handling,
+    local_symbol_count,
+    plocal_symbols,
+    rr);
+}
+
+// Scan the relocs for --emit-relocs.
+
+template<int size, bool big_endian>
+void
+Target_nds32<size, big_endian>::emit_relocs_scan(
+    Symbol_table* symtab,
+    Layout* layout,
+    Sized_relobj_file<size, big_endian>* object,
+    unsigned int data_shndx,
+    unsigned int sh_type,
+    const unsigned char* prelocs,
+    size_t reloc_count,
+    Output_section* output_section,
+    bool needs_special_offset_handling,
+    size_t local_symbol_count,
+    const unsigned char* plocal_syms,
+    Relocatable_relocs* rr)
+{
+  typedef gold::Default_classify_reloc<elfcpp::SHT_RELA, size, big_endian>
+      Classify_reloc;
+  typedef gold::Default_emit_relocs_strategy<Classify_reloc>
+      Emit_relocs_strategy;
+
+  gold_assert(sh_type == elfcpp::SHT_RELA);
+
+  gold::scan_relocatable_relocs<size, big_endian, Emit_relocs_strategy>(
+    symtab,
+    layout,
+    object,
+    data_shndx,
+    prelocs,
+    reloc_count,
+    output_section,
+    needs_special_offset_handling,
+    local_symbol_count,
+    plocal_syms,
+    rr);
+}
+
+// Emit relocations for a section.
+
+template<int size, bool big_endian>
+void
+Target_nds32<size, big_endian>::relocate_relocs(
+    const Relocate_info<size, big_endian>* relinfo,
+    unsigned int sh_type,
+    const unsigned char* prelocs,
+    size_t reloc_count,
+    Output_section* output_section,
+    typename elfcpp::Elf_types<size>::Elf_Off offset_in_output_section,
+    unsigned char* view,
+    Address view_address,
+    section_size_type view_size,
+    unsigned char* reloc_view,
+    section_size_type reloc_view_size)
+{
+  typedef gold::Default_classify_reloc<elfcpp::SHT_RELA, size, big_endian>
+      Classify_reloc;
+
+  gold_assert(sh_type == elfcpp::SHT_RELA);
+
+  gold::relocate_relocs<size, big_endian, Classify_reloc>(
+    relinfo,
+    prelocs,
+    reloc_count,
+    output_section,
+    offset_in_output_section,
+    view,
+    view_address,
+    view_size,
+    reloc_view,
+    reloc_view_size);
+}
+
+// do_make_elf_object to override the same function in the base class.
+// We merge the nds32 e_flags of each input object here, following
+// nds32_elf_merge_private_bfd_data in BFD.
+
+template<int size, bool big_endian>
+Object*
+Target_nds32<size, big_endian>::do_make_elf_object(
+    const std::string& name,
+    Input_file* input_file,
+    off_t offset, const elfcpp::Ehdr<size, big_endian>& ehdr)
+{
+  elfcpp::Elf_Word flags = ehdr.get_e_flags();
+
+  // Objects with no flags, e.g. from "objcopy -B", are compatible
+  // with anything.
+  if (flags == 0)
+    ;
+  else if (!this->elf_flags_set_)
+    {
+      this->elf_flags_ = flags;
+      this->elf_flags_set_ = true;
+    }
+  else
+    {
+      const elfcpp::Elf_Word special = (elfcpp::E_NDS32_HAS_REDUCED_REGS
+					| elfcpp::E_NDS32_HAS_NO_MAC_INST
+					| elfcpp::E_NDS32_FPU_REG_CONF
+					| elfcpp::EF_NDS32_ELF_VERSION);
+      elfcpp::Elf_Word out_flags = this->elf_flags_;
+
+      if ((flags & elfcpp::EF_NDS_ABI) != (out_flags & elfcpp::EF_NDS_ABI))
+	gold_error(_("%s: ABI mismatch with previous modules"),
+		   name.c_str());
+      if ((flags & elfcpp::EF_NDS_ARCH) != (out_flags & elfcpp::EF_NDS_ARCH))
+	gold_error(_("%s: instruction set mismatch with previous modules"),
+		   name.c_str());
+
+      // Accumulate the extensions used.  The reduced register file
+      // and no-MAC flags only hold if every object has them, the FPU
+      // register configuration is the largest one used and the ELF
+      // version is the oldest one.
+      elfcpp::Elf_Word in_fpu = flags & elfcpp::E_NDS32_FPU_REG_CONF;
+      elfcpp::Elf_Word out_fpu = out_flags & elfcpp::E_NDS32_FPU_REG_CONF;
+      elfcpp::Elf_Word in_version = flags & elfcpp::EF_NDS32_ELF_VERSION;
+      elfcpp::Elf_Word out_version = out_flags & elfcpp::EF_NDS32_ELF_VERSION;
+      this->elf_flags_ = (((flags | out_flags) & ~special)
+			  | (flags & out_flags
+			     & (elfcpp::E_NDS32_HAS_REDUCED_REGS
+				| elfcpp::E_NDS32_HAS_NO_MAC_INST))
+			  | std::max(in_fpu, out_fpu)
+			  | std::min(in_version, out_version));
+    }
+
+  return Target::do_make_elf_object(name, input_file, offset, ehdr);
+}
+
+// Adjust ELF file header.
+
+template<int size, bool big_endian>
+void
+Target_nds32<size, big_endian>::do_adjust_elf_header(
+    unsigned char* view,
+    int len)
+{
+  elfcpp::Ehdr_write<size, big_endian> oehdr(view);
+
+  oehdr.put_e_flags(this->elf_flags_);
+
+  Sized_target<size, big_endian>::do_adjust_elf_header(view, len);
+}
+
+// The selector for nds32 object files.
+
+template<bool big_endian>
+class Target_selector_nds32 : public Target_selector
+{
+public:
+  Target_selector_nds32()
+    : Target_selector(elfcpp::EM_NDS32, 32, big_endian,
+		      (big_endian ? "elf32-nds32be" : "elf32-nds32le"),
+		      (big_endian ? "nds32belf" : "nds32elf"))
+  { }
+
+  virtual Target*
+  do_instantiate_target()
+  { return new Target_nds32<32, big_endian>(); }
+};
+
+Target_selector_nds32<false> target_selector_nds32le;
+Target_selector_nds32<true> target_selector_nds32be;
+
+} // End anonymous namespace.
@@ -0,0 +1,30 @@
+# nds32_sda.s -- test _SDA_BASE_ placement and small data relocs
+
+	.text
+	.globl	_start
+_start:
+	lwi.gp	$r0, [+w]
+	lhi.gp	$r1, [+h]
+	lbi.gp	$r2, [+b]
+	swi.gp	$r0, [+z]
+	lwi.gp	$r3, [+d]
+
+	.data
+	.align	2
+d:	.word	1
+	.space	0x1000
+
+	.section .sdata_w,"aw"
+	.align	2
+w:	.word	2
+
+	.section .sdata_h,"aw"
+	.align	1
+h:	.short	3
+
+	.section .sdata_b,"aw"
+b:	.byte	4
+
+	.section .sbss_w,"aw",@nobits
+	.align	2
+z:	.space	4
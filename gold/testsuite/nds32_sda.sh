@@ -0,0 +1,51 @@
+#!/bin/sh
+
+# nds32_sda.sh -- test _SDA_BASE_ placement and small data relocs
+
+# Copyright (C) 2019 Free Software Foundation, Inc.
+
+# This file is part of gold.
+
+# This program is free software; you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 3 of the License, or
+# (at your option) any later version.
+
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+
+# You should have received a copy of the GNU General Public License
+# along with this program; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin Street - Fifth Floor, Boston,
+# MA 02110-1301, USA.
+
+# nds32_sda.s has a 0x1004 byte .data section followed by the
+# .sdata_* and .sbss_w sections.  Like ld, gold should place
+# _SDA_BASE_ in .data, halfway between the start of .data and the
+# start of .sbss_w, rounded down to a multiple of 8 from the start
+# of .data.  A _SDA_BASE_ defined on the command line must be used
+# as is.
+
+match()
+{
+  if ! egrep "$1" "$2" >/dev/null 2>&1; then
+    echo 1>&2 "could not find '$1' in $2"
+    exit 1
+  fi
+}
+
+# .data is at 0x5000a8 and .sbss_w at 0x5010b4.
+match '^005008a8 g .* \.data	00000000 _SDA_BASE_$' nds32_sda.stdout
+match 'lwi\.gp	\$r0, \[ \+ #0x804\]$' nds32_sda.stdout
+match 'lhi\.gp	\$r1, \[ \+ #0x808\]$' nds32_sda.stdout
+match 'lbi\.gp	\$r2, \[ \+ #0x80a\]$' nds32_sda.stdout
+match 'swi\.gp	\$r0, \[ \+ #0x80c\]$' nds32_sda.stdout
+match 'lwi\.gp	\$r3, \[ \+ #-2048\]$' nds32_sda.stdout
+
+match '^00501000 g .* \*ABS\*	00000000 _SDA_BASE_$' nds32_sda_defsym.stdout
+match 'lwi\.gp	\$r0, \[ \+ #0xac\]$' nds32_sda_defsym.stdout
+match 'lwi\.gp	\$r3, \[ \+ #-3928\]$' nds32_sda_defsym.stdout
+
+exit 0
@@ -314,6 +314,7 @@ extern void disassemble_init_powerpc (struct disassemble_info *);
 extern void disassemble_init_s390 (struct disassemble_info *);
 extern void disassemble_init_wasm32 (struct disassemble_info *);
 extern void disassemble_init_nds32 (struct disassemble_info *);
+extern void disassemble_free_nds32 (struct disassemble_info *);
 extern const disasm_options_and_args_t *disassembler_options_arm (void);
 extern const disasm_options_and_args_t *disassembler_options_mips (void);
 extern const disasm_options_and_args_t *disassembler_options_powerpc (void);
@@ -330,6 +331,10 @@ extern disassembler_ftype disassembler (enum bfd_architecture arc,
    Should only be called after initialising the info->arch field.  */
 extern void disassemble_init_for_target (struct disassemble_info * dinfo);
 
+/* Release whatever the target disassembler allocated for DINFO, once
+   the caller is done disassembling with it.  */
+extern void disassemble_free_target (struct disassemble_info * dinfo);
+
 /* Document any target specific options available from the disassembler.  */
 extern void disassembler_usage (FILE *);
 
@@ -0,0 +1,45 @@
+/* This file defines the interface between the NDS32 simulator and GDB.
+
+   Copyright (C) 2019 Free Software Foundation, Inc.
+   Contributed by Andes Technology Corporation.
+
+   This file is part of GDB.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifndef SIM_NDS32_H
+#define SIM_NDS32_H
+
+/* Register numbers used by sim_fetch_register and sim_store_register.
+   The general purpose registers and the PC match GDB's own numbering
+   (see gdb/nds32-tdep.h).  */
+enum sim_nds32_regnum
+{
+  SIM_NDS32_R0_REGNUM = 0,
+  SIM_NDS32_FP_REGNUM = 28,	/* Frame pointer.  */
+  SIM_NDS32_GP_REGNUM = 29,	/* Global pointer.  */
+  SIM_NDS32_LP_REGNUM = 30,	/* Link pointer.  */
+  SIM_NDS32_SP_REGNUM = 31,	/* Stack pointer.  */
+  SIM_NDS32_PC_REGNUM = 32,	/* Program counter.  */
+
+  /* The user special registers holding the multiply/divide results.  */
+  SIM_NDS32_D0LO_REGNUM,
+  SIM_NDS32_D0HI_REGNUM,
+  SIM_NDS32_D1LO_REGNUM,
+  SIM_NDS32_D1HI_REGNUM,
+
+  SIM_NDS32_NUM_REGS
+};
+
+#endif /* SIM_NDS32_H */
@@ -0,0 +1,29 @@
+.text
+.global	_start
+_start:
+	beqz $r0, bar
+	jal foo
+.section .text.2, "ax"
+.global foo
+foo:
+	bnez $r0, .L2
+	beqz $r0, bar
+	call bar
+	ret
+.section .text.3, "ax"
+	beq $r0, $r1, .L2
+	bnez $r0, .L2
+bar:
+	beq $r0, $r1, .L3
+.L2:
+	nop
+.L3:
+	ret
+
+.data
+.global addr
+addr:
+	.word bar
+	.word .L3
+size:
+	.word .L3-bar
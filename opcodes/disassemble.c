@@ -681,6 +681,24 @@ disassemble_init_for_target (struct disassemble_info * info)
     }
 }
 
+void
+disassemble_free_target (struct disassemble_info * info)
+{
+  if (info == NULL)
+    return;
+
+  switch (info->arch)
+    {
+#ifdef ARCH_nds32
+    case bfd_arch_nds32:
+      disassemble_free_nds32 (info);
+      break;
+#endif
+    default:
+      break;
+    }
+}
+
 /* Remove whitespace and consecutive commas from OPTIONS.  */
 
 char *
@@ -28,7 +28,6 @@
 #include "libiberty.h"
 #include "opintl.h"
 #include "bfd_stdint.h"
-#include "hashtab.h"
 #include "nds32-asm.h"
 #include "opcode/nds32.h"
 
@@ -46,6 +45,16 @@ enum map_type
   MAP_CODE,
 };
 
+/* One mapping symbol of the section being disassembled.  */
+struct nds32_map_entry
+{
+  bfd_vma addr;
+  enum map_type type;
+  /* Index in the symbol table, to keep the symbol table order of
+     mapping symbols at the same address.  */
+  int index;
+};
+
 struct nds32_private_data
 {
   /* Whether any mapping symbols are present in the provided symbol
@@ -58,6 +67,19 @@ struct nds32_private_data
   /* Tracking symbol table information.  */
   int last_symbol_index;
   bfd_vma last_addr;
+
+  /* Mapping symbols of the section being disassembled sorted by
+     address, built once per section so that the mapping type at any
+     address is found by binary search.  MAP_SECTION_ID is the id of
+     the section, which unlike its address is never reused by another
+     section, even of another BFD.  MAP_SYMTAB and MAP_SYMTAB_SIZE
+     identify the symbol table the index was built from.  The index is
+     freed by disassemble_free_nds32.  */
+  struct nds32_map_entry *map;
+  int map_count;
+  unsigned int map_section_id;
+  asymbol **map_symtab;
+  int map_symtab_size;
 };
 
 /* Default text to print if an instruction isn't recognized.  */
@@ -77,6 +99,7 @@ static void print_insn16 (bfd_vma pc, disassemble_info *info,
 static void print_insn32 (bfd_vma pc, disassemble_info *info, uint32_t insn,
 			  uint32_t parse_mode);
 static uint32_t nds32_mask_opcode (uint32_t);
+static struct nds32_opcode *nds32_find_opcode (uint32_t);
 static void nds32_special_opcode (uint32_t, struct nds32_opcode **);
 static int get_mapping_symbol_type (struct disassemble_info *, int,
 				    enum map_type *);
@@ -95,9 +118,26 @@ struct objdump_disasm_info
   arelent *          reloc;
 };
 
-/* Hash function for disassemble.  */
+/* Opcode decode index for disassemble.
+
+   Every opcode base value is kept once in OPCODE_INDEX, sorted by
+   value, with forms sharing a value chained through `next' in table
+   order.  OPCODE_BUCKET[B] is the first slot whose value has B as its
+   high bits, so a lookup only binary-searches the few slots of one
+   bucket.  Both are built once by disassemble_init_nds32.  */
+
+struct nds32_opcode_slot
+{
+  uint32_t value;
+  unsigned seq;
+  opcode_t *opc;
+};
+
+#define NDS32_OPCODE_BUCKET_SHIFT 20
+#define NDS32_OPCODE_BUCKET_COUNT (1u << (31 - NDS32_OPCODE_BUCKET_SHIFT))
 
-static htab_t opcode_htab;
+static struct nds32_opcode_slot *opcode_index;
+static unsigned opcode_bucket[NDS32_OPCODE_BUCKET_COUNT + 1];
 
 /* Find the value map register name.  */
 
@@ -595,7 +635,7 @@ print_insn32 (bfd_vma pc, disassemble_info *info, uint32_t insn,
   /* Get the final correct opcode and parse.  */
   struct nds32_opcode *opc;
   uint32_t opcode = nds32_mask_opcode (insn);
-  opc = (struct nds32_opcode *) htab_find (opcode_htab, &opcode);
+  opc = nds32_find_opcode (opcode);
 
   nds32_special_opcode (insn, &opc);
   nds32_filter_unknown_insn (insn, &opc);
@@ -671,28 +711,13 @@ print_insn16 (bfd_vma pc, disassemble_info *info,
       break;
     }
   opcode = insn & mask;
-  opc = (struct nds32_opcode *) htab_find (opcode_htab, &opcode);
+  opc = nds32_find_opcode (opcode);
 
   nds32_special_opcode (insn, &opc);
   /* Get the final correct opcode and parse it.  */
   nds32_parse_opcode (opc, pc, info, insn, parse_mode);
 }
 
-static hashval_t
-htab_hash_hash (const void *p)
-{
-  return (*(unsigned int *) p) % 49;
-}
-
-static int
-htab_hash_eq (const void *p, const void *q)
-{
-  uint32_t pinsn = ((struct nds32_opcode *) p)->value;
-  uint32_t qinsn = *((uint32_t *) q);
-
-  return (pinsn == qinsn);
-}
-
 /* Get the format of instruction.  */
 
 static uint32_t
@@ -985,6 +1010,90 @@ nds32_special_opcode (uint32_t insn, struct nds32_opcode **opc)
     }
 }
 
+/* Compare two mapping symbol entries by address, then by symbol table
+   index.  */
+
+static int
+nds32_map_entry_compare (const void *a, const void *b)
+{
+  const struct nds32_map_entry *ea = (const struct nds32_map_entry *) a;
+  const struct nds32_map_entry *eb = (const struct nds32_map_entry *) b;
+
+  if (ea->addr != eb->addr)
+    return ea->addr < eb->addr ? -1 : 1;
+  return ea->index - eb->index;
+}
+
+/* Build the sorted mapping symbol index of the section being
+   disassembled, unless it is already up to date.  */
+
+static void
+nds32_build_map_index (struct nds32_private_data *private_data,
+		       disassemble_info *info)
+{
+  enum map_type type;
+  int n, count;
+
+  if (private_data->map_symtab != NULL
+      && private_data->map_section_id == info->section->id
+      && private_data->map_symtab == info->symtab
+      && private_data->map_symtab_size == info->symtab_size)
+    return;
+
+  free (private_data->map);
+  private_data->map = NULL;
+  private_data->map_count = 0;
+  private_data->map_section_id = info->section->id;
+  private_data->map_symtab = info->symtab;
+  private_data->map_symtab_size = info->symtab_size;
+
+  count = 0;
+  for (n = 0; n < info->symtab_size; n++)
+    if (get_mapping_symbol_type (info, n, &type))
+      count++;
+
+  if (count == 0)
+    return;
+
+  private_data->map = (struct nds32_map_entry *)
+    xmalloc (count * sizeof (struct nds32_map_entry));
+
+  for (n = 0; n < info->symtab_size; n++)
+    if (get_mapping_symbol_type (info, n, &type))
+      {
+	struct nds32_map_entry *e;
+
+	e = &private_data->map[private_data->map_count++];
+	e->addr = bfd_asymbol_value (info->symtab[n]);
+	e->type = type;
+	e->index = n;
+      }
+
+  qsort (private_data->map, private_data->map_count,
+	 sizeof (struct nds32_map_entry), nds32_map_entry_compare);
+}
+
+/* Return the index in the mapping symbol index of the first mapping
+   symbol whose address is greater than PC.  */
+
+static int
+nds32_map_upper_bound (struct nds32_private_data *private_data, bfd_vma pc)
+{
+  int lo = 0, hi = private_data->map_count;
+
+  while (lo < hi)
+    {
+      int mid = lo + (hi - lo) / 2;
+
+      if (private_data->map[mid].addr <= pc)
+	lo = mid + 1;
+      else
+	hi = mid;
+    }
+
+  return lo;
+}
+
 int
 print_insn_nds32 (bfd_vma pc, disassemble_info *info)
 {
@@ -994,11 +1103,8 @@ print_insn_nds32 (bfd_vma pc, disassemble_info *info)
   long long given;
   long long given1;
   uint32_t insn;
-  int n;
-  int last_symbol_index = -1;
-  bfd_vma addr;
+  int next_map = -1;
   int is_data = FALSE;
-  bfd_boolean found = FALSE;
   struct nds32_private_data *private_data;
   unsigned int size = 16;
   enum map_type mapping_type = MAP_CODE;
@@ -1014,61 +1120,32 @@ print_insn_nds32 (bfd_vma pc, disassemble_info *info)
     }
   private_data = info->private_data;
 
-  if (info->symtab_size != 0)
+  if (info->symtab_size != 0
+      && strncmp (".text", info->section->name, 5) == 0)
     {
-      int start;
-      if (pc == 0)
-	start = 0;
-      else
-	{
-	  start = info->symtab_pos;
-	  if (start < private_data->last_symbol_index)
-	    start = private_data->last_symbol_index;
-	}
-
-      if (0 > start)
-	start = 0;
+      nds32_build_map_index (private_data, info);
 
-      if (private_data->has_mapping_symbols != 0
-	  && ((strncmp (".text", info->section->name, 5) == 0)))
+      if (private_data->map_count != 0)
 	{
-	  for (n = start; n < info->symtab_size; n++)
-	    {
-	      addr = bfd_asymbol_value (info->symtab[n]);
-	      if (addr > pc)
-		break;
-	      if (get_mapping_symbol_type (info, n, &mapping_type))
-		{
-		  last_symbol_index = n;
-		  found = TRUE;
-		}
-	    }
-
-	  if (found)
-	    private_data->has_mapping_symbols = 1;
-	  else if (!found && private_data->has_mapping_symbols == -1)
+	  /* The last mapping symbol at or before PC decides the type.  */
+	  next_map = nds32_map_upper_bound (private_data, pc);
+	  if (next_map > 0)
 	    {
-	      /* Make sure there are no any mapping symbol.  */
-	      for (n = 0; n < info->symtab_size; n++)
-		{
-		  if (is_mapping_symbol (info, n, &mapping_type))
-		    {
-		      private_data->has_mapping_symbols = -1;
-		      break;
-		    }
-		}
-	      if (private_data->has_mapping_symbols == -1)
-		private_data->has_mapping_symbols = 0;
+	      mapping_type = private_data->map[next_map - 1].type;
+	      private_data->last_symbol_index
+		= private_data->map[next_map - 1].index;
 	    }
-
-	  private_data->last_symbol_index = last_symbol_index;
-	  private_data->last_mapping_type = mapping_type;
-	  is_data = (private_data->last_mapping_type == MAP_DATA0
-		     || private_data->last_mapping_type == MAP_DATA1
-		     || private_data->last_mapping_type == MAP_DATA2
-		     || private_data->last_mapping_type == MAP_DATA3
-		     || private_data->last_mapping_type == MAP_DATA4);
+	  private_data->has_mapping_symbols = 1;
 	}
+      else
+	private_data->has_mapping_symbols = 0;
+
+      private_data->last_mapping_type = mapping_type;
+      is_data = (mapping_type == MAP_DATA0
+		 || mapping_type == MAP_DATA1
+		 || mapping_type == MAP_DATA2
+		 || mapping_type == MAP_DATA3
+		 || mapping_type == MAP_DATA4);
     }
 
   /* Wonder data or instruction.  */
@@ -1078,7 +1155,7 @@ print_insn_nds32 (bfd_vma pc, disassemble_info *info)
 
       /* Fix corner case: there is no next mapping symbol,
 	 let mapping type decides size */
-      if (last_symbol_index + 1 >= info->symtab_size)
+      if (next_map >= private_data->map_count)
 	{
 	  if (mapping_type == MAP_DATA0)
 	    size = 1;
@@ -1091,21 +1168,9 @@ print_insn_nds32 (bfd_vma pc, disassemble_info *info)
 	  if (mapping_type == MAP_DATA4)
 	    size = 16;
 	}
-      for (n = last_symbol_index + 1; n < info->symtab_size; n++)
-	{
-	  addr = bfd_asymbol_value (info->symtab[n]);
-
-	  enum map_type fake_mapping_type;
-	  if (get_mapping_symbol_type (info, n, &fake_mapping_type)
-	      && (addr > pc
-		  && ((info->section == NULL)
-		      || (info->section == info->symtab[n]->section)))
-	      && (addr - pc < size))
-	    {
-	      size = addr - pc;
-	      break;
-	    }
-	}
+      else if (private_data->map[next_map].addr - pc < size)
+	/* The next mapping symbol ends this data.  */
+	size = private_data->map[next_map].addr - pc;
 
       if (size == 3)
 	size = (pc & 1) ? 1 : 2;
@@ -1214,46 +1279,120 @@ nds32_symbol_is_valid (asymbol *sym,
   return TRUE;
 }
 
+/* Order opcodes by base value, keeping table order for equal values.  */
+
+static int
+nds32_opcode_compare (const void *a, const void *b)
+{
+  const struct nds32_opcode_slot *sa = (const struct nds32_opcode_slot *) a;
+  const struct nds32_opcode_slot *sb = (const struct nds32_opcode_slot *) b;
+
+  if (sa->value != sb->value)
+    return sa->value < sb->value ? -1 : 1;
+  return sa->seq < sb->seq ? -1 : sa->seq > sb->seq;
+}
+
+/* Build OPCODE_INDEX and OPCODE_BUCKET from all the opcode tables.  */
+
 static void
-nds32_add_opcode_hash_table (unsigned indx)
+nds32_build_opcode_index (void)
 {
+  unsigned count = 0, n = 0, i, k, b;
   opcode_t *opc;
 
-  opc = nds32_opcode_table[indx];
-  if (opc == NULL)
-    return;
+  for (k = 0; k < NDS32_CORE_COUNT; k++)
+    for (opc = nds32_opcode_table[k]; opc && opc->opcode; opc++)
+      count++;
 
-  while (opc->opcode != NULL)
-    {
-      opcode_t **slot;
+  opcode_index = (struct nds32_opcode_slot *)
+    xmalloc ((count + 1) * sizeof (*opcode_index));
+  for (k = 0; k < NDS32_CORE_COUNT; k++)
+    for (opc = nds32_opcode_table[k]; opc && opc->opcode; opc++)
+      {
+	opcode_index[n].value = opc->value;
+	opcode_index[n].seq = n;
+	opcode_index[n].opc = opc;
+	n++;
+      }
+  qsort (opcode_index, count, sizeof (*opcode_index), nds32_opcode_compare);
 
-      slot = (opcode_t **) htab_find_slot
-	(opcode_htab, &opc->value, INSERT);
-      if (*slot == NULL)
-	{
-	  /* This is the new one.  */
-	  *slot = opc;
-	}
-      else
+  /* Chain the forms sharing a value and keep only the first one.  */
+  n = 0;
+  for (i = 0; i < count; i++)
+    {
+      if (n > 0 && opcode_index[n - 1].value == opcode_index[i].value)
 	{
-	  opcode_t *tmp;
+	  opcode_t *tmp = opcode_index[n - 1].opc;
 
-	  /* Already exists.  Append to the list.  */
-	  tmp = *slot;
 	  while (tmp->next)
 	    tmp = tmp->next;
-	  tmp->next = opc;
-	  opc->next = NULL;
+	  tmp->next = opcode_index[i].opc;
+	  opcode_index[i].opc->next = NULL;
 	}
-      opc++;
+      else
+	opcode_index[n++] = opcode_index[i];
+    }
+
+  /* Values never have bit 31 set; nds32_mask_opcode uses that for an
+     unknown instruction.  */
+  i = 0;
+  for (b = 0; b <= NDS32_OPCODE_BUCKET_COUNT; b++)
+    {
+      while (i < n
+	     && (opcode_index[i].value >> NDS32_OPCODE_BUCKET_SHIFT) < b)
+	i++;
+      opcode_bucket[b] = i;
+    }
+}
+
+/* Find the first form of the opcode whose base value is VALUE.  */
+
+static struct nds32_opcode *
+nds32_find_opcode (uint32_t value)
+{
+  uint32_t b = value >> NDS32_OPCODE_BUCKET_SHIFT;
+  unsigned lo, hi;
+
+  if (b >= NDS32_OPCODE_BUCKET_COUNT)
+    return NULL;
+
+  lo = opcode_bucket[b];
+  hi = opcode_bucket[b + 1];
+  while (lo < hi)
+    {
+      unsigned mid = lo + (hi - lo) / 2;
+
+      if (opcode_index[mid].value < value)
+	lo = mid + 1;
+      else
+	hi = mid;
     }
+  if (lo < opcode_bucket[b + 1] && opcode_index[lo].value == value)
+    return opcode_index[lo].opc;
+  return NULL;
+}
+
+/* Free the mapping symbol index print_insn_nds32 built for INFO.  */
+
+void
+disassemble_free_nds32 (struct disassemble_info *info)
+{
+  struct nds32_private_data *private_data = info->private_data;
+
+  if (private_data == NULL)
+    return;
+
+  free (private_data->map);
+  private_data->map = NULL;
+  private_data->map_count = 0;
+  private_data->map_symtab = NULL;
+  private_data->map_symtab_size = 0;
 }
 
 void
 disassemble_init_nds32 (struct disassemble_info *info)
 {
   static unsigned init_done = 0;
-  unsigned k;
 
   /* Set up symbol checking function.  */
   info->symbol_is_valid = nds32_symbol_is_valid;
@@ -1269,15 +1408,8 @@ disassemble_init_nds32 (struct disassemble_info *info)
   nds32_opcode_table[NDS32_MAIN_CORE] = &nds32_opcodes[0];
   nds32_field_table[NDS32_MAIN_CORE] = &operand_fields[0];
 
-  /* Build opcode table.  */
-  opcode_htab = htab_create_alloc (1024, htab_hash_hash, htab_hash_eq,
-				   NULL, xcalloc, free);
-
-  for (k = 0; k < NDS32_CORE_COUNT; k++)
-    {
-      /* Add op-codes.  */
-      nds32_add_opcode_hash_table (k);
-    }
+  /* Build opcode decode index.  */
+  nds32_build_opcode_index ();
 
   init_done = 1;
 }
@@ -1291,6 +1423,9 @@ is_mapping_symbol (struct disassemble_info *info, int n,
   /* Get symbol name.  */
   name = bfd_asymbol_name (info->symtab[n]);
 
+  if (name[0] != '$')
+    return FALSE;
+
   if (name[1] == 'c')
     {
       *map_type = MAP_CODE;
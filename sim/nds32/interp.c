@@ -0,0 +1,1280 @@
+/* Simulator for the NDS32 processor
+
+   Copyright (C) 2019 Free Software Foundation, Inc.
+   Contributed by Andes Technology Corporation.
+
+   This file is part of simulators.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#include "config.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "bfd.h"
+#include "gdb/callback.h"
+#include "libiberty.h"
+#include "gdb/remote-sim.h"
+
+#include "sim-main.h"
+#include "sim-options.h"
+#include "sim-syscall.h"
+
+#include "opcode/nds32.h"
+#include "elf-bfd.h"
+#include "elf32-nds32.h"
+
+/* The simulator covers the NDS32 V3 base instruction set, the
+   performance extension, the 16-bit extension and the multiply/divide
+   instructions working on the user special registers D0 and D1.
+
+   Instructions are not interpreted straight from memory.  The first
+   time an address is executed, the instruction there is decoded into
+   a struct nds32_insn holding its semantic routine and pre-extracted
+   operands, and put into a direct-mapped cache indexed by address.
+   Later executions only pay for the cache lookup and the semantic
+   routine itself.  16-bit instructions are widened to their 32-bit
+   counterparts at decode time, so that they share the 32-bit
+   semantic routines.  */
+
+#define DEFAULT_MEM_SIZE (64 * 1024 * 1024)
+
+#define GPR(n)		(cpu->state.regs[n])
+#define RT		GPR (in->rt)
+#define RA		GPR (in->ra)
+#define RB		GPR (in->rb)
+#define RD		GPR (in->rd)
+#define USR(n)		(cpu->state.usr[n])
+#define NEXT_PC		(pc + in->len)
+
+#define SEM(name) \
+  static sim_cia \
+  sem_##name (SIM_CPU *cpu ATTRIBUTE_UNUSED, \
+	      const struct nds32_insn *in ATTRIBUTE_UNUSED, \
+	      sim_cia pc)
+
+/* Invalidate the whole predecode cache.  */
+
+static void
+nds32_scache_flush (SIM_CPU *cpu)
+{
+  if (++cpu->state.scache_gen == 0)
+    {
+      /* The generation wrapped around; stale entries could match
+	 again, so really clear them.  */
+      memset (cpu->state.scache, 0, sizeof (cpu->state.scache));
+      cpu->state.scache_gen = 1;
+    }
+  cpu->state.code_lo = (uint32_t) -1;
+  cpu->state.code_hi = 0;
+}
+
+static uint32_t
+nds32_load (SIM_CPU *cpu, sim_cia pc, int size, uint32_t addr)
+{
+  switch (size)
+    {
+    case 1:
+      return sim_core_read_aligned_1 (cpu, pc, read_map, addr);
+    case 2:
+      return sim_core_read_aligned_2 (cpu, pc, read_map, addr);
+    default:
+      return sim_core_read_aligned_4 (cpu, pc, read_map, addr);
+    }
+}
+
+static void
+nds32_store (SIM_CPU *cpu, sim_cia pc, int size, uint32_t addr, uint32_t v)
+{
+  switch (size)
+    {
+    case 1:
+      sim_core_write_aligned_1 (cpu, pc, write_map, addr, v);
+      break;
+    case 2:
+      sim_core_write_aligned_2 (cpu, pc, write_map, addr, v);
+      break;
+    default:
+      sim_core_write_aligned_4 (cpu, pc, write_map, addr, v);
+      break;
+    }
+
+  /* Self-modifying code.  */
+  if (addr < cpu->state.code_hi && addr + size > cpu->state.code_lo)
+    nds32_scache_flush (cpu);
+}
+
+/* Load or store multiple words.  The registers RB to RE, followed by
+   those selected by ENABLE4 ($fp, $gp, $lp, $sp from bit 3 down to
+   bit 0), are transferred in ascending order from or to ascending
+   addresses around the base register RA.  RB = RE = $sp is an empty
+   range.  ABDIM are the before/after, increment/decrement and modify
+   flags, encoded like the N32_LSMW_* values.  */
+
+static void
+nds32_lsmw (SIM_CPU *cpu, sim_cia pc, int store_p, int ra, int rb, int re,
+	    int enable4, int abdim)
+{
+  int regs[32 + 4];
+  int i, n = 0;
+  uint32_t base = GPR (ra);
+  uint32_t addr;
+
+  if (!(rb == NDS32_HARD_SP && re == NDS32_HARD_SP))
+    for (i = rb; i <= re; i++)
+      regs[n++] = i;
+  for (i = 3; i >= 0; i--)
+    if (enable4 & (1 << i))
+      regs[n++] = NDS32_HARD_SP - i;
+
+  if (abdim & 2)
+    addr = base - (n - 1) * 4 - ((abdim & 4) ? 4 : 0);
+  else
+    addr = base + ((abdim & 4) ? 4 : 0);
+
+  for (i = 0; i < n; i++, addr += 4)
+    {
+      if (store_p)
+	nds32_store (cpu, pc, 4, addr, GPR (regs[i]));
+      else
+	GPR (regs[i]) = nds32_load (cpu, pc, 4, addr);
+    }
+
+  if (abdim & 1)
+    GPR (ra) = (abdim & 2) ? base - n * 4 : base + n * 4;
+}
+
+static uint32_t
+nds32_ror (uint32_t v, int n)
+{
+  n &= 31;
+  return n == 0 ? v : (v >> n) | (v << (32 - n));
+}
+
+static uint64_t
+nds32_get_d (SIM_CPU *cpu, int dt)
+{
+  return ((uint64_t) USR (dt + 1) << 32) | USR (dt);
+}
+
+static void
+nds32_set_d (SIM_CPU *cpu, int dt, uint64_t v)
+{
+  USR (dt) = (uint32_t) v;
+  USR (dt + 1) = (uint32_t) (v >> 32);
+}
+
+/* Write a 64-bit result into the register pair starting at the even
+   register RT.  The word order follows the data byte order.  */
+
+static void
+nds32_set_pair (SIM_CPU *cpu, int rt, uint64_t v)
+{
+  int lo = CURRENT_TARGET_BYTE_ORDER == BFD_ENDIAN_BIG ? 1 : 0;
+
+  GPR (rt + lo) = (uint32_t) v;
+  GPR (rt + (lo ^ 1)) = (uint32_t) (v >> 32);
+}
+
+/* Unknown or unsupported instructions.  */
+
+SEM (illegal)
+{
+  SIM_DESC sd = CPU_STATE (cpu);
+
+  sim_engine_halt (sd, cpu, NULL, pc, sim_signalled, SIM_SIGILL);
+  return pc;
+}
+
+SEM (nop)
+{
+  return NEXT_PC;
+}
+
+/* Immediate ALU operations.  */
+
+SEM (addi)	{ RT = RA + in->imm; return NEXT_PC; }
+SEM (subri)	{ RT = in->imm - RA; return NEXT_PC; }
+SEM (andi)	{ RT = RA & in->imm; return NEXT_PC; }
+SEM (ori)	{ RT = RA | in->imm; return NEXT_PC; }
+SEM (xori)	{ RT = RA ^ in->imm; return NEXT_PC; }
+SEM (bitci)	{ RT = RA & ~in->imm; return NEXT_PC; }
+SEM (slti)	{ RT = RA < (uint32_t) in->imm; return NEXT_PC; }
+SEM (sltsi)	{ RT = (int32_t) RA < in->imm; return NEXT_PC; }
+SEM (movi)	{ RT = in->imm; return NEXT_PC; }
+
+/* ALU1 operations.  */
+
+SEM (add)	{ RT = RA + (RB << in->sh); return NEXT_PC; }
+SEM (sub)	{ RT = RA - (RB << in->sh); return NEXT_PC; }
+SEM (and)	{ RT = RA & (RB << in->sh); return NEXT_PC; }
+SEM (xor)	{ RT = RA ^ (RB << in->sh); return NEXT_PC; }
+SEM (or)	{ RT = RA | (RB << in->sh); return NEXT_PC; }
+SEM (add_srli)	{ RT = RA + (RB >> in->sh); return NEXT_PC; }
+SEM (sub_srli)	{ RT = RA - (RB >> in->sh); return NEXT_PC; }
+SEM (and_srli)	{ RT = RA & (RB >> in->sh); return NEXT_PC; }
+SEM (xor_srli)	{ RT = RA ^ (RB >> in->sh); return NEXT_PC; }
+SEM (or_srli)	{ RT = RA | (RB >> in->sh); return NEXT_PC; }
+SEM (nor)	{ RT = ~(RA | RB); return NEXT_PC; }
+SEM (slt)	{ RT = RA < RB; return NEXT_PC; }
+SEM (slts)	{ RT = (int32_t) RA < (int32_t) RB; return NEXT_PC; }
+SEM (slli)	{ RT = RA << in->sh; return NEXT_PC; }
+SEM (srli)	{ RT = RA >> in->sh; return NEXT_PC; }
+SEM (srai)	{ RT = (int32_t) RA >> in->sh; return NEXT_PC; }
+SEM (rotri)	{ RT = nds32_ror (RA, in->sh); return NEXT_PC; }
+SEM (sll)	{ RT = RA << (RB & 31); return NEXT_PC; }
+SEM (srl)	{ RT = RA >> (RB & 31); return NEXT_PC; }
+SEM (sra)	{ RT = (int32_t) RA >> (RB & 31); return NEXT_PC; }
+SEM (rotr)	{ RT = nds32_ror (RA, RB); return NEXT_PC; }
+SEM (seb)	{ RT = (int8_t) RA; return NEXT_PC; }
+SEM (seh)	{ RT = (int16_t) RA; return NEXT_PC; }
+SEM (zeh)	{ RT = (uint16_t) RA; return NEXT_PC; }
+SEM (bitc)	{ RT = RA & ~RB; return NEXT_PC; }
+SEM (cmovz)	{ if (RB == 0) RT = RA; return NEXT_PC; }
+SEM (cmovn)	{ if (RB != 0) RT = RA; return NEXT_PC; }
+
+SEM (wsbh)
+{
+  RT = ((RA & 0x00ff00ff) << 8) | ((RA >> 8) & 0x00ff00ff);
+  return NEXT_PC;
+}
+
+SEM (sva)
+{
+  int32_t a = RA, b = RB, r = (uint32_t) a + (uint32_t) b;
+
+  RT = ((a ^ r) & (b ^ r)) >> 31 & 1;
+  return NEXT_PC;
+}
+
+SEM (svs)
+{
+  int32_t a = RA, b = RB, r = (uint32_t) a - (uint32_t) b;
+
+  RT = ((a ^ b) & (a ^ r)) >> 31 & 1;
+  return NEXT_PC;
+}
+
+/* Division.  The remainder is written first so that the quotient
+   wins when RT and RD are the same register.  */
+
+SEM (divsr)
+{
+  int32_t a = RA, b = RB;
+
+  if (b == 0)
+    sim_engine_halt (CPU_STATE (cpu), cpu, NULL, pc, sim_signalled,
+		     SIM_SIGFPE);
+  if (b == -1)
+    {
+      RD = 0;
+      RT = - (uint32_t) a;
+    }
+  else
+    {
+      RD = a % b;
+      RT = a / b;
+    }
+  return NEXT_PC;
+}
+
+SEM (divr)
+{
+  uint32_t a = RA, b = RB;
+
+  if (b == 0)
+    sim_engine_halt (CPU_STATE (cpu), cpu, NULL, pc, sim_signalled,
+		     SIM_SIGFPE);
+  RD = a % b;
+  RT = a / b;
+  return NEXT_PC;
+}
+
+/* ALU2 performance extension.  */
+
+SEM (max)	{ RT = (int32_t) RA > (int32_t) RB ? RA : RB; return NEXT_PC; }
+SEM (min)	{ RT = (int32_t) RA < (int32_t) RB ? RA : RB; return NEXT_PC; }
+SEM (bset)	{ RT = RA | (1u << in->sh); return NEXT_PC; }
+SEM (bclr)	{ RT = RA & ~(1u << in->sh); return NEXT_PC; }
+SEM (btgl)	{ RT = RA ^ (1u << in->sh); return NEXT_PC; }
+SEM (btst)	{ RT = (RA >> in->sh) & 1; return NEXT_PC; }
+
+SEM (ave)
+{
+  RT = (uint32_t) (((int64_t) (int32_t) RA + (int32_t) RB + 1) >> 1);
+  return NEXT_PC;
+}
+
+SEM (abs)
+{
+  int32_t a = RA;
+
+  if (a == INT32_MIN)
+    RT = INT32_MAX;
+  else
+    RT = a < 0 ? -a : a;
+  return NEXT_PC;
+}
+
+SEM (clips)
+{
+  int32_t a = RA;
+  int32_t hi = (int32_t) ((1u << in->sh) - 1);
+  int32_t lo = -hi - 1;
+
+  RT = a > hi ? hi : a < lo ? lo : a;
+  return NEXT_PC;
+}
+
+SEM (clip)
+{
+  int32_t a = RA;
+  int32_t hi = (int32_t) ((1u << in->sh) - 1);
+
+  RT = a > hi ? hi : a < 0 ? 0 : a;
+  return NEXT_PC;
+}
+
+SEM (clz)
+{
+  uint32_t a = RA;
+  int n = 0;
+
+  for (n = 0; n < 32 && !(a & 0x80000000); n++)
+    a <<= 1;
+  RT = n;
+  return NEXT_PC;
+}
+
+SEM (clo)
+{
+  uint32_t a = RA;
+  int n = 0;
+
+  for (n = 0; n < 32 && (a & 0x80000000); n++)
+    a <<= 1;
+  RT = n;
+  return NEXT_PC;
+}
+
+/* User special registers and multiply/divide.  IN->SH selects the user
+   special register, and IN->RD the D0/D1 pair for the DT forms.  */
+
+SEM (mfusr)
+{
+  RT = in->sh == 31 ? pc : USR (in->sh);
+  return NEXT_PC;
+}
+
+SEM (mtusr)
+{
+  if (in->sh == 31)
+    return RT;
+  USR (in->sh) = RT;
+  return NEXT_PC;
+}
+
+SEM (mul)	{ RT = RA * RB; return NEXT_PC; }
+SEM (mult32)	{ USR (in->rd) = RA * RB; return NEXT_PC; }
+SEM (madd32)	{ USR (in->rd) += RA * RB; return NEXT_PC; }
+SEM (msub32)	{ USR (in->rd) -= RA * RB; return NEXT_PC; }
+SEM (maddr32)	{ RT += RA * RB; return NEXT_PC; }
+SEM (msubr32)	{ RT -= RA * RB; return NEXT_PC; }
+
+#define SMUL64 ((int64_t) (int32_t) RA * (int32_t) RB)
+#define UMUL64 ((uint64_t) RA * RB)
+
+SEM (mults64)
+{
+  nds32_set_d (cpu, in->rd, SMUL64);
+  return NEXT_PC;
+}
+
+SEM (mult64)
+{
+  nds32_set_d (cpu, in->rd, UMUL64);
+  return NEXT_PC;
+}
+
+SEM (madds64)
+{
+  nds32_set_d (cpu, in->rd, nds32_get_d (cpu, in->rd) + SMUL64);
+  return NEXT_PC;
+}
+
+SEM (madd64)
+{
+  nds32_set_d (cpu, in->rd, nds32_get_d (cpu, in->rd) + UMUL64);
+  return NEXT_PC;
+}
+
+SEM (msubs64)
+{
+  nds32_set_d (cpu, in->rd, nds32_get_d (cpu, in->rd) - SMUL64);
+  return NEXT_PC;
+}
+
+SEM (msub64)
+{
+  nds32_set_d (cpu, in->rd, nds32_get_d (cpu, in->rd) - UMUL64);
+  return NEXT_PC;
+}
+
+SEM (mulsr64)
+{
+  nds32_set_pair (cpu, in->rt, SMUL64);
+  return NEXT_PC;
+}
+
+SEM (mulr64)
+{
+  nds32_set_pair (cpu, in->rt, UMUL64);
+  return NEXT_PC;
+}
+
+SEM (divs)
+{
+  int32_t a = RA, b = RB;
+
+  if (b == 0)
+    sim_engine_halt (CPU_STATE (cpu), cpu, NULL, pc, sim_signalled,
+		     SIM_SIGFPE);
+  if (b == -1)
+    {
+      USR (in->rd) = - (uint32_t) a;
+      USR (in->rd + 1) = 0;
+    }
+  else
+    {
+      USR (in->rd) = a / b;
+      USR (in->rd + 1) = a % b;
+    }
+  return NEXT_PC;
+}
+
+SEM (div)
+{
+  uint32_t a = RA, b = RB;
+
+  if (b == 0)
+    sim_engine_halt (CPU_STATE (cpu), cpu, NULL, pc, sim_signalled,
+		     SIM_SIGFPE);
+  USR (in->rd) = a / b;
+  USR (in->rd + 1) = a % b;
+  return NEXT_PC;
+}
+
+/* Loads and stores.  Each comes in four flavours: immediate offset,
+   immediate post-increment (.bi), register offset, and register
+   post-increment.  For the immediate forms IN->IMM is already scaled;
+   for the register forms IN->SH is the shift applied to RB.  */
+
+#define DEF_LOAD(name, size, type) \
+  SEM (name##i) \
+  { \
+    RT = (type) nds32_load (cpu, pc, size, RA + in->imm); \
+    return NEXT_PC; \
+  } \
+  SEM (name##i_bi) \
+  { \
+    uint32_t addr = RA; \
+    RT = (type) nds32_load (cpu, pc, size, addr); \
+    RA = addr + in->imm; \
+    return NEXT_PC; \
+  } \
+  SEM (name) \
+  { \
+    RT = (type) nds32_load (cpu, pc, size, RA + (RB << in->sh)); \
+    return NEXT_PC; \
+  } \
+  SEM (name##_bi) \
+  { \
+    uint32_t addr = RA, inc = RB << in->sh; \
+    RT = (type) nds32_load (cpu, pc, size, addr); \
+    RA = addr + inc; \
+    return NEXT_PC; \
+  }
+
+#define DEF_STORE(name, size) \
+  SEM (name##i) \
+  { \
+    nds32_store (cpu, pc, size, RA + in->imm, RT); \
+    return NEXT_PC; \
+  } \
+  SEM (name##i_bi) \
+  { \
+    nds32_store (cpu, pc, size, RA, RT); \
+    RA += in->imm; \
+    return NEXT_PC; \
+  } \
+  SEM (name) \
+  { \
+    nds32_store (cpu, pc, size, RA + (RB << in->sh), RT); \
+    return NEXT_PC; \
+  } \
+  SEM (name##_bi) \
+  { \
+    nds32_store (cpu, pc, size, RA, RT); \
+    RA += RB << in->sh; \
+    return NEXT_PC; \
+  }
+
+DEF_LOAD (lb, 1, uint8_t)
+DEF_LOAD (lbs, 1, int8_t)
+DEF_LOAD (lh, 2, uint16_t)
+DEF_LOAD (lhs, 2, int16_t)
+DEF_LOAD (lw, 4, uint32_t)
+DEF_STORE (sb, 1)
+DEF_STORE (sh, 2)
+DEF_STORE (sw, 4)
+
+/* There is a single hart, so a store-conditional always succeeds.  */
+
+SEM (scw)
+{
+  nds32_store (cpu, pc, 4, RA + (RB << in->sh), RT);
+  RT = 1;
+  return NEXT_PC;
+}
+
+/* For LSMW IN->IMM holds bits [9:0] of the instruction.  */
+
+SEM (lsmw)
+{
+  nds32_lsmw (cpu, pc, (in->imm >> 5) & 1, in->ra, in->rt, in->rb,
+	      (in->imm >> 6) & 0xf, (in->imm >> 2) & 7);
+  return NEXT_PC;
+}
+
+SEM (push25)
+{
+  nds32_lsmw (cpu, pc, 1, NDS32_HARD_SP, 6, in->rt, 0xe, N32_LSMW_ADM);
+  GPR (NDS32_HARD_SP) -= in->imm;
+  return NEXT_PC;
+}
+
+SEM (pop25)
+{
+  GPR (NDS32_HARD_SP) += in->imm;
+  nds32_lsmw (cpu, pc, 0, NDS32_HARD_SP, 6, in->rt, 0xe, N32_LSMW_BIM);
+  return GPR (NDS32_HARD_LP);
+}
+
+SEM (movd44)
+{
+  RT = RA;
+  GPR (in->rt + 1) = GPR (in->ra + 1);
+  return NEXT_PC;
+}
+
+SEM (add5pc)	{ RT += pc; return NEXT_PC; }
+
+/* Branches and jumps.  IN->IMM is the byte displacement.  */
+
+#define DEF_BRANCH(name, cond) \
+  SEM (name) \
+  { \
+    return (cond) ? pc + in->imm : NEXT_PC; \
+  }
+
+DEF_BRANCH (beq, RT == RA)
+DEF_BRANCH (bne, RT != RA)
+DEF_BRANCH (beqz, RT == 0)
+DEF_BRANCH (bnez, RT != 0)
+DEF_BRANCH (bgez, (int32_t) RT >= 0)
+DEF_BRANCH (bltz, (int32_t) RT < 0)
+DEF_BRANCH (bgtz, (int32_t) RT > 0)
+DEF_BRANCH (blez, (int32_t) RT <= 0)
+DEF_BRANCH (beqc, RT == (uint32_t) in->imm2)
+DEF_BRANCH (bnec, RT != (uint32_t) in->imm2)
+DEF_BRANCH (j, 1)
+
+SEM (bgezal)
+{
+  int taken = (int32_t) RT >= 0;
+
+  GPR (NDS32_HARD_LP) = NEXT_PC;
+  return taken ? pc + in->imm : NEXT_PC;
+}
+
+SEM (bltzal)
+{
+  int taken = (int32_t) RT < 0;
+
+  GPR (NDS32_HARD_LP) = NEXT_PC;
+  return taken ? pc + in->imm : NEXT_PC;
+}
+
+SEM (jal)
+{
+  GPR (NDS32_HARD_LP) = NEXT_PC;
+  return pc + in->imm;
+}
+
+SEM (jr)	{ return RB; }
+SEM (jrnez)	{ return RB != 0 ? RB : NEXT_PC; }
+
+SEM (jral)
+{
+  uint32_t target = RB;
+
+  RT = NEXT_PC;
+  return target;
+}
+
+SEM (jralnez)
+{
+  uint32_t target = RB;
+
+  RT = NEXT_PC;
+  return target != 0 ? target : NEXT_PC;
+}
+
+/* Miscellaneous.  */
+
+SEM (break)
+{
+  sim_engine_halt (CPU_STATE (cpu), cpu, NULL, pc, sim_stopped, SIM_SIGTRAP);
+  return pc;
+}
+
+SEM (teqz)
+{
+  if (RT == 0)
+    sim_engine_halt (CPU_STATE (cpu), cpu, NULL, pc, sim_stopped,
+		     SIM_SIGTRAP);
+  return NEXT_PC;
+}
+
+SEM (tnez)
+{
+  if (RT != 0)
+    sim_engine_halt (CPU_STATE (cpu), cpu, NULL, pc, sim_stopped,
+		     SIM_SIGTRAP);
+  return NEXT_PC;
+}
+
+/* The system call number is the SWID; arguments are passed in $r0 to
+   $r3 and the result is returned in $r0.  */
+
+SEM (syscall)
+{
+  GPR (0) = sim_syscall (cpu, in->imm, GPR (0), GPR (1), GPR (2), GPR (3));
+  return NEXT_PC;
+}
+
+/* Decode the 32-bit instruction INSN into IN.  */
+
+static void
+nds32_decode32 (struct nds32_insn *in, uint32_t insn)
+{
+  nds32_sem_fn *sem = sem_illegal;
+
+  in->rt = N32_RT5 (insn);
+  in->ra = N32_RA5 (insn);
+  in->rb = N32_RB5 (insn);
+  in->rd = N32_RD5 (insn);
+  in->sh = N32_SH5 (insn);
+
+  switch (N32_OP6 (insn))
+    {
+    case N32_OP6_LBI: sem = sem_lbi; in->imm = N32_IMM15S (insn); break;
+    case N32_OP6_LHI: sem = sem_lhi; in->imm = N32_IMM15S (insn) << 1; break;
+    case N32_OP6_LWI: sem = sem_lwi; in->imm = N32_IMM15S (insn) << 2; break;
+    case N32_OP6_LBI_BI:
+      sem = sem_lbi_bi; in->imm = N32_IMM15S (insn); break;
+    case N32_OP6_LHI_BI:
+      sem = sem_lhi_bi; in->imm = N32_IMM15S (insn) << 1; break;
+    case N32_OP6_LWI_BI:
+      sem = sem_lwi_bi; in->imm = N32_IMM15S (insn) << 2; break;
+    case N32_OP6_SBI: sem = sem_sbi; in->imm = N32_IMM15S (insn); break;
+    case N32_OP6_SHI: sem = sem_shi; in->imm = N32_IMM15S (insn) << 1; break;
+    case N32_OP6_SWI: sem = sem_swi; in->imm = N32_IMM15S (insn) << 2; break;
+    case N32_OP6_SBI_BI:
+      sem = sem_sbi_bi; in->imm = N32_IMM15S (insn); break;
+    case N32_OP6_SHI_BI:
+      sem = sem_shi_bi; in->imm = N32_IMM15S (insn) << 1; break;
+    case N32_OP6_SWI_BI:
+      sem = sem_swi_bi; in->imm = N32_IMM15S (insn) << 2; break;
+    case N32_OP6_LBSI: sem = sem_lbsi; in->imm = N32_IMM15S (insn); break;
+    case N32_OP6_LHSI:
+      sem = sem_lhsi; in->imm = N32_IMM15S (insn) << 1; break;
+    case N32_OP6_LBSI_BI:
+      sem = sem_lbsi_bi; in->imm = N32_IMM15S (insn); break;
+    case N32_OP6_LHSI_BI:
+      sem = sem_lhsi_bi; in->imm = N32_IMM15S (insn) << 1; break;
+    case N32_OP6_DPREFI: sem = sem_nop; break;
+
+    case N32_OP6_LBGP:
+      in->ra = NDS32_HARD_GP;
+      in->imm = N32_IMMS (insn, 19);
+      sem = (insn & N32_BIT (19)) ? sem_lbsi : sem_lbi;
+      break;
+    case N32_OP6_SBGP:
+      in->ra = NDS32_HARD_GP;
+      in->imm = N32_IMMS (insn, 19);
+      sem = (insn & N32_BIT (19)) ? sem_addi : sem_sbi;
+      break;
+    case N32_OP6_HWGP:
+      in->ra = NDS32_HARD_GP;
+      switch (__GF (insn, 17, 3))
+	{
+	case 0: case 1:
+	  sem = sem_lhi; in->imm = N32_IMMS (insn, 18) << 1; break;
+	case 2: case 3:
+	  sem = sem_lhsi; in->imm = N32_IMMS (insn, 18) << 1; break;
+	case 4: case 5:
+	  sem = sem_shi; in->imm = N32_IMMS (insn, 18) << 1; break;
+	case 6:
+	  sem = sem_lwi; in->imm = N32_IMMS (insn, 17) << 2; break;
+	case 7:
+	  sem = sem_swi; in->imm = N32_IMMS (insn, 17) << 2; break;
+	}
+      break;
+
+    case N32_OP6_MEM:
+      in->sh = __GF (insn, 8, 2);
+      switch (N32_SUB6 (insn))
+	{
+	case N32_MEM_LB: case N32_MEM_LBUP: sem = sem_lb; break;
+	case N32_MEM_LH: sem = sem_lh; break;
+	case N32_MEM_LW: case N32_MEM_LWUP: case N32_MEM_LLW:
+	  sem = sem_lw; break;
+	case N32_MEM_LB_BI: sem = sem_lb_bi; break;
+	case N32_MEM_LH_BI: sem = sem_lh_bi; break;
+	case N32_MEM_LW_BI: sem = sem_lw_bi; break;
+	case N32_MEM_SB: case N32_MEM_SBUP: sem = sem_sb; break;
+	case N32_MEM_SH: sem = sem_sh; break;
+	case N32_MEM_SW: case N32_MEM_SWUP: sem = sem_sw; break;
+	case N32_MEM_SB_BI: sem = sem_sb_bi; break;
+	case N32_MEM_SH_BI: sem = sem_sh_bi; break;
+	case N32_MEM_SW_BI: sem = sem_sw_bi; break;
+	case N32_MEM_LBS: sem = sem_lbs; break;
+	case N32_MEM_LHS: sem = sem_lhs; break;
+	case N32_MEM_LBS_BI: sem = sem_lbs_bi; break;
+	case N32_MEM_LHS_BI: sem = sem_lhs_bi; break;
+	case N32_MEM_DPREF: sem = sem_nop; break;
+	case N32_MEM_SCW: sem = sem_scw; break;
+	}
+      break;
+
+    case N32_OP6_LSMW:
+      /* lmwzb/smwzb are not supported.  */
+      if (__GF (insn, 0, 2) != N32_LSMW_LSMWZB && __GF (insn, 0, 2) != 3)
+	{
+	  sem = sem_lsmw;
+	  in->imm = __GF (insn, 0, 10);
+	}
+      break;
+
+    case N32_OP6_ALU1:
+      switch (N32_SUB5 (insn))
+	{
+	case N32_ALU1_ADD_SLLI: sem = sem_add; break;
+	case N32_ALU1_SUB_SLLI: sem = sem_sub; break;
+	case N32_ALU1_AND_SLLI: sem = sem_and; break;
+	case N32_ALU1_XOR_SLLI: sem = sem_xor; break;
+	case N32_ALU1_OR_SLLI: sem = sem_or; break;
+	case N32_ALU1_NOR: sem = sem_nor; break;
+	case N32_ALU1_SLT: sem = sem_slt; break;
+	case N32_ALU1_SLTS: sem = sem_slts; break;
+	case N32_ALU1_SLLI: sem = sem_slli; in->sh = in->rb; break;
+	case N32_ALU1_SRLI: sem = sem_srli; in->sh = in->rb; break;
+	case N32_ALU1_SRAI: sem = sem_srai; in->sh = in->rb; break;
+	case N32_ALU1_ROTRI: sem = sem_rotri; in->sh = in->rb; break;
+	case N32_ALU1_SLL: sem = sem_sll; break;
+	case N32_ALU1_SRL: sem = sem_srl; break;
+	case N32_ALU1_SRA: sem = sem_sra; break;
+	case N32_ALU1_ROTR: sem = sem_rotr; break;
+	case N32_ALU1_SEB: sem = sem_seb; break;
+	case N32_ALU1_SEH: sem = sem_seh; break;
+	case N32_ALU1_BITC: sem = sem_bitc; break;
+	case N32_ALU1_ZEH: sem = sem_zeh; break;
+	case N32_ALU1_WSBH: sem = sem_wsbh; break;
+	case N32_ALU1_OR_SRLI: sem = sem_or_srli; break;
+	case N32_ALU1_DIVSR: sem = sem_divsr; break;
+	case N32_ALU1_DIVR: sem = sem_divr; break;
+	case N32_ALU1_SVA: sem = sem_sva; break;
+	case N32_ALU1_SVS: sem = sem_svs; break;
+	case N32_ALU1_CMOVZ: sem = sem_cmovz; break;
+	case N32_ALU1_CMOVN: sem = sem_cmovn; break;
+	case N32_ALU1_ADD_SRLI: sem = sem_add_srli; break;
+	case N32_ALU1_SUB_SRLI: sem = sem_sub_srli; break;
+	case N32_ALU1_AND_SRLI: sem = sem_and_srli; break;
+	case N32_ALU1_XOR_SRLI: sem = sem_xor_srli; break;
+	}
+      break;
+
+    case N32_OP6_ALU2:
+      /* The D0/D1 selector of the DT forms lives in the RT field.  */
+      in->rd = __GF (insn, 21, 1) ? NDS32_USR_D1LO : NDS32_USR_D0LO;
+      in->sh = in->rb;
+      switch (__GF (insn, 0, 10))
+	{
+	case N32_ALU2_MAX: sem = sem_max; break;
+	case N32_ALU2_MIN: sem = sem_min; break;
+	case N32_ALU2_AVE: sem = sem_ave; break;
+	case N32_ALU2_ABS: sem = sem_abs; break;
+	case N32_ALU2_CLIPS: sem = sem_clips; break;
+	case N32_ALU2_CLIP: sem = sem_clip; break;
+	case N32_ALU2_CLO: sem = sem_clo; break;
+	case N32_ALU2_CLZ: sem = sem_clz; break;
+	case N32_ALU2_BSET: sem = sem_bset; break;
+	case N32_ALU2_BCLR: sem = sem_bclr; break;
+	case N32_ALU2_BTGL: sem = sem_btgl; break;
+	case N32_ALU2_BTST: sem = sem_btst; break;
+	case N32_ALU2_MFUSR:
+	case N32_ALU2_MTUSR:
+	  /* Only group 0: D0, D1 and the PC.  */
+	  in->sh = __GF (insn, 15, 5);
+	  if (__GF (insn, 10, 5) == 0
+	      && (in->sh <= NDS32_USR_D1HI || in->sh == 31))
+	    sem = N32_SUB6 (insn) == N32_ALU2_MFUSR ? sem_mfusr : sem_mtusr;
+	  break;
+	case N32_ALU2_MUL: sem = sem_mul; break;
+	case N32_ALU2_MULTS64: sem = sem_mults64; break;
+	case N32_ALU2_MULT64: sem = sem_mult64; break;
+	case N32_ALU2_MADDS64: sem = sem_madds64; break;
+	case N32_ALU2_MADD64: sem = sem_madd64; break;
+	case N32_ALU2_MSUBS64: sem = sem_msubs64; break;
+	case N32_ALU2_MSUB64: sem = sem_msub64; break;
+	case N32_ALU2_DIVS: sem = sem_divs; break;
+	case N32_ALU2_DIV: sem = sem_div; break;
+	case N32_ALU2_MULT32: sem = sem_mult32; break;
+	case N32_ALU2_MADD32: sem = sem_madd32; break;
+	case N32_ALU2_MSUB32: sem = sem_msub32; break;
+	case N32_BIT (6) | N32_ALU2_MULSR64:
+	  if ((in->rt & 1) == 0)
+	    sem = sem_mulsr64;
+	  break;
+	case N32_BIT (6) | N32_ALU2_MULR64:
+	  if ((in->rt & 1) == 0)
+	    sem = sem_mulr64;
+	  break;
+	case N32_BIT (6) | N32_ALU2_MADDR32: sem = sem_maddr32; break;
+	case N32_BIT (6) | N32_ALU2_MSUBR32: sem = sem_msubr32; break;
+	}
+      break;
+
+    case N32_OP6_MOVI: sem = sem_movi; in->imm = N32_IMM20S (insn); break;
+    case N32_OP6_SETHI:
+      sem = sem_movi;
+      in->imm = N32_IMM20U (insn) << 12;
+      break;
+
+    case N32_OP6_ADDI: sem = sem_addi; in->imm = N32_IMM15S (insn); break;
+    case N32_OP6_SUBRI: sem = sem_subri; in->imm = N32_IMM15S (insn); break;
+    case N32_OP6_ANDI: sem = sem_andi; in->imm = N32_IMM15U (insn); break;
+    case N32_OP6_XORI: sem = sem_xori; in->imm = N32_IMM15U (insn); break;
+    case N32_OP6_ORI: sem = sem_ori; in->imm = N32_IMM15U (insn); break;
+    case N32_OP6_BITCI: sem = sem_bitci; in->imm = N32_IMM15U (insn); break;
+    case N32_OP6_SLTI: sem = sem_slti; in->imm = N32_IMM15S (insn); break;
+    case N32_OP6_SLTSI: sem = sem_sltsi; in->imm = N32_IMM15S (insn); break;
+
+    case N32_OP6_JI:
+      sem = (insn & N32_BIT (24)) ? sem_jal : sem_j;
+      in->imm = N32_IMM24S (insn) << 1;
+      break;
+
+    case N32_OP6_JREG:
+      switch (N32_SUB5 (insn))
+	{
+	case N32_JREG_JR:
+	  /* ifret behaves as a nop while IFC is off, as it always is
+	     here.  */
+	  sem = N32_JREG_HINT (insn) == 3 ? sem_nop : sem_jr;
+	  break;
+	case N32_JREG_JRAL: sem = sem_jral; break;
+	case N32_JREG_JRNEZ: sem = sem_jrnez; break;
+	case N32_JREG_JRALNEZ: sem = sem_jralnez; break;
+	}
+      break;
+
+    case N32_OP6_BR1:
+      sem = (insn & N32_BIT (14)) ? sem_bne : sem_beq;
+      in->imm = N32_IMM14S (insn) << 1;
+      break;
+
+    case N32_OP6_BR2:
+      in->imm = N32_IMM16S (insn) << 1;
+      switch (N32_BR2_SUB (insn))
+	{
+	case N32_BR2_BEQZ: sem = sem_beqz; break;
+	case N32_BR2_BNEZ: sem = sem_bnez; break;
+	case N32_BR2_BGEZ: sem = sem_bgez; break;
+	case N32_BR2_BLTZ: sem = sem_bltz; break;
+	case N32_BR2_BGTZ: sem = sem_bgtz; break;
+	case N32_BR2_BLEZ: sem = sem_blez; break;
+	case N32_BR2_BGEZAL: sem = sem_bgezal; break;
+	case N32_BR2_BLTZAL: sem = sem_bltzal; break;
+	}
+      break;
+
+    case N32_OP6_BR3:
+      sem = (insn & N32_BIT (19)) ? sem_bnec : sem_beqc;
+      in->imm2 = __SEXT (__GF (insn, 8, 11), 11);
+      in->imm = __SEXT (__GF (insn, 0, 8), 8) << 1;
+      break;
+
+    case N32_OP6_MISC:
+      switch (N32_SUB5 (insn))
+	{
+	case N32_MISC_STANDBY:
+	case N32_MISC_CCTL:
+	case N32_MISC_DSB:
+	case N32_MISC_ISB:
+	case N32_MISC_MSYNC:
+	case N32_MISC_ISYNC:
+	  sem = sem_nop;
+	  break;
+	case N32_MISC_TRAP:
+	case N32_MISC_BREAK:
+	  sem = sem_break;
+	  break;
+	case N32_MISC_TEQZ: sem = sem_teqz; break;
+	case N32_MISC_TNEZ: sem = sem_tnez; break;
+	case N32_MISC_SYSCALL:
+	  sem = sem_syscall;
+	  in->imm = __GF (insn, 5, 15);
+	  break;
+	}
+      break;
+    }
+
+  in->sem = sem;
+}
+
+/* Decode the 16-bit instruction INSN16 into IN.  Most of them have an
+   exact 32-bit counterpart; the few that do not get their own
+   semantic routines.  */
+
+static void
+nds32_decode16 (SIM_CPU *cpu, struct nds32_insn *in, uint16_t insn16)
+{
+  bfd *abfd = STATE_PROG_BFD (CPU_STATE (cpu));
+  uint32_t insn;
+
+  if (__GF (insn16, 7, 8) == N16_T25_PUSH25
+      || __GF (insn16, 7, 8) == N16_T25_POP25)
+    {
+      static const unsigned char re_map[] = { 6, 8, 10, 14 };
+
+      in->sem = __GF (insn16, 7, 8) == N16_T25_PUSH25 ? sem_push25 : sem_pop25;
+      in->rt = re_map[__GF (insn16, 5, 2)];
+      in->imm = __GF (insn16, 0, 5) << 3;
+      return;
+    }
+
+  if (__GF (insn16, 8, 7) == N15_T44_MOVD44)
+    {
+      in->sem = sem_movd44;
+      in->rt = __GF (insn16, 4, 4) << 1;
+      in->ra = __GF (insn16, 0, 4) << 1;
+      return;
+    }
+
+  if (__GF (insn16, 5, 10) == N16_T5_ADD5PC)
+    {
+      in->sem = sem_add5pc;
+      in->rt = __GF (insn16, 0, 5);
+      return;
+    }
+
+  if (insn16 == INSN_IFRET16)
+    {
+      in->sem = sem_nop;
+      return;
+    }
+
+  /* ex9.it shares its major opcode with break16.  */
+  if ((__GF (insn16, 9, 6) == N16_T9_EX9IT && __GF (insn16, 5, 4) != 0)
+      || __GF (insn16, 5, 10) == N16_T5_EX9IT)
+    {
+      in->sem = sem_illegal;
+      return;
+    }
+
+  if (abfd != NULL && nds32_convert_16_to_32 (abfd, insn16, &insn))
+    nds32_decode32 (in, insn);
+  else
+    in->sem = sem_illegal;
+}
+
+/* Decode the instruction at PC into the predecode cache entry IN.  */
+
+static void
+nds32_decode (SIM_CPU *cpu, struct nds32_insn *in, sim_cia pc)
+{
+  SIM_DESC sd = CPU_STATE (cpu);
+  unsigned char buf[4];
+  uint32_t end;
+
+  memset (in, 0, sizeof (*in));
+
+  /* Instructions are always big-endian, whatever the data byte
+     order.  */
+  if (sim_core_read_buffer (sd, cpu, exec_map, buf, pc, 2) != 2)
+    sim_engine_halt (sd, cpu, NULL, pc, sim_signalled, SIM_SIGSEGV);
+
+  if (buf[0] & 0x80)
+    {
+      in->len = 2;
+      nds32_decode16 (cpu, in, (buf[0] << 8) | buf[1]);
+    }
+  else
+    {
+      if (sim_core_read_buffer (sd, cpu, exec_map, buf + 2, pc + 2, 2) != 2)
+	sim_engine_halt (sd, cpu, NULL, pc, sim_signalled, SIM_SIGSEGV);
+      in->len = 4;
+      nds32_decode32 (in, ((uint32_t) buf[0] << 24) | (buf[1] << 16)
+			  | (buf[2] << 8) | buf[3]);
+    }
+
+  in->pc = pc;
+  in->gen = cpu->state.scache_gen;
+
+  end = pc + in->len;
+  if (pc < cpu->state.code_lo)
+    cpu->state.code_lo = pc;
+  if (end > cpu->state.code_hi)
+    cpu->state.code_hi = end;
+}
+
+static void
+step_once (SIM_CPU *cpu)
+{
+  sim_cia pc = cpu->state.pc;
+  struct nds32_insn *in;
+
+  in = &cpu->state.scache[(pc >> 1) & (NDS32_SCACHE_SIZE - 1)];
+  if (in->pc != pc || in->gen != cpu->state.scache_gen)
+    nds32_decode (cpu, in, pc);
+
+  cpu->state.pc = in->sem (cpu, in, pc);
+}
+
+void
+sim_engine_run (SIM_DESC sd,
+		int next_cpu_nr,  /* ignore  */
+		int nr_cpus,      /* ignore  */
+		int siggnal)      /* ignore  */
+{
+  sim_cpu *cpu;
+
+  SIM_ASSERT (STATE_MAGIC (sd) == SIM_MAGIC_NUMBER);
+
+  cpu = STATE_CPU (sd, 0);
+
+  /* Memory may have been written since we last ran, e.g. by GDB
+     inserting or removing breakpoints.  */
+  nds32_scache_flush (cpu);
+
+  while (1)
+    {
+      step_once (cpu);
+      if (sim_events_tick (sd))
+	sim_events_process (sd);
+    }
+}
+
+static uint32_t *
+nds32_lookup_register (SIM_CPU *cpu, int nr)
+{
+  switch (nr)
+    {
+    case SIM_NDS32_PC_REGNUM:
+      return &cpu->state.pc;
+    case SIM_NDS32_D0LO_REGNUM:
+      return &cpu->state.usr[NDS32_USR_D0LO];
+    case SIM_NDS32_D0HI_REGNUM:
+      return &cpu->state.usr[NDS32_USR_D0HI];
+    case SIM_NDS32_D1LO_REGNUM:
+      return &cpu->state.usr[NDS32_USR_D1LO];
+    case SIM_NDS32_D1HI_REGNUM:
+      return &cpu->state.usr[NDS32_USR_D1HI];
+    default:
+      return &cpu->state.regs[nr];
+    }
+}
+
+static int
+nds32_reg_store (SIM_CPU *cpu,
+		 int rn,
+		 unsigned char *memory,
+		 int length)
+{
+  uint32_t val;
+
+  if (rn < 0 || rn >= SIM_NDS32_NUM_REGS)
+    return 0;
+
+  if (length == 4)
+    {
+      memcpy (&val, memory, 4);
+      *nds32_lookup_register (cpu, rn) = T2H_4 (val);
+    }
+  return 4;
+}
+
+static int
+nds32_reg_fetch (SIM_CPU *cpu,
+		 int rn,
+		 unsigned char *memory,
+		 int length)
+{
+  uint32_t val;
+
+  if (rn < 0 || rn >= SIM_NDS32_NUM_REGS)
+    return 0;
+
+  if (length == 4)
+    {
+      val = H2T_4 (*nds32_lookup_register (cpu, rn));
+      memcpy (memory, &val, 4);
+    }
+  return 4;
+}
+
+static sim_cia
+nds32_pc_get (SIM_CPU *cpu)
+{
+  return cpu->state.pc;
+}
+
+static void
+nds32_pc_set (SIM_CPU *cpu, sim_cia newpc)
+{
+  cpu->state.pc = newpc;
+}
+
+/* Cover function of sim_state_free to free the cpu buffers as well.  */
+
+static void
+free_state (SIM_DESC sd)
+{
+  if (STATE_MODULES (sd) != NULL)
+    sim_module_uninstall (sd);
+  sim_cpu_free_all (sd);
+  sim_state_free (sd);
+}
+
+SIM_DESC
+sim_open (SIM_OPEN_KIND kind,
+	  host_callback *cb,
+	  struct bfd *abfd,
+	  char * const *argv)
+{
+  char c;
+  size_t i;
+  SIM_DESC sd = sim_state_alloc (kind, cb);
+
+  /* The cpu data is kept in a separately allocated chunk of memory.  */
+  if (sim_cpu_alloc_all (sd, 1, /*cgen_cpu_max_extra_bytes ()*/0) != SIM_RC_OK)
+    {
+      free_state (sd);
+      return 0;
+    }
+
+  if (sim_pre_argv_init (sd, argv[0]) != SIM_RC_OK)
+    {
+      free_state (sd);
+      return 0;
+    }
+
+  /* The parser will print an error message for us, so we silently return.  */
+  if (sim_parse_args (sd, argv) != SIM_RC_OK)
+    {
+      free_state (sd);
+      return 0;
+    }
+
+  /* Allocate external memory if none specified by user.
+     Use address 4 here in case the user wanted address 0 unmapped.  */
+  if (sim_core_read_buffer (sd, NULL, read_map, &c, 4, 1) == 0)
+    sim_do_commandf (sd, "memory-size %#x", DEFAULT_MEM_SIZE);
+
+  /* Check for/establish the reference program image.  */
+  if (sim_analyze_program (sd,
+			   (STATE_PROG_ARGV (sd) != NULL
+			    ? *STATE_PROG_ARGV (sd)
+			    : NULL), abfd) != SIM_RC_OK)
+    {
+      free_state (sd);
+      return 0;
+    }
+
+  /* Configure/verify the target byte order and other runtime
+     configuration options.  */
+  if (sim_config (sd) != SIM_RC_OK)
+    {
+      free_state (sd);
+      return 0;
+    }
+
+  if (sim_post_argv_init (sd) != SIM_RC_OK)
+    {
+      free_state (sd);
+      return 0;
+    }
+
+  /* CPU specific initialization.  */
+  for (i = 0; i < MAX_NR_PROCESSORS; ++i)
+    {
+      SIM_CPU *cpu = STATE_CPU (sd, i);
+
+      CPU_REG_FETCH (cpu) = nds32_reg_fetch;
+      CPU_REG_STORE (cpu) = nds32_reg_store;
+      CPU_PC_FETCH (cpu) = nds32_pc_get;
+      CPU_PC_STORE (cpu) = nds32_pc_set;
+
+      /* Entries are zeroed, so generation 0 must never be current.  */
+      cpu->state.scache_gen = 0;
+      nds32_scache_flush (cpu);
+    }
+
+  return sd;
+}
+
+SIM_RC
+sim_create_inferior (SIM_DESC sd,
+		     struct bfd *abfd,
+		     char * const *argv,
+		     char * const *env)
+{
+  sim_cpu *cpu = STATE_CPU (sd, 0);
+
+  /* Set the PC.  */
+  if (abfd != NULL)
+    cpu->state.pc = bfd_get_start_address (abfd);
+  else
+    cpu->state.pc = 0;
+
+  /* Standalone mode (i.e. `run`) will take care of the argv for us in
+     sim_open() -> sim_parse_args().  But in debug mode (i.e. 'target sim'
+     with `gdb`), we need to handle it because the user can change the
+     argv on the fly via gdb's 'run'.  */
+  if (STATE_PROG_ARGV (sd) != argv)
+    {
+      freeargv (STATE_PROG_ARGV (sd));
+      STATE_PROG_ARGV (sd) = dupargv (argv);
+    }
+
+  memset (cpu->state.regs, 0, sizeof (cpu->state.regs));
+  memset (cpu->state.usr, 0, sizeof (cpu->state.usr));
+  cpu->state.regs[NDS32_HARD_SP] = DEFAULT_MEM_SIZE - 8;
+  nds32_scache_flush (cpu);
+
+  return SIM_RC_OK;
+}
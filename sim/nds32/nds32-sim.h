@@ -0,0 +1,85 @@
+/* Simulator for the NDS32 processor
+
+   Copyright (C) 2019 Free Software Foundation, Inc.
+   Contributed by Andes Technology Corporation.
+
+   This file is part of simulators.
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.  */
+
+#ifndef _NDS32_SIM_H_
+#define _NDS32_SIM_H_
+
+#include <stdint.h>
+
+#include "gdb/sim-nds32.h"
+
+#define NDS32_HARD_FP 28
+#define NDS32_HARD_GP 29
+#define NDS32_HARD_LP 30
+#define NDS32_HARD_SP 31
+
+/* Indices of the user special registers in STATE.USR.  */
+#define NDS32_USR_D0LO 0
+#define NDS32_USR_D0HI 1
+#define NDS32_USR_D1LO 2
+#define NDS32_USR_D1HI 3
+
+struct nds32_insn;
+
+/* A semantic routine.  It executes the decoded instruction IN found
+   at PC and returns the address of the next instruction.  */
+typedef sim_cia (nds32_sem_fn) (SIM_CPU *, const struct nds32_insn *,
+				sim_cia);
+
+/* An entry of the predecoded instruction cache.  Like the CGEN
+   scache, each instruction is decoded once into its semantic routine
+   and operand fields, and re-used for as long as the entry is valid.
+   An entry is valid when PC matches the address being executed and
+   GEN matches the cpu's current decode generation.  */
+struct nds32_insn
+{
+  uint32_t pc;
+  unsigned int gen;
+  nds32_sem_fn *sem;
+  /* Instruction length in bytes, 2 or 4.  */
+  unsigned char len;
+  unsigned char rt, ra, rb, rd;
+  /* Shift amount, or a sub-operation selector.  */
+  unsigned char sh;
+  int32_t imm;
+  /* Second immediate, e.g. the constant compared by beqc/bnec.  */
+  int32_t imm2;
+};
+
+/* Number of predecode cache entries; must be a power of two.  */
+#define NDS32_SCACHE_SIZE 8192
+
+struct nds32_cpu_state {
+  uint32_t regs[32];
+  uint32_t pc;
+  uint32_t usr[4];
+
+  /* The predecode cache.  Bumping SCACHE_GEN invalidates every entry
+     at once; this is done whenever code may have been modified behind
+     our back (e.g. GDB inserting breakpoints between resumes) and when
+     the program stores into [CODE_LO, CODE_HI), the range of addresses
+     decoded so far.  */
+  unsigned int scache_gen;
+  uint32_t code_lo;
+  uint32_t code_hi;
+  struct nds32_insn scache[NDS32_SCACHE_SIZE];
+};
+
+#endif  /* _NDS32_SIM_H_ */
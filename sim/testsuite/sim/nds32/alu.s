@@ -0,0 +1,93 @@
+# check that the ALU instructions work.
+# mach: nds32
+
+.include "testutils.inc"
+
+	start
+
+	movi	$r0, 10
+	addi	$r1, $r0, 23
+	EXPECT	$r1, 33
+	subri	$r1, $r0, 3
+	EXPECT	$r1, -7
+	sethi	$r2, 0x12345
+	ori	$r2, $r2, 0x678
+	EXPECT	$r2, 0x12345678
+
+	add	$r3, $r2, $r0
+	EXPECT	$r3, 0x12345682
+	sub	$r3, $r2, $r0
+	EXPECT	$r3, 0x1234566e
+	add_slli $r3, $r0, $r0, 4
+	EXPECT	$r3, 170
+	or_srli	$r3, $r0, $r2, 28
+	EXPECT	$r3, 11
+	and	$r3, $r2, $r0
+	EXPECT	$r3, 8
+	xor	$r3, $r2, $r2
+	EXPECT	$r3, 0
+	nor	$r3, $r2, $r0
+	EXPECT	$r3, 0xedcba985
+	bitci	$r3, $r2, 0x7ff
+	EXPECT	$r3, 0x12345000
+
+	movi	$r4, -1
+	slt	$r3, $r0, $r4
+	EXPECT	$r3, 1
+	slts	$r3, $r0, $r4
+	EXPECT	$r3, 0
+	sltsi	$r3, $r4, 0
+	EXPECT	$r3, 1
+
+	slli	$r3, $r2, 4
+	EXPECT	$r3, 0x23456780
+	srli	$r3, $r4, 28
+	EXPECT	$r3, 15
+	srai	$r3, $r4, 28
+	EXPECT	$r3, -1
+	rotri	$r3, $r2, 8
+	EXPECT	$r3, 0x78123456
+	movi	$r5, 36
+	sll	$r3, $r2, $r5
+	EXPECT	$r3, 0x23456780
+
+	seb	$r3, $r4
+	EXPECT	$r3, -1
+	zeh	$r3, $r4
+	EXPECT	$r3, 0xffff
+	wsbh	$r3, $r2
+	EXPECT	$r3, 0x34127856
+
+	movi	$r3, 0
+	cmovz	$r3, $r0, $r3
+	EXPECT	$r3, 10
+	cmovn	$r3, $r4, $r3
+	EXPECT	$r3, -1
+
+	max	$r3, $r0, $r4
+	EXPECT	$r3, 10
+	abs	$r3, $r4
+	EXPECT	$r3, 1
+	clz	$r3, $r0
+	EXPECT	$r3, 28
+	clips	$r3, $r2, 7
+	EXPECT	$r3, 127
+	bset	$r3, $r0, 31
+	EXPECT	$r3, 0x8000000a
+	btst	$r3, $r0, 3
+	EXPECT	$r3, 1
+
+# 16-bit forms.
+	movi55	$r6, 5
+	addi45	$r6, 7
+	EXPECT	$r6, 12
+	movi55	$r7, -3
+	add45	$r6, $r7
+	EXPECT	$r6, 9
+	slli333	$r6, $r6, 2
+	EXPECT	$r6, 36
+	movd44	$r8, $r6
+	EXPECT	$r8, 36
+	EXPECT	$r9, -3
+
+	PASS
@@ -0,0 +1,44 @@
+# check the branch and jump instructions.
+# mach: nds32
+
+.include "testutils.inc"
+
+	start
+
+	movi	$r0, 0
+	movi	$r1, -1
+	beq	$r0, $r1, failcase
+	bne	$r0, $r0, failcase
+	bnez	$r0, failcase
+	bltz	$r0, failcase
+	bgtz	$r1, failcase
+	bgez	$r1, failcase
+	beqc	$r1, 0, failcase
+	bnec	$r1, -1, failcase
+
+	movi	$r2, 0
+	beqz	$r0, 1f
+	j	failcase
+1:	addi	$r2, $r2, 1
+	bltzal	$r1, 2f
+	j	failcase
+2:	addi	$r2, $r2, 1
+	beqc	$r1, -1, 3f
+	j	failcase
+3:	addi	$r2, $r2, 1
+	la	$r3, 4f
+	jral	$r3
+	j	failcase
+4:	addi	$r2, $r2, 1
+	jrnez	$r0
+	EXPECT	$r2, 4
+
+# A counted loop, using 16-bit branches.
+	movi	$r0, 10
+	movi	$r5, 0
+5:	addi45	$r5, 3
+	subi45	$r0, 1
+	bnez38	$r0, 5b
+	EXPECT	$r5, 30
+
+	PASS
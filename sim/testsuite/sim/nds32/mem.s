@@ -0,0 +1,63 @@
+# check the load and store instructions.
+# mach: nds32
+
+.include "testutils.inc"
+
+	start
+
+	la	$r0, buf
+	li	$r1, 0x8091a2b3
+	swi	$r1, [$r0 + 4]
+	lwi	$r2, [$r0 + 4]
+	EXPECT	$r2, 0x8091a2b3
+	lhsi	$r2, [$r0 + 6]
+	lbi	$r3, [$r0 + 4]
+	movi	$r4, 2
+	lw	$r5, [$r0 + ($r4 << 1)]
+	EXPECT	$r5, 0x8091a2b3
+
+	sbi.bi	$r4, [$r0], 1
+	sbi.bi	$r4, [$r0], 1
+	la	$r6, buf + 2
+	bne	$r0, $r6, failcase
+	lhi	$r2, [$r0 + -2]
+	EXPECT	$r2, 0x0202
+
+# Multiple loads and stores.
+	la	$r0, buf + 32
+	movi	$r6, 6
+	movi	$r7, 7
+	movi	$r8, 8
+	smw.adm	$r6, [$r0], $r8, 0x2
+	la	$r1, buf + 16
+	bne	$r0, $r1, failcase
+	lwi	$r2, [$r0 + 0]
+	EXPECT	$r2, 6
+	lwi	$r2, [$r0 + 12]
+	bne	$r2, $lp, failcase
+	movi	$r6, 0
+	movi	$r7, 0
+	lmw.bim	$r6, [$r0], $r7, 0
+	EXPECT	$r6, 6
+	EXPECT	$r7, 7
+
+# push25/pop25.
+	movi	$r6, 66
+	move	$r10, $sp
+	jal	func
+	bne	$r10, $sp, failcase
+	EXPECT	$r6, 66
+
+	PASS
+
+func:
+	push25	$r6, 16
+	addi	$r1, $sp, 32
+	bne	$r1, $r10, failcase
+	movi	$r6, 0
+	pop25	$r6, 16
+
+	.data
+	.align	2
+buf:
+	.space	64
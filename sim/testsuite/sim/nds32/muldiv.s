@@ -0,0 +1,45 @@
+# check the multiply and divide instructions.
+# mach: nds32
+# as: -mdiv -mdx-regs
+
+.include "testutils.inc"
+
+	start
+
+	movi	$r0, -7
+	movi	$r1, 3
+	mul	$r2, $r0, $r1
+	EXPECT	$r2, -21
+
+	divsr	$r2, $r3, $r0, $r1
+	EXPECT	$r2, -2
+	EXPECT	$r3, -1
+	divr	$r2, $r3, $r0, $r1
+	EXPECT	$r2, 0x55555553
+	EXPECT	$r3, 0
+
+	mults64	$d0, $r0, $r1
+	mfusr	$r2, $d0.lo
+	mfusr	$r3, $d0.hi
+	EXPECT	$r2, -21
+	EXPECT	$r3, -1
+	mult64	$d1, $r0, $r1
+	mfusr	$r2, $d1.lo
+	mfusr	$r3, $d1.hi
+	EXPECT	$r2, -21
+	EXPECT	$r3, 2
+	madds64	$d0, $r1, $r1
+	mfusr	$r2, $d0.lo
+	EXPECT	$r2, -12
+
+	divs	$d0, $r0, $r1
+	mfusr	$r2, $d0.lo
+	mfusr	$r3, $d0.hi
+	EXPECT	$r2, -2
+	EXPECT	$r3, -1
+
+	movi	$r2, 100
+	maddr32	$r2, $r0, $r1
+	EXPECT	$r2, 79
+
+	PASS
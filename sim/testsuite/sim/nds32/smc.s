@@ -0,0 +1,26 @@
+# check that the predecode cache notices modified code.
+# mach: nds32
+
+.include "testutils.inc"
+
+	start
+
+	movi	$r5, 0
+	movi	$r6, 2
+	la	$r1, patch
+	la	$r2, newinsn
+	lwi	$r2, [$r2]
+loop:
+patch:
+	addi	$r5, $r5, 1
+	swi	$r2, [$r1]
+	addi	$r6, $r6, -1
+	bnez	$r6, loop
+	EXPECT	$r5, 101
+
+	PASS
+
+	.data
+	.align	2
+newinsn:
+	addi	$r5, $r5, 100